@@ -217,6 +217,16 @@ AC_TRY_COMPILE([#include <sys/stat.h>],[struct stat t;
 dnl See if we have the removefile(3) function for securely removing files
 AC_CHECK_FUNCS(removefile)
 
+dnl See if we have splice(2) for moving data between file descriptors
+AC_CHECK_FUNCS(splice)
+
+dnl See if we have the Linux sendfile(2) for sending files to sockets
+AC_MSG_CHECKING(for Linux sendfile)
+AC_TRY_COMPILE([#include <sys/sendfile.h>],[ssize_t n = sendfile(1, 0, (off_t *)0, 1);],
+	AC_MSG_RESULT(yes)
+	AC_DEFINE(HAVE_SENDFILE),
+	AC_MSG_RESULT(no))
+
 dnl See if we have libusb...
 AC_ARG_ENABLE(libusb, [  --enable-libusb         use libusb for USB printing])
 
@@ -9,4 +9,12 @@ dnl
 
 AC_CHECK_FUNC(poll, AC_DEFINE(HAVE_POLL))
 AC_CHECK_FUNC(epoll_create, AC_DEFINE(HAVE_EPOLL))
+AC_MSG_CHECKING(for io_uring)
+AC_TRY_COMPILE([#include <linux/io_uring.h>
+#include <sys/syscall.h>],[struct io_uring_getevents_arg arg;
+	int o = IORING_FEAT_EXT_ARG | IORING_OP_POLL_REMOVE;
+	long n = SYS_io_uring_setup + SYS_io_uring_enter;],
+	AC_MSG_RESULT(yes)
+	AC_DEFINE(HAVE_IO_URING),
+	AC_MSG_RESULT(no))
 AC_CHECK_FUNC(kqueue, AC_DEFINE(HAVE_KQUEUE))
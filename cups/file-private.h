@@ -104,6 +104,11 @@ struct _cups_file_s			/**** CUPS file structure... ****/
 
   char		*printf_buffer;		/* cupsFilePrintf buffer */
   size_t	printf_size;		/* Size of cupsFilePrintf buffer */
+
+  int		is_buffer;		/* Memory buffer? */
+  char		*buffer;		/* Memory buffer data */
+  size_t	buffer_used,		/* Bytes in memory buffer */
+		buffer_size;		/* Size of memory buffer */
 };
 
 
@@ -119,6 +124,9 @@ extern _cups_fc_result_t	_cupsFileCheck(const char *filename,
 extern void			_cupsFileCheckFilter(void *context,
 						     _cups_fc_result_t result,
 						     const char *message);
+extern const char		*_cupsFileGetBuffer(cups_file_t *fp,
+						    size_t *length);
+extern cups_file_t		*_cupsFileOpenBuffer(void);
 
 #  ifdef __cplusplus
 }
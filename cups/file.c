@@ -303,6 +303,55 @@ _cupsFileCheckFilter(
 #endif /* !WIN32 */
 
 
+/*
+ * '_cupsFileGetBuffer()' - Get the contents of a memory buffer file.
+ *
+ * The returned buffer is nul-terminated and remains valid until the file is
+ * closed or written to again.
+ */
+
+const char *				/* O - Buffer contents or @code NULL@ on error */
+_cupsFileGetBuffer(cups_file_t *fp,	/* I - CUPS file */
+                   size_t      *length)	/* O - Length of contents */
+{
+  if (length)
+    *length = 0;
+
+  if (!fp || !fp->is_buffer || cupsFileFlush(fp))
+    return (NULL);
+
+  if (length)
+    *length = fp->buffer_used;
+
+  return (fp->buffer ? fp->buffer : "");
+}
+
+
+/*
+ * '_cupsFileOpenBuffer()' - Open a memory buffer for writing.
+ *
+ * Use @link _cupsFileGetBuffer@ to get the data that has been written.
+ */
+
+cups_file_t *				/* O - CUPS file or @code NULL@ on error */
+_cupsFileOpenBuffer(void)
+{
+  cups_file_t	*fp;			/* New CUPS file */
+
+
+  if ((fp = calloc(1, sizeof(cups_file_t))) == NULL)
+    return (NULL);
+
+  fp->fd        = -1;
+  fp->mode      = 'w';
+  fp->is_buffer = 1;
+  fp->ptr       = fp->buf;
+  fp->end       = fp->buf + sizeof(fp->buf);
+
+  return (fp);
+}
+
+
 /*
  * 'cupsFileClose()' - Close a CUPS file.
  *
@@ -420,6 +469,18 @@ cupsFileClose(cups_file_t *fp)		/* I - CUPS file */
   if (fp->printf_buffer)
     free(fp->printf_buffer);
 
+  if (fp->is_buffer)
+  {
+   /*
+    * Memory buffers have no file descriptor to close...
+    */
+
+    free(fp->buffer);
+    free(fp);
+
+    return (status);
+  }
+
   free(fp);
 
  /*
@@ -2696,6 +2757,36 @@ cups_write(cups_file_t *fp,		/* I - CUPS file */
   * Loop until all bytes are written...
   */
 
+  if (fp->is_buffer)
+  {
+   /*
+    * Append to the memory buffer, keeping room for a nul terminator...
+    */
+
+    if (fp->buffer_used + bytes >= fp->buffer_size)
+    {
+      char	*buffer;		/* New buffer */
+      size_t	size;			/* New size */
+
+
+      size = fp->buffer_size ? 2 * fp->buffer_size : 4096;
+      while (fp->buffer_used + bytes >= size)
+        size *= 2;
+
+      if ((buffer = realloc(fp->buffer, size)) == NULL)
+        return (-1);
+
+      fp->buffer      = buffer;
+      fp->buffer_size = size;
+    }
+
+    memcpy(fp->buffer + fp->buffer_used, buf, bytes);
+    fp->buffer_used += bytes;
+    fp->buffer[fp->buffer_used] = '\0';
+
+    return ((ssize_t)bytes);
+  }
+
   total = 0;
   while (bytes > 0)
   {
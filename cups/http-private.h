@@ -166,6 +166,7 @@ extern "C" {
  * Constants...
  */
 
+#  define _HTTP_MAX_BUFFER	65536	/* Default size of data buffers */
 #  define _HTTP_MAX_SBUFFER	65536	/* Size of (de)compression buffer */
 #  define _HTTP_RESOLVE_DEFAULT	0	/* Just resolve with default options */
 #  define _HTTP_RESOLVE_STDERR	1	/* Log resolve progress to stderr */
@@ -292,8 +293,8 @@ struct _http_s				/**** HTTP connection structure ****/
   http_encoding_t	data_encoding;	/* Chunked or not */
   int			_data_remaining;/* Number of bytes left (deprecated) */
   int			used;		/* Number of bytes used in buffer */
-  char			buffer[HTTP_MAX_BUFFER];
-					/* Buffer for incoming data */
+  char			_buffer[HTTP_MAX_BUFFER];
+					/* Old buffer for incoming data (deprecated) */
   int			_auth_type;	/* Authentication in use (deprecated) */
   unsigned char		_md5_state[88];	/* MD5 state (deprecated) */
   char			nonce[HTTP_MAX_VALUE];
@@ -318,8 +319,8 @@ struct _http_s				/**** HTTP connection structure ****/
   off_t			data_remaining;	/* Number of bytes left */
   http_addr_t		*hostaddr;	/* Current host address and port */
   http_addrlist_t	*addrlist;	/* List of valid addresses */
-  char			wbuffer[HTTP_MAX_BUFFER];
-					/* Buffer for outgoing data */
+  char			_wbuffer[HTTP_MAX_BUFFER];
+					/* Old buffer for outgoing data (deprecated) */
   int			wused;		/* Write buffer bytes used */
 
   /**** New in CUPS 1.3 ****/
@@ -367,6 +368,11 @@ struct _http_s				/**** HTTP connection structure ****/
 					/* Allocated field values */
   			*default_fields[HTTP_FIELD_MAX];
 					/* Default field values, if any */
+  size_t		bufsize;	/* Size of read and write buffers */
+  char			*rbuffer,	/* Buffer for incoming data */
+			*buffer,	/* Next unread byte in rbuffer */
+			*wbuffer;	/* Buffer for outgoing data */
+  int			wfields;	/* Bytes of header fields in wbuffer */
 };
 #  endif /* !_HTTP_NO_PRIVATE */
 
@@ -436,17 +442,25 @@ extern void		_httpDisconnect(http_t *http);
 extern char		*_httpEncodeURI(char *dst, const char *src,
 			                size_t dstsize);
 extern void		_httpFreeCredentials(http_tls_credentials_t credentials);
+#ifdef HAVE_SPLICE
+extern ssize_t		_httpReadSplice(http_t *http, int pipefd, size_t length);
+#endif /* HAVE_SPLICE */
 extern const char	*_httpResolveURI(const char *uri, char *resolved_uri,
 			                 size_t resolved_size, int options,
 					 int (*cb)(void *context),
 					 void *context);
+#ifdef HAVE_SENDFILE
+extern ssize_t		_httpSendFile(http_t *http, int fd, size_t length);
+#endif /* HAVE_SENDFILE */
 extern int		_httpSetDigestAuthString(http_t *http, const char *nonce, const char *method, const char *resource);
 extern const char	*_httpStatus(cups_lang_t *lang, http_status_t status);
 extern void		_httpTLSInitialize(void);
 extern size_t		_httpTLSPending(http_t *http);
 extern int		_httpTLSRead(http_t *http, char *buf, int len);
+extern int		_httpTLSResumed(http_t *http);
 extern int		_httpTLSSetCredentials(http_t *http);
 extern void		_httpTLSSetOptions(int options, int min_version, int max_version);
+extern void		_httpTLSSetSessionCache(int timeout);
 extern int		_httpTLSStart(http_t *http);
 extern void		_httpTLSStop(http_t *http);
 extern int		_httpTLSWrite(http_t *http, const char *buf, int len);
@@ -24,10 +24,27 @@
 #  include <signal.h>
 #  include <sys/time.h>
 #  include <sys/resource.h>
+#  include <sys/uio.h>
 #endif /* WIN32 */
 #ifdef HAVE_POLL
 #  include <poll.h>
 #endif /* HAVE_POLL */
+#ifdef HAVE_SENDFILE
+#  include <sys/sendfile.h>
+#endif /* HAVE_SENDFILE */
+
+
+/*
+ * Local types...
+ */
+
+#ifdef WIN32
+struct iovec				/* Scatter/gather buffer */
+{
+  void		*iov_base;		/* Start of buffer */
+  size_t	iov_len;		/* Length of buffer */
+};
+#endif /* WIN32 */
 
 
 /*
@@ -55,8 +72,10 @@ static int		http_send(http_t *http, http_state_t request,
 			          const char *uri);
 static ssize_t		http_write(http_t *http, const char *buffer,
 			           size_t length);
-static ssize_t		http_write_chunk(http_t *http, const char *buffer,
-			                 size_t length);
+static ssize_t		http_write_buffer(http_t *http, const char *buffer,
+			                  size_t length, int eof);
+static ssize_t		http_writev(http_t *http, struct iovec *iov,
+			            int iovcnt);
 static off_t		http_set_length(http_t *http);
 static void		http_set_timeout(int fd, double timeout);
 static void		http_set_wait(http_t *http);
@@ -368,6 +387,9 @@ httpClose(http_t *http)			/* I - HTTP connection */
   if (http->authstring && http->authstring != http->_authstring)
     free(http->authstring);
 
+  free(http->rbuffer);
+  free(http->wbuffer);
+
   free(http);
 }
 
@@ -683,12 +705,7 @@ httpFlushWrite(http_t *http)		/* I - HTTP connection */
     return (0);
   }
 
-  if (http->data_encoding == HTTP_ENCODING_CHUNKED)
-    bytes = http_write_chunk(http, http->wbuffer, (size_t)http->wused);
-  else
-    bytes = http_write(http, http->wbuffer, (size_t)http->wused);
-
-  http->wused = 0;
+  bytes = http_write_buffer(http, NULL, 0, 0);
 
   DEBUG_printf(("1httpFlushWrite: Returning %d, errno=%d.", (int)bytes, errno));
 
@@ -1171,7 +1188,8 @@ httpGets(char   *line,			/* I - Line to read into */
         return (NULL);
       }
 
-      bytes = http_read(http, http->buffer + http->used, (size_t)(HTTP_MAX_BUFFER - http->used));
+      http->buffer = http->rbuffer;
+      bytes        = http_read(http, http->buffer, http->bufsize);
 
       DEBUG_printf(("4httpGets: read " CUPS_LLFMT " bytes.", CUPS_LLCAST bytes));
 
@@ -1255,9 +1273,8 @@ httpGets(char   *line,			/* I - Line to read into */
 	*lineptr++ = *bufptr++;
     }
 
-    http->used -= (int)(bufptr - http->buffer);
-    if (http->used > 0)
-      memmove(http->buffer, bufptr, (size_t)http->used);
+    http->used   -= (int)(bufptr - http->buffer);
+    http->buffer = bufptr;
 
     if (eol)
     {
@@ -1697,13 +1714,14 @@ httpPeek(http_t *http,			/* I - HTTP connection */
       }
     }
 
-    if ((size_t)http->data_remaining > sizeof(http->buffer))
-      buflen = sizeof(http->buffer);
+    if ((size_t)http->data_remaining > http->bufsize)
+      buflen = (ssize_t)http->bufsize;
     else
       buflen = (ssize_t)http->data_remaining;
 
     DEBUG_printf(("2httpPeek: Reading %d bytes into buffer.", (int)buflen));
-    bytes = http_read(http, http->buffer, (size_t)buflen);
+    http->buffer = http->rbuffer;
+    bytes        = http_read(http, http->buffer, (size_t)buflen);
 
     DEBUG_printf(("2httpPeek: Read " CUPS_LLFMT " bytes into buffer.",
                   CUPS_LLCAST bytes));
@@ -1724,9 +1742,9 @@ httpPeek(http_t *http,			/* I - HTTP connection */
     int		zerr;			/* Decompressor error */
     z_stream	stream;			/* Copy of decompressor stream */
 
-    if (http->used > 0 && http->stream.avail_in < HTTP_MAX_BUFFER)
+    if (http->used > 0 && http->stream.avail_in < _HTTP_MAX_SBUFFER)
     {
-      size_t buflen = buflen = HTTP_MAX_BUFFER - http->stream.avail_in;
+      size_t buflen = _HTTP_MAX_SBUFFER - http->stream.avail_in;
 					/* Number of bytes to copy */
 
       if (http->stream.avail_in > 0 &&
@@ -1746,11 +1764,9 @@ httpPeek(http_t *http,			/* I - HTTP connection */
 
       memcpy(http->sbuffer + http->stream.avail_in, http->buffer, buflen);
       http->stream.avail_in += buflen;
+      http->buffer          += buflen;
       http->used            -= (int)buflen;
       http->data_remaining  -= (off_t)buflen;
-
-      if (http->used > 0)
-        memmove(http->buffer, http->buffer + buflen, (size_t)http->used);
     }
 
     DEBUG_printf(("2httpPeek: length=%d, avail_in=%d", (int)length,
@@ -1979,7 +1995,7 @@ httpRead2(http_t *http,			/* I - HTTP connection */
 
       if (bytes == 0)
       {
-        ssize_t buflen = HTTP_MAX_BUFFER - (ssize_t)http->stream.avail_in;
+        ssize_t buflen = _HTTP_MAX_SBUFFER - (ssize_t)http->stream.avail_in;
 					/* Additional bytes for buffer */
 
         if (buflen > 0)
@@ -2282,6 +2298,99 @@ httpReadRequest(http_t *http,		/* I - HTTP connection */
 }
 
 
+#ifdef HAVE_SPLICE
+/*
+ * '_httpReadSplice()' - Move message body data from a HTTP connection to a
+ *                       pipe.
+ *
+ * The data is moved using splice() without copying it through a buffer.
+ * Only unencrypted, unencoded data that is not already buffered can be moved
+ * this way - 0 is returned when the caller needs to use httpRead2() instead.
+ */
+
+ssize_t					/* O - Number of bytes moved, 0 to use httpRead2(), or -1 on error */
+_httpReadSplice(http_t *http,		/* I - HTTP connection */
+                int    pipefd,		/* I - Write end of pipe */
+		size_t length)		/* I - Maximum number of bytes */
+{
+  ssize_t	bytes;			/* Bytes moved */
+
+
+  DEBUG_printf(("_httpReadSplice(http=%p, pipefd=%d, length=" CUPS_LLFMT ")", (void *)http, pipefd, CUPS_LLCAST length));
+
+  if (!http || pipefd < 0 || length == 0 || http->used > 0 ||
+#ifdef HAVE_SSL
+      http->tls ||
+#endif /* HAVE_SSL */
+#ifdef HAVE_LIBZ
+      http->coding != _HTTP_CODING_IDENTITY ||
+#endif /* HAVE_LIBZ */
+      http->data_remaining <= 0)
+    return (0);
+
+  http->activity = time(NULL);
+  http->error    = 0;
+
+  if (length > (size_t)http->data_remaining)
+    length = (size_t)http->data_remaining;
+
+  while ((bytes = splice(http->fd, NULL, pipefd, NULL, length, SPLICE_F_MOVE | SPLICE_F_NONBLOCK)) < 0)
+  {
+    DEBUG_printf(("2_httpReadSplice: %s", strerror(errno)));
+
+    if (errno == EAGAIN || errno == EINVAL || errno == ENOSYS)
+      return (0);			/* Let httpRead2() deal with it */
+    else if (errno != EINTR)
+    {
+      http->error = errno;
+      return (-1);
+    }
+  }
+
+  if (bytes == 0)
+  {
+    http->error = EPIPE;
+    return (-1);
+  }
+
+  DEBUG_printf(("2_httpReadSplice: Moved " CUPS_LLFMT " bytes.", CUPS_LLCAST bytes));
+
+  if ((http->data_remaining -= bytes) <= 0)
+  {
+    if (http->data_encoding == HTTP_ENCODING_CHUNKED)
+    {
+     /*
+      * Read the trailing blank line now...
+      */
+
+      char	len[32];		/* Length string */
+
+      httpGets(len, sizeof(len), http);
+    }
+    else
+    {
+     /*
+      * End of content...
+      */
+
+      if (http->state == HTTP_STATE_POST_RECV)
+	http->state ++;
+      else if (http->state == HTTP_STATE_GET_SEND ||
+	       http->state == HTTP_STATE_POST_SEND)
+	http->state = HTTP_STATE_WAITING;
+      else
+	http->state = HTTP_STATE_STATUS;
+
+      DEBUG_printf(("1_httpReadSplice: End of content, set state to %s.",
+		    httpStateString(http->state)));
+    }
+  }
+
+  return (bytes);
+}
+#endif /* HAVE_SPLICE */
+
+
 /*
  * 'httpReconnect()' - Reconnect to a HTTP server.
  *
@@ -2357,9 +2466,11 @@ httpReconnect2(http_t *http,		/* I - HTTP connection */
   http->data_encoding   = HTTP_ENCODING_FIELDS;
   http->_data_remaining = 0;
   http->used            = 0;
+  http->buffer          = http->rbuffer;
   http->data_remaining  = 0;
   http->hostaddr        = NULL;
   http->wused           = 0;
+  http->wfields         = 0;
 
  /*
   * Connect to the server...
@@ -2425,6 +2536,88 @@ httpReconnect2(http_t *http,		/* I - HTTP connection */
 }
 
 
+#ifdef HAVE_SENDFILE
+/*
+ * '_httpSendFile()' - Send message body data from a file.
+ *
+ * The data is sent from the current offset in the file using sendfile()
+ * without copying it through a buffer.  Only unencrypted, unencoded data with
+ * a known length can be sent this way - 0 is returned when the caller needs to
+ * use httpWrite2() instead.
+ */
+
+ssize_t					/* O - Number of bytes sent, 0 to use httpWrite2(), or -1 on error */
+_httpSendFile(http_t *http,		/* I - HTTP connection */
+              int    fd,		/* I - File to send */
+	      size_t length)		/* I - Maximum number of bytes */
+{
+  ssize_t	bytes;			/* Bytes sent */
+
+
+  DEBUG_printf(("_httpSendFile(http=%p, fd=%d, length=" CUPS_LLFMT ")", (void *)http, fd, CUPS_LLCAST length));
+
+  if (!http || fd < 0 || length == 0 ||
+#ifdef HAVE_SSL
+      http->tls ||
+#endif /* HAVE_SSL */
+#ifdef HAVE_LIBZ
+      http->coding != _HTTP_CODING_IDENTITY ||
+#endif /* HAVE_LIBZ */
+      http->data_encoding != HTTP_ENCODING_LENGTH ||
+      http->data_remaining <= 0)
+    return (0);
+
+  http->activity = time(NULL);
+
+ /*
+  * Send any buffered header data first...
+  */
+
+  if (http->wused && httpFlushWrite(http) < 0)
+    return (-1);
+
+  if (length > (size_t)http->data_remaining)
+    length = (size_t)http->data_remaining;
+
+  while ((bytes = sendfile(http->fd, fd, NULL, length)) < 0)
+  {
+    DEBUG_printf(("2_httpSendFile: %s", strerror(errno)));
+
+    if (errno == EAGAIN || errno == EINVAL || errno == ENOSYS)
+      return (0);			/* Let httpWrite2() deal with it */
+    else if (errno != EINTR)
+    {
+      http->error = errno;
+      return (-1);
+    }
+  }
+
+  DEBUG_printf(("2_httpSendFile: Sent " CUPS_LLFMT " bytes.", CUPS_LLCAST bytes));
+
+  if ((http->data_remaining -= bytes) <= 0)
+  {
+   /*
+    * Finished with the transfer; unless we are sending POST or PUT data, go
+    * idle...
+    */
+
+    if (http->state == HTTP_STATE_POST_RECV)
+      http->state ++;
+    else if (http->state == HTTP_STATE_POST_SEND ||
+             http->state == HTTP_STATE_GET_SEND)
+      http->state = HTTP_STATE_WAITING;
+    else
+      http->state = HTTP_STATE_STATUS;
+
+    DEBUG_printf(("2_httpSendFile: Changed state to %s.",
+		  httpStateString(http->state)));
+  }
+
+  return (bytes);
+}
+#endif /* HAVE_SENDFILE */
+
+
 /*
  * 'httpSetAuthString()' - Set the current authorization string.
  *
@@ -2487,6 +2680,73 @@ httpSetAuthString(http_t     *http,	/* I - HTTP connection */
 }
 
 
+/*
+ * 'httpSetBufferSize()' - Set the size of the read and write buffers.
+ *
+ * The default buffer size is 64k, which is suitable for bulk transfers of
+ * print data.  Sizes smaller than @code HTTP_MAX_BUFFER@ are increased to
+ * @code HTTP_MAX_BUFFER@.  Any pending output is written before the buffers
+ * are resized.
+ *
+ * @since CUPS 2.3@
+ */
+
+int					/* O - 0 on success, -1 on error */
+httpSetBufferSize(http_t *http,		/* I - HTTP connection */
+                  size_t bufsize)	/* I - Buffer size in bytes */
+{
+  char	*rbuffer,			/* New read buffer */
+	*wbuffer;			/* New write buffer */
+
+
+  DEBUG_printf(("httpSetBufferSize(http=%p, bufsize=" CUPS_LLFMT ")", (void *)http, CUPS_LLCAST bufsize));
+
+  if (!http || bufsize > INT_MAX)
+    return (-1);
+
+  if (bufsize < HTTP_MAX_BUFFER)
+    bufsize = HTTP_MAX_BUFFER;
+
+  if (bufsize == http->bufsize)
+    return (0);
+
+  if ((size_t)http->used > bufsize)
+  {
+    DEBUG_printf(("1httpSetBufferSize: %d bytes of input are buffered.", http->used));
+    return (-1);
+  }
+
+  if (http->wused && httpFlushWrite(http) < 0)
+    return (-1);
+
+  if ((rbuffer = malloc(bufsize)) == NULL)
+    return (-1);
+
+  if ((wbuffer = malloc(bufsize)) == NULL)
+  {
+    free(rbuffer);
+    return (-1);
+  }
+
+ /*
+  * Move any unread data to the new read buffer...
+  */
+
+  if (http->used > 0)
+    memcpy(rbuffer, http->buffer, (size_t)http->used);
+
+  free(http->rbuffer);
+  free(http->wbuffer);
+
+  http->bufsize = bufsize;
+  http->rbuffer = rbuffer;
+  http->buffer  = rbuffer;
+  http->wbuffer = wbuffer;
+
+  return (0);
+}
+
+
 /*
  * 'httpSetCredentials()' - Set the credentials associated with an encrypted
  *			    connection.
@@ -3184,10 +3444,8 @@ httpWrite2(http_t     *http,		/* I - HTTP connection */
 
         DEBUG_printf(("1httpWrite2: Writing intermediate chunk, len=%d", (int)slen));
 
-	if (slen > 0 && http->data_encoding == HTTP_ENCODING_CHUNKED)
-	  sret = http_write_chunk(http, (char *)http->sbuffer, slen);
-	else if (slen > 0)
-	  sret = http_write(http, (char *)http->sbuffer, slen);
+	if (slen > 0)
+	  sret = http_write_buffer(http, (char *)http->sbuffer, slen, 0);
 	else
 	  sret = 0;
 
@@ -3208,15 +3466,7 @@ httpWrite2(http_t     *http,		/* I - HTTP connection */
 #endif /* HAVE_LIBZ */
   if (length > 0)
   {
-    if (http->wused && (length + (size_t)http->wused) > sizeof(http->wbuffer))
-    {
-      DEBUG_printf(("2httpWrite2: Flushing buffer (wused=%d, length="
-                    CUPS_LLFMT ")", http->wused, CUPS_LLCAST length));
-
-      httpFlushWrite(http);
-    }
-
-    if ((length + (size_t)http->wused) <= sizeof(http->wbuffer) && length < sizeof(http->wbuffer))
+    if ((length + (size_t)http->wused) <= http->bufsize && length < http->bufsize)
     {
      /*
       * Write to buffer...
@@ -3232,16 +3482,16 @@ httpWrite2(http_t     *http,		/* I - HTTP connection */
     else
     {
      /*
-      * Otherwise write the data directly...
+      * Otherwise write any buffered data and the new data together...
       */
 
-      DEBUG_printf(("2httpWrite2: Writing " CUPS_LLFMT " bytes to socket...",
-                    CUPS_LLCAST length));
+      DEBUG_printf(("2httpWrite2: Writing " CUPS_LLFMT " bytes to socket (wused=%d)...",
+                    CUPS_LLCAST length, http->wused));
 
-      if (http->data_encoding == HTTP_ENCODING_CHUNKED)
-	bytes = (ssize_t)http_write_chunk(http, buffer, length);
+      if (http_write_buffer(http, buffer, length, 0) < 0)
+        bytes = -1;
       else
-	bytes = (ssize_t)http_write(http, buffer, length);
+        bytes = (ssize_t)length;
 
       DEBUG_printf(("2httpWrite2: Wrote " CUPS_LLFMT " bytes...",
                     CUPS_LLCAST bytes));
@@ -3270,19 +3520,15 @@ httpWrite2(http_t     *http,		/* I - HTTP connection */
       http_content_coding_finish(http);
 #endif /* HAVE_LIBZ */
 
-    if (http->wused)
-    {
-      if (httpFlushWrite(http) < 0)
-        return (-1);
-    }
-
     if (http->data_encoding == HTTP_ENCODING_CHUNKED)
     {
      /*
-      * Send a 0-length chunk at the end of the request...
+      * Send any buffered data and a 0-length chunk at the end of the
+      * request...
       */
 
-      http_write(http, "0\r\n\r\n", 5);
+      if (http_write_buffer(http, NULL, 0, 1) < 0)
+        return (-1);
 
      /*
       * Reset the data state...
@@ -3291,6 +3537,11 @@ httpWrite2(http_t     *http,		/* I - HTTP connection */
       http->data_encoding  = HTTP_ENCODING_FIELDS;
       http->data_remaining = 0;
     }
+    else if (http->wused)
+    {
+      if (httpFlushWrite(http) < 0)
+        return (-1);
+    }
 
     if (http->state == HTTP_STATE_POST_RECV)
       http->state ++;
@@ -3463,15 +3714,15 @@ httpWriteResponse(http_t        *http,	/* I - HTTP connection */
     return (-1);
   }
 
-  if (httpFlushWrite(http) < 0)
-  {
-    http->status = HTTP_STATUS_ERROR;
-    return (-1);
-  }
-
   if (status == HTTP_STATUS_CONTINUE ||
       status == HTTP_STATUS_SWITCHING_PROTOCOLS)
   {
+    if (httpFlushWrite(http) < 0)
+    {
+      http->status = HTTP_STATUS_ERROR;
+      return (-1);
+    }
+
    /*
     * Restore the old data_encoding and data_length values...
     */
@@ -3491,12 +3742,25 @@ httpWriteResponse(http_t        *http,	/* I - HTTP connection */
            http->state == HTTP_STATE_CONNECT ||
            http->state == HTTP_STATE_STATUS)
   {
+    if (httpFlushWrite(http) < 0)
+    {
+      http->status = HTTP_STATUS_ERROR;
+      return (-1);
+    }
+
     DEBUG_printf(("1httpWriteResponse: Resetting state to HTTP_STATE_WAITING, "
                   "was %s.", httpStateString(http->state)));
     http->state = HTTP_STATE_WAITING;
   }
   else
   {
+   /*
+    * Keep the response header in the write buffer so that it goes out with
+    * the first part of the message body...
+    */
+
+    http->wfields = http->wused;
+
    /*
     * Force data_encoding and data_length to be set according to the response
     * headers...
@@ -3506,6 +3770,12 @@ httpWriteResponse(http_t        *http,	/* I - HTTP connection */
 
     if (http->data_encoding == HTTP_ENCODING_LENGTH && http->data_remaining == 0)
     {
+      if (httpFlushWrite(http) < 0)
+      {
+	http->status = HTTP_STATUS_ERROR;
+	return (-1);
+      }
+
       DEBUG_printf(("1httpWriteResponse: Resetting state to HTTP_STATE_WAITING, "
                     "was %s.", httpStateString(http->state)));
       http->state = HTTP_STATE_WAITING;
@@ -3699,10 +3969,7 @@ http_content_coding_finish(
 	  {
 	    DEBUG_printf(("1http_content_coding_finish: Writing trailing chunk, len=%d", (int)bytes));
 
-	    if (http->data_encoding == HTTP_ENCODING_CHUNKED)
-	      http_write_chunk(http, (char *)http->sbuffer, bytes);
-	    else
-	      http_write(http, (char *)http->sbuffer, bytes);
+	    http_write_buffer(http, (char *)http->sbuffer, bytes, 0);
           }
 
           http->stream.next_out  = (Bytef *)http->sbuffer;
@@ -3799,7 +4066,7 @@ http_content_coding_start(
   {
     case _HTTP_CODING_DEFLATE :
     case _HTTP_CODING_GZIP :
-        if (http->wused)
+        if (http->wused > http->wfields)
           httpFlushWrite(http);
 
         if ((http->sbuffer = malloc(_HTTP_MAX_SBUFFER)) == NULL)
@@ -3925,6 +4192,16 @@ http_create(
     return (NULL);
   }
 
+  if ((http->rbuffer = malloc(_HTTP_MAX_BUFFER)) == NULL ||
+      (http->wbuffer = malloc(_HTTP_MAX_BUFFER)) == NULL)
+  {
+    _cupsSetError(IPP_STATUS_ERROR_INTERNAL, strerror(errno), 0);
+    httpAddrFreeList(myaddrlist);
+    free(http->rbuffer);
+    free(http);
+    return (NULL);
+  }
+
  /*
   * Initialize the HTTP data...
   */
@@ -3933,6 +4210,8 @@ http_create(
   http->activity = time(NULL);
   http->addrlist = myaddrlist;
   http->blocking = blocking;
+  http->bufsize  = _HTTP_MAX_BUFFER;
+  http->buffer   = http->rbuffer;
   http->fd       = -1;
 #ifdef HAVE_GSSAPI
   http->gssctx   = GSS_C_NO_CONTEXT;
@@ -4146,6 +4425,19 @@ http_read_buffered(http_t *http,	/* I - HTTP connection */
 
   DEBUG_printf(("http_read_buffered(http=%p, buffer=%p, length=" CUPS_LLFMT ") used=%d", (void *)http, (void *)buffer, CUPS_LLCAST length, http->used));
 
+  if (http->used == 0 && length < http->bufsize)
+  {
+   /*
+    * Fill the input buffer so that small reads don't each need a recv()...
+    */
+
+    if ((bytes = http_read(http, http->rbuffer, http->bufsize)) <= 0)
+      return (bytes);
+
+    http->buffer = http->rbuffer;
+    http->used   = (int)bytes;
+  }
+
   if (http->used > 0)
   {
     if (length > (size_t)http->used)
@@ -4157,10 +4449,8 @@ http_read_buffered(http_t *http,	/* I - HTTP connection */
                   (int)bytes));
 
     memcpy(buffer, http->buffer, (size_t)bytes);
-    http->used -= (int)bytes;
-
-    if (http->used > 0)
-      memmove(http->buffer, http->buffer + bytes, (size_t)http->used);
+    http->buffer += bytes;
+    http->used   -= (int)bytes;
   }
   else
     bytes = http_read(http, buffer, length);
@@ -4619,18 +4909,133 @@ static ssize_t				/* O - Number of bytes written */
 http_write(http_t     *http,		/* I - HTTP connection */
            const char *buffer,		/* I - Buffer for data */
 	   size_t     length)		/* I - Number of bytes to write */
+{
+  struct iovec	iov;			/* Buffer for data */
+
+
+  DEBUG_printf(("2http_write(http=%p, buffer=%p, length=" CUPS_LLFMT ")", (void *)http, (void *)buffer, CUPS_LLCAST length));
+
+  iov.iov_base = (void *)buffer;
+  iov.iov_len  = length;
+
+  return (http_writev(http, &iov, 1));
+}
+
+
+/*
+ * 'http_write_buffer()' - Write the write buffer and any new data.
+ *
+ * Header fields at the start of the write buffer are written as-is.  The rest
+ * of the buffer and the new data are written as a single chunk when using
+ * chunked encoding.  Everything is sent using a single http_writev() call.
+ */
+
+static ssize_t				/* O - Number of bytes written */
+http_write_buffer(http_t     *http,	/* I - HTTP connection */
+                  const char *buffer,	/* I - New data or @code NULL@ */
+		  size_t     length,	/* I - Length of new data */
+		  int        eof)	/* I - 1 to send a 0-length chunk */
+{
+  struct iovec	iov[6];			/* Buffers for data */
+  int		iovcnt = 0;		/* Number of buffers */
+  size_t	fields,			/* Bytes of header fields */
+		body;			/* Bytes of body data */
+  int		chunked;		/* Use chunked encoding? */
+  char		header[16];		/* Chunk header */
+
+
+  DEBUG_printf(("7http_write_buffer(http=%p, buffer=%p, length=" CUPS_LLFMT ", eof=%d) wused=%d, wfields=%d", (void *)http, (void *)buffer, CUPS_LLCAST length, eof, http->wused, http->wfields));
+
+  fields  = (size_t)http->wfields;
+  body    = (size_t)(http->wused - http->wfields) + length;
+  chunked = http->data_encoding == HTTP_ENCODING_CHUNKED;
+
+  if (fields > 0)
+  {
+    iov[iovcnt].iov_base = http->wbuffer;
+    iov[iovcnt].iov_len  = fields;
+    iovcnt ++;
+  }
+
+  if (chunked && body > 0)
+  {
+    snprintf(header, sizeof(header), "%x\r\n", (unsigned)body);
+
+    iov[iovcnt].iov_base = header;
+    iov[iovcnt].iov_len  = strlen(header);
+    iovcnt ++;
+  }
+
+  if (http->wused > http->wfields)
+  {
+    iov[iovcnt].iov_base = http->wbuffer + fields;
+    iov[iovcnt].iov_len  = (size_t)(http->wused - http->wfields);
+    iovcnt ++;
+  }
+
+  if (length > 0)
+  {
+    iov[iovcnt].iov_base = (void *)buffer;
+    iov[iovcnt].iov_len  = length;
+    iovcnt ++;
+  }
+
+  if (chunked && body > 0)
+  {
+    iov[iovcnt].iov_base = "\r\n";
+    iov[iovcnt].iov_len  = 2;
+    iovcnt ++;
+  }
+
+  if (chunked && eof)
+  {
+    iov[iovcnt].iov_base = "0\r\n\r\n";
+    iov[iovcnt].iov_len  = 5;
+    iovcnt ++;
+  }
+
+  http->wused   = 0;
+  http->wfields = 0;
+
+  if (iovcnt > 0 && http_writev(http, iov, iovcnt) < 0)
+  {
+    DEBUG_puts("8http_write_buffer: http_writev failed.");
+    return (-1);
+  }
+
+  return ((ssize_t)(fields + body));
+}
+
+
+/*
+ * 'http_writev()' - Write a list of buffers to a HTTP connection.
+ *
+ * The I/O vectors are updated as data is written.
+ */
+
+static ssize_t				/* O - Number of bytes written */
+http_writev(http_t       *http,		/* I - HTTP connection */
+            struct iovec *iov,		/* I - Buffers for data */
+	    int          iovcnt)	/* I - Number of buffers */
 {
   ssize_t	tbytes,			/* Total bytes sent */
 		bytes;			/* Bytes sent */
 
 
-  DEBUG_printf(("2http_write(http=%p, buffer=%p, length=" CUPS_LLFMT ")", (void *)http, (void *)buffer, CUPS_LLCAST length));
+  DEBUG_printf(("2http_writev(http=%p, iov=%p, iovcnt=%d)", (void *)http, (void *)iov, iovcnt));
   http->error = 0;
   tbytes      = 0;
 
-  while (length > 0)
+  while (iovcnt > 0)
   {
-    DEBUG_printf(("3http_write: About to write %d bytes.", (int)length));
+    if (iov->iov_len == 0)
+    {
+      iov ++;
+      iovcnt --;
+      continue;
+    }
+
+    DEBUG_printf(("3http_writev: About to write %d buffers.", iovcnt));
 
     if (http->timeout_value > 0.0)
     {
@@ -4689,15 +5094,23 @@ http_write(http_t     *http,		/* I - HTTP connection */
       while (nfds <= 0);
     }
 
+#ifdef DEBUG
+    http_debug_hex("http_writev", iov->iov_base, (int)iov->iov_len);
+#endif /* DEBUG */
+
 #ifdef HAVE_SSL
     if (http->tls)
-      bytes = _httpTLSWrite(http, buffer, (int)length);
+      bytes = _httpTLSWrite(http, iov->iov_base, (int)iov->iov_len);
     else
 #endif /* HAVE_SSL */
-    bytes = send(http->fd, buffer, length, 0);
+#ifdef WIN32
+    bytes = send(http->fd, iov->iov_base, (int)iov->iov_len, 0);
+#else
+    bytes = writev(http->fd, iov, iovcnt);
+#endif /* WIN32 */
 
-    DEBUG_printf(("3http_write: Write of " CUPS_LLFMT " bytes returned "
-                  CUPS_LLFMT ".", CUPS_LLCAST length, CUPS_LLCAST bytes));
+    DEBUG_printf(("3http_writev: Write returned " CUPS_LLFMT ".",
+                  CUPS_LLCAST bytes));
 
     if (bytes < 0)
     {
@@ -4737,64 +5150,29 @@ http_write(http_t     *http,		/* I - HTTP connection */
       }
 #endif /* WIN32 */
 
-      DEBUG_printf(("3http_write: error writing data (%s).",
+      DEBUG_printf(("3http_writev: error writing data (%s).",
                     strerror(http->error)));
 
       return (-1);
     }
 
-    buffer += bytes;
     tbytes += bytes;
-    length -= (size_t)bytes;
-  }
-
-#ifdef DEBUG
-  http_debug_hex("http_write", buffer - tbytes, (int)tbytes);
-#endif /* DEBUG */
-
-  DEBUG_printf(("3http_write: Returning " CUPS_LLFMT ".", CUPS_LLCAST tbytes));
-
-  return (tbytes);
-}
-
-
-/*
- * 'http_write_chunk()' - Write a chunked buffer.
- */
-
-static ssize_t				/* O - Number bytes written */
-http_write_chunk(http_t     *http,	/* I - HTTP connection */
-                 const char *buffer,	/* I - Buffer to write */
-		 size_t        length)	/* I - Length of buffer */
-{
-  char		header[16];		/* Chunk header */
-  ssize_t	bytes;			/* Bytes written */
-
 
-  DEBUG_printf(("7http_write_chunk(http=%p, buffer=%p, length=" CUPS_LLFMT ")", (void *)http, (void *)buffer, CUPS_LLCAST length));
-
- /*
-  * Write the chunk header, data, and trailer.
-  */
-
-  snprintf(header, sizeof(header), "%x\r\n", (unsigned)length);
-  if (http_write(http, header, strlen(header)) < 0)
-  {
-    DEBUG_puts("8http_write_chunk: http_write of length failed.");
-    return (-1);
-  }
+    while (iovcnt > 0 && (size_t)bytes >= iov->iov_len)
+    {
+      bytes -= (ssize_t)iov->iov_len;
+      iov ++;
+      iovcnt --;
+    }
 
-  if ((bytes = http_write(http, buffer, length)) < 0)
-  {
-    DEBUG_puts("8http_write_chunk: http_write of buffer failed.");
-    return (-1);
+    if (bytes > 0)
+    {
+      iov->iov_base = (char *)iov->iov_base + bytes;
+      iov->iov_len  -= (size_t)bytes;
+    }
   }
 
-  if (http_write(http, "\r\n", 2) < 0)
-  {
-    DEBUG_puts("8http_write_chunk: http_write of CR LF failed.");
-    return (-1);
-  }
+  DEBUG_printf(("3http_writev: Returning " CUPS_LLFMT ".", CUPS_LLCAST tbytes));
 
-  return (bytes);
+  return (tbytes);
 }
@@ -939,7 +939,7 @@ cupsWriteRequestData(
   * Finally, check if we have any pending data from the server...
   */
 
-  if (length >= HTTP_MAX_BUFFER ||
+  if (length >= http->bufsize ||
       http->wused < wused ||
       (wused > 0 && (size_t)http->wused == length))
   {
@@ -547,6 +547,94 @@ main(int  argc,				/* I - Number of command-line arguments */
     else
       printf("PASS (%s)\n", buffer);
 
+#ifndef WIN32
+   /*
+    * httpSetBufferSize and buffered/chunked I/O...
+    */
+
+    fputs("httpSetBufferSize(): ", stdout);
+
+    {
+      http_t	*reader,		/* Reading end */
+		*writer;		/* Writing end */
+      int	fds[2];			/* Socket pair */
+      char	*data,			/* Data to write */
+		*rdata;			/* Data that was read */
+      size_t	datalen = 50000;	/* Length of data */
+
+      data  = malloc(datalen);
+      rdata = malloc(datalen + 1);
+
+      for (i = 0; i < (int)datalen; i ++)
+        data[i] = (char)('A' + i % 26);
+
+      reader = httpConnect2("localhost", 631, NULL, AF_UNSPEC, HTTP_ENCRYPTION_NEVER, 1, 0, NULL);
+      writer = httpConnect2("localhost", 631, NULL, AF_UNSPEC, HTTP_ENCRYPTION_NEVER, 1, 0, NULL);
+
+      if (!data || !rdata || !reader || !writer)
+      {
+        puts("FAIL (unable to allocate)");
+        failures ++;
+      }
+      else if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+      {
+        printf("FAIL (socketpair: %s)\n", strerror(errno));
+        failures ++;
+      }
+      else if (httpSetBufferSize(writer, 4096) || writer->bufsize != 4096)
+      {
+        puts("FAIL (unable to set buffer size)");
+        failures ++;
+      }
+      else if (httpSetBufferSize(reader, 1) || reader->bufsize != HTTP_MAX_BUFFER)
+      {
+        puts("FAIL (minimum buffer size not used)");
+        failures ++;
+      }
+      else
+      {
+        writer->fd            = fds[0];
+        writer->state         = HTTP_STATE_POST_RECV;
+        writer->data_encoding = HTTP_ENCODING_CHUNKED;
+        reader->fd            = fds[1];
+        reader->state         = HTTP_STATE_POST_RECV;
+        reader->data_encoding = HTTP_ENCODING_CHUNKED;
+
+        if (httpWrite2(writer, data, 100) != 100 ||
+            httpWrite2(writer, data + 100, datalen - 100) != (ssize_t)(datalen - 100) ||
+            httpWrite2(writer, "", 0) < 0)
+        {
+          printf("FAIL (write: %s)\n", strerror(httpError(writer)));
+          failures ++;
+        }
+        else
+        {
+          for (length = 0; length < (off_t)datalen; length += bytes)
+            if ((bytes = (long)httpRead2(reader, rdata + length, datalen + 1 - (size_t)length)) <= 0)
+              break;
+
+          if (length != (off_t)datalen || memcmp(data, rdata, datalen))
+          {
+            printf("FAIL (read " CUPS_LLFMT " of %d bytes)\n", CUPS_LLCAST length, (int)datalen);
+            failures ++;
+          }
+          else if (httpRead2(reader, rdata, datalen) != 0)
+          {
+            puts("FAIL (missing end of chunked data)");
+            failures ++;
+          }
+          else
+            puts("PASS");
+        }
+      }
+
+      httpClose(reader);
+      httpClose(writer);
+      free(data);
+      free(rdata);
+    }
+#endif /* !WIN32 */
+
    /*
     * Show a summary and return...
     */
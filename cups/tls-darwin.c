@@ -1188,6 +1188,19 @@ _httpTLSRead(http_t *http,		/* I - HTTP connection */
 }
 
 
+/*
+ * '_httpTLSResumed()' - Return whether the TLS session was resumed.
+ */
+
+int					/* O - 1 if resumed, 0 otherwise */
+_httpTLSResumed(http_t *http)		/* I - HTTP connection */
+{
+  (void)http;
+
+  return (0);
+}
+
+
 /*
  * '_httpTLSSetOptions()' - Set TLS protocol and cipher suite options.
  */
@@ -1206,6 +1219,19 @@ _httpTLSSetOptions(int options,		/* I - Options */
 }
 
 
+/*
+ * '_httpTLSSetSessionCache()' - Set the server session resumption timeout.
+ *
+ * Secure Transport manages server session resumption internally.
+ */
+
+void
+_httpTLSSetSessionCache(int timeout)	/* I - Timeout in seconds */
+{
+  (void)timeout;
+}
+
+
 /*
  * '_httpTLSStart()' - Set up SSL/TLS support on a connection.
  */
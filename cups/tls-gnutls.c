@@ -17,6 +17,29 @@
 #include <sys/stat.h>
 
 
+/*
+ * Local constants...
+ */
+
+#define HTTP_GNUTLS_SESSION_MAX	1024	/* Maximum cached server sessions */
+#define HTTP_GNUTLS_TICKET_KEY	10	/* Ticket key lifetime in session timeouts */
+
+
+/*
+ * Local types...
+ */
+
+typedef struct http_gnutls_session_s	/**** Cached server session ****/
+{
+  time_t	expires;		/* When the session expires */
+  size_t	idlen,			/* Length of session ID */
+		datalen;		/* Length of session data */
+  unsigned char	id[GNUTLS_MAX_SESSION_ID_SIZE];
+					/* Session ID */
+  unsigned char	data[1];		/* Session data (variable length) */
+} http_gnutls_session_t;
+
+
 /*
  * Local globals...
  */
@@ -33,17 +56,29 @@ static _cups_mutex_t	tls_mutex = _CUPS_MUTEX_INITIALIZER;
 static int		tls_options = -1,/* Options for TLS connections */
 			tls_min_version = _HTTP_TLS_1_0,
 			tls_max_version = _HTTP_TLS_MAX;
+static int		tls_session_timeout = 0;
+					/* Server session timeout, 0 = none */
+static cups_array_t	*tls_sessions = NULL;
+					/* Cached server sessions */
+static gnutls_datum_t	tls_ticket_key = { NULL, 0 };
+					/* Session ticket master key */
+static time_t		tls_ticket_time = 0;
+					/* When the ticket key was generated */
 
 
 /*
  * Local functions...
  */
 
+static int		http_gnutls_compare_sessions(http_gnutls_session_t *a, http_gnutls_session_t *b);
 static gnutls_x509_crt_t http_gnutls_create_credential(http_credential_t *credential);
 static const char	*http_gnutls_default_path(char *buffer, size_t bufsize);
 static void		http_gnutls_load_crl(void);
 static const char	*http_gnutls_make_path(char *buffer, size_t bufsize, const char *dirname, const char *filename, const char *ext);
 static ssize_t		http_gnutls_read(gnutls_transport_ptr_t ptr, void *data, size_t length);
+static int		http_gnutls_remove_session(void *ptr, gnutls_datum_t key);
+static gnutls_datum_t	http_gnutls_retrieve_session(void *ptr, gnutls_datum_t key);
+static int		http_gnutls_store_session(void *ptr, gnutls_datum_t key, gnutls_datum_t data);
 static ssize_t		http_gnutls_write(gnutls_transport_ptr_t ptr, const void *data, size_t length);
 
 
@@ -863,6 +898,22 @@ httpSaveCredentials(
 }
 
 
+/*
+ * 'http_gnutls_compare_sessions()' - Compare two cached server sessions.
+ */
+
+static int				/* O - Result of comparison */
+http_gnutls_compare_sessions(
+    http_gnutls_session_t *a,		/* I - First session */
+    http_gnutls_session_t *b)		/* I - Second session */
+{
+  if (a->idlen != b->idlen)
+    return (a->idlen < b->idlen ? -1 : 1);
+  else
+    return (memcmp(a->id, b->id, a->idlen));
+}
+
+
 /*
  * 'http_gnutls_create_credential()' - Create a single credential in the internal format.
  */
@@ -1119,6 +1170,154 @@ http_gnutls_read(
 }
 
 
+/*
+ * 'http_gnutls_remove_session()' - Remove a session from the server cache.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+http_gnutls_remove_session(
+    void           *ptr,		/* I - Callback data (unused) */
+    gnutls_datum_t key)			/* I - Session ID */
+{
+  http_gnutls_session_t	skey,		/* Search key */
+			*session;	/* Matching session */
+
+
+  (void)ptr;
+
+  if (key.size > sizeof(skey.id))
+    return (-1);
+
+  skey.idlen = key.size;
+  memcpy(skey.id, key.data, key.size);
+
+  _cupsMutexLock(&tls_mutex);
+
+  if ((session = (http_gnutls_session_t *)cupsArrayFind(tls_sessions, &skey)) != NULL)
+    cupsArrayRemove(tls_sessions, session);
+
+  _cupsMutexUnlock(&tls_mutex);
+
+  return (session ? 0 : -1);
+}
+
+
+/*
+ * 'http_gnutls_retrieve_session()' - Find a session in the server cache.
+ */
+
+static gnutls_datum_t			/* O - Copy of session data */
+http_gnutls_retrieve_session(
+    void           *ptr,		/* I - Callback data (unused) */
+    gnutls_datum_t key)			/* I - Session ID */
+{
+  http_gnutls_session_t	skey,		/* Search key */
+			*session;	/* Matching session */
+  gnutls_datum_t	data = { NULL, 0 };
+					/* Session data */
+
+
+  (void)ptr;
+
+  if (key.size > sizeof(skey.id))
+    return (data);
+
+  skey.idlen = key.size;
+  memcpy(skey.id, key.data, key.size);
+
+  _cupsMutexLock(&tls_mutex);
+
+  if ((session = (http_gnutls_session_t *)cupsArrayFind(tls_sessions, &skey)) != NULL)
+  {
+    if (session->expires <= time(NULL))
+      cupsArrayRemove(tls_sessions, session);
+    else if ((data.data = gnutls_malloc(session->datalen)) != NULL)
+    {
+      memcpy(data.data, session->data, session->datalen);
+      data.size = (unsigned)session->datalen;
+    }
+  }
+
+  _cupsMutexUnlock(&tls_mutex);
+
+  return (data);
+}
+
+
+/*
+ * 'http_gnutls_store_session()' - Add a session to the server cache.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+http_gnutls_store_session(
+    void           *ptr,		/* I - Callback data (unused) */
+    gnutls_datum_t key,			/* I - Session ID */
+    gnutls_datum_t data)		/* I - Session data */
+{
+  http_gnutls_session_t	*session,	/* New session */
+			*current,	/* Current session */
+			*oldest;	/* Oldest session */
+  time_t		curtime;	/* Current time */
+
+
+  (void)ptr;
+
+  if (key.size > sizeof(session->id) || data.size == 0)
+    return (-1);
+
+  if ((session = malloc(sizeof(http_gnutls_session_t) + data.size)) == NULL)
+    return (-1);
+
+  curtime = time(NULL);
+
+  session->expires = curtime + tls_session_timeout;
+  session->idlen   = key.size;
+  session->datalen = data.size;
+
+  memcpy(session->id, key.data, key.size);
+  memcpy(session->data, data.data, data.size);
+
+  _cupsMutexLock(&tls_mutex);
+
+  if (!tls_sessions)
+    tls_sessions = cupsArrayNew3((cups_array_func_t)http_gnutls_compare_sessions, NULL, NULL, 0, NULL, (cups_afree_func_t)free);
+
+  if ((current = (http_gnutls_session_t *)cupsArrayFind(tls_sessions, session)) != NULL)
+    cupsArrayRemove(tls_sessions, current);
+
+  if (cupsArrayCount(tls_sessions) >= HTTP_GNUTLS_SESSION_MAX)
+  {
+   /*
+    * Cache is full, remove expired sessions or the session that expires
+    * first...
+    */
+
+    for (oldest = NULL, current = (http_gnutls_session_t *)cupsArrayFirst(tls_sessions);
+         current;
+         current = (http_gnutls_session_t *)cupsArrayNext(tls_sessions))
+    {
+      if (current->expires <= curtime)
+        cupsArrayRemove(tls_sessions, current);
+      else if (!oldest || current->expires < oldest->expires)
+        oldest = current;
+    }
+
+    if (oldest && cupsArrayCount(tls_sessions) >= HTTP_GNUTLS_SESSION_MAX)
+      cupsArrayRemove(tls_sessions, oldest);
+  }
+
+  if (!cupsArrayAdd(tls_sessions, session))
+  {
+    free(session);
+    session = NULL;
+  }
+
+  _cupsMutexUnlock(&tls_mutex);
+
+  return (session ? 0 : -1);
+}
+
+
 /*
  * 'http_gnutls_write()' - Write function for the GNU TLS library.
  */
@@ -1209,6 +1408,17 @@ _httpTLSRead(http_t *http,		/* I - Connection to server */
 }
 
 
+/*
+ * '_httpTLSResumed()' - Return whether the TLS session was resumed.
+ */
+
+int					/* O - 1 if resumed, 0 otherwise */
+_httpTLSResumed(http_t *http)		/* I - HTTP connection */
+{
+  return (http->tls && gnutls_session_is_resumed(http->tls));
+}
+
+
 /*
  * '_httpTLSSetCredentials()' - Set the TLS credentials.
  */
@@ -1240,6 +1450,37 @@ _httpTLSSetOptions(int options,		/* I - Options */
 }
 
 
+/*
+ * '_httpTLSSetSessionCache()' - Set the server session resumption timeout.
+ *
+ * Server connections issue session tickets and cache sessions for up to
+ * "timeout" seconds so that returning clients can skip the public key
+ * operations of a full handshake.  A timeout of 0 disables resumption.
+ */
+
+void
+_httpTLSSetSessionCache(int timeout)	/* I - Timeout in seconds */
+{
+  _cupsMutexLock(&tls_mutex);
+
+  tls_session_timeout = timeout > 0 ? timeout : 0;
+
+  cupsArrayDelete(tls_sessions);
+  tls_sessions = NULL;
+
+  if (tls_ticket_key.data)
+  {
+    gnutls_memset(tls_ticket_key.data, 0, tls_ticket_key.size);
+    gnutls_free(tls_ticket_key.data);
+
+    tls_ticket_key.data = NULL;
+    tls_ticket_key.size = 0;
+  }
+
+  _cupsMutexUnlock(&tls_mutex);
+}
+
+
 /*
  * '_httpTLSStart()' - Set up SSL/TLS support on a connection.
  */
@@ -1510,6 +1751,40 @@ _httpTLSStart(http_t *http)		/* I - Connection to server */
   if (!status)
     status = gnutls_credentials_set(http->tls, GNUTLS_CRD_CERTIFICATE, *credentials);
 
+  if (!status && http->mode == _HTTP_MODE_SERVER && tls_session_timeout > 0)
+  {
+   /*
+    * Server: allow clients to resume sessions using a ticket or session ID,
+    * replacing the ticket key periodically...
+    */
+
+    _cupsMutexLock(&tls_mutex);
+
+    if (tls_ticket_key.data && (time(NULL) - tls_ticket_time) >= (HTTP_GNUTLS_TICKET_KEY * tls_session_timeout))
+    {
+      DEBUG_puts("4_httpTLSStart: Replacing session ticket key.");
+
+      gnutls_memset(tls_ticket_key.data, 0, tls_ticket_key.size);
+      gnutls_free(tls_ticket_key.data);
+
+      tls_ticket_key.data = NULL;
+      tls_ticket_key.size = 0;
+    }
+
+    if (!tls_ticket_key.data && !gnutls_session_ticket_key_generate(&tls_ticket_key))
+      tls_ticket_time = time(NULL);
+
+    if (tls_ticket_key.data)
+      gnutls_session_ticket_enable_server(http->tls, &tls_ticket_key);
+
+    _cupsMutexUnlock(&tls_mutex);
+
+    gnutls_db_set_cache_expiration(http->tls, tls_session_timeout);
+    gnutls_db_set_retrieve_function(http->tls, http_gnutls_retrieve_session);
+    gnutls_db_set_store_function(http->tls, http_gnutls_store_session);
+    gnutls_db_set_remove_function(http->tls, http_gnutls_remove_session);
+  }
+
   if (status)
   {
     http->error  = EIO;
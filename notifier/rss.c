@@ -20,6 +20,14 @@
 #include <cups/ipp-private.h>	/* TODO: Update so we don't need this */
 
 
+/*
+ * Constants...
+ */
+
+#define RSS_SAVE_DELAY	5		/* Seconds to collect events before
+					 * saving the RSS file */
+
+
 /*
  * Structures...
  */
@@ -27,10 +35,8 @@
 typedef struct _cups_rss_s		/**** RSS message data ****/
 {
   int		sequence_number;	/* notify-sequence-number */
-  char		*subject,		/* Message subject/summary */
-		*text,			/* Message text */
-		*link_url;		/* Link to printer */
-  time_t	event_time;		/* When the event occurred */
+  char		*item;			/* Rendered <item> element */
+  size_t	itemlen;		/* Length of rendered element */
 } _cups_rss_t;
 
 
@@ -48,8 +54,8 @@ static char		*rss_password;	/* Password for remote RSS */
 static int		compare_rss(_cups_rss_t *a, _cups_rss_t *b);
 static void		delete_message(_cups_rss_t *rss);
 static void		load_rss(cups_array_t *rss, const char *filename);
-static _cups_rss_t	*new_message(int sequence_number, char *subject,
-			             char *text, char *link_url,
+static _cups_rss_t	*new_message(int sequence_number, const char *subject,
+			             const char *text, const char *link_url,
 				     time_t event_time);
 static const char	*password_cb(const char *prompt);
 static int		save_rss(cups_array_t *rss, const char *filename,
@@ -85,6 +91,9 @@ main(int  argc,				/* I - Number of command-line arguments */
 		*notify_printer_uri;	/* Printer URI */
   char		*subject,		/* Subject for notification message */
 		*text,			/* Text for notification message */
+		*esubject,		/* Escaped subject */
+		*etext,			/* Escaped text */
+		*elink_url,		/* Escaped link */
 		link_url[1024],		/* Link to printer */
 		link_scheme[32],	/* Scheme for link */
 		link_username[256],	/* Username for link */
@@ -97,6 +106,9 @@ main(int  argc,				/* I - Number of command-line arguments */
   fd_set	input;			/* Input set for select() */
   struct timeval timeout;		/* Timeout for select() */
   int		changed;		/* Has the RSS data changed? */
+  time_t	curtime,		/* Current time */
+		save_time;		/* When to save the changes */
+  int		done;			/* Done reading events? */
   int		exit_status;		/* Exit status */
 
 
@@ -230,9 +242,11 @@ main(int  argc,				/* I - Number of command-line arguments */
   * Read events and update the RSS file until we are out of events.
   */
 
-  for (exit_status = 0, event = NULL;;)
+  for (exit_status = 0, event = NULL, save_time = 0, done = 0;;)
   {
-    if (changed)
+    curtime = time(NULL);
+
+    if (changed && (done || curtime >= save_time))
     {
      /*
       * Save the messages to the file again, uploading as needed...
@@ -263,13 +277,22 @@ main(int  argc,				/* I - Number of command-line arguments */
 
 	changed = 0;
       }
+      else
+        save_time = curtime + RSS_SAVE_DELAY;
     }
 
+    if (done)
+      break;
+
    /*
-    * Wait up to 30 seconds for an event...
+    * Wait for the next event - up to 30 seconds when idle or until the
+    * pending changes need to be saved...
     */
 
-    timeout.tv_sec  = 30;
+    if (changed)
+      timeout.tv_sec = save_time > curtime ? save_time - curtime : 0;
+    else
+      timeout.tv_sec = 30;
     timeout.tv_usec = 0;
 
     FD_ZERO(&input);
@@ -279,6 +302,9 @@ main(int  argc,				/* I - Number of command-line arguments */
       continue;
     else if (!FD_ISSET(0, &input))
     {
+      if (changed)
+        continue;
+
       fprintf(stderr, "DEBUG: %s is bored, exiting...\n", argv[1]);
       break;
     }
@@ -298,7 +324,12 @@ main(int  argc,				/* I - Number of command-line arguments */
       fputs("DEBUG: ippReadFile() returned IPP_ERROR!\n", stderr);
 
     if (state <= IPP_IDLE)
-      break;
+    {
+      ippDelete(event);
+      event = NULL;
+      done  = 1;
+      continue;
+    }
 
    /*
     * Collect the info from the event...
@@ -332,10 +363,17 @@ main(int  argc,				/* I - Number of command-line arguments */
 			link_resource);
       }
 
-      msg = new_message(notify_sequence_number->values[0].integer,
-                        xml_escape(subject), xml_escape(text),
-			notify_printer_uri ? xml_escape(link_url) : NULL,
-			printer_up_time->values[0].integer);
+      esubject  = xml_escape(subject);
+      etext     = xml_escape(text);
+      elink_url = notify_printer_uri ? xml_escape(link_url) : NULL;
+
+      msg = new_message(notify_sequence_number->values[0].integer, esubject,
+                        etext, elink_url, printer_up_time->values[0].integer);
+
+      free(esubject);
+      free(etext);
+      if (elink_url)
+        free(elink_url);
 
       if (!msg)
       {
@@ -351,7 +389,11 @@ main(int  argc,				/* I - Number of command-line arguments */
 
       cupsArrayAdd(rss, msg);
 
-      changed = 1;
+      if (!changed)
+      {
+        changed   = 1;
+        save_time = time(NULL) + RSS_SAVE_DELAY;
+      }
 
      /*
       * Trim the array as needed...
@@ -412,15 +454,7 @@ compare_rss(_cups_rss_t *a,		/* I - First message */
 static void
 delete_message(_cups_rss_t *msg)	/* I - RSS message */
 {
-  if (msg->subject)
-    free(msg->subject);
-
-  if (msg->text)
-    free(msg->text);
-
-  if (msg->link_url)
-    free(msg->link_url);
-
+  free(msg->item);
   free(msg);
 }
 
@@ -475,19 +509,16 @@ load_rss(cups_array_t *rss,		/* I - RSS messages */
 
         if (msg)
 	  cupsArrayAdd(rss, msg);
-
       }
-      else
-      {
-        if (subject)
-	  free(subject);
 
-	if (text)
-	  free(text);
+      if (subject)
+	free(subject);
 
-	if (link_url)
-	  free(link_url);
-      }
+      if (text)
+	free(text);
+
+      if (link_url)
+	free(link_url);
 
       subject         = NULL;
       text            = NULL;
@@ -553,26 +584,54 @@ load_rss(cups_array_t *rss,		/* I - RSS messages */
 
 /*
  * 'new_message()' - Create a new RSS message.
+ *
+ * The subject, text, and link strings must already be XML-escaped.  The
+ * message is rendered as an <item> element once so that saving the feed only
+ * needs to copy the rendered elements.
  */
 
 static _cups_rss_t *			/* O - New message */
-new_message(int    sequence_number,	/* I - notify-sequence-number */
-            char   *subject,		/* I - Subject/summary */
-            char   *text,		/* I - Text */
-	    char   *link_url,		/* I - Link to printer */
-	    time_t event_time)		/* I - Date/time of event */
+new_message(int        sequence_number,	/* I - notify-sequence-number */
+            const char *subject,	/* I - Subject/summary */
+            const char *text,		/* I - Text */
+	    const char *link_url,	/* I - Link to printer */
+	    time_t     event_time)	/* I - Date/time of event */
 {
   _cups_rss_t	*msg;			/* New message */
+  char		date[256];		/* Date of event */
+  int		length;			/* Length of item element */
+  static const char * const format =	/* Item element */
+		"    <item>\n"
+		"      <title>%s</title>\n"
+		"      <description>%s</description>\n"
+		"%s%s%s"
+		"      <pubDate>%s</pubDate>\n"
+		"      <guid>%d</guid>\n"
+		"    </item>\n";
 
 
   if ((msg = calloc(1, sizeof(_cups_rss_t))) == NULL)
     return (NULL);
 
   msg->sequence_number = sequence_number;
-  msg->subject         = subject;
-  msg->text            = text;
-  msg->link_url        = link_url;
-  msg->event_time      = event_time;
+
+  httpGetDateString2(event_time, date, sizeof(date));
+
+  length = snprintf(NULL, 0, format, subject, text,
+                    link_url ? "      <link>" : "", link_url ? link_url : "",
+		    link_url ? "</link>\n" : "", date, sequence_number);
+
+  if (length < 0 || (msg->item = malloc((size_t)length + 1)) == NULL)
+  {
+    free(msg);
+    return (NULL);
+  }
+
+  snprintf(msg->item, (size_t)length + 1, format, subject, text,
+           link_url ? "      <link>" : "", link_url ? link_url : "",
+	   link_url ? "</link>\n" : "", date, sequence_number);
+
+  msg->itemlen = (size_t)length;
 
   return (msg);
 }
@@ -634,23 +693,7 @@ save_rss(cups_array_t *rss,		/* I - RSS messages */
   for (msg = (_cups_rss_t *)cupsArrayLast(rss);
        msg;
        msg = (_cups_rss_t *)cupsArrayPrev(rss))
-  {
-    char *subject = xml_escape(msg->subject);
-    char *text = xml_escape(msg->text);
-
-    fputs("    <item>\n", fp);
-    fprintf(fp, "      <title>%s</title>\n", subject);
-    fprintf(fp, "      <description>%s</description>\n", text);
-    if (msg->link_url)
-      fprintf(fp, "      <link>%s</link>\n", msg->link_url);
-    fprintf(fp, "      <pubDate>%s</pubDate>\n",
-            httpGetDateString2(msg->event_time, date, sizeof(date)));
-    fprintf(fp, "      <guid>%d</guid>\n", msg->sequence_number);
-    fputs("    </item>\n", fp);
-
-    free(subject);
-    free(text);
-  }
+    fwrite(msg->item, 1, msg->itemlen, fp);
 
   fputs(" </channel>\n", fp);
   fputs("</rss>\n", fp);
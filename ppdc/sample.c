@@ -0,0 +1,446 @@
+_("ISOLatin1");
+_("English");
+_("3 x 5");
+_("3.5 x 5");
+_("5 x 7");
+_("10 x 11");
+_("10 x 13");
+_("10 x 14");
+_("12 x 11");
+_("15 x 11");
+_("7 x 9");
+_("8 x 10");
+_("9 x 11");
+_("9 x 12");
+_("A0");
+_("A0 Long Edge");
+_("A1");
+_("A1 Long Edge");
+_("A2");
+_("A2 Long Edge");
+_("A3");
+_("A3 Long Edge");
+_("A3 Oversize");
+_("A3 Oversize Long Edge");
+_("A4");
+_("A4 Oversize");
+_("A4 Long Edge");
+_("A4 Small");
+_("A5");
+_("A5 Oversize");
+_("A5 Long Edge");
+_("A6");
+_("A6 Long Edge");
+_("A7");
+_("A8");
+_("A9");
+_("A10");
+_("ANSI A");
+_("ANSI B");
+_("ANSI C");
+_("ANSI D");
+_("ANSI E");
+_("Letter Oversize");
+_("Letter Oversize Long Edge");
+_("Tabloid Oversize");
+_("Tabloid Oversize Long Edge");
+_("ARCH C");
+_("ARCH C Long Edge");
+_("ARCH D");
+_("ARCH D Long Edge");
+_("ARCH E");
+_("ARCH E Long Edge");
+_("JIS B0");
+_("JIS B10");
+_("JIS B1");
+_("JIS B2");
+_("JIS B3");
+_("JIS B4");
+_("JIS B4 Long Edge");
+_("JIS B5");
+_("JIS B5 Long Edge");
+_("JIS B6");
+_("JIS B6 Long Edge");
+_("JIS B7");
+_("JIS B8");
+_("JIS B9");
+_("Envelope C4");
+_("Envelope C5");
+_("Envelope C6");
+_("Envelope DL");
+_("Postcard Double");
+_("Postcard Double Long Edge");
+_("Envelope #10");
+_("Envelope #11");
+_("Envelope #12");
+_("Envelope #14");
+_("Envelope #9");
+_("Envelope C0");
+_("Envelope C1");
+_("Envelope C2");
+_("Envelope C3");
+_("Envelope C65");
+_("Envelope C7");
+_("Envelope Choukei 3");
+_("Envelope Choukei 3 Long Edge");
+_("Envelope Choukei 4");
+_("Envelope Choukei 4 Long Edge");
+_("Envelope Invite");
+_("Envelope B4");
+_("Envelope B5");
+_("Envelope B6");
+_("Envelope Italian");
+_("Envelope Kaku2");
+_("Envelope Kaku2 Long Edge");
+_("Envelope Kaku3");
+_("Envelope Kaku3 Long Edge");
+_("Envelope Monarch");
+_("Envelope Personal");
+_("Envelope PRC1");
+_("Envelope PRC1 Long Edge");
+_("Envelope PRC2");
+_("Envelope PRC2 Long Edge");
+_("Envelope PRC3");
+_("Envelope PRC3 Long Edge");
+_("Envelope PRC4");
+_("Envelope PRC4 Long Edge");
+_("Envelope PRC5PRC5");
+_("Envelope PRC5 Long Edge");
+_("Envelope PRC6");
+_("Envelope PRC6 Long Edge");
+_("Envelope PRC7");
+_("Envelope PRC7 Long Edge");
+_("Envelope PRC8");
+_("Envelope PRC8 Long Edge");
+_("Envelope PRC9");
+_("Envelope PRC9 Long Edge");
+_("Envelope PRC10");
+_("Envelope PRC10 Long Edge");
+_("Envelope You4");
+_("Envelope You4 Long Edge");
+_("Executive");
+_("European Fanfold");
+_("European Fanfold Legal");
+_("US Fanfold");
+_("Folio");
+_("B0");
+_("B1");
+_("B2");
+_("B3");
+_("B4");
+_("B5");
+_("B5 Oversize");
+_("B6");
+_("B7");
+_("B8");
+_("B9");
+_("B10");
+_("US Ledger");
+_("US Legal");
+_("US Legal Oversize");
+_("US Letter");
+_("US Letter Long Edge");
+_("US Letter Oversize");
+_("US Letter Oversize Long Edge");
+_("US Letter Small");
+_("Note");
+_("Postcard");
+_("Postcard Long Edge");
+_("PRC16K");
+_("PRC16K Long Edge");
+_("PRC32K");
+_("PRC32K Oversize");
+_("PRC32K Oversize Long Edge");
+_("PRC32K Long Edge");
+_("Quarto");
+_("Statement");
+_("Super A");
+_("Super B");
+_("Tabloid");
+_("Photo");
+_("Photo Labels");
+_("Super B/A3");
+_("Address");
+_("Large Address");
+_("Return Address");
+_("Shipping Address");
+_("Internet Postage 2-Part");
+_("Internet Postage 3-Part");
+_("File Folder");
+_("Hanging Folder");
+_("3.5\" Disk");
+_("1.25x0.25\"");
+_("1.25x2.25\"");
+_("1.50x0.25\"");
+_("1.50x0.50\"");
+_("1.50x1.00\"");
+_("1.50x2.00\"");
+_("2.00x0.37\"");
+_("2.00x0.50\"");
+_("2.00x1.00\"");
+_("2.00x1.25\"");
+_("2.00x2.00\"");
+_("2.00x3.00\"");
+_("2.00x4.00\"");
+_("2.00x5.50\"");
+_("2.25x0.50\"");
+_("2.25x1.25\"");
+_("2.25x4.00\"");
+_("2.25x5.50\"");
+_("2.38x5.50\"");
+_("2.50x1.00\"");
+_("2.50x2.00\"");
+_("2.75x1.25\"");
+_("2.9 x 1\"");
+_("3.00x1.00\"");
+_("3.00x1.25\"");
+_("3.00x2.00\"");
+_("3.00x3.00\"");
+_("3.00x5.00\"");
+_("3.25x2.00\"");
+_("3.25x5.00\"");
+_("3.25x5.50\"");
+_("3.25x5.83\"");
+_("3.25x7.83\"");
+_("3.50x1.00\"");
+_("4.00x1.00\"");
+_("4.00x2.00\"");
+_("4.00x2.50\"");
+_("4.00x3.00\"");
+_("4.00x4.00\"");
+_("4.00x5.00\"");
+_("4.00x6.00\"");
+_("4.00x6.50\"");
+_("4.00x13.00\"");
+_("6.00x1.00\"");
+_("6.00x2.00\"");
+_("6.00x3.00\"");
+_("6.00x4.00\"");
+_("6.00x5.00\"");
+_("6.00x6.00\"");
+_("6.00x6.50\"");
+_("8.00x1.00\"");
+_("8.00x2.00\"");
+_("8.00x3.00\"");
+_("8.00x4.00\"");
+_("8.00x5.00\"");
+_("8.00x6.00\"");
+_("8.00x6.50\"");
+_("Dymo");
+_("Label Printer");
+_("Resolution");
+_("136dpi");
+_("203dpi");
+_("300dpi");
+_("Darkness");
+_("Light");
+_("Medium");
+_("Normal");
+_("Dark");
+_("Epson");
+_("24-Pin Series");
+_("60dpi");
+_("120x60dpi");
+_("180dpi");
+_("360x180dpi");
+_("360dpi");
+_("9-Pin Series");
+_("60x72dpi");
+_("120x72dpi");
+_("240x72dpi");
+_("Generic");
+_("PCL Laser Printer");
+_("600dpi");
+_("Media Source");
+_("Printer Default");
+_("Tray 1");
+_("Tray 2");
+_("Tray 3");
+_("Tray 4");
+_("Manual Feed");
+_("Envelope Feed");
+_("2-Sided Printing");
+_("Off (1-Sided)");
+_("Long-Edge (Portrait)");
+_("Short-Edge (Landscape)");
+_("Installable Options");
+_("Duplexer");
+_("Not Installed");
+_("Installed");
+_("PostScript Printer");
+_("Cassette");
+_("HP");
+_("DeskJet Series");
+_("Color Mode");
+_("Grayscale");
+_("Color");
+_("CMYK");
+_("150dpi");
+_("Tray");
+_("Media Type");
+_("Plain Paper");
+_("Bond Paper");
+_("Special Paper");
+_("Transparency");
+_("Glossy Paper");
+_("LaserJet Series PCL 4/5");
+_("Intellitech");
+_("IntelliBar Label Printer");
+_("Printer Settings");
+_("Print Density");
+_("-15");
+_("-14");
+_("-13");
+_("-12");
+_("-11");
+_("-10");
+_("-9");
+_("-8");
+_("-7");
+_("-6");
+_("-5");
+_("-4");
+_("-3");
+_("-2");
+_("-1");
+_("0");
+_("1");
+_("2");
+_("3");
+_("4");
+_("5");
+_("6");
+_("7");
+_("8");
+_("9");
+_("10");
+_("11");
+_("12");
+_("13");
+_("14");
+_("15");
+_("Print Speed");
+_("15 mm/sec.");
+_("20 mm/sec.");
+_("30 mm/sec.");
+_("40 mm/sec.");
+_("60 mm/sec.");
+_("80 mm/sec.");
+_("100 mm/sec.");
+_("120 mm/sec.");
+_("150 mm/sec.");
+_("200 mm/sec.");
+_("250 mm/sec.");
+_("300 mm/sec.");
+_("Print Mode");
+_("Standard");
+_("Tear");
+_("Cut");
+_("Print and Tear");
+_("Disabled");
+_("Every Label");
+_("Every 2 Labels");
+_("Every 3 Labels");
+_("Every 4 Labels");
+_("Every 5 Labels");
+_("Every 6 Labels");
+_("Every 7 Labels");
+_("Every 8 Labels");
+_("Every 9 Labels");
+_("Every 10 Labels");
+_("Print and Cut");
+_("CustominTearInterval");
+_("ParamCustominTearInterval");
+_("CustominCutInterval");
+_("ParamCustominCutInterval");
+_("Oki");
+_("Zebra");
+_("CPCL Label Printer");
+_("Media Tracking");
+_("Continuous");
+_("Non-continuous (Web sensing)");
+_("Non-continuous (Mark sensing)");
+_("16");
+_("17");
+_("18");
+_("19");
+_("20");
+_("21");
+_("22");
+_("23");
+_("24");
+_("25");
+_("26");
+_("27");
+_("28");
+_("29");
+_("30");
+_("Print Rate");
+_("1 inch/sec.");
+_("2 inches/sec.");
+_("3 inches/sec.");
+_("4 inches/sec.");
+_("Tear-Off Adjust Position");
+_("-120");
+_("-115");
+_("-110");
+_("-105");
+_("-100");
+_("-95");
+_("-90");
+_("-85");
+_("-80");
+_("-75");
+_("-70");
+_("-65");
+_("-60");
+_("-55");
+_("-50");
+_("-45");
+_("-40");
+_("-35");
+_("-30");
+_("-25");
+_("-20");
+_("35");
+_("40");
+_("45");
+_("50");
+_("55");
+_("60");
+_("65");
+_("70");
+_("75");
+_("80");
+_("85");
+_("90");
+_("95");
+_("100");
+_("105");
+_("110");
+_("115");
+_("120");
+_("Reprint After Error");
+_("Always");
+_("Never");
+_("EPL1 Label Printer");
+_("1.5 inch/sec.");
+_("2.5 inches/sec.");
+_("EPL2 Label Printer");
+_("Thermal Transfer Media");
+_("Direct Thermal Media");
+_("5 inches/sec.");
+_("6 inches/sec.");
+_("ZPL Label Printer");
+_("7 inches/sec.");
+_("8 inches/sec.");
+_("9 inches/sec.");
+_("10 inches/sec.");
+_("11 inches/sec.");
+_("12 inches/sec.");
+_("Label Top");
+_("Tear-Off");
+_("Peel-Off");
+_("Rewind");
+_("Applicator");
+_("Cutter");
@@ -58,17 +58,100 @@ typedef struct sockpeercred cupsd_ucred_t;
 #endif /* HAVE_SYS_UCRED_H */
 
 
+/*
+ * Local constants...
+ */
+
+#define CUPSD_AUTH_CACHE_MAX	256	/* Maximum cached authentications */
+#define CUPSD_AUTH_INDEX_MIN	8	/* Minimum number of masks to index */
+#define CUPSD_GROUP_CACHE_MAX	1024	/* Maximum cached group checks */
+#define CUPSD_LOCNODE_ANY	7	/* Location trie index for LIMIT_ALL */
+
+
+/*
+ * Local types...
+ */
+
+typedef struct cupsd_authcache_s	/**** Cached authentication ****/
+{
+  unsigned char	hash[32];		/* SHA-256 hash of salt and credentials */
+  time_t	expires;		/* When the entry expires */
+} cupsd_authcache_t;
+
+typedef struct cupsd_ipnode_s		/**** IP address trie node ****/
+{
+  struct cupsd_ipnode_s	*child[2];	/* Child nodes for next address bit */
+  int			match;		/* Does a network end here? */
+} cupsd_ipnode_t;
+
+typedef struct cupsd_authindex_s	/**** Index of authorization masks ****/
+{
+  cups_array_t		*masks;		/* Masks that were indexed */
+  int			count;		/* Number of masks that were indexed */
+  cupsd_ipnode_t	*ip;		/* Trie of IP networks */
+  cups_array_t		*ipmasks,	/* IP masks with non-contiguous netmasks */
+			*names,		/* Lowercase host and domain names */
+			*interfaces;	/* Interface masks */
+} cupsd_authindex_t;
+
+typedef struct cupsd_groupcache_s	/**** Cached group membership ****/
+{
+  const char	*username,		/* User name */
+		*groupname;		/* Group name */
+  int		has_user;		/* Was system user info supplied? */
+  uid_t		uid;			/* User ID */
+  gid_t		gid;			/* Primary group ID */
+  int		is_member;		/* 1 if user is a member of the group */
+  time_t	expires;		/* When the entry expires */
+} cupsd_groupcache_t;
+
+typedef struct cupsd_locnode_s		/**** Location trie node ****/
+{
+  char			*label;		/* Characters leading to this node */
+  size_t		labellen;	/* Length of label */
+  int			num_children;	/* Number of child nodes */
+  struct cupsd_locnode_s **children;	/* Child nodes, sorted by first char */
+  cupsd_location_t	**limits;	/* First location ending here for each
+					 * limit bit, or NULL */
+} cupsd_locnode_t;
+
+
 /*
  * Local functions...
  */
 
+static int		add_ip_node(cupsd_authindex_t *index,
+			            cupsd_authmask_t *mask);
+static int		add_location_node(cupsd_locnode_t *root,
+			                  const char *key,
+					  cupsd_location_t *loc);
+static int		build_location_tries(void);
+static int		check_auth_index(cupsd_authindex_t *index,
+			                 unsigned ip[4], const char *name,
+					 size_t name_len);
 #ifdef HAVE_AUTHORIZATION_H
 static int		check_authref(cupsd_client_t *con, const char *right);
 #endif /* HAVE_AUTHORIZATION_H */
+static int		check_group(const char *username, struct passwd *user,
+			            const char *groupname);
+static int		check_interface(cupsd_authmask_t *mask,
+			                unsigned ip[4]);
+static int		compare_auth_cache(cupsd_authcache_t *a,
+			                   cupsd_authcache_t *b);
+static int		compare_auth_index(cupsd_authindex_t *a,
+			                   cupsd_authindex_t *b);
+static int		compare_group_cache(cupsd_groupcache_t *a,
+			                    cupsd_groupcache_t *b);
 static int		compare_locations(cupsd_location_t *a,
 			                  cupsd_location_t *b);
+static int		compile_names(cupsd_location_t *loc);
 static cupsd_authmask_t	*copy_authmask(cupsd_authmask_t *am, void *data);
+static void		delete_auth_index(cups_array_t *masks);
+static cupsd_authindex_t *find_auth_index(cups_array_t *masks);
+static void		free_auth_index(cupsd_authindex_t *index);
 static void		free_authmask(cupsd_authmask_t *am, void *data);
+static void		free_ip_trie(cupsd_ipnode_t *node);
+static void		free_location_trie(cupsd_locnode_t *node);
 #if HAVE_LIBPAM
 static int		pam_func(int, const struct pam_message **,
 			         struct pam_response **, void *);
@@ -90,6 +173,107 @@ typedef struct cupsd_authdata_s		/**** Authentication data ****/
 #endif /* HAVE_LIBPAM */
 
 
+/*
+ * Local globals...
+ *
+ * Successful Basic authentications are cached for AuthCacheTimeout seconds
+ * so that clients which send their credentials with every request (like the
+ * web interface) do not need a PAM or password file lookup each time.  The
+ * cache is keyed by a SHA-256 hash of a random salt, the client's hostname,
+ * and the username and password, and is cleared whenever the configuration
+ * is (re)loaded.
+ */
+
+static cups_array_t	*auth_cache = NULL;
+					/* Cached authentications */
+static unsigned char	auth_cache_salt[16];
+					/* Salt for cache keys */
+static int		auth_cache_hits = 0,
+					/* Number of cache hits */
+			auth_cache_misses = 0;
+					/* Number of cache misses */
+
+/*
+ * Group membership checks are cached for GroupCacheTimeout seconds, since
+ * each check can mean several NSS lookups (getgrnam, getgrouplist) and one
+ * request may check many policy limits.
+ */
+
+static cups_array_t	*group_cache = NULL;
+					/* Cached group memberships */
+static int		group_cache_hits = 0,
+					/* Number of cache hits */
+			group_cache_misses = 0;
+					/* Number of cache misses */
+
+/*
+ * cupsdFindBest() looks up locations using two radix trees built from the
+ * Locations array the first time they are needed - one keyed by the
+ * location path and one by the lowercase path for the case-insensitive
+ * /printers and /classes resources.  Each node where a location path ends
+ * records the first location for each Limit method, so a lookup only needs
+ * to walk the request path once.
+ */
+
+/*
+ * cupsdCheckAuth() compiles Allow and Deny lists with CUPSD_AUTH_INDEX_MIN
+ * or more entries into an index the first time they are checked: IP
+ * networks go into a binary trie of address bits, and host and domain
+ * names into a sorted array that is searched for the client's hostname and
+ * each of its domain suffixes.  Indexes are kept by mask array and are
+ * rebuilt if masks are added to the array.
+ */
+
+static cups_array_t	*auth_indexes = NULL;
+					/* Indexes of authorization masks */
+
+static cupsd_locnode_t	*loc_trie = NULL,
+					/* Locations by path */
+			*loc_itrie = NULL;
+					/* Locations by lowercase path */
+
+
+/*
+ * 'cupsdAddAuthCache()' - Add validated credentials to the authentication
+ *                         cache.
+ */
+
+void
+cupsdAddAuthCache(
+    const unsigned char *hash)		/* I - Hash from cupsdCheckAuthCache() */
+{
+  cupsd_authcache_t	*entry,		/* Cache entry */
+			*oldest;	/* Oldest cache entry */
+
+
+  if (!auth_cache)
+    return;
+
+  if (cupsArrayCount(auth_cache) >= CUPSD_AUTH_CACHE_MAX)
+  {
+   /*
+    * Cache is full, remove the entry that expires first...
+    */
+
+    for (oldest = entry = (cupsd_authcache_t *)cupsArrayFirst(auth_cache);
+         entry;
+	 entry = (cupsd_authcache_t *)cupsArrayNext(auth_cache))
+      if (entry->expires < oldest->expires)
+        oldest = entry;
+
+    cupsArrayRemove(auth_cache, oldest);
+  }
+
+  if ((entry = calloc(1, sizeof(cupsd_authcache_t))) == NULL)
+    return;
+
+  memcpy(entry->hash, hash, sizeof(entry->hash));
+  entry->expires = time(NULL) + AuthCacheTimeout;
+
+  cupsArrayAdd(auth_cache, entry);
+}
+
+
 /*
  * 'cupsdAddIPMask()' - Add an IP address authorization mask.
  */
@@ -143,6 +327,12 @@ cupsdAddLocation(cupsd_location_t *loc)	/* I - Location to add */
   {
     cupsArrayAdd(Locations, loc);
 
+    free_location_trie(loc_trie);
+    free_location_trie(loc_itrie);
+
+    loc_trie  = NULL;
+    loc_itrie = NULL;
+
     cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdAddLocation: Added location \"%s\"", loc->location ? loc->location : "(null)");
   }
 }
@@ -509,7 +699,9 @@ cupsdAuthorize(cupsd_client_t *con)	/* I - Client connection */
     * Get the Basic authentication data...
     */
 
-    int	userlen;			/* Username:password length */
+    int			userlen;	/* Username:password length */
+    unsigned char	hash[32];	/* Authentication cache key */
+    int			cached = -1;	/* Authentication cache status */
 
 
     authorization += 5;
@@ -561,6 +753,17 @@ cupsdAuthorize(cupsd_client_t *con)	/* I - Client connection */
     {
       default :
       case CUPSD_AUTH_BASIC :
+          if (AuthCacheTimeout > 0 &&
+	      (cached = cupsdCheckAuthCache(con->http->hostname, username, password, hash)) > 0)
+	  {
+	   /*
+	    * These credentials were validated recently...
+	    */
+
+	    cupsdLogClient(con, CUPSD_LOG_DEBUG, "Authorized as \"%s\" using Basic (cached).", username);
+	    break;
+	  }
+
           {
 #if HAVE_LIBPAM
 	   /*
@@ -713,6 +916,9 @@ cupsdAuthorize(cupsd_client_t *con)	/* I - Client connection */
 #endif /* HAVE_LIBPAM */
           }
 
+	  if (!cached)
+	    cupsdAddAuthCache(hash);
+
 	  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Authorized as \"%s\" using Basic.", username);
           break;
     }
@@ -960,12 +1166,12 @@ cupsdCheckAuth(unsigned     ip[4],	/* I - Client address */
 {
   int			i;		/* Looping var */
   cupsd_authmask_t	*mask;		/* Current mask */
-  cupsd_netif_t		*iface;		/* Network interface */
-  unsigned		netip4;		/* IPv4 network address */
-#ifdef AF_INET6
-  unsigned		netip6[4];	/* IPv6 network address */
-#endif /* AF_INET6 */
+  cupsd_authindex_t	*index;		/* Index of masks */
+
 
+  if (cupsArrayCount(masks) >= CUPSD_AUTH_INDEX_MIN &&
+      (index = find_auth_index(masks)) != NULL)
+    return (check_auth_index(index, ip, name, name_len));
 
   for (mask = (cupsd_authmask_t *)cupsArrayFirst(masks);
        mask;
@@ -978,116 +1184,8 @@ cupsdCheckAuth(unsigned     ip[4],	/* I - Client address */
 	  * Check for a match with a network interface...
 	  */
 
-          netip4 = htonl(ip[3]);
-
-#ifdef AF_INET6
-          netip6[0] = htonl(ip[0]);
-          netip6[1] = htonl(ip[1]);
-          netip6[2] = htonl(ip[2]);
-          netip6[3] = htonl(ip[3]);
-#endif /* AF_INET6 */
-
-	  cupsdNetIFUpdate();
-
-          if (!strcmp(mask->mask.name.name, "*"))
-	  {
-#ifdef __APPLE__
-           /*
-	    * Allow Back-to-My-Mac addresses...
-	    */
-
-	    if ((ip[0] & 0xff000000) == 0xfd000000)
-	      return (1);
-#endif /* __APPLE__ */
-
-	   /*
-	    * Check against all local interfaces...
-	    */
-
-	    for (iface = (cupsd_netif_t *)cupsArrayFirst(NetIFList);
-		 iface;
-		 iface = (cupsd_netif_t *)cupsArrayNext(NetIFList))
-	    {
-	     /*
-	      * Only check local interfaces...
-	      */
-
-	      if (!iface->is_local)
-	        continue;
-
-              if (iface->address.addr.sa_family == AF_INET)
-	      {
-	       /*
-	        * Check IPv4 address...
-		*/
-
-        	if ((netip4 & iface->mask.ipv4.sin_addr.s_addr) ==
-	            (iface->address.ipv4.sin_addr.s_addr &
-		     iface->mask.ipv4.sin_addr.s_addr))
-		  return (1);
-              }
-#ifdef AF_INET6
-	      else
-	      {
-	       /*
-	        * Check IPv6 address...
-		*/
-
-        	for (i = 0; i < 4; i ++)
-		  if ((netip6[i] & iface->mask.ipv6.sin6_addr.s6_addr32[i]) !=
-		      (iface->address.ipv6.sin6_addr.s6_addr32[i] &
-		       iface->mask.ipv6.sin6_addr.s6_addr32[i]))
-		    break;
-
-		if (i == 4)
-		  return (1);
-              }
-#endif /* AF_INET6 */
-	    }
-	  }
-	  else
-	  {
-	   /*
-	    * Check the named interface...
-	    */
-
-	    for (iface = (cupsd_netif_t *)cupsArrayFirst(NetIFList);
-	         iface;
-		 iface = (cupsd_netif_t *)cupsArrayNext(NetIFList))
-	    {
-              if (strcmp(mask->mask.name.name, iface->name))
-                continue;
-
-              if (iface->address.addr.sa_family == AF_INET)
-	      {
-	       /*
-		* Check IPv4 address...
-		*/
-
-        	if ((netip4 & iface->mask.ipv4.sin_addr.s_addr) ==
-	            (iface->address.ipv4.sin_addr.s_addr &
-		     iface->mask.ipv4.sin_addr.s_addr))
-		  return (1);
-              }
-#ifdef AF_INET6
-	      else
-	      {
-	       /*
-		* Check IPv6 address...
-		*/
-
-        	for (i = 0; i < 4; i ++)
-		  if ((netip6[i] & iface->mask.ipv6.sin6_addr.s6_addr32[i]) !=
-		      (iface->address.ipv6.sin6_addr.s6_addr32[i] &
-		       iface->mask.ipv6.sin6_addr.s6_addr32[i]))
-		    break;
-
-		if (i == 4)
-		  return (1);
-              }
-#endif /* AF_INET6 */
-	    }
-	  }
+          if (check_interface(mask, ip))
+	    return (1);
 	  break;
 
       case CUPSD_AUTH_NAME :
@@ -1130,172 +1228,264 @@ cupsdCheckAuth(unsigned     ip[4],	/* I - Client address */
 
 
 /*
- * 'cupsdCheckGroup()' - Check for a user's group membership.
+ * 'cupsdCheckAuthCache()' - Look for Basic credentials in the authentication
+ *                           cache.
+ *
+ * The cache key is returned in "hash" for cupsdAddAuthCache().
  */
 
-int					/* O - 1 if user is a member, 0 otherwise */
-cupsdCheckGroup(
-    const char    *username,		/* I - User name */
-    struct passwd *user,		/* I - System user info */
-    const char    *groupname)		/* I - Group name */
+int					/* O - 1 if cached, 0 if not, -1 on error */
+cupsdCheckAuthCache(
+    const char     *hostname,		/* I - Client hostname */
+    const char     *username,		/* I - Username */
+    const char     *password,		/* I - Password */
+    unsigned char  *hash)		/* O - Cache key (32 bytes) */
 {
-  int		i;			/* Looping var */
-  struct group	*group;			/* Group info */
-  gid_t		groupid;		/* ID of named group */
-#ifdef HAVE_MBR_UID_TO_UUID
-  uuid_t	useruuid,		/* UUID for username */
-		groupuuid;		/* UUID for groupname */
-  int		is_member;		/* True if user is a member of group */
-#endif /* HAVE_MBR_UID_TO_UUID */
-
+  unsigned char		data[sizeof(auth_cache_salt) + HTTP_MAX_HOST +
+			     2 * HTTP_MAX_VALUE];
+					/* Data to hash */
+  size_t		datalen,	/* Length of data */
+			hostlen,	/* Length of hostname */
+			userlen,	/* Length of username */
+			passlen;	/* Length of password */
+  cupsd_authcache_t	key,		/* Search key */
+			*entry;		/* Matching entry */
 
-  cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdCheckGroup(username=\"%s\", user=%p, groupname=\"%s\")", username, user, groupname);
 
  /*
-  * Validate input...
+  * Create the cache with a new salt as needed...
   */
 
-  if (!username || !groupname)
-    return (0);
-
- /*
-  * Check to see if the user is a member of the named group...
-  */
+  if (!auth_cache)
+  {
+    size_t	i;			/* Looping var */
 
-  group = getgrnam(groupname);
-  endgrent();
+    if ((auth_cache = cupsArrayNew3((cups_array_func_t)compare_auth_cache,
+                                    NULL, NULL, 0, NULL,
+				    (cups_afree_func_t)free)) == NULL)
+      return (-1);
 
-  if (group != NULL)
-  {
-   /*
-    * Group exists, check it...
-    */
+    for (i = 0; i < sizeof(auth_cache_salt); i ++)
+      auth_cache_salt[i] = (unsigned char)CUPS_RAND();
+  }
 
-    groupid = group->gr_gid;
+ /*
+  * Hash the salt, client hostname, username, and password, keeping the nul
+  * terminators as separators...
+  */
 
-#ifdef HAVE_GETGROUPLIST
-    if (user)
-    {
-      int	ngroups;		/* Number of groups */
-#  ifdef __APPLE__
-      int	groups[2048];		/* Groups that user belongs to */
-#  else
-      gid_t	groups[2048];		/* Groups that user belongs to */
-#  endif /* __APPLE__ */
+  hostlen = strlen(hostname) + 1;
+  userlen = strlen(username) + 1;
+  passlen = strlen(password);
+  datalen = sizeof(auth_cache_salt) + hostlen + userlen + passlen;
 
-      ngroups = (int)(sizeof(groups) / sizeof(groups[0]));
-#  ifdef __APPLE__
-      getgrouplist(username, (int)user->pw_gid, groups, &ngroups);
-#  else
-      getgrouplist(username, user->pw_gid, groups, &ngroups);
-#endif /* __APPLE__ */
+  if (datalen > sizeof(data))
+    return (-1);
 
-      for (i = 0; i < ngroups; i ++)
-        if ((int)groupid == (int)groups[i])
-	  return (1);
-    }
+  memcpy(data, auth_cache_salt, sizeof(auth_cache_salt));
+  memcpy(data + sizeof(auth_cache_salt), hostname, hostlen);
+  memcpy(data + sizeof(auth_cache_salt) + hostlen, username, userlen);
+  memcpy(data + sizeof(auth_cache_salt) + hostlen + userlen, password, passlen);
 
-#else
-    for (i = 0; group->gr_mem[i]; i ++)
-    {
-      if (!_cups_strcasecmp(username, group->gr_mem[i]))
-	return (1);
-    }
-#endif /* HAVE_GETGROUPLIST */
+  if (cupsHashData("sha2-256", data, datalen, hash, 32) != 32)
+  {
+    memset(data, 0, sizeof(data));
+    return (-1);
   }
-  else
-    groupid = (gid_t)-1;
-
- /*
-  * Group doesn't exist or user not in group list, check the group ID
-  * against the user's group ID...
-  */
 
-  if (user && groupid == user->pw_gid)
-    return (1);
+  memset(data, 0, sizeof(data));
 
-#ifdef HAVE_MBR_UID_TO_UUID
  /*
-  * Check group membership through macOS membership API...
+  * Look it up...
   */
 
-  if (user && !mbr_uid_to_uuid(user->pw_uid, useruuid))
+  memcpy(key.hash, hash, sizeof(key.hash));
+
+  if ((entry = (cupsd_authcache_t *)cupsArrayFind(auth_cache, &key)) != NULL)
   {
-    if (groupid != (gid_t)-1)
+    if (entry->expires > time(NULL))
     {
-     /*
-      * Map group name to UUID and check membership...
-      */
-
-      if (!mbr_gid_to_uuid(groupid, groupuuid))
-        if (!mbr_check_membership(useruuid, groupuuid, &is_member))
-	  if (is_member)
-	    return (1);
+      auth_cache_hits ++;
+      return (1);
     }
-    else if (groupname[0] == '#')
-    {
-     /*
-      * Use UUID directly and check for equality (user UUID) and
-      * membership (group UUID)...
-      */
-
-      if (!uuid_parse((char *)groupname + 1, groupuuid))
-      {
-        if (!uuid_compare(useruuid, groupuuid))
-	  return (1);
-	else if (!mbr_check_membership(useruuid, groupuuid, &is_member))
-	  if (is_member)
-	    return (1);
-      }
 
-      return (0);
-    }
+    cupsArrayRemove(auth_cache, entry);
   }
-  else if (groupname[0] == '#')
-    return (0);
-#endif /* HAVE_MBR_UID_TO_UUID */
 
- /*
-  * If we get this far, then the user isn't part of the named group...
-  */
+  auth_cache_misses ++;
 
   return (0);
 }
 
 
 /*
- * 'cupsdCopyLocation()' - Make a copy of a location...
+ * 'cupsdCheckGroup()' - Check for a user's group membership.
  */
 
-cupsd_location_t *			/* O - New location */
-cupsdCopyLocation(
-    cupsd_location_t *loc)		/* I - Original location */
+int					/* O - 1 if user is a member, 0 otherwise */
+cupsdCheckGroup(
+    const char    *username,		/* I - User name */
+    struct passwd *user,		/* I - System user info */
+    const char    *groupname)		/* I - Group name */
 {
-  cupsd_location_t	*temp;		/* New location */
+  cupsd_groupcache_t	key,		/* Search key */
+			*entry,		/* Cache entry */
+			*oldest;	/* Oldest cache entry */
+  size_t		userlen,	/* Length of user name */
+			grouplen;	/* Length of group name */
+  time_t		curtime;	/* Current time */
+
 
+  cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdCheckGroup(username=\"%s\", user=%p, groupname=\"%s\")", username, user, groupname);
 
  /*
-  * Make a copy of the original location...
+  * Validate input...
   */
 
-  if ((temp = calloc(1, sizeof(cupsd_location_t))) == NULL)
-    return (NULL);
+  if (!username || !groupname)
+    return (0);
+
+  if (GroupCacheTimeout <= 0)
+    return (check_group(username, user, groupname));
 
  /*
-  * Copy the information from the original location to the new one.
+  * See if we checked this user and group recently...
   */
 
-  if (!loc)
-    return (temp);
+  if (!group_cache)
+    group_cache = cupsArrayNew3((cups_array_func_t)compare_group_cache, NULL,
+                                NULL, 0, NULL, (cups_afree_func_t)free);
 
-  if (loc->location)
-    temp->location = _cupsStrAlloc(loc->location);
+  key.username  = username;
+  key.groupname = groupname;
+  key.has_user  = user != NULL;
+  key.uid       = user ? user->pw_uid : 0;
+  key.gid       = user ? user->pw_gid : 0;
+  curtime       = time(NULL);
 
-  temp->length     = loc->length;
-  temp->limit      = loc->limit;
-  temp->order_type = loc->order_type;
-  temp->type       = loc->type;
-  temp->level      = loc->level;
+  if ((entry = (cupsd_groupcache_t *)cupsArrayFind(group_cache, &key)) != NULL)
+  {
+    if (entry->expires > curtime)
+    {
+      group_cache_hits ++;
+      return (entry->is_member);
+    }
+
+    cupsArrayRemove(group_cache, entry);
+  }
+
+  group_cache_misses ++;
+
+  key.is_member = check_group(username, user, groupname);
+  key.expires   = curtime + GroupCacheTimeout;
+
+ /*
+  * Add the result to the cache, replacing the entry that expires first if
+  * the cache is full...
+  */
+
+  if (cupsArrayCount(group_cache) >= CUPSD_GROUP_CACHE_MAX)
+  {
+    for (oldest = entry = (cupsd_groupcache_t *)cupsArrayFirst(group_cache);
+         entry;
+	 entry = (cupsd_groupcache_t *)cupsArrayNext(group_cache))
+      if (entry->expires < oldest->expires)
+        oldest = entry;
+
+    cupsArrayRemove(group_cache, oldest);
+  }
+
+  userlen  = strlen(username) + 1;
+  grouplen = strlen(groupname) + 1;
+
+  if ((entry = malloc(sizeof(cupsd_groupcache_t) + userlen + grouplen)) != NULL)
+  {
+    memcpy(entry, &key, sizeof(cupsd_groupcache_t));
+    memcpy((char *)(entry + 1), username, userlen);
+    memcpy((char *)(entry + 1) + userlen, groupname, grouplen);
+
+    entry->username  = (char *)(entry + 1);
+    entry->groupname = (char *)(entry + 1) + userlen;
+
+    cupsArrayAdd(group_cache, entry);
+  }
+
+  return (key.is_member);
+}
+
+
+/*
+ * 'cupsdClearAuthCache()' - Clear the authentication and group caches.
+ */
+
+void
+cupsdClearAuthCache(void)
+{
+  if (auth_cache)
+  {
+    if (auth_cache_hits || auth_cache_misses)
+      cupsdLogMessage(CUPSD_LOG_INFO,
+		      "Authentication cache: %d hits, %d misses, %d entries.",
+		      auth_cache_hits, auth_cache_misses,
+		      cupsArrayCount(auth_cache));
+
+    cupsArrayDelete(auth_cache);
+
+    auth_cache        = NULL;
+    auth_cache_hits   = 0;
+    auth_cache_misses = 0;
+  }
+
+  if (group_cache)
+  {
+    if (group_cache_hits || group_cache_misses)
+      cupsdLogMessage(CUPSD_LOG_INFO,
+		      "Group cache: %d hits, %d misses, %d entries.",
+		      group_cache_hits, group_cache_misses,
+		      cupsArrayCount(group_cache));
+
+    cupsArrayDelete(group_cache);
+
+    group_cache        = NULL;
+    group_cache_hits   = 0;
+    group_cache_misses = 0;
+  }
+}
+
+
+/*
+ * 'cupsdCopyLocation()' - Make a copy of a location...
+ */
+
+cupsd_location_t *			/* O - New location */
+cupsdCopyLocation(
+    cupsd_location_t *loc)		/* I - Original location */
+{
+  cupsd_location_t	*temp;		/* New location */
+
+
+ /*
+  * Make a copy of the original location...
+  */
+
+  if ((temp = calloc(1, sizeof(cupsd_location_t))) == NULL)
+    return (NULL);
+
+ /*
+  * Copy the information from the original location to the new one.
+  */
+
+  if (!loc)
+    return (temp);
+
+  if (loc->location)
+    temp->location = _cupsStrAlloc(loc->location);
+
+  temp->length     = loc->length;
+  temp->limit      = loc->limit;
+  temp->order_type = loc->order_type;
+  temp->type       = loc->type;
+  temp->level      = loc->level;
   temp->satisfy    = loc->satisfy;
   temp->encryption = loc->encryption;
 
@@ -1361,6 +1551,12 @@ cupsdDeleteAllLocations(void)
 
   cupsArrayDelete(Locations);
   Locations = NULL;
+
+  free_location_trie(loc_trie);
+  free_location_trie(loc_itrie);
+
+  loc_trie  = NULL;
+  loc_itrie = NULL;
 }
 
 
@@ -1375,10 +1571,16 @@ cupsdFindBest(const char   *path,	/* I - Resource path */
   char			uri[HTTP_MAX_URI],
 					/* URI in request... */
 			*uriptr;	/* Pointer into URI */
-  cupsd_location_t	*loc,		/* Current location */
-			*best;		/* Best match for location so far */
-  size_t		bestlen;	/* Length of best match */
-  int			limit;		/* Limit field */
+  cupsd_location_t	*best;		/* Best match for location so far */
+  cupsd_locnode_t	*node,		/* Current trie node */
+			*child;		/* Matching child node */
+  int			limit,		/* Limit field */
+			index,		/* Index into node limits */
+			icase,		/* Case-insensitive match? */
+			left,		/* Left side of binary search */
+			right,		/* Right side of binary search */
+			middle;		/* Middle of binary search */
+  size_t		i;		/* Looping var */
   static const int	limits[] =	/* Map http_status_t to CUPSD_AUTH_LIMIT_xyz */
 		{
 		  CUPSD_AUTH_LIMIT_ALL,
@@ -1428,52 +1630,94 @@ cupsdFindBest(const char   *path,	/* I - Resource path */
   }
 
  /*
-  * Loop through the list of locations to find a match...
+  * Walk the location trie to find the longest matching location for this
+  * limit...
   */
 
-  limit   = limits[state];
-  best    = NULL;
-  bestlen = 0;
+  limit = limits[state];
+  best  = NULL;
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdFindBest: uri=\"%s\", limit=%x...", uri, limit);
 
+  if (limit == CUPSD_AUTH_LIMIT_ALL)
+    index = CUPSD_LOCNODE_ANY;
+  else
+    for (index = 0; index < CUPSD_LOCNODE_ANY && !(limit & (1 << index)); index ++);
+
+  icase = !strncmp(uri, "/printers/", 10) || !strncmp(uri, "/classes/", 9);
 
-  for (loc = (cupsd_location_t *)cupsArrayFirst(Locations);
-       loc;
-       loc = (cupsd_location_t *)cupsArrayNext(Locations))
+  if (!loc_trie && !build_location_tries())
   {
-    cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdFindBest: Location %s(%d) Limit %x", loc->location ? loc->location : "(null)", (int)loc->length, loc->limit);
+   /*
+    * Unable to build the trie, loop through the list of locations...
+    */
 
-    if (!strncmp(uri, "/printers/", 10) || !strncmp(uri, "/classes/", 9))
-    {
-     /*
-      * Use case-insensitive comparison for queue names...
-      */
+    cupsd_location_t	*loc;		/* Current location */
+    size_t		bestlen = 0;	/* Length of best match */
 
-      if (loc->length > bestlen && loc->location &&
-          !_cups_strncasecmp(uri, loc->location, loc->length) &&
-	  loc->location[0] == '/' &&
-	  (limit & loc->limit) != 0)
+    for (loc = (cupsd_location_t *)cupsArrayFirst(Locations);
+         loc;
+	 loc = (cupsd_location_t *)cupsArrayNext(Locations))
+    {
+      if (loc->length > bestlen && loc->location && loc->location[0] == '/' &&
+	  (limit & loc->limit) != 0 &&
+          !(icase ? _cups_strncasecmp(uri, loc->location, loc->length) :
+	            strncmp(uri, loc->location, loc->length)))
       {
 	best    = loc;
 	bestlen = loc->length;
       }
     }
-    else
+
+    return (best);
+  }
+
+ /*
+  * Use case-insensitive comparison for queue names...
+  */
+
+  for (node = icase ? loc_itrie : loc_trie, uriptr = uri; node && *uriptr; node = child)
+  {
+   /*
+    * Find the child node starting with the next character...
+    */
+
+    for (left = 0, right = node->num_children - 1, child = NULL; left <= right;)
     {
-     /*
-      * Use case-sensitive comparison for other URIs...
-      */
+      int	ch = icase ? _cups_tolower(*uriptr) : *uriptr;
+					/* Next character */
 
-      if (loc->length > bestlen && loc->location &&
-          !strncmp(uri, loc->location, loc->length) &&
-	  loc->location[0] == '/' &&
-	  (limit & loc->limit) != 0)
+      middle = (left + right) / 2;
+
+      if (ch == node->children[middle]->label[0])
       {
-	best    = loc;
-	bestlen = loc->length;
+        child = node->children[middle];
+	break;
       }
+      else if (ch < node->children[middle]->label[0])
+        right = middle - 1;
+      else
+        left = middle + 1;
     }
+
+    if (!child)
+      break;
+
+   /*
+    * Then match the rest of its label...
+    */
+
+    for (i = 1; i < child->labellen && uriptr[i]; i ++)
+      if ((icase ? _cups_tolower(uriptr[i]) : uriptr[i]) != child->label[i])
+        break;
+
+    if (i < child->labellen)
+      break;
+
+    uriptr += child->labellen;
+
+    if (child->limits && child->limits[index])
+      best = child->limits[index];
   }
 
  /*
@@ -1509,7 +1753,12 @@ cupsdFindLocation(const char *location)	/* I - Connection */
 void
 cupsdFreeLocation(cupsd_location_t *loc)/* I - Location to free */
 {
+  delete_auth_index(loc->allow);
+  delete_auth_index(loc->deny);
+
   cupsArrayDelete(loc->names);
+  cupsArrayDelete(loc->users);
+  cupsArrayDelete(loc->groups);
   cupsArrayDelete(loc->allow);
   cupsArrayDelete(loc->deny);
 
@@ -1757,6 +2006,9 @@ cupsdIsAuthorized(cupsd_client_t *con,	/* I - Connection */
     if (cupsArrayCount(best->names) == 0)
       return (HTTP_OK);
 
+    if (!compile_names(best))
+      return (HTTP_SERVER_ERROR);
+
    /*
     * Otherwise check the user list and return OK if this user is
     * allowed...
@@ -1786,28 +2038,26 @@ cupsdIsAuthorized(cupsd_client_t *con,	/* I - Connection */
     }
 #endif /* HAVE_AUTHORIZATION_H */
 
-    for (name = (char *)cupsArrayFirst(best->names);
-	 name;
-	 name = (char *)cupsArrayNext(best->names))
+    if ((best->name_flags & CUPSD_AUTH_NAMES_OWNER) && owner &&
+        !_cups_strcasecmp(username, ownername))
+      return (HTTP_OK);
+
+    if (cupsArrayFind(best->users, (void *)username))
+      return (HTTP_OK);
+
+    if (best->name_flags & CUPSD_AUTH_NAMES_SYSTEM)
     {
-      if (!_cups_strcasecmp(name, "@OWNER") && owner &&
-          !_cups_strcasecmp(username, ownername))
-	return (HTTP_OK);
-      else if (!_cups_strcasecmp(name, "@SYSTEM"))
-      {
-        for (i = 0; i < NumSystemGroups; i ++)
-	  if (cupsdCheckGroup(username, pw, SystemGroups[i]))
-	    return (HTTP_OK);
-      }
-      else if (name[0] == '@')
-      {
-        if (cupsdCheckGroup(username, pw, name + 1))
-          return (HTTP_OK);
-      }
-      else if (!_cups_strcasecmp(username, name))
-        return (HTTP_OK);
+      for (i = 0; i < NumSystemGroups; i ++)
+	if (cupsdCheckGroup(username, pw, SystemGroups[i]))
+	  return (HTTP_OK);
     }
 
+    for (name = (char *)cupsArrayFirst(best->groups);
+	 name;
+	 name = (char *)cupsArrayNext(best->groups))
+      if (cupsdCheckGroup(username, pw, name))
+        return (HTTP_OK);
+
     return (con->username[0] ? HTTP_FORBIDDEN : HTTP_UNAUTHORIZED);
   }
 
@@ -1817,23 +2067,27 @@ cupsdIsAuthorized(cupsd_client_t *con,	/* I - Connection */
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdIsAuthorized: Checking group membership...");
 
+  if (!compile_names(best))
+    return (HTTP_SERVER_ERROR);
+
  /*
   * Check to see if this user is in any of the named groups...
   */
 
-  for (name = (char *)cupsArrayFirst(best->names);
+  if (best->name_flags & CUPSD_AUTH_NAMES_SYSTEM)
+  {
+    for (i = 0; i < NumSystemGroups; i ++)
+      if (cupsdCheckGroup(username, pw, SystemGroups[i]))
+	return (HTTP_OK);
+  }
+
+  for (name = (char *)cupsArrayFirst(best->groups);
        name;
-       name = (char *)cupsArrayNext(best->names))
+       name = (char *)cupsArrayNext(best->groups))
   {
     cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdIsAuthorized: Checking group \"%s\" membership...", name);
 
-    if (!_cups_strcasecmp(name, "@SYSTEM"))
-    {
-      for (i = 0; i < NumSystemGroups; i ++)
-	if (cupsdCheckGroup(username, pw, SystemGroups[i]))
-	  return (HTTP_OK);
-    }
-    else if (cupsdCheckGroup(username, pw, name))
+    if (cupsdCheckGroup(username, pw, name))
       return (HTTP_OK);
   }
 
@@ -1887,122 +2141,1012 @@ cupsdNewLocation(const char *location)	/* I - Location path */
 }
 
 
-#ifdef HAVE_AUTHORIZATION_H
 /*
- * 'check_authref()' - Check if an authorization services reference has the
- *		       supplied right.
+ * 'cupsdReportAuthCache()' - Log statistics for the authentication and group
+ *                            caches.
  */
 
-static int				/* O - 1 if right is valid, 0 otherwise */
-check_authref(cupsd_client_t *con,	/* I - Connection */
-	      const char     *right)	/* I - Right name */
+void
+cupsdReportAuthCache(void)
 {
-  OSStatus		status;		/* OS Status */
-  AuthorizationItem	authright;	/* Authorization right */
-  AuthorizationRights	authrights;	/* Authorization rights */
-  AuthorizationFlags	authflags;	/* Authorization flags */
+  if (AuthCacheTimeout > 0)
+  {
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: auth-cache-entries=%d",
+		    cupsArrayCount(auth_cache));
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: auth-cache-hits=%d",
+		    auth_cache_hits);
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: auth-cache-misses=%d",
+		    auth_cache_misses);
+  }
+
+  if (GroupCacheTimeout > 0)
+  {
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: group-cache-entries=%d",
+		    cupsArrayCount(group_cache));
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: group-cache-hits=%d",
+		    group_cache_hits);
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: group-cache-misses=%d",
+		    group_cache_misses);
+  }
+}
+
+
+/*
+ * 'add_ip_node()' - Add an IP network to the IP trie of an index.
+ */
+
+static int				/* O - 1 if added, 0 if not a network,
+					 *    -1 on error */
+add_ip_node(cupsd_authindex_t *index,	/* I - Index */
+            cupsd_authmask_t  *mask)	/* I - IP mask */
+{
+  int			i,		/* Looping var */
+			bits;		/* Number of bits in netmask */
+  cupsd_ipnode_t	*node;		/* Current node */
+  unsigned		*address = mask->mask.ip.address,
+					/* Network address */
+			*netmask = mask->mask.ip.netmask;
+					/* Network mask */
 
 
  /*
-  * Check to see if the user is allowed to perform the task...
+  * Only contiguous netmasks can be added...
   */
 
-  if (!con->authref)
-    return (0);
+  for (bits = 0; bits < 128 && (netmask[bits / 32] & (0x80000000U >> (bits % 32))); bits ++);
 
-  authright.name        = right;
-  authright.valueLength = 0;
-  authright.value       = NULL;
-  authright.flags       = 0;
+  for (i = bits; i < 128; i ++)
+    if (netmask[i / 32] & (0x80000000U >> (i % 32)))
+      return (0);
 
-  authrights.count = 1;
-  authrights.items = &authright;
+  for (i = 0; i < 4; i ++)
+    if (address[i] & ~netmask[i])
+      return (1);			/* Never matches, like "Allow none" */
 
-  authflags = kAuthorizationFlagDefaults |
-	      kAuthorizationFlagExtendRights;
+ /*
+  * Add nodes for each bit of the network address...
+  */
 
-  if ((status = AuthorizationCopyRights(con->authref, &authrights,
-					kAuthorizationEmptyEnvironment,
-					authflags, NULL)) != 0)
+  if (!index->ip && (index->ip = calloc(1, sizeof(cupsd_ipnode_t))) == NULL)
+    return (-1);
+
+  for (i = 0, node = index->ip; i < bits && !node->match; i ++)
   {
-    cupsdLogMessage(CUPSD_LOG_ERROR,
-		    "AuthorizationCopyRights(\"%s\") returned %d (%s)",
-		    authright.name, (int)status, cssmErrorString(status));
-    return (0);
+    int	bit = (address[i / 32] >> (31 - i % 32)) & 1;
+					/* Next address bit */
+
+    if (!node->child[bit] && (node->child[bit] = calloc(1, sizeof(cupsd_ipnode_t))) == NULL)
+      return (-1);
+
+    node = node->child[bit];
   }
 
-  cupsdLogMessage(CUPSD_LOG_DEBUG2, "AuthorizationCopyRights(\"%s\") succeeded.", authright.name);
+  node->match = 1;
 
   return (1);
 }
-#endif /* HAVE_AUTHORIZATION_H */
 
 
 /*
- * 'compare_locations()' - Compare two locations.
+ * 'add_location_node()' - Add a location to a location trie.
  */
 
-static int				/* O - Result of comparison */
-compare_locations(cupsd_location_t *a,	/* I - First location */
-                  cupsd_location_t *b)	/* I - Second location */
+static int				/* O - 1 on success, 0 on error */
+add_location_node(
+    cupsd_locnode_t  *root,		/* I - Root node */
+    const char       *key,		/* I - Location path */
+    cupsd_location_t *loc)		/* I - Location */
 {
-  return (strcmp(b->location, a->location));
-}
+  cupsd_locnode_t	*node,		/* Current node */
+			*child,		/* Child node */
+			*mid,		/* Node for split label */
+			**children;	/* New child array */
+  int			i;		/* Looping var */
+  size_t		len;		/* Length of common prefix */
 
 
-/*
- * 'copy_authmask()' - Copy function for auth masks.
- */
+  for (node = root; *key; node = child, key += len)
+  {
+   /*
+    * Find the child that starts with the next character...
+    */
 
-static cupsd_authmask_t	*		/* O - New auth mask */
-copy_authmask(cupsd_authmask_t *mask,	/* I - Existing auth mask */
-              void             *data)	/* I - User data (unused) */
-{
-  cupsd_authmask_t	*temp;		/* New auth mask */
+    for (i = 0; i < node->num_children; i ++)
+      if (node->children[i]->label[0] >= *key)
+        break;
 
+    if (i < node->num_children && node->children[i]->label[0] == *key)
+    {
+     /*
+      * Match as much of the child's label as possible, splitting the child
+      * if the key ends or differs in the middle of it...
+      */
 
-  (void)data;
+      child = node->children[i];
 
-  if ((temp = malloc(sizeof(cupsd_authmask_t))) != NULL)
-  {
-    memcpy(temp, mask, sizeof(cupsd_authmask_t));
+      for (len = 1; len < child->labellen && key[len] == child->label[len]; len ++);
 
-    if (temp->type == CUPSD_AUTH_NAME || temp->type == CUPSD_AUTH_INTERFACE)
+      if (len < child->labellen)
+      {
+        if ((mid = calloc(1, sizeof(cupsd_locnode_t))) == NULL ||
+	    (mid->children = malloc(sizeof(cupsd_locnode_t *))) == NULL ||
+	    (mid->label = strndup(child->label, len)) == NULL)
+	{
+	  if (mid)
+	  {
+	    free(mid->children);
+	    free(mid);
+	  }
+
+	  return (0);
+	}
+
+        memmove(child->label, child->label + len, child->labellen - len + 1);
+	child->labellen -= len;
+
+	mid->labellen       = len;
+	mid->num_children   = 1;
+	mid->children[0]    = child;
+	node->children[i]   = mid;
+        child               = mid;
+      }
+    }
+    else
     {
      /*
-      * Make a copy of the name...
+      * Add a new child for the rest of the key...
       */
 
-      if ((temp->mask.name.name = _cupsStrAlloc(temp->mask.name.name)) == NULL)
-      {
-       /*
-        * Failed to make copy...
-	*/
+      if ((children = realloc(node->children, (size_t)(node->num_children + 1) * sizeof(cupsd_locnode_t *))) == NULL)
+        return (0);
 
-        free(temp);
-	temp = NULL;
+      node->children = children;
+
+      if ((child = calloc(1, sizeof(cupsd_locnode_t))) == NULL)
+        return (0);
+
+      if ((child->label = strdup(key)) == NULL)
+      {
+        free(child);
+	return (0);
       }
+
+      child->labellen = len = strlen(key);
+
+      memmove(node->children + i + 1, node->children + i, (size_t)(node->num_children - i) * sizeof(cupsd_locnode_t *));
+      node->children[i] = child;
+      node->num_children ++;
     }
   }
 
-  return (temp);
+ /*
+  * Record the location for each of its limits, unless an earlier location
+  * for the same path already has them...
+  */
+
+  if (!node->limits && (node->limits = calloc(CUPSD_LOCNODE_ANY + 1, sizeof(cupsd_location_t *))) == NULL)
+    return (0);
+
+  for (i = 0; i < CUPSD_LOCNODE_ANY; i ++)
+    if ((loc->limit & (1 << i)) && !node->limits[i])
+      node->limits[i] = loc;
+
+  if ((loc->limit & CUPSD_AUTH_LIMIT_ALL) && !node->limits[CUPSD_LOCNODE_ANY])
+    node->limits[CUPSD_LOCNODE_ANY] = loc;
+
+  return (1);
 }
 
 
 /*
- * 'free_authmask()' - Free function for auth masks.
+ * 'build_location_tries()' - Build the location tries used by cupsdFindBest().
  */
 
-static void
-free_authmask(cupsd_authmask_t *mask,	/* I - Auth mask to free */
-              void             *data)	/* I - User data (unused) */
+static int				/* O - 1 on success, 0 on error */
+build_location_tries(void)
 {
-  (void)data;
+  cupsd_location_t	*loc;		/* Current location */
+  char			key[HTTP_MAX_URI],
+					/* Lowercase location path */
+			*keyptr;	/* Pointer into key */
+  int			ok = 1;		/* Added all locations? */
 
-  if (mask->type == CUPSD_AUTH_NAME || mask->type == CUPSD_AUTH_INTERFACE)
-    _cupsStrFree(mask->mask.name.name);
 
-  free(mask);
+  if ((loc_trie = calloc(1, sizeof(cupsd_locnode_t))) == NULL ||
+      (loc_itrie = calloc(1, sizeof(cupsd_locnode_t))) == NULL)
+  {
+    ok = 0;
+  }
+  else
+  {
+    for (loc = (cupsd_location_t *)cupsArrayFirst(Locations);
+	 loc && ok;
+	 loc = (cupsd_location_t *)cupsArrayNext(Locations))
+    {
+      if (!loc->location || loc->location[0] != '/')
+	continue;
+
+      strlcpy(key, loc->location, sizeof(key));
+      for (keyptr = key; *keyptr; keyptr ++)
+	*keyptr = (char)_cups_tolower(*keyptr);
+
+      ok = add_location_node(loc_trie, loc->location, loc) &&
+	   add_location_node(loc_itrie, key, loc);
+    }
+  }
+
+  if (!ok)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to build location index: %s", strerror(errno));
+
+    free_location_trie(loc_trie);
+    free_location_trie(loc_itrie);
+
+    loc_trie  = NULL;
+    loc_itrie = NULL;
+  }
+
+  return (ok);
+}
+
+
+/*
+ * 'check_auth_index()' - Check an address and hostname against an index of
+ *                        authorization masks.
+ */
+
+static int				/* O - 1 if a mask matches, 0 otherwise */
+check_auth_index(
+    cupsd_authindex_t *index,		/* I - Index */
+    unsigned          ip[4],		/* I - Client address */
+    const char        *name,		/* I - Client hostname */
+    size_t            name_len)		/* I - Length of hostname */
+{
+  int			i;		/* Looping var */
+  cupsd_ipnode_t	*node;		/* Current IP trie node */
+  cupsd_authmask_t	*mask;		/* Current mask */
+  char			lname[HTTP_MAX_HOST],
+					/* Lowercase hostname */
+			*lptr;		/* Pointer into hostname */
+
+
+ /*
+  * Check for IP/network address match...
+  */
+
+  for (i = 0, node = index->ip; node; i ++)
+  {
+    if (node->match)
+      return (1);
+
+    if (i >= 128)
+      break;
+
+    node = node->child[(ip[i / 32] >> (31 - i % 32)) & 1];
+  }
+
+  for (mask = (cupsd_authmask_t *)cupsArrayFirst(index->ipmasks);
+       mask;
+       mask = (cupsd_authmask_t *)cupsArrayNext(index->ipmasks))
+  {
+    for (i = 0; i < 4; i ++)
+      if ((ip[i] & mask->mask.ip.netmask[i]) != mask->mask.ip.address[i])
+        break;
+
+    if (i == 4)
+      return (1);
+  }
+
+ /*
+  * Check for exact name match and then domain match for each domain suffix
+  * of the hostname...
+  */
+
+  if (cupsArrayCount(index->names) > 0 && name_len < sizeof(lname))
+  {
+    for (lptr = lname; *name && lptr < (lname + name_len); name ++)
+      *lptr++ = (char)_cups_tolower(*name);
+    *lptr = '\0';
+
+    if (cupsArrayFind(index->names, lname))
+      return (1);
+
+    for (lptr = strchr(lname, '.'); lptr; lptr = strchr(lptr + 1, '.'))
+      if (cupsArrayFind(index->names, lptr))
+        return (1);
+  }
+
+ /*
+  * Check for a match with a network interface...
+  */
+
+  for (mask = (cupsd_authmask_t *)cupsArrayFirst(index->interfaces);
+       mask;
+       mask = (cupsd_authmask_t *)cupsArrayNext(index->interfaces))
+    if (check_interface(mask, ip))
+      return (1);
+
+  return (0);
+}
+
+
+#ifdef HAVE_AUTHORIZATION_H
+/*
+ * 'check_authref()' - Check if an authorization services reference has the
+ *		       supplied right.
+ */
+
+static int				/* O - 1 if right is valid, 0 otherwise */
+check_authref(cupsd_client_t *con,	/* I - Connection */
+	      const char     *right)	/* I - Right name */
+{
+  OSStatus		status;		/* OS Status */
+  AuthorizationItem	authright;	/* Authorization right */
+  AuthorizationRights	authrights;	/* Authorization rights */
+  AuthorizationFlags	authflags;	/* Authorization flags */
+
+
+ /*
+  * Check to see if the user is allowed to perform the task...
+  */
+
+  if (!con->authref)
+    return (0);
+
+  authright.name        = right;
+  authright.valueLength = 0;
+  authright.value       = NULL;
+  authright.flags       = 0;
+
+  authrights.count = 1;
+  authrights.items = &authright;
+
+  authflags = kAuthorizationFlagDefaults |
+	      kAuthorizationFlagExtendRights;
+
+  if ((status = AuthorizationCopyRights(con->authref, &authrights,
+					kAuthorizationEmptyEnvironment,
+					authflags, NULL)) != 0)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR,
+		    "AuthorizationCopyRights(\"%s\") returned %d (%s)",
+		    authright.name, (int)status, cssmErrorString(status));
+    return (0);
+  }
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG2, "AuthorizationCopyRights(\"%s\") succeeded.", authright.name);
+
+  return (1);
+}
+#endif /* HAVE_AUTHORIZATION_H */
+
+
+/*
+ * 'check_group()' - Check to see if a user is a member of a group.
+ */
+
+static int				/* O - 1 if member, 0 if not */
+check_group(
+    const char    *username,		/* I - User name */
+    struct passwd *user,		/* I - System user info */
+    const char    *groupname)		/* I - Group name */
+{
+  int		i;			/* Looping var */
+  struct group	*group;			/* Group info */
+  gid_t		groupid;		/* ID of named group */
+#ifdef HAVE_MBR_UID_TO_UUID
+  uuid_t	useruuid,		/* UUID for username */
+		groupuuid;		/* UUID for groupname */
+  int		is_member;		/* True if user is a member of group */
+#endif /* HAVE_MBR_UID_TO_UUID */
+
+
+ /*
+  * Check to see if the user is a member of the named group...
+  */
+
+  group = getgrnam(groupname);
+  endgrent();
+
+  if (group != NULL)
+  {
+   /*
+    * Group exists, check it...
+    */
+
+    groupid = group->gr_gid;
+
+#ifdef HAVE_GETGROUPLIST
+    if (user)
+    {
+      int	ngroups;		/* Number of groups */
+#  ifdef __APPLE__
+      int	groups[2048];		/* Groups that user belongs to */
+#  else
+      gid_t	groups[2048];		/* Groups that user belongs to */
+#  endif /* __APPLE__ */
+
+      ngroups = (int)(sizeof(groups) / sizeof(groups[0]));
+#  ifdef __APPLE__
+      getgrouplist(username, (int)user->pw_gid, groups, &ngroups);
+#  else
+      getgrouplist(username, user->pw_gid, groups, &ngroups);
+#endif /* __APPLE__ */
+
+      for (i = 0; i < ngroups; i ++)
+        if ((int)groupid == (int)groups[i])
+	  return (1);
+    }
+
+#else
+    for (i = 0; group->gr_mem[i]; i ++)
+    {
+      if (!_cups_strcasecmp(username, group->gr_mem[i]))
+	return (1);
+    }
+#endif /* HAVE_GETGROUPLIST */
+  }
+  else
+    groupid = (gid_t)-1;
+
+ /*
+  * Group doesn't exist or user not in group list, check the group ID
+  * against the user's group ID...
+  */
+
+  if (user && groupid == user->pw_gid)
+    return (1);
+
+#ifdef HAVE_MBR_UID_TO_UUID
+ /*
+  * Check group membership through macOS membership API...
+  */
+
+  if (user && !mbr_uid_to_uuid(user->pw_uid, useruuid))
+  {
+    if (groupid != (gid_t)-1)
+    {
+     /*
+      * Map group name to UUID and check membership...
+      */
+
+      if (!mbr_gid_to_uuid(groupid, groupuuid))
+        if (!mbr_check_membership(useruuid, groupuuid, &is_member))
+	  if (is_member)
+	    return (1);
+    }
+    else if (groupname[0] == '#')
+    {
+     /*
+      * Use UUID directly and check for equality (user UUID) and
+      * membership (group UUID)...
+      */
+
+      if (!uuid_parse((char *)groupname + 1, groupuuid))
+      {
+        if (!uuid_compare(useruuid, groupuuid))
+	  return (1);
+	else if (!mbr_check_membership(useruuid, groupuuid, &is_member))
+	  if (is_member)
+	    return (1);
+      }
+
+      return (0);
+    }
+  }
+  else if (groupname[0] == '#')
+    return (0);
+#endif /* HAVE_MBR_UID_TO_UUID */
+
+ /*
+  * If we get this far, then the user isn't part of the named group...
+  */
+
+  return (0);
+}
+
+
+/*
+ * 'check_interface()' - Check an address against a network interface mask.
+ */
+
+static int				/* O - 1 if address matches, 0 otherwise */
+check_interface(
+    cupsd_authmask_t *mask,		/* I - Interface mask */
+    unsigned         ip[4])		/* I - Client address */
+{
+  cupsd_netif_t		*iface;		/* Network interface */
+  unsigned		netip4;		/* IPv4 network address */
+#ifdef AF_INET6
+  int			i;		/* Looping var */
+  unsigned		netip6[4];	/* IPv6 network address */
+#endif /* AF_INET6 */
+
+
+  netip4 = htonl(ip[3]);
+
+#ifdef AF_INET6
+  netip6[0] = htonl(ip[0]);
+  netip6[1] = htonl(ip[1]);
+  netip6[2] = htonl(ip[2]);
+  netip6[3] = htonl(ip[3]);
+#endif /* AF_INET6 */
+
+  cupsdNetIFUpdate();
+
+  if (!strcmp(mask->mask.name.name, "*"))
+  {
+#ifdef __APPLE__
+   /*
+    * Allow Back-to-My-Mac addresses...
+    */
+
+    if ((ip[0] & 0xff000000) == 0xfd000000)
+      return (1);
+#endif /* __APPLE__ */
+
+   /*
+    * Check against all local interfaces...
+    */
+
+    for (iface = (cupsd_netif_t *)cupsArrayFirst(NetIFList);
+	 iface;
+	 iface = (cupsd_netif_t *)cupsArrayNext(NetIFList))
+    {
+     /*
+      * Only check local interfaces...
+      */
+
+      if (!iface->is_local)
+	continue;
+
+      if (iface->address.addr.sa_family == AF_INET)
+      {
+       /*
+	* Check IPv4 address...
+	*/
+
+	if ((netip4 & iface->mask.ipv4.sin_addr.s_addr) ==
+	    (iface->address.ipv4.sin_addr.s_addr &
+	     iface->mask.ipv4.sin_addr.s_addr))
+	  return (1);
+      }
+#ifdef AF_INET6
+      else
+      {
+       /*
+	* Check IPv6 address...
+	*/
+
+	for (i = 0; i < 4; i ++)
+	  if ((netip6[i] & iface->mask.ipv6.sin6_addr.s6_addr32[i]) !=
+	      (iface->address.ipv6.sin6_addr.s6_addr32[i] &
+	       iface->mask.ipv6.sin6_addr.s6_addr32[i]))
+	    break;
+
+	if (i == 4)
+	  return (1);
+      }
+#endif /* AF_INET6 */
+    }
+  }
+  else
+  {
+   /*
+    * Check the named interface...
+    */
+
+    for (iface = (cupsd_netif_t *)cupsArrayFirst(NetIFList);
+	 iface;
+	 iface = (cupsd_netif_t *)cupsArrayNext(NetIFList))
+    {
+      if (strcmp(mask->mask.name.name, iface->name))
+	continue;
+
+      if (iface->address.addr.sa_family == AF_INET)
+      {
+       /*
+	* Check IPv4 address...
+	*/
+
+	if ((netip4 & iface->mask.ipv4.sin_addr.s_addr) ==
+	    (iface->address.ipv4.sin_addr.s_addr &
+	     iface->mask.ipv4.sin_addr.s_addr))
+	  return (1);
+      }
+#ifdef AF_INET6
+      else
+      {
+       /*
+	* Check IPv6 address...
+	*/
+
+	for (i = 0; i < 4; i ++)
+	  if ((netip6[i] & iface->mask.ipv6.sin6_addr.s6_addr32[i]) !=
+	      (iface->address.ipv6.sin6_addr.s6_addr32[i] &
+	       iface->mask.ipv6.sin6_addr.s6_addr32[i]))
+	    break;
+
+	if (i == 4)
+	  return (1);
+      }
+#endif /* AF_INET6 */
+    }
+  }
+
+  return (0);
+}
+
+
+/*
+ * 'compare_auth_cache()' - Compare two authentication cache entries.
+ */
+
+static int				/* O - Result of comparison */
+compare_auth_cache(cupsd_authcache_t *a,/* I - First entry */
+                   cupsd_authcache_t *b)/* I - Second entry */
+{
+  return (memcmp(a->hash, b->hash, sizeof(a->hash)));
+}
+
+
+/*
+ * 'compare_auth_index()' - Compare two authorization mask indexes.
+ */
+
+static int				/* O - Result of comparison */
+compare_auth_index(cupsd_authindex_t *a,/* I - First index */
+                   cupsd_authindex_t *b)/* I - Second index */
+{
+  if (a->masks < b->masks)
+    return (-1);
+  else if (a->masks > b->masks)
+    return (1);
+  else
+    return (0);
+}
+
+
+/*
+ * 'compare_group_cache()' - Compare two group cache entries.
+ */
+
+static int				/* O - Result of comparison */
+compare_group_cache(
+    cupsd_groupcache_t *a,		/* I - First entry */
+    cupsd_groupcache_t *b)		/* I - Second entry */
+{
+  int	result;				/* Result of comparison */
+
+
+  if ((result = strcmp(a->username, b->username)) != 0)
+    return (result);
+  else if ((result = strcmp(a->groupname, b->groupname)) != 0)
+    return (result);
+  else if (a->has_user != b->has_user)
+    return (a->has_user - b->has_user);
+  else if (a->uid != b->uid)
+    return (a->uid < b->uid ? -1 : 1);
+  else if (a->gid != b->gid)
+    return (a->gid < b->gid ? -1 : 1);
+  else
+    return (0);
+}
+
+
+/*
+ * 'compare_locations()' - Compare two locations.
+ */
+
+static int				/* O - Result of comparison */
+compare_locations(cupsd_location_t *a,	/* I - First location */
+                  cupsd_location_t *b)	/* I - Second location */
+{
+  return (strcmp(b->location, a->location));
+}
+
+
+/*
+ * 'compile_names()' - Sort the names of a location into user names, group
+ *                     names, and flags for @OWNER and @SYSTEM.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+compile_names(cupsd_location_t *loc)	/* I - Location */
+{
+  char	*name;				/* Current name */
+
+
+  if (loc->num_compiled == cupsArrayCount(loc->names) &&
+      loc->compiled_level == loc->level && (loc->users || loc->groups))
+    return (1);
+
+  cupsArrayDelete(loc->users);
+  cupsArrayDelete(loc->groups);
+
+  loc->num_compiled   = cupsArrayCount(loc->names);
+  loc->compiled_level = loc->level;
+  loc->name_flags     = 0;
+  loc->users          = cupsArrayNew((cups_array_func_t)_cups_strcasecmp, NULL);
+  loc->groups         = cupsArrayNew(NULL, NULL);
+
+  if (!loc->users || !loc->groups)
+    goto error;
+
+  for (name = (char *)cupsArrayFirst(loc->names);
+       name;
+       name = (char *)cupsArrayNext(loc->names))
+  {
+    if (!_cups_strcasecmp(name, "@SYSTEM"))
+      loc->name_flags |= CUPSD_AUTH_NAMES_SYSTEM;
+    else if (loc->level == CUPSD_AUTH_GROUP)
+    {
+      if (!cupsArrayAdd(loc->groups, name))
+        goto error;
+    }
+    else if (!_cups_strcasecmp(name, "@OWNER"))
+      loc->name_flags |= CUPSD_AUTH_NAMES_OWNER;
+    else if (name[0] == '@')
+    {
+      if (!cupsArrayAdd(loc->groups, name + 1))
+        goto error;
+    }
+    else if (!cupsArrayFind(loc->users, name) && !cupsArrayAdd(loc->users, name))
+      goto error;
+  }
+
+  return (1);
+
+ /*
+  * If we get here, we ran out of memory...
+  */
+
+  error:
+
+  cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to compile names for location %s: %s", loc->location ? loc->location : "nil", strerror(errno));
+
+  cupsArrayDelete(loc->users);
+  cupsArrayDelete(loc->groups);
+
+  loc->users  = NULL;
+  loc->groups = NULL;
+
+  return (0);
+}
+
+
+/*
+ * 'copy_authmask()' - Copy function for auth masks.
+ */
+
+static cupsd_authmask_t	*		/* O - New auth mask */
+copy_authmask(cupsd_authmask_t *mask,	/* I - Existing auth mask */
+              void             *data)	/* I - User data (unused) */
+{
+  cupsd_authmask_t	*temp;		/* New auth mask */
+
+
+  (void)data;
+
+  if ((temp = malloc(sizeof(cupsd_authmask_t))) != NULL)
+  {
+    memcpy(temp, mask, sizeof(cupsd_authmask_t));
+
+    if (temp->type == CUPSD_AUTH_NAME || temp->type == CUPSD_AUTH_INTERFACE)
+    {
+     /*
+      * Make a copy of the name...
+      */
+
+      if ((temp->mask.name.name = _cupsStrAlloc(temp->mask.name.name)) == NULL)
+      {
+       /*
+        * Failed to make copy...
+	*/
+
+        free(temp);
+	temp = NULL;
+      }
+    }
+  }
+
+  return (temp);
+}
+
+
+/*
+ * 'delete_auth_index()' - Delete the index for an array of masks.
+ */
+
+static void
+delete_auth_index(cups_array_t *masks)	/* I - Masks */
+{
+  cupsd_authindex_t	key,		/* Search key */
+			*index;		/* Index */
+
+
+  if (!auth_indexes || !masks)
+    return;
+
+  key.masks = masks;
+
+  if ((index = (cupsd_authindex_t *)cupsArrayFind(auth_indexes, &key)) != NULL)
+  {
+    cupsArrayRemove(auth_indexes, index);
+    free_auth_index(index);
+  }
+}
+
+
+/*
+ * 'find_auth_index()' - Find or build the index for an array of masks.
+ */
+
+static cupsd_authindex_t *		/* O - Index or @code NULL@ on error */
+find_auth_index(cups_array_t *masks)	/* I - Masks */
+{
+  cupsd_authindex_t	key,		/* Search key */
+			*index;		/* Index */
+  cupsd_authmask_t	*mask;		/* Current mask */
+  char			*name,		/* Lowercase name */
+			*nameptr;	/* Pointer into name */
+  int			ok = 1;		/* Indexed all masks? */
+
+
+  if (!auth_indexes &&
+      (auth_indexes = cupsArrayNew((cups_array_func_t)compare_auth_index, NULL)) == NULL)
+    return (NULL);
+
+  key.masks = masks;
+
+  if ((index = (cupsd_authindex_t *)cupsArrayFind(auth_indexes, &key)) != NULL)
+  {
+    if (index->count == cupsArrayCount(masks))
+      return (index);
+
+   /*
+    * Masks were added, rebuild the index...
+    */
+
+    cupsArrayRemove(auth_indexes, index);
+    free_auth_index(index);
+  }
+
+  if ((index = calloc(1, sizeof(cupsd_authindex_t))) == NULL)
+    return (NULL);
+
+  index->masks      = masks;
+  index->count      = cupsArrayCount(masks);
+  index->ipmasks    = cupsArrayNew(NULL, NULL);
+  index->names      = cupsArrayNew3((cups_array_func_t)strcmp, NULL, NULL, 0, NULL, (cups_afree_func_t)free);
+  index->interfaces = cupsArrayNew(NULL, NULL);
+
+  if (!index->ipmasks || !index->names || !index->interfaces)
+    ok = 0;
+
+  for (mask = (cupsd_authmask_t *)cupsArrayFirst(masks);
+       mask && ok;
+       mask = (cupsd_authmask_t *)cupsArrayNext(masks))
+  {
+    switch (mask->type)
+    {
+      case CUPSD_AUTH_INTERFACE :
+          ok = cupsArrayAdd(index->interfaces, mask);
+          break;
+
+      case CUPSD_AUTH_NAME :
+          if ((name = strdup(mask->mask.name.name)) == NULL)
+	  {
+	    ok = 0;
+	    break;
+	  }
+
+          for (nameptr = name; *nameptr; nameptr ++)
+	    *nameptr = (char)_cups_tolower(*nameptr);
+
+          if (!cupsArrayFind(index->names, name))
+            ok = cupsArrayAdd(index->names, name);
+	  else
+	    free(name);
+          break;
+
+      case CUPSD_AUTH_IP :
+          switch (add_ip_node(index, mask))
+	  {
+	    case 0 :
+	        ok = cupsArrayAdd(index->ipmasks, mask);
+	        break;
+	    case -1 :
+	        ok = 0;
+		break;
+	  }
+          break;
+    }
+  }
+
+  if (!ok || !cupsArrayAdd(auth_indexes, index))
+  {
+    free_auth_index(index);
+    return (NULL);
+  }
+
+  return (index);
+}
+
+
+/*
+ * 'free_auth_index()' - Free an index of authorization masks.
+ */
+
+static void
+free_auth_index(
+    cupsd_authindex_t *index)		/* I - Index */
+{
+  free_ip_trie(index->ip);
+
+  cupsArrayDelete(index->ipmasks);
+  cupsArrayDelete(index->names);
+  cupsArrayDelete(index->interfaces);
+
+  free(index);
+}
+
+
+/*
+ * 'free_authmask()' - Free function for auth masks.
+ */
+
+static void
+free_authmask(cupsd_authmask_t *mask,	/* I - Auth mask to free */
+              void             *data)	/* I - User data (unused) */
+{
+  (void)data;
+
+  if (mask->type == CUPSD_AUTH_NAME || mask->type == CUPSD_AUTH_INTERFACE)
+    _cupsStrFree(mask->mask.name.name);
+
+  free(mask);
+}
+
+
+/*
+ * 'free_ip_trie()' - Free an IP address trie.
+ */
+
+static void
+free_ip_trie(cupsd_ipnode_t *node)	/* I - Root node */
+{
+  if (!node)
+    return;
+
+  free_ip_trie(node->child[0]);
+  free_ip_trie(node->child[1]);
+
+  free(node);
+}
+
+
+/*
+ * 'free_location_trie()' - Free a location trie.
+ */
+
+static void
+free_location_trie(
+    cupsd_locnode_t *node)		/* I - Root node */
+{
+  int	i;				/* Looping var */
+
+
+  if (!node)
+    return;
+
+  for (i = 0; i < node->num_children; i ++)
+    free_location_trie(node->children[i]);
+
+  free(node->children);
+  free(node->limits);
+  free(node->label);
+  free(node);
 }
 
 
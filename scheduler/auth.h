@@ -48,6 +48,9 @@
 #define CUPSD_AUTH_LIMIT_ALL	127	/* Limit all requests */
 #define CUPSD_AUTH_LIMIT_IPP	128	/* Limit IPP requests */
 
+#define CUPSD_AUTH_NAMES_OWNER	1	/* @OWNER is in the names */
+#define CUPSD_AUTH_NAMES_SYSTEM	2	/* @SYSTEM is in the names */
+
 #define IPP_ANY_OPERATION	(ipp_op_t)0
 					/* Any IPP operation */
 #define IPP_BAD_OPERATION	(ipp_op_t)-1
@@ -94,6 +97,11 @@ typedef struct
 			*allow,		/* Allow lines */
 			*deny;		/* Deny lines */
   http_encryption_t	encryption;	/* To encrypt or not to encrypt... */
+  int			num_compiled,	/* Number of names compiled */
+			compiled_level,	/* Access level of compiled names */
+			name_flags;	/* @OWNER/@SYSTEM in names */
+  cups_array_t		*users,		/* Compiled user names */
+			*groups;	/* Compiled group names */
 } cupsd_location_t;
 
 typedef struct cupsd_client_s cupsd_client_t;
@@ -105,6 +113,10 @@ typedef struct cupsd_client_s cupsd_client_t;
 
 VAR cups_array_t	*Locations	VALUE(NULL);
 					/* Authorization locations */
+VAR int			AuthCacheTimeout VALUE(0),
+					/* Seconds to cache Basic authentications */
+			GroupCacheTimeout VALUE(0);
+					/* Seconds to cache group memberships */
 #ifdef HAVE_SSL
 VAR http_encryption_t	DefaultEncryption VALUE(HTTP_ENCRYPT_REQUIRED);
 					/* Default encryption for authentication */
@@ -115,6 +127,7 @@ VAR http_encryption_t	DefaultEncryption VALUE(HTTP_ENCRYPT_REQUIRED);
  * Prototypes...
  */
 
+extern void		cupsdAddAuthCache(const unsigned char *hash);
 extern int		cupsdAddIPMask(cups_array_t **masks,
 				       const unsigned address[4],
 				       const unsigned netmask[4]);
@@ -124,9 +137,14 @@ extern int		cupsdAddNameMask(cups_array_t **masks, char *name);
 extern void		cupsdAuthorize(cupsd_client_t *con);
 extern int		cupsdCheckAccess(unsigned ip[4], const char *name, size_t namelen, cupsd_location_t *loc);
 extern int		cupsdCheckAuth(unsigned ip[4], const char *name, size_t namelen, cups_array_t *masks);
+extern int		cupsdCheckAuthCache(const char *hostname,
+			                    const char *username,
+			                    const char *password,
+			                    unsigned char *hash);
 extern int		cupsdCheckGroup(const char *username,
 			                struct passwd *user,
 			                const char *groupname);
+extern void		cupsdClearAuthCache(void);
 extern cupsd_location_t	*cupsdCopyLocation(cupsd_location_t *loc);
 extern void		cupsdDeleteAllLocations(void);
 extern cupsd_location_t	*cupsdFindBest(const char *path, http_state_t state);
@@ -134,3 +152,4 @@ extern cupsd_location_t	*cupsdFindLocation(const char *location);
 extern void		cupsdFreeLocation(cupsd_location_t *loc);
 extern http_status_t	cupsdIsAuthorized(cupsd_client_t *con, const char *owner);
 extern cupsd_location_t	*cupsdNewLocation(const char *location);
+extern void		cupsdReportAuthCache(void);
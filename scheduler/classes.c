@@ -274,6 +274,9 @@ cupsdLoadAllClasses(void)
   */
 
   snprintf(line, sizeof(line), "%s/classes.conf", ServerRoot);
+
+  cupsdReplayJournal(line, ConfigFilePerm);
+
   if ((fp = cupsdOpenConfFile(line)) == NULL)
     return;
 
@@ -656,7 +659,8 @@ cupsdLoadAllClasses(void)
 void
 cupsdSaveAllClasses(void)
 {
-  cups_file_t		*fp;		/* classes.conf file */
+  cupsd_journal_t	*j;		/* classes.conf journal */
+  cups_file_t		*fp;		/* classes.conf record */
   char			filename[1024],	/* classes.conf filename */
 			temp[1024],	/* Temporary string */
 			value[2048],	/* Value string */
@@ -674,7 +678,8 @@ cupsdSaveAllClasses(void)
 
   snprintf(filename, sizeof(filename), "%s/classes.conf", ServerRoot);
 
-  if ((fp = cupsdCreateConfFile(filename, ConfigFilePerm)) == NULL)
+  if ((j = cupsdBeginJournal(filename, ConfigFilePerm,
+                             CUPSD_DIRTY_CLASSES)) == NULL)
     return;
 
   cupsdLogMessage(CUPSD_LOG_INFO, "Saving classes.conf...");
@@ -687,6 +692,8 @@ cupsdSaveAllClasses(void)
   curdate = localtime(&curtime);
   strftime(temp, sizeof(temp) - 1, "%Y-%m-%d %H:%M", curdate);
 
+  fp = cupsdAddJournalRecord(j, NULL);
+
   cupsFilePuts(fp, "# Class configuration file for " CUPS_SVERSION "\n");
   cupsFilePrintf(fp, "# Written by cupsd on %s\n", temp);
   cupsFilePuts(fp, "# DO NOT EDIT THIS FILE WHEN CUPSD IS RUNNING\n");
@@ -711,6 +718,8 @@ cupsdSaveAllClasses(void)
     * Write printers as needed...
     */
 
+    fp = cupsdAddJournalRecord(j, pclass->name);
+
     if (pclass == DefaultPrinter)
       cupsFilePrintf(fp, "<DefaultClass %s>\n", pclass->name);
     else
@@ -805,5 +814,5 @@ cupsdSaveAllClasses(void)
       cupsFilePuts(fp, "</Class>\n");
   }
 
-  cupsdCloseCreatedConfFile(fp, filename);
+  cupsdEndJournal(j);
 }
@@ -27,6 +27,17 @@
 #endif /* HAVE_TCPD_H */
 
 
+/*
+ * Local globals...
+ */
+
+#ifdef HAVE_SSL
+static int		tls_handshakes = 0,
+					/* Number of TLS handshakes */
+			tls_resumed = 0;/* Number of resumed TLS sessions */
+#endif /* HAVE_SSL */
+
+
 /*
  * Local functions...
  */
@@ -46,6 +57,10 @@ static int		is_cgi(cupsd_client_t *con, const char *filename,
 static int		is_path_absolute(const char *path);
 static int		pipe_command(cupsd_client_t *con, int infile, int *outfile,
 			             char *command, char *options, int root);
+#ifdef HAVE_SPLICE
+static int		splice_request(cupsd_client_t *con, ssize_t bytes);
+#endif /* HAVE_SPLICE */
+static void		timeout_client(cupsd_client_t *con);
 static int		valid_host(cupsd_client_t *con);
 static int		write_file(cupsd_client_t *con, http_status_t code,
 		        	   char *filename, char *type,
@@ -337,6 +352,13 @@ cupsdAcceptClient(cupsd_listener_t *lis)/* I - Listener socket */
 
   cupsArrayAdd(Clients, con);
 
+ /*
+  * Schedule the inactivity timeout...
+  */
+
+  con->timer = cupsdAddTimer(httpGetActivity(con->http) + Timeout + 1,
+                             (cupsd_timerfunc_t)timeout_client, con);
+
  /*
   * Add the socket to the server select.
   */
@@ -533,6 +555,8 @@ cupsdCloseClient(cupsd_client_t *con)	/* I - Client to close */
 
     cupsArrayRemove(Clients, con);
 
+    cupsdDeleteTimer(con->timer);
+
     free(con);
   }
 
@@ -553,6 +577,7 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
   http_status_t		status;		/* Transfer status */
   ipp_state_t		ipp_state;	/* State of IPP transfer */
   int			bytes;		/* Number of bytes to POST */
+  int			spliced;	/* Were the bytes spliced into the file? */
   char			*filename;	/* Name of file for GET/HEAD */
   char			buf[1024];	/* Buffer for real filename */
   struct stat		filestats;	/* File information */
@@ -1685,7 +1710,26 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
 	  {
 	    if (!httpWait(con->http, 0))
 	      return;
-            else if ((bytes = httpRead2(con->http, line, sizeof(line))) < 0)
+
+            spliced = 0;
+
+#ifdef HAVE_SPLICE
+           /*
+	    * Move unbuffered request data directly into the file when possible,
+	    * falling back to httpRead2() otherwise...
+	    */
+
+            if (con->file >= 0 && SplicePipes[1] >= 0 &&
+                (bytes = (int)_httpReadSplice(con->http, SplicePipes[1], CUPSD_SPLICE_SIZE)) != 0)
+	    {
+	      if (bytes > 0)
+	        spliced = splice_request(con, bytes) ? 1 : -1;
+	    }
+	    else
+#endif /* HAVE_SPLICE */
+            bytes = (int)httpRead2(con->http, line, sizeof(line));
+
+            if (bytes < 0)
 	    {
 	      if (httpError(con->http) && httpError(con->http) != EPIPE)
 		cupsdLogClient(con, CUPSD_LOG_DEBUG,
@@ -1716,7 +1760,8 @@ cupsdReadClient(cupsd_client_t *con)	/* I - Client to read from */
                 }
               }
 
-              if (write(con->file, line, (size_t)bytes) < bytes)
+              if (spliced < 0 ||
+	          (!spliced && write(con->file, line, (size_t)bytes) < bytes))
 	      {
         	cupsdLogClient(con, CUPSD_LOG_ERROR,
 	                       "Unable to write %d bytes to \"%s\": %s",
@@ -2356,6 +2401,28 @@ cupsdWriteClient(cupsd_client_t *con)	/* I - Client connection */
                    (int)bytes, httpGetState(con->http),
                    CUPS_LLCAST httpGetLength2(con->http));
   }
+#ifdef HAVE_SENDFILE
+  else if (!con->pipe_pid && !con->header_used &&
+           (bytes = (int)_httpSendFile(con->http, con->file, CUPSD_SENDFILE_SIZE)) != 0)
+  {
+   /*
+    * Sent file data directly to the client...
+    */
+
+    if (bytes < 0)
+    {
+      cupsdLogClient(con, CUPSD_LOG_DEBUG, "Closing for error %d (%s)",
+		     httpError(con->http), strerror(httpError(con->http)));
+      cupsdCloseClient(con);
+      return;
+    }
+
+    con->bytes += bytes;
+
+    if (httpGetState(con->http) == HTTP_STATE_WAITING)
+      bytes = 0;
+  }
+#endif /* HAVE_SENDFILE */
   else if ((bytes = read(con->file, con->header + con->header_used, (size_t)bytes)) > 0)
   {
     con->header_used += bytes;
@@ -2673,7 +2740,17 @@ cupsd_start_tls(cupsd_client_t    *con,	/* I - Client connection */
     return (-1);
   }
 
-  cupsdLogClient(con, CUPSD_LOG_DEBUG, "Connection now encrypted.");
+  tls_handshakes ++;
+
+  if (_httpTLSResumed(con->http))
+  {
+    tls_resumed ++;
+
+    cupsdLogClient(con, CUPSD_LOG_DEBUG, "Connection now encrypted using a resumed session (%d of %d sessions resumed).", tls_resumed, tls_handshakes);
+  }
+  else
+    cupsdLogClient(con, CUPSD_LOG_DEBUG, "Connection now encrypted (%d of %d sessions resumed).", tls_resumed, tls_handshakes);
+
   return (0);
 }
 #endif /* HAVE_SSL */
@@ -3035,7 +3112,8 @@ install_cupsd_conf(cupsd_client_t *con)	/* I - Connection */
 
   cupsFileClose(in);
 
-  if (cupsdCloseCreatedConfFile(out, ConfigurationFile))
+  if (cupsdCloseCreatedConfFile(out, ConfigurationFile) ||
+      cupsdSyncConfFile(ConfigurationFile))
     goto server_error;
 
  /*
@@ -3531,6 +3609,101 @@ pipe_command(cupsd_client_t *con,	/* I - Client connection */
 }
 
 
+#ifdef HAVE_SPLICE
+/*
+ * 'splice_request()' - Move spliced request data from the pipe to the request
+ *                      file.
+ *
+ * The pipe is always emptied, even when the data cannot be written, so that it
+ * can be used for the next request.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+splice_request(cupsd_client_t *con,	/* I - Client connection */
+               ssize_t        bytes)	/* I - Number of bytes in pipe */
+{
+  ssize_t	moved;			/* Bytes moved or discarded */
+  int		error;			/* Write error */
+  char		buffer[8192];		/* Discard buffer */
+
+
+  while (bytes > 0)
+  {
+    if ((moved = splice(SplicePipes[0], NULL, con->file, NULL, (size_t)bytes, SPLICE_F_MOVE)) > 0)
+    {
+      bytes        -= moved;
+      SplicedBytes += moved;
+      continue;
+    }
+    else if (moved < 0 && errno == EINTR)
+      continue;
+
+   /*
+    * Unable to write the file, discard the rest of the data...
+    */
+
+    error = moved < 0 ? errno : ENOSPC;
+
+    while (bytes > 0)
+    {
+      if ((moved = read(SplicePipes[0], buffer, (size_t)bytes > sizeof(buffer) ? sizeof(buffer) : (size_t)bytes)) > 0)
+        bytes -= moved;
+      else if (moved < 0 && errno == EINTR)
+        continue;
+      else
+      {
+       /*
+        * Stop using the pipe if we can't empty it...
+	*/
+
+        cupsdClosePipe(SplicePipes);
+        break;
+      }
+    }
+
+    errno = error;
+    return (0);
+  }
+
+  return (1);
+}
+#endif /* HAVE_SPLICE */
+
+
+/*
+ * 'timeout_client()' - Close a client connection after a period of inactivity.
+ */
+
+static void
+timeout_client(cupsd_client_t *con)	/* I - Client connection */
+{
+  time_t	curtime,		/* Current time */
+		timeout;		/* Inactivity timeout */
+
+
+  curtime = time(NULL);
+  timeout = httpGetActivity(con->http) + Timeout;
+
+  if (timeout < curtime && !con->pipe_pid)
+  {
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Closing client %d after %d seconds of inactivity.", con->number, Timeout);
+
+    if (!cupsdCloseClient(con))
+      return;
+
+   /*
+    * Partially closed, check again later...
+    */
+
+    timeout = curtime;
+  }
+  else if (timeout < curtime)
+    timeout = curtime;
+
+  cupsdSetTimer(con->timer, timeout + 1);
+}
+
+
 /*
  * 'valid_host()' - Is the Host: field valid?
  */
@@ -21,6 +21,7 @@ struct cupsd_client_s
 {
   int			number;		/* Connection number */
   http_t		*http;		/* HTTP client connection */
+  cupsd_timer_t		*timer;		/* Timer for inactivity timeout */
   ipp_t			*request,	/* IPP request information */
 			*response;	/* IPP response information */
   cupsd_location_t	*best;		/* Best match for AAA */
@@ -67,6 +68,9 @@ struct cupsd_client_s
 
 #define HTTP(con) ((con)->http)
 
+#define CUPSD_SENDFILE_SIZE	65536	/* Maximum bytes per sendfile() call */
+#define CUPSD_SPLICE_SIZE	1048576	/* Size of pipe for splicing request data */
+
 
 /*
  * HTTP listener structure...
@@ -111,6 +115,12 @@ VAR int			CGIPipes[2]	VALUE2(-1,-1);
 					/* Pipes for CGI error/debug output */
 VAR cupsd_statbuf_t	*CGIStatusBuffer VALUE(NULL);
 					/* Status buffer for pipes */
+#ifdef HAVE_SPLICE
+VAR int			SplicePipes[2]	VALUE2(-1,-1);
+					/* Pipe for splicing request data */
+VAR off_t		SplicedBytes	VALUE(0);
+					/* Request bytes received using splice() */
+#endif /* HAVE_SPLICE */
 
 
 /*
@@ -66,6 +66,7 @@ typedef struct
 
 static const cupsd_var_t	cupsd_vars[] =
 {
+  { "AuthCacheTimeout",		&AuthCacheTimeout,	CUPSD_VARTYPE_TIME },
   { "AutoPurgeJobs", 		&JobAutoPurge,		CUPSD_VARTYPE_BOOLEAN },
 #if defined(HAVE_DNSSD) || defined(HAVE_AVAHI)
   { "BrowseDNSSDSubTypes",	&DNSSDSubTypes,		CUPSD_VARTYPE_STRING },
@@ -84,8 +85,10 @@ static const cupsd_var_t	cupsd_vars[] =
   { "DNSSDHostName",		&DNSSDHostName,		CUPSD_VARTYPE_STRING },
 #endif /* HAVE_DNSSD || HAVE_AVAHI */
   { "ErrorPolicy",		&ErrorPolicy,		CUPSD_VARTYPE_STRING },
+  { "EventCacheSize",		&EventCacheSize,	CUPSD_VARTYPE_INTEGER },
   { "FilterLimit",		&FilterLimit,		CUPSD_VARTYPE_INTEGER },
   { "FilterNice",		&FilterNice,		CUPSD_VARTYPE_INTEGER },
+  { "GroupCacheTimeout",	&GroupCacheTimeout,	CUPSD_VARTYPE_TIME },
 #ifdef HAVE_GSSAPI
   { "GSSServiceName",		&GSSServiceName,	CUPSD_VARTYPE_STRING },
 #endif /* HAVE_GSSAPI */
@@ -102,6 +105,7 @@ static const cupsd_var_t	cupsd_vars[] =
 #endif /* HAVE_LAUNCHD */
   { "LimitRequestBody",		&MaxRequestSize,	CUPSD_VARTYPE_INTEGER },
   { "ListenBackLog",		&ListenBackLog,		CUPSD_VARTYPE_INTEGER },
+  { "LogBufferSize",		&LogBufferSize,		CUPSD_VARTYPE_INTEGER },
   { "LogDebugHistory",		&LogDebugHistory,	CUPSD_VARTYPE_INTEGER },
   { "MaxActiveJobs",		&MaxActiveJobs,		CUPSD_VARTYPE_INTEGER },
   { "MaxClients",		&MaxClients,		CUPSD_VARTYPE_INTEGER },
@@ -121,6 +125,7 @@ static const cupsd_var_t	cupsd_vars[] =
   { "MaxSubscriptionsPerPrinter",&MaxSubscriptionsPerPrinter,	CUPSD_VARTYPE_INTEGER },
   { "MaxSubscriptionsPerUser",	&MaxSubscriptionsPerUser,	CUPSD_VARTYPE_INTEGER },
   { "MultipleOperationTimeout",	&MultipleOperationTimeout,	CUPSD_VARTYPE_TIME },
+  { "NotifierBatchInterval",	&NotifierBatchInterval,	CUPSD_VARTYPE_TIME },
   { "PageLogFormat",		&PageLogFormat,		CUPSD_VARTYPE_STRING },
   { "PreserveJobFiles",		&JobFiles,		CUPSD_VARTYPE_TIME },
   { "PreserveJobHistory",	&JobHistory,		CUPSD_VARTYPE_TIME },
@@ -129,9 +134,13 @@ static const cupsd_var_t	cupsd_vars[] =
   { "RootCertDuration",		&RootCertDuration,	CUPSD_VARTYPE_TIME },
   { "ServerAdmin",		&ServerAdmin,		CUPSD_VARTYPE_STRING },
   { "ServerName",		&ServerName,		CUPSD_VARTYPE_STRING },
+#ifdef HAVE_SSL
+  { "SSLSessionTimeout",	&SSLSessionTimeout,	CUPSD_VARTYPE_TIME },
+#endif /* HAVE_SSL */
   { "StrictConformance",	&StrictConformance,	CUPSD_VARTYPE_BOOLEAN },
   { "Timeout",			&Timeout,		CUPSD_VARTYPE_TIME },
-  { "WebInterface",		&WebInterface,		CUPSD_VARTYPE_BOOLEAN }
+  { "WebInterface",		&WebInterface,		CUPSD_VARTYPE_BOOLEAN },
+  { "WorkerThreads",		&WorkerThreads,		CUPSD_VARTYPE_INTEGER }
 };
 static const cupsd_var_t	cupsfiles_vars[] =
 {
@@ -560,6 +569,7 @@ cupsdReadConfiguration(void)
   */
 
   cupsdDeleteAllLocations();
+  cupsdClearAuthCache();
 
   cupsdDeleteAllListeners();
 
@@ -702,12 +712,14 @@ cupsdReadConfiguration(void)
   */
 
   AccessLogLevel           = CUPSD_ACCESSLOG_ACTIONS;
+  AuthCacheTimeout         = 0;
   ConfigFilePerm           = CUPS_DEFAULT_CONFIG_FILE_PERM;
   FatalErrors              = parse_fatal_errors(CUPS_DEFAULT_FATAL_ERRORS);
   default_auth_type        = CUPSD_AUTH_BASIC;
 #ifdef HAVE_SSL
   CreateSelfSignedCerts    = TRUE;
   DefaultEncryption        = HTTP_ENCRYPT_REQUIRED;
+  SSLSessionTimeout        = 300;
 #endif /* HAVE_SSL */
   DirtyCleanInterval       = DEFAULT_KEEPALIVE;
   JobKillDelay             = DEFAULT_TIMEOUT;
@@ -717,10 +729,13 @@ cupsdReadConfiguration(void)
   FilterLevel              = 0;
   FilterLimit              = 0;
   FilterNice               = 0;
+  GroupCacheTimeout        = 0;
   HostNameLookups          = FALSE;
   KeepAlive                = TRUE;
   KeepAliveTimeout         = DEFAULT_KEEPALIVE;
   ListenBackLog            = SOMAXCONN;
+  LogBufferOverflow        = CUPSD_LOGOVERFLOW_BLOCK;
+  LogBufferSize            = 1024 * 1024;
   LogDebugHistory          = 200;
   LogFilePerm              = CUPS_DEFAULT_LOG_FILE_PERM;
   LogLevel                 = CUPSD_LOG_WARN;
@@ -738,6 +753,17 @@ cupsdReadConfiguration(void)
   SyncOnClose              = FALSE;
   Timeout                  = DEFAULT_TIMEOUT;
   WebInterface             = CUPS_DEFAULT_WEBIF;
+  WorkerThreads            = 0;
+
+#ifdef _SC_NPROCESSORS_ONLN
+ /*
+  * Default to one worker thread per CPU, up to DEFAULT_WORKERS; a single CPU
+  * gets nothing from them...
+  */
+
+  if ((i = (int)sysconf(_SC_NPROCESSORS_ONLN)) > 1)
+    WorkerThreads = i < DEFAULT_WORKERS ? i : DEFAULT_WORKERS;
+#endif /* _SC_NPROCESSORS_ONLN */
 
   BrowseLocalProtocols     = parse_protocols(CUPS_DEFAULT_BROWSE_LOCAL_PROTOCOLS);
   BrowseWebIF              = FALSE;
@@ -778,6 +804,8 @@ cupsdReadConfiguration(void)
   MaxSubscriptionsPerUser    = 0;
   DefaultLeaseDuration       = 86400;
   MaxLeaseDuration           = 0;
+  EventCacheSize             = 1000;
+  NotifierBatchInterval      = 0;
 
 #ifdef HAVE_ONDEMAND
   IdleExitTimeout = 60;
@@ -1110,6 +1138,7 @@ cupsdReadConfiguration(void)
   if (!CreateSelfSignedCerts)
     cupsdLogMessage(CUPSD_LOG_DEBUG, "Self-signed TLS certificate generation is disabled.");
   cupsSetServerCredentials(ServerKeychain, ServerName, CreateSelfSignedCerts);
+  _httpTLSSetSessionCache(SSLSessionTimeout);
 #endif /* HAVE_SSL */
 
  /*
@@ -1303,6 +1332,19 @@ cupsdReadConfiguration(void)
   if (MaxActiveJobs > (MaxFDs / 3))
     MaxActiveJobs = MaxFDs / 3;
 
+ /*
+  * Check the WorkerThreads setting...
+  */
+
+  if (WorkerThreads < 0 || WorkerThreads > MAX_WORKERS)
+  {
+    cupsdLogMessage(CUPSD_LOG_WARN,
+                    "WorkerThreads %d out of range, using %d instead.",
+		    WorkerThreads, WorkerThreads < 0 ? 0 : MAX_WORKERS);
+
+    WorkerThreads = WorkerThreads < 0 ? 0 : MAX_WORKERS;
+  }
+
  /*
   * Update the MaxClientsPerHost value, as needed...
   */
@@ -1650,6 +1692,12 @@ cupsdReadConfiguration(void)
 
     cupsdLoadAllJobs();
 
+   /*
+    * Load quota usage...
+    */
+
+    cupsdLoadQuotas();
+
    /*
     * Load subscriptions...
     */
@@ -3267,6 +3315,22 @@ read_cupsd_conf(cups_file_t *fp)	/* I - File to read from */
         cupsdLogMessage(CUPSD_LOG_WARN, "Unknown AccessLogLevel %s on line %d of %s.",
 	                value, linenum, ConfigurationFile);
     }
+    else if (!_cups_strcasecmp(line, "LogBufferOverflow") && value)
+    {
+     /*
+      * What to do when the log buffer is full...
+      */
+
+      if (!_cups_strcasecmp(value, "block"))
+        LogBufferOverflow = CUPSD_LOGOVERFLOW_BLOCK;
+      else if (!_cups_strcasecmp(value, "drop"))
+        LogBufferOverflow = CUPSD_LOGOVERFLOW_DROP;
+      else if (!_cups_strcasecmp(value, "count"))
+        LogBufferOverflow = CUPSD_LOGOVERFLOW_COUNT;
+      else
+        cupsdLogMessage(CUPSD_LOG_WARN, "Unknown LogBufferOverflow %s on line %d of %s.",
+	                value, linenum, ConfigurationFile);
+    }
     else if (!_cups_strcasecmp(line, "LogLevel") && value)
     {
      /*
@@ -46,6 +46,13 @@ typedef enum
   CUPSD_TIME_USECS			/* Standard format with microseconds */
 } cupsd_time_t;
 
+typedef enum
+{
+  CUPSD_LOGOVERFLOW_BLOCK,		/* Wait for room in the log buffer */
+  CUPSD_LOGOVERFLOW_DROP,		/* Drop lines silently */
+  CUPSD_LOGOVERFLOW_COUNT		/* Drop lines and log how many */
+} cupsd_logoverflow_t;
+
 typedef enum
 {
   CUPSD_SANDBOXING_OFF,			/* No sandboxing */
@@ -177,6 +184,8 @@ VAR cupsd_loglevel_t	LogLevel		VALUE(CUPSD_LOG_WARN);
 					/* Error log level */
 VAR cupsd_time_t	LogTimeFormat		VALUE(CUPSD_TIME_STANDARD);
 					/* Log file time format */
+VAR cupsd_logoverflow_t	LogBufferOverflow	VALUE(CUPSD_LOGOVERFLOW_BLOCK);
+					/* What to do when log buffer is full */
 VAR cups_file_t		*LogStderr		VALUE(NULL);
 					/* Stderr file, if any */
 VAR cupsd_sandboxing_t	Sandboxing		VALUE(CUPSD_SANDBOXING_STRICT);
@@ -191,6 +200,8 @@ VAR int			MaxClients		VALUE(100),
 					/* Maximum number of copies per job */
 			MaxLogSize		VALUE(1024 * 1024),
 					/* Maximum size of log files */
+			LogBufferSize		VALUE(1024 * 1024),
+					/* Size of log buffer */
 			MaxRequestSize		VALUE(0),
 					/* Maximum size of IPP requests */
 			HostNameLookups		VALUE(FALSE),
@@ -219,8 +230,10 @@ VAR int			MaxClients		VALUE(100),
 					/* Share printers by default? */
 			MultipleOperationTimeout VALUE(DEFAULT_TIMEOUT),
 					/* multiple-operation-time-out value */
-			WebInterface		VALUE(CUPS_DEFAULT_WEBIF);
+			WebInterface		VALUE(CUPS_DEFAULT_WEBIF),
 					/* Enable the web interface? */
+			WorkerThreads		VALUE(0);
+					/* Number of worker threads */
 VAR cups_file_t		*AccessFile		VALUE(NULL),
 					/* Access log file */
 			*ErrorFile		VALUE(NULL),
@@ -241,6 +254,8 @@ VAR int			CreateSelfSignedCerts	VALUE(TRUE);
 					/* Automatically create self-signed certs? */
 VAR char		*ServerKeychain		VALUE(NULL);
 					/* Keychain holding cert + key */
+VAR int			SSLSessionTimeout	VALUE(300);
+					/* Seconds to keep TLS sessions for resumption */
 #endif /* HAVE_SSL */
 
 #ifdef HAVE_ONDEMAND
@@ -287,4 +302,6 @@ extern int	cupsdLogMessage(int level, const char *message, ...) _CUPS_FORMAT(2,
 extern int	cupsdLogPage(cupsd_job_t *job, const char *page);
 extern int	cupsdLogRequest(cupsd_client_t *con, http_status_t code);
 extern int	cupsdReadConfiguration(void);
+extern void	cupsdStartLogWriter(void);
+extern void	cupsdStopLogWriter(void);
 extern int	cupsdWriteErrorLog(int level, const char *message);
@@ -72,6 +72,7 @@ extern const char *cups_hstrerror(int);
 #define MAX_USERPASS		33	/* Maximum size of username/password */
 #define MAX_FILTERS		20	/* Maximum number of filters */
 #define MAX_SYSTEM_GROUPS	32	/* Maximum number of system groups */
+#define MAX_WORKERS		64	/* Maximum number of worker threads */
 
 
 /*
@@ -82,6 +83,7 @@ extern const char *cups_hstrerror(int);
 #define DEFAULT_FILES		86400	/* Preserve job files? */
 #define DEFAULT_TIMEOUT		300	/* Timeout during requests/updates */
 #define DEFAULT_KEEPALIVE	30	/* Timeout between requests */
+#define DEFAULT_WORKERS		4	/* Maximum default worker threads */
 
 
 /*
@@ -99,6 +101,16 @@ extern const char *cups_hstrerror(int);
 #endif /* _MAIN_C */
 
 
+/*
+ * Timer types (used by the objects below)...
+ */
+
+typedef struct cupsd_timer_s cupsd_timer_t;
+					/* Timer */
+typedef void (*cupsd_timerfunc_t)(void *data);
+					/* Timer callback function */
+
+
 /*
  * Other stuff for the scheduler...
  */
@@ -136,6 +148,21 @@ extern const char *cups_hstrerror(int);
 typedef void (*cupsd_selfunc_t)(void *data);
 
 
+/*
+ * Worker callback function type...
+ */
+
+typedef void (*cupsd_workfunc_t)(void *data);
+
+
+/*
+ * State file journal type...
+ */
+
+typedef struct cupsd_journal_s cupsd_journal_t;
+					/* State file journal */
+
+
 /*
  * Globals...
  */
@@ -172,16 +199,32 @@ extern void		cupsdSetEnvf(const char *name, const char *value, ...) _CUPS_FORMAT
 extern void		cupsdUpdateEnv(void);
 
 /* file.c */
+extern int		cupsdAppendConfFile(const char *filename, mode_t mode,
+			                    const char *data, size_t length);
+extern void		cupsdCheckConfFiles(void);
 extern void		cupsdCleanFiles(const char *path, const char *pattern);
 extern int		cupsdCloseCreatedConfFile(cups_file_t *fp,
 			                          const char *filename);
+extern int		cupsdCloseCreatedJobFile(cups_file_t *fp,
+			                         const char *filename);
 extern void		cupsdClosePipe(int *fds);
 extern cups_file_t	*cupsdCreateConfFile(const char *filename, mode_t mode);
 extern cups_file_t	*cupsdOpenConfFile(const char *filename);
 extern int		cupsdOpenPipe(int *fds);
 extern int		cupsdRemoveFile(const char *filename);
+extern int		cupsdSyncConfFile(const char *filename);
+extern void		cupsdSyncConfFiles(void);
 extern int		cupsdUnlinkOrRemoveFile(const char *filename);
 
+/* journal.c */
+extern cups_file_t	*cupsdAddJournalRecord(cupsd_journal_t *j,
+			                       const char *name);
+extern cupsd_journal_t	*cupsdBeginJournal(const char *filename, mode_t perm,
+			                   int dirty);
+extern void		cupsdCompactJournals(void);
+extern int		cupsdEndJournal(cupsd_journal_t *j);
+extern void		cupsdReplayJournal(const char *filename, mode_t perm);
+
 /* main.c */
 extern int		cupsdAddString(cups_array_t **a, const char *s);
 extern void		cupsdCheckProcess(void);
@@ -220,3 +263,17 @@ extern void		cupsdStopSelect(void);
 /* server.c */
 extern void		cupsdStartServer(void);
 extern void		cupsdStopServer(void);
+
+/* timers.c */
+extern cupsd_timer_t	*cupsdAddTimer(time_t when, cupsd_timerfunc_t cb,
+			               void *data);
+extern void		cupsdDeleteTimer(cupsd_timer_t *timer);
+extern time_t		cupsdNextTimer(void);
+extern void		cupsdRunTimers(time_t curtime);
+extern void		cupsdSetTimer(cupsd_timer_t *timer, time_t when);
+extern void		cupsdStopTimers(void);
+
+/* workers.c */
+extern void		cupsdRunWorkers(cupsd_workfunc_t func, void **data,
+			                int num_data);
+extern void		cupsdStopWorkers(void);
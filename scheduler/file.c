@@ -14,13 +14,206 @@
 
 #include "cupsd.h"
 #include <cups/dir.h>
+#include <cups/thread-private.h>
 #include <fnmatch.h>
 #ifdef HAVE_REMOVEFILE
 #  include <removefile.h>
-#else
+#endif /* HAVE_REMOVEFILE */
+
+
+/*
+ * Design Notes for Configuration File Commits in CUPSD
+ * ----------------------------------------------------
+ *
+ * cupsdCreateConfFile() returns a memory buffer rather than an open file, so
+ * the contents of a configuration or cache file are serialized without doing
+ * any I/O.  cupsdCloseCreatedConfFile() then queues the contents for a
+ * dedicated I/O thread which writes "filename.N", syncs it when SyncOnClose
+ * is enabled, and renames it into place exactly as before.  Appends to
+ * journal files use the same queue so that all file operations happen in the
+ * order they were requested.  A commit only replaces the contents of a
+ * pending commit of the same file when that is the last queued operation.
+ *
+ * Job control files are committed the same way using
+ * cupsdCloseCreatedJobFile(), except that they are owned by RunUser and no
+ * "filename.O" backup is kept.  A job whose control file could not be written
+ * is marked dirty again so that it is saved on the next pass.
+ *
+ * The I/O thread does not touch any scheduler state and does not log - the
+ * SyncOnClose, Classification, and Group settings are copied into each queued
+ * operation.  The results of completed operations are collected by the main
+ * thread with cupsdCheckConfFiles() (called from the main loop), which logs
+ * any errors.
+ *
+ * cupsdSyncConfFile() waits for the queued operations on a single file and
+ * returns whether they were successful - this is used when the caller needs
+ * the file on disk right away (PPD files, cupsd.conf, journal compaction) and
+ * is also done automatically by cupsdOpenConfFile() and the file removal
+ * functions.  cupsdSyncConfFiles() waits for all queued operations and is
+ * used when the server is stopped for a shutdown or reload.
+ */
+
+
+/*
+ * Local types...
+ */
+
+#define CUPSD_FILEOP_COMMIT	0	/* Write and rename file */
+#define CUPSD_FILEOP_APPEND	1	/* Append to file */
+#define CUPSD_FILEOP_JOB	2	/* Write and rename job control file */
+
+typedef struct cupsd_fileop_s		/**** Queued file operation ****/
+{
+  struct cupsd_fileop_s	*next;		/* Next operation */
+  int			op,		/* Operation */
+			seq;		/* Sequence number */
+  char			*filename;	/* Filename */
+  mode_t		mode;		/* Permissions */
+  uid_t			owner;		/* Owner */
+  gid_t			group;		/* Group */
+  int			sync,		/* Sync file on close? */
+			secure;		/* Remove old file securely? */
+  char			*data;		/* File contents */
+  size_t		length;		/* Length of contents */
+  int			status;		/* 0 on success, -1 on error */
+  cupsd_loglevel_t	level;		/* Log level for message */
+  char			message[1024];	/* Error/warning message, if any */
+} cupsd_fileop_t;
+
+typedef struct cupsd_created_s		/**** Created configuration file ****/
+{
+  cups_file_t		*fp;		/* Memory buffer */
+  mode_t		mode;		/* Permissions */
+} cupsd_created_t;
+
+
+/*
+ * Local globals...
+ */
+
+static cups_array_t	*created_files = NULL;
+					/* Buffers from cupsdCreateConfFile */
+static _cups_mutex_t	fileop_mutex = _CUPS_MUTEX_INITIALIZER;
+					/* Mutex for file operation queue */
+static _cups_cond_t	fileop_cond = _CUPS_COND_INITIALIZER,
+					/* Condition for queued operations */
+			fileop_done_cond = _CUPS_COND_INITIALIZER;
+					/* Condition for completed operations */
+static cupsd_fileop_t	*fileop_first = NULL,
+					/* First queued operation */
+			*fileop_last = NULL,
+					/* Last queued operation */
+			*fileop_current = NULL,
+					/* Operation being performed */
+			*fileop_done = NULL;
+					/* Completed operations */
+static int		fileop_seq = 0,	/* Last queued sequence number */
+			fileop_done_seq = 0,
+					/* Last completed sequence number */
+			fileop_started = 0;
+					/* I/O thread started? */
+
+
+/*
+ * Local functions...
+ */
+
+static int	close_created(cups_file_t *fp, const char *filename, int op);
+static int	compare_created(cupsd_created_t *a, cupsd_created_t *b);
+static void	do_fileop(cupsd_fileop_t *op);
+static void	*fileop_thread(void *arg);
+static int	queue_fileop(int op, const char *filename, mode_t mode,
+		             const char *data, size_t length);
+static int	remove_file(const char *filename);
+static int	sync_fileops(const char *filename);
+#ifndef HAVE_REMOVEFILE
 static int	overwrite_data(int fd, const char *buffer, int bufsize,
 		               int filesize);
-#endif /* HAVE_REMOVEFILE */
+#endif /* !HAVE_REMOVEFILE */
+
+
+/*
+ * 'cupsdAppendConfFile()' - Queue data to be appended to a file.
+ *
+ * The file is created with the specified permissions as needed.
+ */
+
+int					/* O - 0 on success, -1 on error */
+cupsdAppendConfFile(
+    const char *filename,		/* I - Filename */
+    mode_t     mode,			/* I - Permissions */
+    const char *data,			/* I - Data to append */
+    size_t     length)			/* I - Length of data */
+{
+  return (queue_fileop(CUPSD_FILEOP_APPEND, filename, mode, data, length));
+}
+
+
+/*
+ * 'cupsdCheckConfFiles()' - Log the results of completed file operations.
+ */
+
+void
+cupsdCheckConfFiles(void)
+{
+  cupsd_fileop_t	*op,		/* Current operation */
+			*next,		/* Next operation */
+			*prev;		/* Previous operation */
+
+
+  _cupsMutexLock(&fileop_mutex);
+  op          = fileop_done;
+  fileop_done = NULL;
+  _cupsMutexUnlock(&fileop_mutex);
+
+ /*
+  * The completed operations are in reverse order...
+  */
+
+  for (prev = NULL; op; op = next)
+  {
+    next     = op->next;
+    op->next = prev;
+    prev     = op;
+  }
+
+  for (op = prev; op; op = next)
+  {
+    next = op->next;
+
+    if (op->message[0])
+      cupsdLogMessage(op->level, "%s", op->message);
+
+    if (op->status && op->op == CUPSD_FILEOP_APPEND)
+    {
+     /*
+      * Rewrite the state files in full since the journal is incomplete...
+      */
+
+      cupsdCompactJournals();
+    }
+    else if (op->op == CUPSD_FILEOP_JOB)
+    {
+     /*
+      * Save the job again on the next pass if the write failed.  Either way
+      * flush job.index again so that it stays newer than the control file...
+      */
+
+      const char	*ptr;		/* Pointer to job filename */
+      cupsd_job_t	*job;		/* Job */
+
+      if (op->status && (ptr = strrchr(op->filename, '/')) != NULL &&
+          (job = cupsdFindJob(atoi(ptr + 2))) != NULL)
+        job->dirty = 1;
+
+      cupsdMarkDirty(CUPSD_DIRTY_JOBS);
+    }
+
+    free(op->filename);
+    free(op->data);
+    free(op);
+  }
+}
 
 
 /*
@@ -78,6 +271,10 @@ cupsdCleanFiles(const char *path,	/* I - Directory to clean */
 /*
  * 'cupsdCloseCreatedConfFile()' - Close a created configuration file and move
  *                                 into place.
+ *
+ * The file contents are queued for the I/O thread, which writes "filename.N"
+ * and renames it to "filename", keeping the previous file as "filename.O".
+ * Use cupsdSyncConfFile() to wait for the file to be moved into place.
  */
 
 int					/* O - 0 on success, -1 on error */
@@ -85,58 +282,26 @@ cupsdCloseCreatedConfFile(
     cups_file_t *fp,			/* I - File to close */
     const char  *filename)		/* I - Filename */
 {
-  char	newfile[1024],			/* filename.N */
-	oldfile[1024];			/* filename.O */
-
-
- /*
-  * Synchronize changes to disk if SyncOnClose is enabled.
-  */
-
-  if (SyncOnClose)
-  {
-    if (cupsFileFlush(fp))
-    {
-      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to write changes to \"%s\": %s",
-		      filename, strerror(errno));
-      cupsFileClose(fp);
-      return (-1);
-    }
-
-    if (fsync(cupsFileNumber(fp)))
-    {
-      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to sync changes to \"%s\": %s",
-		      filename, strerror(errno));
-      cupsFileClose(fp);
-      return (-1);
-    }
-  }
-
- /*
-  * First close the file...
-  */
-
-  if (cupsFileClose(fp))
-    return (-1);
-
- /*
-  * Then remove "filename.O", rename "filename" to "filename.O", and rename
-  * "filename.N" to "filename".
-  */
+  return (close_created(fp, filename, CUPSD_FILEOP_COMMIT));
+}
 
-  snprintf(newfile, sizeof(newfile), "%s.N", filename);
-  snprintf(oldfile, sizeof(oldfile), "%s.O", filename);
 
-  if ((cupsdUnlinkOrRemoveFile(oldfile) && errno != ENOENT) ||
-      (rename(filename, oldfile) && errno != ENOENT) ||
-      rename(newfile, filename))
-  {
-    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to finalize \"%s\": %s",
-                    filename, strerror(errno));
-    return (-1);
-  }
+/*
+ * 'cupsdCloseCreatedJobFile()' - Close a created job control file and move
+ *                                into place.
+ *
+ * The file contents are queued for the I/O thread, which writes "filename.N",
+ * changes the owner to RunUser, and renames it to "filename" without keeping
+ * a backup.  Use cupsdSyncConfFile() to wait for the file to be moved into
+ * place.
+ */
 
-  return (0);
+int					/* O - 0 on success, -1 on error */
+cupsdCloseCreatedJobFile(
+    cups_file_t *fp,			/* I - File to close */
+    const char  *filename)		/* I - Filename */
+{
+  return (close_created(fp, filename, CUPSD_FILEOP_JOB));
 }
 
 
@@ -167,6 +332,9 @@ cupsdClosePipe(int *fds)		/* I - Pipe file descriptors (2) */
 
 /*
  * 'cupsdCreateConfFile()' - Create a configuration file safely.
+ *
+ * The returned file is a memory buffer - the file is written when it is
+ * closed using cupsdCloseCreatedConfFile().
  */
 
 cups_file_t *				/* O - File pointer */
@@ -174,28 +342,44 @@ cupsdCreateConfFile(
     const char *filename,		/* I - Filename */
     mode_t     mode)			/* I - Permissions */
 {
-  cups_file_t	*fp;			/* File pointer */
-  char		newfile[1024];		/* filename.N */
+  cups_file_t		*fp;		/* File pointer */
+  cupsd_created_t	key,		/* Search key */
+			*created;	/* Created file */
 
 
-  snprintf(newfile, sizeof(newfile), "%s.N", filename);
-  if ((fp = cupsFileOpen(newfile, "w")) == NULL)
+  if (!created_files)
+    created_files = cupsArrayNew((cups_array_func_t)compare_created, NULL);
+
+  if ((fp = _cupsFileOpenBuffer()) == NULL)
   {
-    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to create \"%s\": %s", newfile,
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to create \"%s\": %s", filename,
 		    strerror(errno));
+    return (NULL);
   }
-  else
+
+ /*
+  * Remember the permissions for the file, replacing any stale entry for a
+  * buffer that was closed with cupsFileClose()...
+  */
+
+  key.fp = fp;
+
+  if ((created = (cupsd_created_t *)cupsArrayFind(created_files, &key)) == NULL)
   {
-    if (!getuid() && fchown(cupsFileNumber(fp), getuid(), Group))
-      cupsdLogMessage(CUPSD_LOG_WARN, "Unable to change group for \"%s\": %s",
-		      newfile, strerror(errno));
+    if ((created = calloc(1, sizeof(cupsd_created_t))) == NULL)
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to create \"%s\": %s", filename,
+		      strerror(errno));
+      cupsFileClose(fp);
+      return (NULL);
+    }
 
-    if (fchmod(cupsFileNumber(fp), mode))
-      cupsdLogMessage(CUPSD_LOG_WARN,
-                      "Unable to change permissions for \"%s\": %s",
-		      newfile, strerror(errno));
+    created->fp = fp;
+    cupsArrayAdd(created_files, created);
   }
 
+  created->mode = mode;
+
   return (fp);
 }
 
@@ -213,6 +397,8 @@ cupsdOpenConfFile(const char *filename)	/* I - Filename */
   cups_file_t	*fp;			/* File pointer */
 
 
+  sync_fileops(filename);
+
   if ((fp = cupsFileOpen(filename, "r")) == NULL)
   {
     if (errno == ENOENT)
@@ -295,7 +481,8 @@ cupsdOpenPipe(int *fds)			/* O - Pipe file descriptors (2) */
 int					/* O - 0 on success, -1 on error */
 cupsdRemoveFile(const char *filename)	/* I - File to remove */
 {
-#ifdef HAVE_REMOVEFILE
+  sync_fileops(filename);
+
  /*
   * See if the file exists...
   */
@@ -309,88 +496,303 @@ cupsdRemoveFile(const char *filename)	/* I - File to remove */
   * Remove the file...
   */
 
-  return (removefile(filename, NULL, REMOVEFILE_SECURE_1_PASS));
+  return (remove_file(filename));
+}
 
-#else
-  int			fd;		/* File descriptor */
-  struct stat		info;		/* File information */
-  char			buffer[512];	/* Data buffer */
-  int			i;		/* Looping var */
 
+/*
+ * 'cupsdSyncConfFile()' - Wait for the queued operations on a file.
+ */
 
- /*
-  * See if the file exists...
-  */
+int					/* O - 0 on success, -1 on error */
+cupsdSyncConfFile(const char *filename)	/* I - Filename */
+{
+  return (sync_fileops(filename));
+}
 
-  if (access(filename, 0))
-    return (0);
 
-  cupsdLogMessage(CUPSD_LOG_DEBUG, "Securely removing \"%s\".", filename);
+/*
+ * 'cupsdSyncConfFiles()' - Wait for all queued file operations.
+ */
 
- /*
-  * First open the file for writing in exclusive mode.
-  */
+void
+cupsdSyncConfFiles(void)
+{
+  sync_fileops(NULL);
+}
 
-  if ((fd = open(filename, O_WRONLY | O_EXCL)) < 0)
-    return (-1);
 
- /*
-  * Delete the file now - it will still be around as long as the file is
-  * open...
-  */
+/*
+ * 'cupsdUnlinkOrRemoveFile()' - Unlink or securely remove a file depending
+ *                               on the configuration.
+ */
 
-  if (unlink(filename))
+int					/* O - 0 on success, -1 on error */
+cupsdUnlinkOrRemoveFile(
+    const char *filename)		/* I - Filename */
+{
+  sync_fileops(filename);
+
+  if (Classification)
+    return (cupsdRemoveFile(filename));
+  else
+    return (unlink(filename));
+}
+
+
+/*
+ * 'close_created()' - Close a created file and queue the commit.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+close_created(cups_file_t *fp,		/* I - File to close */
+              const char  *filename,	/* I - Filename */
+	      int         op)		/* I - Operation */
+{
+  cupsd_created_t	key,		/* Search key */
+			*created;	/* Created file */
+  mode_t		mode = ConfigFilePerm;
+					/* Permissions */
+  const char		*data;		/* File contents */
+  size_t		length;		/* Length of contents */
+  int			status;		/* Return status */
+
+
+  key.fp = fp;
+
+  if ((created = (cupsd_created_t *)cupsArrayFind(created_files, &key)) != NULL)
   {
-    close(fd);
+    mode = created->mode;
+
+    cupsArrayRemove(created_files, created);
+    free(created);
+  }
+
+  if ((data = _cupsFileGetBuffer(fp, &length)) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to write changes to \"%s\": %s",
+		    filename, strerror(errno));
+    cupsFileClose(fp);
     return (-1);
   }
 
- /*
-  * Then get the file size...
-  */
+  status = queue_fileop(op, filename, mode, data, length);
 
-  if (fstat(fd, &info))
-  {
-    close(fd);
+  cupsFileClose(fp);
+
+  return (status);
+}
+
+
+/*
+ * 'compare_created()' - Compare two created files.
+ */
+
+static int				/* O - Result of comparison */
+compare_created(cupsd_created_t *a,	/* I - First file */
+                cupsd_created_t *b)	/* I - Second file */
+{
+  if (a->fp < b->fp)
     return (-1);
+  else if (a->fp > b->fp)
+    return (1);
+  else
+    return (0);
+}
+
+
+/*
+ * 'do_fileop()' - Perform a queued file operation.
+ *
+ * This function is run by the I/O thread and must not use any scheduler
+ * state or log messages.
+ */
+
+static void
+do_fileop(cupsd_fileop_t *op)		/* I - Operation */
+{
+  int		fd;			/* File descriptor */
+  const char	*ptr;			/* Pointer into data */
+  size_t	remaining;		/* Remaining bytes */
+  ssize_t	bytes;			/* Bytes written */
+  char		newfile[1024],		/* filename.N */
+		oldfile[1024];		/* filename.O */
+
+
+  if (op->op == CUPSD_FILEOP_APPEND)
+  {
+    strlcpy(newfile, op->filename, sizeof(newfile));
+
+    fd = open(newfile, O_WRONLY | O_APPEND | O_CREAT, op->mode);
+  }
+  else
+  {
+    snprintf(newfile, sizeof(newfile), "%s.N", op->filename);
+
+    fd = open(newfile, O_WRONLY | O_CREAT | O_TRUNC, op->mode);
+  }
+
+  if (fd < 0)
+  {
+    op->status = -1;
+    op->level  = CUPSD_LOG_ERROR;
+    snprintf(op->message, sizeof(op->message), "Unable to create \"%s\": %s",
+             newfile, strerror(errno));
+    return;
+  }
+
+  if (!getuid() && fchown(fd, op->owner, op->group))
+  {
+    op->level = CUPSD_LOG_WARN;
+    snprintf(op->message, sizeof(op->message),
+             "Unable to change group for \"%s\": %s", newfile,
+	     strerror(errno));
+  }
+
+  if (fchmod(fd, op->mode))
+  {
+    op->level = CUPSD_LOG_WARN;
+    snprintf(op->message, sizeof(op->message),
+             "Unable to change permissions for \"%s\": %s", newfile,
+	     strerror(errno));
   }
 
  /*
-  * Overwrite the file with random data.
+  * Write the data, syncing changes to disk if SyncOnClose is enabled...
   */
 
-  CUPS_SRAND(time(NULL));
+  for (ptr = op->data, remaining = op->length; remaining > 0; ptr += bytes, remaining -= (size_t)bytes)
+  {
+    if ((bytes = write(fd, ptr, remaining)) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+      {
+        bytes = 0;
+        continue;
+      }
+
+      op->status = -1;
+      op->level  = CUPSD_LOG_ERROR;
+      snprintf(op->message, sizeof(op->message),
+	       "Unable to write changes to \"%s\": %s", op->filename,
+	       strerror(errno));
+      close(fd);
+      return;
+    }
+  }
 
-  for (i = 0; i < sizeof(buffer); i ++)
-    buffer[i] = CUPS_RAND();
-  if (overwrite_data(fd, buffer, sizeof(buffer), (int)info.st_size))
+  if (op->sync && fsync(fd))
   {
+    op->status = -1;
+    op->level  = CUPSD_LOG_ERROR;
+    snprintf(op->message, sizeof(op->message),
+             "Unable to sync changes to \"%s\": %s", op->filename,
+	     strerror(errno));
     close(fd);
-    return (-1);
+    return;
+  }
+
+  if (close(fd))
+  {
+    op->status = -1;
+    op->level  = CUPSD_LOG_ERROR;
+    snprintf(op->message, sizeof(op->message),
+             "Unable to write changes to \"%s\": %s", op->filename,
+	     strerror(errno));
+    return;
+  }
+
+  if (op->op == CUPSD_FILEOP_APPEND)
+    return;
+
+  if (op->op == CUPSD_FILEOP_JOB)
+  {
+   /*
+    * Job control files are replaced without keeping a backup...
+    */
+
+    if (rename(newfile, op->filename))
+    {
+      op->status = -1;
+      op->level  = CUPSD_LOG_ERROR;
+      snprintf(op->message, sizeof(op->message),
+	       "Unable to finalize \"%s\": %s", op->filename, strerror(errno));
+    }
+
+    return;
   }
 
  /*
-  * Close the file, which will lead to the actual deletion, and return...
+  * Then remove "filename.O", rename "filename" to "filename.O", and rename
+  * "filename.N" to "filename".
   */
 
-  return (close(fd));
-#endif /* HAVE_REMOVEFILE */
+  snprintf(oldfile, sizeof(oldfile), "%s.O", op->filename);
+
+  if (((op->secure ? remove_file(oldfile) : unlink(oldfile)) &&
+       errno != ENOENT) ||
+      (rename(op->filename, oldfile) && errno != ENOENT) ||
+      rename(newfile, op->filename))
+  {
+    op->status = -1;
+    op->level  = CUPSD_LOG_ERROR;
+    snprintf(op->message, sizeof(op->message),
+             "Unable to finalize \"%s\": %s", op->filename, strerror(errno));
+  }
 }
 
 
 /*
- * 'cupsdUnlinkOrRemoveFile()' - Unlink or securely remove a file depending
- *                               on the configuration.
+ * 'fileop_thread()' - Perform queued file operations.
  */
 
-int					/* O - 0 on success, -1 on error */
-cupsdUnlinkOrRemoveFile(
-    const char *filename)		/* I - Filename */
+static void *				/* O - Exit status */
+fileop_thread(void *arg)		/* I - Not used */
 {
-  if (Classification)
-    return (cupsdRemoveFile(filename));
-  else
-    return (unlink(filename));
+  cupsd_fileop_t	*op;		/* Current operation */
+  sigset_t		mask;		/* Signal mask */
+
+
+  (void)arg;
+
+ /*
+  * Signals are handled by the main thread...
+  */
+
+  sigfillset(&mask);
+  pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+  pthread_detach(pthread_self());
+
+  _cupsMutexLock(&fileop_mutex);
+
+  for (;;)
+  {
+    if ((op = fileop_first) == NULL)
+    {
+      _cupsCondWait(&fileop_cond, &fileop_mutex, 0.0);
+      continue;
+    }
+
+    if ((fileop_first = op->next) == NULL)
+      fileop_last = NULL;
+
+    fileop_current = op;
+
+    _cupsMutexUnlock(&fileop_mutex);
+    do_fileop(op);
+    _cupsMutexLock(&fileop_mutex);
+
+    fileop_current  = NULL;
+    fileop_done_seq = op->seq;
+
+    op->next    = fileop_done;
+    fileop_done = op;
+
+    _cupsCondBroadcast(&fileop_done_cond);
+  }
+
+  return (NULL);
 }
 
 
@@ -439,3 +841,254 @@ overwrite_data(int        fd,		/* I - File descriptor */
   return (fsync(fd));
 }
 #endif /* HAVE_REMOVEFILE */
+
+
+/*
+ * 'queue_fileop()' - Queue a file operation for the I/O thread.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+queue_fileop(int        op,		/* I - Operation */
+             const char *filename,	/* I - Filename */
+             mode_t     mode,		/* I - Permissions */
+	     const char *data,		/* I - Data */
+	     size_t     length)		/* I - Length of data */
+{
+  cupsd_fileop_t	*fop,		/* New operation */
+			*last;		/* Last queued operation */
+  char			*copy;		/* Copy of data */
+  uid_t			owner;		/* Owner of file */
+
+
+ /*
+  * Job control files are owned by RunUser, everything else by root...
+  */
+
+  owner = op == CUPSD_FILEOP_JOB ? RunUser : getuid();
+
+  if ((copy = malloc(length + 1)) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to write changes to \"%s\": %s",
+                    filename, strerror(errno));
+    return (-1);
+  }
+
+  memcpy(copy, data, length);
+  copy[length] = '\0';
+
+  _cupsMutexLock(&fileop_mutex);
+
+  if (!fileop_started)
+  {
+    if (!_cupsThreadCreate((_cups_thread_func_t)fileop_thread, NULL))
+    {
+     /*
+      * Fall back to writing the file on the main thread...
+      */
+
+      cupsd_fileop_t	temp;		/* Temporary operation */
+
+      _cupsMutexUnlock(&fileop_mutex);
+
+      memset(&temp, 0, sizeof(temp));
+      temp.op       = op;
+      temp.filename = (char *)filename;
+      temp.mode     = mode;
+      temp.owner    = owner;
+      temp.group    = Group;
+      temp.sync     = SyncOnClose;
+      temp.secure   = Classification != NULL;
+      temp.data     = copy;
+      temp.length   = length;
+
+      do_fileop(&temp);
+      free(copy);
+
+      if (temp.message[0])
+        cupsdLogMessage(temp.level, "%s", temp.message);
+
+      return (temp.status);
+    }
+
+    fileop_started = 1;
+  }
+
+ /*
+  * Replace the contents of a pending commit of the same file if it is the
+  * last queued operation, so that files are still written in the order they
+  * were committed...
+  */
+
+  if (op != CUPSD_FILEOP_APPEND)
+  {
+    last = fileop_last;
+
+    if (last && last->op == op && !strcmp(last->filename, filename))
+    {
+      free(last->data);
+
+      last->data   = copy;
+      last->length = length;
+      last->mode   = mode;
+      last->owner  = owner;
+      last->group  = Group;
+      last->sync   = SyncOnClose;
+      last->secure = Classification != NULL;
+
+      _cupsMutexUnlock(&fileop_mutex);
+
+      return (0);
+    }
+  }
+
+  if ((fop = calloc(1, sizeof(cupsd_fileop_t))) == NULL ||
+      (fop->filename = strdup(filename)) == NULL)
+  {
+    _cupsMutexUnlock(&fileop_mutex);
+
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to write changes to \"%s\": %s",
+                    filename, strerror(errno));
+    free(fop);
+    free(copy);
+    return (-1);
+  }
+
+  fop->op     = op;
+  fop->seq    = ++ fileop_seq;
+  fop->mode   = mode;
+  fop->owner  = owner;
+  fop->group  = Group;
+  fop->sync   = SyncOnClose;
+  fop->secure = Classification != NULL;
+  fop->data   = copy;
+  fop->length = length;
+
+  if (fileop_last)
+    fileop_last->next = fop;
+  else
+    fileop_first = fop;
+
+  fileop_last = fop;
+
+  _cupsCondBroadcast(&fileop_cond);
+  _cupsMutexUnlock(&fileop_mutex);
+
+  return (0);
+}
+
+
+/*
+ * 'remove_file()' - Remove a file securely.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+remove_file(const char *filename)	/* I - File to remove */
+{
+#ifdef HAVE_REMOVEFILE
+  return (removefile(filename, NULL, REMOVEFILE_SECURE_1_PASS));
+
+#else
+  int			fd;		/* File descriptor */
+  struct stat		info;		/* File information */
+  char			buffer[512];	/* Data buffer */
+  int			i;		/* Looping var */
+
+
+ /*
+  * First open the file for writing in exclusive mode.
+  */
+
+  if ((fd = open(filename, O_WRONLY | O_EXCL)) < 0)
+    return (-1);
+
+ /*
+  * Delete the file now - it will still be around as long as the file is
+  * open...
+  */
+
+  if (unlink(filename))
+  {
+    close(fd);
+    return (-1);
+  }
+
+ /*
+  * Then get the file size...
+  */
+
+  if (fstat(fd, &info))
+  {
+    close(fd);
+    return (-1);
+  }
+
+ /*
+  * Overwrite the file with random data.
+  */
+
+  CUPS_SRAND(time(NULL));
+
+  for (i = 0; i < sizeof(buffer); i ++)
+    buffer[i] = CUPS_RAND();
+  if (overwrite_data(fd, buffer, sizeof(buffer), (int)info.st_size))
+  {
+    close(fd);
+    return (-1);
+  }
+
+ /*
+  * Close the file, which will lead to the actual deletion, and return...
+  */
+
+  return (close(fd));
+#endif /* HAVE_REMOVEFILE */
+}
+
+
+
+
+/*
+ * 'sync_fileops()' - Wait for queued file operations to complete.
+ *
+ * A NULL filename waits for all queued operations.
+ */
+
+static int				/* O - 0 on success, -1 on error */
+sync_fileops(const char *filename)	/* I - Filename or NULL */
+{
+  cupsd_fileop_t	*op;		/* Current operation */
+  int			seq = 0,	/* Sequence number to wait for */
+			status = 0;	/* Return status */
+
+
+  _cupsMutexLock(&fileop_mutex);
+
+  if (fileop_current && (!filename || !strcmp(fileop_current->filename, filename)))
+    seq = fileop_current->seq;
+
+  for (op = fileop_first; op; op = op->next)
+    if (!filename || !strcmp(op->filename, filename))
+      seq = op->seq;
+
+  if (!seq)
+  {
+    _cupsMutexUnlock(&fileop_mutex);
+    return (0);
+  }
+
+  while (fileop_done_seq < seq)
+    _cupsCondWait(&fileop_done_cond, &fileop_mutex, 0.0);
+
+  for (op = fileop_done; op; op = op->next)
+    if (op->seq == seq)
+    {
+      status = op->status;
+      break;
+    }
+
+  _cupsMutexUnlock(&fileop_mutex);
+
+  cupsdCheckConfFiles();
+
+  return (status);
+}
@@ -99,6 +99,10 @@ static void	get_subscriptions(cupsd_client_t *con, ipp_attribute_t *uri);
 static const char *get_username(cupsd_client_t *con);
 static void	hold_job(cupsd_client_t *con, ipp_attribute_t *uri);
 static void	hold_new_jobs(cupsd_client_t *con, ipp_attribute_t *uri);
+static int	match_job(cupsd_job_t *job, const char *dest,
+		          cups_ptype_t dtype, cups_ptype_t dmask,
+		          int job_comparison, ipp_jstate_t job_state,
+		          int first_job_id, const char *username);
 static void	move_job(cupsd_client_t *con, ipp_attribute_t *uri);
 static int	ppd_parse_line(const char *line, char *option, int olen,
 		               char *choice, int clen);
@@ -1743,6 +1747,8 @@ add_job(cupsd_client_t  *con,		/* I - Client connection */
     job->hold_until               = time(NULL) + MultipleOperationTimeout;
     job->state->values[0].integer = IPP_JOB_HELD;
     job->state_value              = IPP_JOB_HELD;
+
+    cupsdUpdateJobTimer(job);
   }
   else
   {
@@ -1750,6 +1756,8 @@ add_job(cupsd_client_t  *con,		/* I - Client connection */
     job->state_value              = IPP_JOB_PENDING;
 
     ippSetString(job->attrs, &job->reasons, 0, "none");
+
+    cupsdUpdateReadyJob(job);
   }
 
   if (!(printer->type & CUPS_PRINTER_REMOTE) || Classification)
@@ -2328,8 +2336,12 @@ add_printer(cupsd_client_t  *con,	/* I - Client connection */
   need_restart_job = 0;
 
   if ((attr = ippFindAttribute(con->request, "printer-is-temporary", IPP_TAG_BOOLEAN)) != NULL)
+  {
     printer->temporary = ippGetBoolean(attr, 0);
 
+    cupsdUpdateTemporaryPrinter(printer);
+  }
+
   if ((attr = ippFindAttribute(con->request, "printer-location",
                                IPP_TAG_TEXT)) != NULL)
     cupsdSetString(&printer->location, attr->values[0].string.text);
@@ -3992,6 +4004,8 @@ close_job(cupsd_client_t  *con,		/* I - Client connection */
     }
   }
 
+  cupsdUpdateReadyJob(job);
+
   job->dirty = 1;
   cupsdMarkDirty(CUPSD_DIRTY_JOBS);
 
@@ -4426,7 +4440,10 @@ copy_file(const char *from,		/* I - Source file */
 
   cupsFileClose(src);
 
-  return (cupsdCloseCreatedConfFile(dst, to));
+  if (cupsdCloseCreatedConfFile(dst, to))
+    return (-1);
+
+  return (cupsdSyncConfFile(to));
 }
 
 
@@ -4715,7 +4732,10 @@ copy_model(cupsd_client_t *con,		/* I - Client connection */
 
   unlink(tempfile);
 
-  return (cupsdCloseCreatedConfFile(dst, to));
+  if (cupsdCloseCreatedConfFile(dst, to))
+    return (-1);
+
+  return (cupsdSyncConfFile(to));
 }
 
 
@@ -4809,9 +4829,15 @@ copy_job_attrs(cupsd_client_t *con,	/* I - Client connection */
     if (!ra || cupsArrayFind(ra, "job-id"))
       ippAddInteger(con->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-id", job->id);
 
+    if (job->impressions_completed >= 0 && (!ra || cupsArrayFind(ra, "job-impressions-completed")))
+      ippAddInteger(con->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", job->impressions_completed);
+
     if (!ra || cupsArrayFind(ra, "job-k-octets"))
       ippAddInteger(con->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-k-octets", job->koctets);
 
+    if (job->sheets_completed >= 0 && (!ra || cupsArrayFind(ra, "job-media-sheets-completed")))
+      ippAddInteger(con->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-media-sheets-completed", job->sheets_completed);
+
     if (job->name && (!ra || cupsArrayFind(ra, "job-name")))
       ippAddString(con->response, IPP_TAG_JOB, IPP_TAG_NAME, "job-name", NULL, job->name);
 
@@ -5358,7 +5384,7 @@ create_local_bg_thread(
       cupsFilePrintf(to, "%s\n", line);
 
     cupsFileClose(from);
-    if (!cupsdCloseCreatedConfFile(to, toppd))
+    if (!cupsdCloseCreatedConfFile(to, toppd) && !cupsdSyncConfFile(toppd))
     {
       printer->config_time = time(NULL);
       printer->state       = IPP_PSTATE_IDLE;
@@ -5487,6 +5513,8 @@ create_local_printer(
   printer->shared    = 0;
   printer->temporary = 1;
 
+  cupsdUpdateTemporaryPrinter(printer);
+
   cupsdSetDeviceURI(printer, ippGetString(device_uri, 0, NULL));
 
   if (printer_geo_location)
@@ -5925,6 +5953,8 @@ create_subscriptions(
     sub->lease    = lease;
     sub->expire   = lease ? time(NULL) + lease : 0;
 
+    cupsdUpdateSubscriptionTimer(sub);
+
     cupsdSetString(&sub->owner, username);
 
     if (user_data)
@@ -6026,10 +6056,11 @@ delete_printer(cupsd_client_t  *con,	/* I - Client connection */
   unlink(filename);
 
  /*
-  * Unregister color profiles...
+  * Unregister color profiles and drop the quota usage ledgers...
   */
 
   cupsdUnregisterColor(printer);
+  cupsdResetQuotas(printer);
 
   temporary = printer->temporary;
 
@@ -6708,9 +6739,13 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
 
   ra = create_requested_array(con->request);
   for (job_attr = (char *)cupsArrayFirst(ra); job_attr; job_attr = (char *)cupsArrayNext(ra))
-    if (strcmp(job_attr, "job-id") &&
+    if (strcmp(job_attr, "date-time-at-completed") &&
+	strcmp(job_attr, "date-time-at-creation") &&
+	strcmp(job_attr, "job-id") &&
+	strcmp(job_attr, "job-impressions-completed") &&
 	strcmp(job_attr, "job-k-octets") &&
 	strcmp(job_attr, "job-media-progress") &&
+	strcmp(job_attr, "job-media-sheets-completed") &&
 	strcmp(job_attr, "job-more-info") &&
 	strcmp(job_attr, "job-name") &&
 	strcmp(job_attr, "job-originating-user-name") &&
@@ -6765,6 +6800,27 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
       return;
     }
 
+    if (need_load_job && WorkerThreads > 0)
+    {
+     /*
+      * Read the job control files in parallel...
+      */
+
+      cups_array_t *load = cupsArrayNew(NULL, NULL);
+					/* Jobs to load */
+
+      for (i = 0; i < job_ids->num_values; i ++)
+      {
+        job = cupsdFindJob(job_ids->values[i].integer);
+
+        if (!job->attrs)
+          cupsArrayAdd(load, job);
+      }
+
+      cupsdLoadJobs(load);
+      cupsArrayDelete(load);
+    }
+
     for (i = 0; i < job_ids->num_values; i ++)
     {
       job = cupsdFindJob(job_ids->values[i].integer);
@@ -6793,6 +6849,45 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
   }
   else
   {
+    if (WorkerThreads > 0)
+    {
+     /*
+      * Read the control files for the jobs we will report in parallel.  Jobs
+      * that are missing their destination or owner are always read, while
+      * the remaining jobs are only read if they match the request...
+      */
+
+      cups_array_t *load = cupsArrayNew(NULL, NULL);
+					/* Jobs to load */
+
+      if (first_index > 1)
+	job = (cupsd_job_t *)cupsArrayIndex(list, first_index - 1);
+      else
+	job = (cupsd_job_t *)cupsArrayFirst(list);
+
+      for (count = 0; (limit <= 0 || count < limit) && job; job = (cupsd_job_t *)cupsArrayNext(list))
+      {
+	if (!job->attrs && (!job->dest || !job->username))
+	{
+	  cupsArrayAdd(load, job);
+	  count ++;
+	  continue;
+	}
+
+	if (!match_job(job, dest, dtype, dmask, job_comparison, job_state,
+	               first_job_id, username))
+	  continue;
+
+	if (need_load_job && !job->attrs)
+	  cupsArrayAdd(load, job);
+
+	count ++;
+      }
+
+      cupsdLoadJobs(load);
+      cupsArrayDelete(load);
+    }
+
     if (first_index > 1)
       job = (cupsd_job_t *)cupsArrayIndex(list, first_index - 1);
     else
@@ -6815,19 +6910,8 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
       if (!job->dest || !job->username)
 	continue;
 
-      if ((dest && strcmp(job->dest, dest)) &&
-	  (!job->printer || !dest || strcmp(job->printer->name, dest)))
-	continue;
-      if ((job->dtype & dmask) != dtype &&
-	  (!job->printer || (job->printer->type & dmask) != dtype))
-	continue;
-
-      if ((job_comparison < 0 && job->state_value > job_state) ||
-          (job_comparison == 0 && job->state_value != job_state) ||
-          (job_comparison > 0 && job->state_value < job_state))
-	continue;
-
-      if (job->id < first_job_id)
+      if (!match_job(job, dest, dtype, dmask, job_comparison, job_state,
+                     first_job_id, username))
 	continue;
 
       if (need_load_job && !job->attrs)
@@ -6841,9 +6925,6 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
 	}
       }
 
-      if (username[0] && _cups_strcasecmp(username, job->username))
-	continue;
-
       if (count > 0)
 	ippAddSeparator(con->response);
 
@@ -6876,7 +6957,7 @@ get_jobs(cupsd_client_t  *con,		/* I - Client connection */
 static void
 get_notifications(cupsd_client_t *con)	/* I - Client connection */
 {
-  int			i, j;		/* Looping vars */
+  int			i;		/* Looping var */
   http_status_t		status;		/* Policy status */
   cupsd_subscription_t	*sub;		/* Subscription */
   ipp_attribute_t	*ids,		/* notify-subscription-ids */
@@ -6979,29 +7060,10 @@ get_notifications(cupsd_client_t *con)	/* I - Client connection */
       min_seq = 1;
 
    /*
-    * If we don't have any new events, nothing to do here...
-    */
-
-    if (min_seq > (sub->first_event_id + cupsArrayCount(sub->events)))
-      continue;
-
-   /*
-    * Otherwise copy all of the new events...
+    * Copy the new events...
     */
 
-    if (sub->first_event_id > min_seq)
-      j = 0;
-    else
-      j = min_seq - sub->first_event_id;
-
-    for (; j < cupsArrayCount(sub->events); j ++)
-    {
-      ippAddSeparator(con->response);
-
-      copy_attrs(con->response,
-                 ((cupsd_event_t *)cupsArrayIndex(sub->events, j))->attrs, NULL,
-        	 IPP_TAG_EVENT_NOTIFICATION, 0, NULL);
-    }
+    cupsdCopyEvents(con->response, sub, min_seq);
   }
 }
 
@@ -8061,6 +8123,42 @@ hold_new_jobs(cupsd_client_t  *con,	/* I - Connection */
 }
 
 
+/*
+ * 'match_job()' - Determine whether a job matches a Get-Jobs request.
+ */
+
+static int				/* O - 1 if the job matches, 0 otherwise */
+match_job(cupsd_job_t  *job,		/* I - Job */
+          const char   *dest,		/* I - Destination or NULL for all */
+          cups_ptype_t dtype,		/* I - Destination type */
+          cups_ptype_t dmask,		/* I - Destination type mask */
+          int          job_comparison,	/* I - Job state comparison */
+          ipp_jstate_t job_state,	/* I - job-state value */
+          int          first_job_id,	/* I - First job ID */
+          const char   *username)	/* I - Username or "" for all */
+{
+  if ((dest && strcmp(job->dest, dest)) &&
+      (!job->printer || !dest || strcmp(job->printer->name, dest)))
+    return (0);
+  if ((job->dtype & dmask) != dtype &&
+      (!job->printer || (job->printer->type & dmask) != dtype))
+    return (0);
+
+  if ((job_comparison < 0 && job->state_value > job_state) ||
+      (job_comparison == 0 && job->state_value != job_state) ||
+      (job_comparison > 0 && job->state_value < job_state))
+    return (0);
+
+  if (job->id < first_job_id)
+    return (0);
+
+  if (username[0] && _cups_strcasecmp(username, job->username))
+    return (0);
+
+  return (1);
+}
+
+
 /*
  * 'move_job()' - Move a job to a new destination.
  */
@@ -8988,6 +9086,11 @@ release_held_new_jobs(
                     "Printer \"%s\" now printing pending/new jobs (\"%s\").",
                     printer->name, get_username(con));
 
+ /*
+  * Clear the job-held-on-create reason for jobs on this printer...
+  */
+
+  cupsdReleaseHeldNewJobs(printer);
   cupsdCheckJobs();
 
  /*
@@ -9213,6 +9316,8 @@ renew_subscription(
 
   sub->expire = sub->lease ? time(NULL) + sub->lease : 0;
 
+  cupsdUpdateSubscriptionTimer(sub);
+
   cupsdMarkDirty(CUPSD_DIRTY_SUBSCRIPTIONS);
 
   con->response->request.status.status_code = IPP_OK;
@@ -9920,6 +10025,8 @@ send_document(cupsd_client_t  *con,	/* I - Client connection */
 	ippSetString(job->attrs, &job->reasons, 0, "job-hold-until-specified");
     }
 
+    cupsdUpdateReadyJob(job);
+
     job->dirty = 1;
     cupsdMarkDirty(CUPSD_DIRTY_JOBS);
 
@@ -9937,6 +10044,8 @@ send_document(cupsd_client_t  *con,	/* I - Client connection */
       job->state_value              = IPP_JOB_HELD;
       job->hold_until               = time(NULL) + MultipleOperationTimeout;
 
+      cupsdUpdateJobTimer(job);
+
       ippSetString(job->attrs, &job->reasons, 0, "job-incoming");
 
       job->dirty = 1;
@@ -10753,6 +10862,8 @@ set_printer_defaults(
 
       cupsdLogMessage(CUPSD_LOG_DEBUG, "Setting job-quota-period to %d...",
         	      attr->values[0].integer);
+      if (printer->quota_period != attr->values[0].integer)
+        cupsdResetQuotas(printer);
       cupsdFreeQuotas(printer);
 
       printer->quota_period = attr->values[0].integer;
@@ -10764,6 +10875,8 @@ set_printer_defaults(
 
       cupsdLogMessage(CUPSD_LOG_DEBUG, "Setting job-k-limit to %d...",
         	      attr->values[0].integer);
+      if (printer->k_limit != attr->values[0].integer)
+        cupsdResetQuotas(printer);
       cupsdFreeQuotas(printer);
 
       printer->k_limit = attr->values[0].integer;
@@ -10775,6 +10888,8 @@ set_printer_defaults(
 
       cupsdLogMessage(CUPSD_LOG_DEBUG, "Setting job-page-limit to %d...",
         	      attr->values[0].integer);
+      if (printer->page_limit != attr->values[0].integer)
+        cupsdResetQuotas(printer);
       cupsdFreeQuotas(printer);
 
       printer->page_limit = attr->values[0].integer;
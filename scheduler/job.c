@@ -16,6 +16,7 @@
 #include <grp.h>
 #include <cups/backend.h>
 #include <cups/dir.h>
+#include <sys/mman.h>
 #ifdef __APPLE__
 #  include <IOKit/pwr_mgt/IOPMLib.h>
 #  ifdef HAVE_IOKIT_PWR_MGT_IOPMLIBPRIVATE_H
@@ -42,12 +43,20 @@
  *     buffer, closes all of the pipes, etc. and doesn't get run until all of
  *     the print processes are finished.
  *
- * UNLOADING OF JOBS (cupsdUnloadCompletedJobs)
+ * UNLOADING OF JOBS (check_job_timer)
  *
  *     We unload the job attributes when they are not needed to reduce overall
  *     memory consumption.  We don't unload jobs where job->state_value <
  *     IPP_JOB_STOPPED, job->printer != NULL, or job->access_time is recent.
  *
+ * JOB TIMERS (cupsdUpdateJobTimer and check_job_timer)
+ *
+ *     Each job has a single timer for its earliest deadline - kill_time,
+ *     cancel_time, hold_until (pending-held jobs), or the time the job
+ *     attributes can be unloaded.  The timer callback handles whichever
+ *     deadlines have passed and then schedules the next one, so the main loop
+ *     never needs to look at jobs that have nothing to do.
+ *
  * STARTING OF JOBS (start_job)
  *
  *     When a job is started, a status buffer, several pipes, a security
@@ -87,6 +96,23 @@
  *
  *     Then we close the pipes and free the status buffers and profiles.
  *
+ * JOB CACHE (cupsdSaveAllJobs and load_job_index)
+ *
+ *     A summary of each job is kept in the "job.index" file in the CacheDir.
+ *     The file is memory-mapped and consists of a header followed by fixed-
+ *     size records, one per job.  Each job remembers the record it uses so
+ *     that saving the cache only copies the records that have changed rather
+ *     than rewriting the whole file.  Records that fail their checksum cause
+ *     the jobs to be loaded from the spool directory instead.  The file is
+ *     touched on every save and after each job control file is written, so
+ *     the spool directory is only scanned at startup if a control file is
+ *     newer than the job.index file.
+ *
+ *     Older text "job.cache" files are imported when there is no job.index
+ *     file and are removed once the job.index file has been written.  The
+ *     text format is also still written if the job.index file cannot be
+ *     created or mapped.
+ *
  * JOB FILE COMPLETION (process_children in main.c)
  *
  *     For multiple-file jobs, process_children (in main.c) sees that all
@@ -96,6 +122,66 @@
  */
 
 
+/*
+ * Local types...
+ */
+
+typedef struct cupsd_jobread_s		/**** Job control file read data ****/
+{
+  int		id;			/* Job ID */
+  ipp_t		*attrs;			/* Job attributes or NULL on error */
+  int		error;			/* errno value for open errors */
+} cupsd_jobread_t;
+
+typedef struct cupsd_readyq_s		/**** Ready queue for a destination ****/
+{
+  char		*dest;			/* Destination printer or class */
+  cups_array_t	*jobs;			/* Pending jobs in priority order */
+  int		busy;			/* Nothing more to start in this pass? */
+} cupsd_readyq_t;
+
+#define CUPSD_JOBINDEX_MAGIC	"CUPSJIDX"
+					/* job.index file magic */
+#define CUPSD_JOBINDEX_VERSION	1	/* job.index format version */
+#define CUPSD_JOBINDEX_RECORD	512	/* Size of job.index records */
+#define CUPSD_JOBINDEX_ORDER	0x01020304
+					/* Byte order marker */
+
+#define CUPSD_JOBREC_PARTIAL	1	/* Strings did not fit in record */
+
+typedef struct cupsd_jobhdr_s		/**** job.index header ****/
+{
+  char		magic[8];		/* CUPSD_JOBINDEX_MAGIC */
+  int		version,		/* CUPSD_JOBINDEX_VERSION */
+		record_size,		/* CUPSD_JOBINDEX_RECORD */
+		byte_order,		/* CUPSD_JOBINDEX_ORDER */
+		num_records,		/* Number of records, including header */
+		next_job_id;		/* NextJobId value */
+} cupsd_jobhdr_t;
+
+typedef struct cupsd_jobrec_s		/**** job.index record ****/
+{
+  int		id,			/* Job ID or 0 if unused */
+		state,			/* job-state */
+		priority,		/* job-priority */
+		dtype,			/* Destination type */
+		koctets,		/* job-k-octets */
+		impressions,		/* job-impressions-completed */
+		sheets,			/* job-media-sheets-completed */
+		num_files,		/* Number of document files */
+		flags;			/* CUPSD_JOBREC_ flags */
+  unsigned	checksum;		/* Checksum of record */
+  long long	creation_time,		/* When job was created */
+		completed_time,		/* When job was completed (0 if not) */
+		hold_until;		/* Hold expiration date/time */
+  char		strings[CUPSD_JOBINDEX_RECORD - 10 * sizeof(int) -
+		        3 * sizeof(long long)];
+					/* Username, destination, name, and
+					 * "compression super/type" for each
+					 * file, nul-separated */
+} cupsd_jobrec_t;
+
+
 /*
  * Local globals...
  */
@@ -107,27 +193,53 @@ static mime_filter_t	gziptoany_filter =
 			  0,		/* Cost */
 			  "gziptoany"	/* Filter program to run */
 			};
+static cups_array_t	*ready_queues = NULL;
+					/* Ready queues for destinations */
+static int		job_index_fd = -1;
+					/* job.index file */
+static char		*job_index = NULL;
+					/* Mapped job.index file */
+static int		job_index_hint = 1;
+					/* First record that may be unused */
+static int		job_cache_removed = 0;
+					/* Has job.cache been removed? */
+static cupsd_jobread_t	*job_read = NULL;
+					/* Attributes read by cupsdLoadJobs() */
 
 
 /*
  * Local functions...
  */
 
+static void	check_job_timer(cupsd_job_t *job);
+static void	close_job_index(void);
 static int	compare_active_jobs(void *first, void *second, void *data);
 static int	compare_completed_jobs(void *first, void *second, void *data);
 static int	compare_jobs(void *first, void *second, void *data);
+static int	compare_ready_queues(cupsd_readyq_t *first,
+		                     cupsd_readyq_t *second, void *data);
 static void	dump_job_history(cupsd_job_t *job);
 static void	finalize_job(cupsd_job_t *job, int set_job_state);
+static int	find_job_record(cupsd_job_t *job);
+static cupsd_readyq_t *find_ready_queue(const char *dest, int create);
 static void	free_job_history(cupsd_job_t *job);
 static char	*get_options(cupsd_job_t *job, int banner_page, char *copies,
 		             size_t copies_size, char *title,
 			     size_t title_size);
 static size_t	ipp_length(ipp_t *ipp);
+static unsigned	job_record_checksum(const cupsd_jobrec_t *rec);
 static void	load_job_cache(const char *filename);
+static int	load_job_index(const char *filename);
 static void	load_next_job_id(const char *filename);
 static void	load_request_root(void);
+static int	open_job_index(const char *filename, int create);
+static void	pack_job_record(cupsd_job_t *job, cupsd_jobrec_t *rec);
+static void	read_job_attrs(cupsd_jobread_t *jr);
+static int	release_held_new_job(cupsd_job_t *job);
 static void	remove_job_files(cupsd_job_t *job);
 static void	remove_job_history(cupsd_job_t *job);
+static void	remove_ready_job(cupsd_job_t *job);
+static void	save_job_cache(void);
 static void	set_time(cupsd_job_t *job, const char *name);
 static void	start_job(cupsd_job_t *job, cupsd_printer_t *printer);
 static void	stop_job(cupsd_job_t *job, cupsd_jobaction_t action);
@@ -219,196 +331,186 @@ cupsdCancelJobs(const char *dest,	/* I - Destination to cancel */
 void
 cupsdCheckJobs(void)
 {
-  cupsd_job_t		*job;		/* Current job in queue */
+  cupsd_job_t		*job,		/* Current job in queue */
+			*best;		/* Best job to start */
+  cupsd_readyq_t	*rq,		/* Current ready queue */
+			*bestrq;	/* Ready queue for best job */
   cupsd_printer_t	*printer,	/* Printer destination */
 			*pclass;	/* Printer class destination */
   ipp_attribute_t	*attr;		/* Job attribute */
-  time_t		curtime;	/* Current time */
-  const char		*reasons;	/* job-state-reasons value */
+  int			id;		/* Job ID */
 
 
-  curtime = time(NULL);
+  cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdCheckJobs: %d active jobs, %d ready queues, sleeping=%d, ac-power=%d, reload=%d", cupsArrayCount(ActiveJobs), cupsArrayCount(ready_queues), Sleeping, ACPower, NeedReload);
 
-  cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdCheckJobs: %d active jobs, sleeping=%d, ac-power=%d, reload=%d, curtime=%ld", cupsArrayCount(ActiveJobs), Sleeping, ACPower, NeedReload, (long)curtime);
+ /*
+  * Continue jobs that are waiting on the FilterLimit...
+  */
 
-  for (job = (cupsd_job_t *)cupsArrayFirst(ActiveJobs);
+  for (job = (cupsd_job_t *)cupsArrayFirst(PrintingJobs);
        job;
-       job = (cupsd_job_t *)cupsArrayNext(ActiveJobs))
+       job = (cupsd_job_t *)cupsArrayNext(PrintingJobs))
   {
-    cupsdLogMessage(CUPSD_LOG_DEBUG2,
-                    "cupsdCheckJobs: Job %d - dest=\"%s\", printer=%p, "
-                    "state=%d, cancel_time=%ld, hold_until=%ld, kill_time=%ld, "
-                    "pending_cost=%d, pending_timeout=%ld", job->id, job->dest,
-                    job->printer, job->state_value, (long)job->cancel_time,
-                    (long)job->hold_until, (long)job->kill_time,
-                    job->pending_cost, (long)job->pending_timeout);
+    if (job->pending_cost > 0 &&
+	((FilterLevel + job->pending_cost) < FilterLimit || FilterLevel == 0))
+    {
+      cupsArraySave(PrintingJobs);
+      cupsdContinueJob(job);
+      cupsArrayRestore(PrintingJobs);
+    }
+  }
 
-   /*
-    * Kill jobs if they are unresponsive...
-    */
+ /*
+  * Start pending jobs if the destination is available...
+  */
 
-    if (job->kill_time && job->kill_time <= curtime)
-    {
-      if (!job->completed)
-        cupsdLogJob(job, CUPSD_LOG_ERROR, "Stopping unresponsive job.");
+  if (NeedReload || (Sleeping && !ACPower) || DoingShutdown)
+    return;
 
-      stop_job(job, CUPSD_JOB_FORCE);
-      continue;
-    }
+  for (rq = (cupsd_readyq_t *)cupsArrayFirst(ready_queues);
+       rq;
+       rq = (cupsd_readyq_t *)cupsArrayNext(ready_queues))
+    rq->busy = 0;
 
+  for (;;)
+  {
    /*
-    * Cancel stuck jobs...
+    * Find the highest priority job at the head of the ready queues...
     */
 
-    if (job->cancel_time && job->cancel_time <= curtime)
+    best   = NULL;
+    bestrq = NULL;
+
+    for (rq = (cupsd_readyq_t *)cupsArrayFirst(ready_queues);
+         rq;
+	 rq = (cupsd_readyq_t *)cupsArrayNext(ready_queues))
     {
-      int cancel_after;			/* job-cancel-after value */
+      if (rq->busy)
+        continue;
 
-      attr         = ippFindAttribute(job->attrs, "job-cancel-after", IPP_TAG_INTEGER);
-      cancel_after = attr ? ippGetInteger(attr, 0) : MaxJobTime;
+      for (job = (cupsd_job_t *)cupsArrayFirst(rq->jobs);
+           job;
+	   job = (cupsd_job_t *)cupsArrayNext(rq->jobs))
+      {
+        if (job->state_value != IPP_JOB_PENDING)
+	{
+	 /*
+	  * No longer pending, drop it from the queue...
+	  */
 
-      if (job->completed)
-	cupsdSetJobState(job, IPP_JOB_CANCELED, CUPSD_JOB_FORCE, "Marking stuck job as completed after %d seconds.", cancel_after);
-      else
-	cupsdSetJobState(job, IPP_JOB_CANCELED, CUPSD_JOB_DEFAULT, "Canceling stuck job after %d seconds.", cancel_after);
-      continue;
-    }
+	  cupsArrayRemove(rq->jobs, job);
+	  continue;
+	}
 
-   /*
-    * Start held jobs if they are ready...
-    */
+	if (job->printer)
+	  continue;
 
-    if (job->state_value == IPP_JOB_HELD &&
-        job->hold_until &&
-	job->hold_until < curtime)
-    {
-      if (job->pending_timeout)
-      {
        /*
-        * This job is pending; check that we don't have an active Send-Document
-	* operation in progress on any of the client connections, then timeout
-	* the job so we can start printing...
+	* Skip jobs that where held-on-create...
 	*/
 
-        cupsd_client_t	*con;		/* Current client connection */
-
-	for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
-	     con;
-	     con = (cupsd_client_t *)cupsArrayNext(Clients))
-	  if (con->request &&
-	      con->request->request.op.operation_id == IPP_SEND_DOCUMENT)
-	    break;
-
-        if (con)
+	if (!release_held_new_job(job))
 	  continue;
 
-        if (cupsdTimeoutJob(job))
-	  continue;
+        break;
       }
 
-      cupsdSetJobState(job, IPP_JOB_PENDING, CUPSD_JOB_DEFAULT,
-                       "Job submission timed out.");
+      if (!job)
+        rq->busy = 1;
+      else if (!best || compare_active_jobs(job, best, NULL) < 0)
+      {
+        best   = job;
+	bestrq = rq;
+      }
     }
 
+    if (!best)
+      break;
+
    /*
-    * Continue jobs that are waiting on the FilterLimit...
+    * Try starting the job...
     */
 
-    if (job->pending_cost > 0 &&
-	((FilterLevel + job->pending_cost) < FilterLimit || FilterLevel == 0))
-      cupsdContinueJob(job);
+    job     = best;
+    id      = job->id;
+    printer = cupsdFindDest(job->dest);
+    pclass  = NULL;
 
-   /*
-    * Skip jobs that where held-on-create
-    */
+    cupsdLogMessage(CUPSD_LOG_DEBUG2,
+                    "cupsdCheckJobs: Job %d - dest=\"%s\", priority=%d",
+		    job->id, job->dest, job->priority);
 
-    reasons = ippGetString(job->reasons, 0, NULL);
-    if (reasons && !strcmp(reasons, "job-held-on-create"))
+    while (printer && (printer->type & CUPS_PRINTER_CLASS))
     {
      /*
-      * Check whether the printer is still holding new jobs...
+      * If the class is remote, just pass it to the remote server...
       */
 
-      printer = cupsdFindDest(job->dest);
-
-      if (printer->holding_new_jobs)
-        continue;
+      pclass = printer;
 
-      ippSetString(job->attrs, &job->reasons, 0, "none");
+      if (pclass->state == IPP_PRINTER_STOPPED)
+	printer = NULL;
+      else if (pclass->type & CUPS_PRINTER_REMOTE)
+	break;
+      else
+	printer = cupsdFindAvailablePrinter(printer->name);
     }
 
-   /*
-    * Start pending jobs if the destination is available...
-    */
+    if (!printer && !pclass)
+    {
+     /*
+      * Whoa, the printer and/or class for this destination went away;
+      * cancel the job...
+      */
 
-    if (job->state_value == IPP_JOB_PENDING && !NeedReload &&
-        (!Sleeping || ACPower) && !DoingShutdown && !job->printer)
+      cupsdSetJobState(job, IPP_JOB_ABORTED, CUPSD_JOB_PURGE,
+		       "Job aborted because the destination printer/class "
+		       "has gone away.");
+    }
+    else if (printer)
     {
-      printer = cupsdFindDest(job->dest);
-      pclass  = NULL;
+     /*
+      * See if the printer is available or remote and not printing a job;
+      * if so, start the job...
+      */
 
-      while (printer && (printer->type & CUPS_PRINTER_CLASS))
+      if (pclass)
       {
        /*
-        * If the class is remote, just pass it to the remote server...
+	* Add/update a job-printer-uri-actual attribute for this job
+	* so that we know which printer actually printed the job...
 	*/
 
-        pclass = printer;
-
-        if (pclass->state == IPP_PRINTER_STOPPED)
-	  printer = NULL;
-        else if (pclass->type & CUPS_PRINTER_REMOTE)
-	  break;
+	if ((attr = ippFindAttribute(job->attrs, "job-printer-uri-actual", IPP_TAG_URI)) != NULL)
+	  ippSetString(job->attrs, &attr, 0, printer->uri);
 	else
-	  printer = cupsdFindAvailablePrinter(printer->name);
+	  ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_URI, "job-printer-uri-actual", NULL, printer->uri);
+
+	job->dirty = 1;
+	cupsdMarkDirty(CUPSD_DIRTY_JOBS);
       }
 
-      if (!printer && !pclass)
+      if (!printer->job && printer->state == IPP_PRINTER_IDLE)
       {
        /*
-        * Whoa, the printer and/or class for this destination went away;
-	* cancel the job...
+	* Start the job...
 	*/
 
-        cupsdSetJobState(job, IPP_JOB_ABORTED, CUPSD_JOB_PURGE,
-	                 "Job aborted because the destination printer/class "
-			 "has gone away.");
+	start_job(job, printer);
       }
-      else if (printer)
-      {
-       /*
-        * See if the printer is available or remote and not printing a job;
-	* if so, start the job...
-	*/
-
-        if (pclass)
-	{
-	 /*
-	  * Add/update a job-printer-uri-actual attribute for this job
-	  * so that we know which printer actually printed the job...
-	  */
-
-          if ((attr = ippFindAttribute(job->attrs, "job-printer-uri-actual", IPP_TAG_URI)) != NULL)
-            ippSetString(job->attrs, &attr, 0, printer->uri);
-	  else
-	    ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_URI, "job-printer-uri-actual", NULL, printer->uri);
-
-          job->dirty = 1;
-          cupsdMarkDirty(CUPSD_DIRTY_JOBS);
-	}
+      else
+        bestrq->busy = 1;
+    }
+    else
+      bestrq->busy = 1;
 
-        if (!printer->job && printer->state == IPP_PRINTER_IDLE)
-        {
-	 /*
-	  * Start the job...
-	  */
+   /*
+    * Make sure we make progress if the job could not be started...
+    */
 
-	  cupsArraySave(ActiveJobs);
-	  start_job(job, printer);
-	  cupsArrayRestore(ActiveJobs);
-	}
-      }
-    }
+    if ((job = cupsdFindJob(id)) != NULL &&
+        job->state_value == IPP_JOB_PENDING && !job->printer)
+      bestrq->busy = 1;
   }
 }
 
@@ -1375,6 +1477,8 @@ cupsdContinueJob(cupsd_job_t *job)	/* I - Job */
 
   job->printer->job = NULL;
   job->printer      = NULL;
+
+  cupsdUpdateJobTimer(job);
 }
 
 
@@ -1395,6 +1499,8 @@ cupsdDeleteJob(cupsd_job_t       *job,	/* I - Job */
   if (action == CUPSD_JOB_PURGE)
     remove_job_history(job);
 
+  remove_ready_job(job);
+
   cupsdClearString(&job->username);
   cupsdClearString(&job->dest);
   for (i = 0;
@@ -1422,6 +1528,8 @@ cupsdDeleteJob(cupsd_job_t       *job,	/* I - Job */
   cupsArrayRemove(ActiveJobs, job);
   cupsArrayRemove(PrintingJobs, job);
 
+  cupsdDeleteTimer(job->timer);
+
   free(job);
 }
 
@@ -1434,6 +1542,7 @@ void
 cupsdFreeAllJobs(void)
 {
   cupsd_job_t	*job;			/* Current job */
+  cupsd_readyq_t *rq;			/* Current ready queue */
 
 
   if (!Jobs)
@@ -1449,6 +1558,20 @@ cupsdFreeAllJobs(void)
        job = (cupsd_job_t *)cupsArrayNext(Jobs))
     cupsdDeleteJob(job, CUPSD_JOB_DEFAULT);
 
+  for (rq = (cupsd_readyq_t *)cupsArrayFirst(ready_queues);
+       rq;
+       rq = (cupsd_readyq_t *)cupsArrayNext(ready_queues))
+  {
+    cupsArrayDelete(rq->jobs);
+    free(rq->dest);
+    free(rq);
+  }
+
+  cupsArrayDelete(ready_queues);
+  ready_queues = NULL;
+
+  close_job_index();
+
   cupsdReleaseSignals();
 }
 
@@ -1539,6 +1662,32 @@ cupsdGetUserJobCount(
 }
 
 
+/*
+ * 'cupsdHasPendingJobs()' - Determine whether any jobs are waiting to print.
+ */
+
+int					/* O - 1 if jobs are pending, 0 otherwise */
+cupsdHasPendingJobs(void)
+{
+  cupsd_readyq_t	*rq;		/* Current ready queue */
+  cupsd_job_t		*job;		/* Current job */
+
+
+  for (rq = (cupsd_readyq_t *)cupsArrayFirst(ready_queues);
+       rq;
+       rq = (cupsd_readyq_t *)cupsArrayNext(ready_queues))
+  {
+    for (job = (cupsd_job_t *)cupsArrayFirst(rq->jobs);
+         job;
+	 job = (cupsd_job_t *)cupsArrayNext(rq->jobs))
+      if (job->state_value == IPP_JOB_PENDING)
+        return (1);
+  }
+
+  return (0);
+}
+
+
 /*
  * 'cupsdLoadAllJobs()' - Load all jobs from disk.
  */
@@ -1546,11 +1695,14 @@ cupsdGetUserJobCount(
 void
 cupsdLoadAllJobs(void)
 {
-  char		filename[1024];		/* Full filename of job.cache file */
-  struct stat	fileinfo;		/* Information on job.cache file */
+  char		filename[1024],		/* Full filename of job.index file */
+		cachefile[1024];	/* Full filename of job.cache file */
+  const char	*loadfile;		/* File to load */
+  struct stat	fileinfo;		/* Information on job.index/cache file */
   cups_dir_t	*dir;			/* RequestRoot dir */
   cups_dentry_t	*dent;			/* Entry in RequestRoot */
-  int		load_cache = 1;		/* Load the job.cache file? */
+  int		load_cache = 1;		/* Load the job.index/cache file? */
+  cupsd_job_t	*job;			/* Current job */
 
 
  /*
@@ -1567,15 +1719,29 @@ cupsdLoadAllJobs(void)
     PrintingJobs = cupsArrayNew(compare_jobs, NULL);
 
  /*
-  * See whether the job.cache file is older than the RequestRoot directory...
+  * See whether the job.index (or older job.cache) file is older than the
+  * RequestRoot directory...
   */
 
-  snprintf(filename, sizeof(filename), "%s/job.cache", CacheDir);
+  snprintf(filename, sizeof(filename), "%s/job.index", CacheDir);
+  snprintf(cachefile, sizeof(cachefile), "%s/job.cache", CacheDir);
+
+  loadfile = filename;
 
   if (stat(filename, &fileinfo))
+  {
+    if (errno != ENOENT)
+      cupsdLogMessage(CUPSD_LOG_ERROR,
+                      "Unable to get file information for \"%s\" - %s",
+		      filename, strerror(errno));
+
+    loadfile = cachefile;
+  }
+
+  if (loadfile == cachefile && stat(cachefile, &fileinfo))
   {
    /*
-    * No job.cache file...
+    * No job.index or job.cache file...
     */
 
     load_cache = 0;
@@ -1583,7 +1749,7 @@ cupsdLoadAllJobs(void)
     if (errno != ENOENT)
       cupsdLogMessage(CUPSD_LOG_ERROR,
                       "Unable to get file information for \"%s\" - %s",
-		      filename, strerror(errno));
+		      cachefile, strerror(errno));
   }
   else if ((dir = cupsDirOpen(RequestRoot)) == NULL)
   {
@@ -1600,7 +1766,7 @@ cupsdLoadAllJobs(void)
       if (strlen(dent->filename) >= 6 && dent->filename[0] == 'c' && dent->fileinfo.st_mtime > fileinfo.st_mtime)
       {
        /*
-        * Job history file is newer than job.cache file...
+        * Job history file is newer than job.index/cache file...
 	*/
 
         load_cache = 0;
@@ -1615,23 +1781,60 @@ cupsdLoadAllJobs(void)
   * Load the most recent source for job data...
   */
 
-  if (load_cache)
+  if (load_cache && loadfile == filename)
+  {
+   /*
+    * Load the job.index file, falling back on the spool directory if it is
+    * damaged...
+    */
+
+    if (!load_job_index(filename))
+    {
+      load_request_root();
+      cupsdMarkDirty(CUPSD_DIRTY_JOBS);
+    }
+  }
+  else if (load_cache)
   {
    /*
-    * Load the job.cache file...
+    * Import the job.cache file...
     */
 
-    load_job_cache(filename);
+    load_job_cache(cachefile);
+    cupsdMarkDirty(CUPSD_DIRTY_JOBS);
   }
   else
   {
    /*
-    * Load the job history files...
+    * Load the job history files, then start a new job.index file...
     */
 
     load_request_root();
 
-    load_next_job_id(filename);
+    if (!open_job_index(filename, 0))
+      load_next_job_id(cachefile);
+    else
+    {
+      if (((cupsd_jobhdr_t *)job_index)->next_job_id > NextJobId)
+        NextJobId = ((cupsd_jobhdr_t *)job_index)->next_job_id;
+
+      close_job_index();
+      unlink(filename);
+    }
+
+    cupsdMarkDirty(CUPSD_DIRTY_JOBS);
+  }
+
+ /*
+  * Schedule the deadlines for the active jobs and queue the pending ones...
+  */
+
+  for (job = (cupsd_job_t *)cupsArrayFirst(ActiveJobs);
+       job;
+       job = (cupsd_job_t *)cupsArrayNext(ActiveJobs))
+  {
+    cupsdUpdateJobTimer(job);
+    cupsdUpdateReadyJob(job);
   }
 
  /*
@@ -1669,32 +1872,59 @@ cupsdLoadJob(cupsd_job_t *job)		/* I - Job */
     return (1);
   }
 
-  if ((job->attrs = ippNew()) == NULL)
+  if (job_read)
   {
-    cupsdLogJob(job, CUPSD_LOG_ERROR, "Ran out of memory for job attributes.");
-    return (0);
-  }
+   /*
+    * Use the job attributes that were read by a worker thread...
+    */
 
- /*
-  * Load job attributes...
-  */
+    job->attrs     = job_read->attrs;
+    job_read->attrs = NULL;
 
-  cupsdLogJob(job, CUPSD_LOG_DEBUG, "Loading attributes...");
+    if (!job->attrs)
+    {
+      snprintf(jobfile, sizeof(jobfile), "%s/c%05d", RequestRoot, job->id);
 
-  snprintf(jobfile, sizeof(jobfile), "%s/c%05d", RequestRoot, job->id);
-  if ((fp = cupsdOpenConfFile(jobfile)) == NULL)
-    goto error;
+      if (job_read->error && job_read->error != ENOENT)
+	cupsdLogJob(job, CUPSD_LOG_ERROR, "Unable to open \"%s\": %s",
+		    jobfile, strerror(job_read->error));
+      else if (!job_read->error)
+	cupsdLogJob(job, CUPSD_LOG_ERROR,
+		    "Unable to read job control file \"%s\".", jobfile);
 
-  if (ippReadIO(fp, (ipp_iocb_t)cupsFileRead, 1, NULL, job->attrs) != IPP_DATA)
+      goto error;
+    }
+  }
+  else
   {
-    cupsdLogJob(job, CUPSD_LOG_ERROR,
-		"Unable to read job control file \"%s\".", jobfile);
+    if ((job->attrs = ippNew()) == NULL)
+    {
+      cupsdLogJob(job, CUPSD_LOG_ERROR,
+                  "Ran out of memory for job attributes.");
+      return (0);
+    }
+
+   /*
+    * Load job attributes...
+    */
+
+    cupsdLogJob(job, CUPSD_LOG_DEBUG, "Loading attributes...");
+
+    snprintf(jobfile, sizeof(jobfile), "%s/c%05d", RequestRoot, job->id);
+    if ((fp = cupsdOpenConfFile(jobfile)) == NULL)
+      goto error;
+
+    if (ippReadIO(fp, (ipp_iocb_t)cupsFileRead, 1, NULL, job->attrs) != IPP_DATA)
+    {
+      cupsdLogJob(job, CUPSD_LOG_ERROR,
+		  "Unable to read job control file \"%s\".", jobfile);
+      cupsFileClose(fp);
+      goto error;
+    }
+
     cupsFileClose(fp);
-    goto error;
   }
 
-  cupsFileClose(fp);
-
  /*
   * Copy attribute data to the job object...
   */
@@ -1850,6 +2080,9 @@ cupsdLoadJob(cupsd_job_t *job)		/* I - Job */
   if (!job->sheets)
     job->sheets = ippAddInteger(job->attrs, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-media-sheets-completed", 0);
 
+  job->impressions_completed = ippGetInteger(job->impressions, 0);
+  job->sheets_completed      = ippGetInteger(job->sheets, 0);
+
   if (!job->priority)
   {
     if ((attr = ippFindAttribute(job->attrs, "job-priority",
@@ -2053,6 +2286,9 @@ cupsdLoadJob(cupsd_job_t *job)		/* I - Job */
   }
 
   job->access_time = time(NULL);
+
+  cupsdUpdateJobTimer(job);
+
   return (1);
 
  /*
@@ -2071,6 +2307,81 @@ cupsdLoadJob(cupsd_job_t *job)		/* I - Job */
 }
 
 
+/*
+ * 'cupsdLoadJobs()' - Load several jobs.
+ *
+ * The job control files are read and parsed using the worker threads and
+ * the attributes are then applied to each job on the main thread.
+ */
+
+void
+cupsdLoadJobs(cups_array_t *jobs)	/* I - Jobs to load */
+{
+  int			i,		/* Looping var */
+			num_reads;	/* Number of control files to read */
+  cupsd_job_t		*job;		/* Current job */
+  cupsd_jobread_t	*reads;		/* Control file read data */
+  void			**items;	/* Work items */
+  char			jobfile[1024];	/* Job filename */
+
+
+  if (cupsArrayCount(jobs) == 0)
+    return;
+
+  reads = calloc((size_t)cupsArrayCount(jobs), sizeof(cupsd_jobread_t));
+  items = calloc((size_t)cupsArrayCount(jobs), sizeof(void *));
+
+  if (!reads || !items)
+  {
+    free(reads);
+    free(items);
+    return;
+  }
+
+  for (job = (cupsd_job_t *)cupsArrayFirst(jobs), num_reads = 0;
+       job;
+       job = (cupsd_job_t *)cupsArrayNext(jobs))
+  {
+    if (job->attrs)
+      continue;
+
+    cupsdLogJob(job, CUPSD_LOG_DEBUG, "Loading attributes...");
+
+   /*
+    * Make sure any queued save of the control file is on disk...
+    */
+
+    snprintf(jobfile, sizeof(jobfile), "%s/c%05d", RequestRoot, job->id);
+    cupsdSyncConfFile(jobfile);
+
+    reads[num_reads].id = job->id;
+    items[num_reads]    = reads + num_reads;
+    num_reads ++;
+  }
+
+  cupsdRunWorkers((cupsd_workfunc_t)read_job_attrs, items, num_reads);
+
+ /*
+  * Apply the attributes on the main thread...
+  */
+
+  for (i = 0; i < num_reads; i ++)
+  {
+    if ((job = cupsdFindJob(reads[i].id)) != NULL && !job->attrs)
+    {
+      job_read = reads + i;
+      cupsdLoadJob(job);
+      job_read = NULL;
+    }
+
+    ippDelete(reads[i].attrs);
+  }
+
+  free(items);
+  free(reads);
+}
+
+
 /*
  * 'cupsdMoveJob()' - Move the specified job to a different destination.
  */
@@ -2114,9 +2425,13 @@ cupsdMoveJob(cupsd_job_t     *job,	/* I - Job */
                 "Job #%d moved from %s to %s.", job->id, olddest,
 		p->name);
 
+  remove_ready_job(job);
+
   cupsdSetString(&job->dest, p->name);
   job->dtype = p->type & (CUPS_PRINTER_CLASS | CUPS_PRINTER_REMOTE);
 
+  cupsdUpdateReadyJob(job);
+
   if ((attr = ippFindAttribute(job->attrs, "job-printer-uri",
                                IPP_TAG_URI)) != NULL)
     ippSetString(job->attrs, &attr, 0, p->uri);
@@ -2131,7 +2446,30 @@ cupsdMoveJob(cupsd_job_t     *job,	/* I - Job */
 
 
 /*
- * 'cupsdReleaseJob()' - Release the specified job.
+ * 'cupsdReleaseHeldNewJobs()' - Clear the job-held-on-create reason for the
+ *                               jobs on a destination.
+ *
+ * Held jobs are not in the ready queues, so this looks at all active jobs.
+ * It is only called for Release-Held-New-Jobs requests.
+ */
+
+void
+cupsdReleaseHeldNewJobs(
+    cupsd_printer_t *printer)		/* I - Printer or class */
+{
+  cupsd_job_t	*job;			/* Current job */
+
+
+  for (job = (cupsd_job_t *)cupsArrayFirst(ActiveJobs);
+       job;
+       job = (cupsd_job_t *)cupsArrayNext(ActiveJobs))
+    if (job->dest && !_cups_strcasecmp(job->dest, printer->name))
+      release_held_new_job(job);
+}
+
+
+/*
+ * 'cupsdReleaseJob()' - Release the specified job.
  */
 
 void
@@ -2178,35 +2516,31 @@ cupsdRestartJob(cupsd_job_t *job)	/* I - Job */
 void
 cupsdSaveAllJobs(void)
 {
-  int		i;			/* Looping var */
-  cups_file_t	*fp;			/* job.cache file */
-  char		filename[1024],		/* job.cache filename */
-		temp[1024];		/* Temporary string */
-  cupsd_job_t	*job;			/* Current job */
-  time_t	curtime;		/* Current time */
-  struct tm	*curdate;		/* Current date */
-
-
-  snprintf(filename, sizeof(filename), "%s/job.cache", CacheDir);
-  if ((fp = cupsdCreateConfFile(filename, ConfigFilePerm)) == NULL)
-    return;
+  int			i;		/* Looping var */
+  char			filename[1024];	/* job.index filename */
+  cupsd_job_t		*job;		/* Current job */
+  cupsd_jobhdr_t	*hdr;		/* job.index header */
+  cupsd_jobrec_t	rec,		/* New record for job */
+			*recptr;	/* Record in job.index */
+  char			*used;		/* Records in use */
+  int			changed = 0;	/* Number of changed records */
 
-  cupsdLogMessage(CUPSD_LOG_INFO, "Saving job.cache...");
 
- /*
-  * Write a small header to the file...
-  */
+  snprintf(filename, sizeof(filename), "%s/job.index", CacheDir);
 
-  curtime = time(NULL);
-  curdate = localtime(&curtime);
-  strftime(temp, sizeof(temp) - 1, "%Y-%m-%d %H:%M", curdate);
+  if (!job_index && !open_job_index(filename, 1))
+  {
+   /*
+    * Fall back on the text job.cache file...
+    */
 
-  cupsFilePuts(fp, "# Job cache file for " CUPS_SVERSION "\n");
-  cupsFilePrintf(fp, "# Written by cupsd on %s\n", temp);
-  cupsFilePrintf(fp, "NextJobId %d\n", NextJobId);
+    save_job_cache();
+    job_cache_removed = 0;
+    return;
+  }
 
  /*
-  * Write each job known to the system...
+  * Assign records to new jobs; this may grow the job.index file...
   */
 
   for (job = (cupsd_job_t *)cupsArrayFirst(Jobs);
@@ -2214,36 +2548,115 @@ cupsdSaveAllJobs(void)
        job = (cupsd_job_t *)cupsArrayNext(Jobs))
   {
     if (job->printer && job->printer->temporary)
+      continue;				/* Don't save jobs on temporary printers */
+
+    if (!job->index_slot && !find_job_record(job))
     {
      /*
-      * Don't save jobs on temporary printers...
+      * Unable to grow job.index, start over with the text job.cache file...
       */
 
+      close_job_index();
+      unlink(filename);
+
+      for (job = (cupsd_job_t *)cupsArrayFirst(Jobs);
+           job;
+	   job = (cupsd_job_t *)cupsArrayNext(Jobs))
+        job->index_slot = 0;
+
+      save_job_cache();
+      job_cache_removed = 0;
+      return;
+    }
+  }
+
+  hdr = (cupsd_jobhdr_t *)job_index;
+
+  if ((used = calloc((size_t)hdr->num_records, 1)) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to allocate memory for %d job records.", hdr->num_records);
+    return;
+  }
+
+ /*
+  * Update the records that have changed...
+  */
+
+  for (job = (cupsd_job_t *)cupsArrayFirst(Jobs);
+       job;
+       job = (cupsd_job_t *)cupsArrayNext(Jobs))
+  {
+    if (!job->index_slot)
       continue;
+
+    pack_job_record(job, &rec);
+
+    recptr = (cupsd_jobrec_t *)(job_index + job->index_slot * CUPSD_JOBINDEX_RECORD);
+
+    if (memcmp(recptr, &rec, sizeof(rec)))
+    {
+      memcpy(recptr, &rec, sizeof(rec));
+      changed ++;
     }
 
-    cupsFilePrintf(fp, "<Job %d>\n", job->id);
-    cupsFilePrintf(fp, "State %d\n", job->state_value);
-    cupsFilePrintf(fp, "Created %ld\n", (long)job->creation_time);
-    if (job->completed_time)
-      cupsFilePrintf(fp, "Completed %ld\n", (long)job->completed_time);
-    cupsFilePrintf(fp, "Priority %d\n", job->priority);
-    if (job->hold_until)
-      cupsFilePrintf(fp, "HoldUntil %ld\n", (long)job->hold_until);
-    cupsFilePrintf(fp, "Username %s\n", job->username);
-    if (job->name)
-      cupsFilePutConf(fp, "Name", job->name);
-    cupsFilePrintf(fp, "Destination %s\n", job->dest);
-    cupsFilePrintf(fp, "DestType %d\n", job->dtype);
-    cupsFilePrintf(fp, "KOctets %d\n", job->koctets);
-    cupsFilePrintf(fp, "NumFiles %d\n", job->num_files);
-    for (i = 0; i < job->num_files; i ++)
-      cupsFilePrintf(fp, "File %d %s/%s %d\n", i + 1, job->filetypes[i]->super,
-                     job->filetypes[i]->type, job->compressions[i]);
-    cupsFilePuts(fp, "</Job>\n");
+    used[job->index_slot] = 1;
   }
 
-  cupsdCloseCreatedConfFile(fp, filename);
+ /*
+  * Free the records of jobs that have been deleted...
+  */
+
+  for (i = 1; i < hdr->num_records; i ++)
+  {
+    recptr = (cupsd_jobrec_t *)(job_index + i * CUPSD_JOBINDEX_RECORD);
+
+    if (recptr->id && !used[i])
+    {
+      memset(recptr, 0, sizeof(cupsd_jobrec_t));
+      changed ++;
+
+      if (i < job_index_hint)
+        job_index_hint = i;
+    }
+  }
+
+  free(used);
+
+  if (hdr->next_job_id != NextJobId)
+  {
+    hdr->next_job_id = NextJobId;
+    changed ++;
+  }
+
+  if (changed)
+  {
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Saving job.index (%d changed records)...", changed);
+
+    if (msync(job_index, (size_t)hdr->num_records * CUPSD_JOBINDEX_RECORD, SyncOnClose ? MS_SYNC : MS_ASYNC))
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to sync \"%s\": %s", filename, strerror(errno));
+  }
+
+ /*
+  * Always update the modification time, which is compared against the job
+  * control files at startup - control files are also rewritten without
+  * changing their job.index records...
+  */
+
+  if (utimes(filename, NULL))
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to update \"%s\": %s", filename, strerror(errno));
+
+  if (!job_cache_removed)
+  {
+   /*
+    * Remove any older job.cache file now that job.index is current...
+    */
+
+    snprintf(filename, sizeof(filename), "%s/job.cache", CacheDir);
+    if (unlink(filename) && errno != ENOENT)
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to remove \"%s\": %s", filename, strerror(errno));
+
+    job_cache_removed = 1;
+  }
 }
 
 
@@ -2276,8 +2689,6 @@ cupsdSaveJob(cupsd_job_t *job)		/* I - Job */
   if ((fp = cupsdCreateConfFile(filename, ConfigFilePerm & 0600)) == NULL)
     return;
 
-  fchown(cupsFileNumber(fp), RunUser, Group);
-
   job->attrs->state = IPP_IDLE;
 
   if (ippWriteIO(fp, (ipp_iocb_t)cupsFileWrite, 1, NULL,
@@ -2288,15 +2699,13 @@ cupsdSaveJob(cupsd_job_t *job)		/* I - Job */
     return;
   }
 
-  if (!cupsdCloseCreatedConfFile(fp, filename))
+  if (!cupsdCloseCreatedJobFile(fp, filename))
   {
    /*
-    * Remove backup file and mark this job as clean...
+    * Mark this job as clean - the job is marked dirty again if the I/O thread
+    * is unable to write the control file...
     */
 
-    strlcat(filename, ".O", sizeof(filename));
-    unlink(filename);
-
     job->dirty = 0;
   }
 }
@@ -2479,6 +2888,8 @@ cupsdSetJobHoldUntil(cupsd_job_t *job,	/* I - Job */
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdSetJobHoldUntil: hold_until=%d",
                   (int)job->hold_until);
+
+  cupsdUpdateJobTimer(job);
 }
 
 
@@ -2507,6 +2918,7 @@ cupsdSetJobPriority(
   */
 
   cupsArrayRemove(ActiveJobs, job);
+  remove_ready_job(job);
 
   job->priority = priority;
 
@@ -2518,6 +2930,7 @@ cupsdSetJobPriority(
                   priority);
 
   cupsArrayAdd(ActiveJobs, job);
+  cupsdUpdateReadyJob(job);
 
   job->dirty = 1;
   cupsdMarkDirty(CUPSD_DIRTY_JOBS);
@@ -2756,6 +3169,12 @@ cupsdSetJobState(
 	break;
   }
 
+  if (job)
+  {
+    cupsdUpdateJobTimer(job);
+    cupsdUpdateReadyJob(job);
+  }
+
  /*
   * Finalize the job immediately if we forced things...
   */
@@ -2805,30 +3224,37 @@ cupsdStopAllJobs(
 
 
 /*
- * 'cupsdUnloadCompletedJobs()' - Flush completed job history from memory.
+ * 'cupsdUpdateJobTimer()' - Schedule the timer for the next job deadline.
+ *
+ * This must be called whenever the cancel, kill, or hold time of a job is
+ * moved earlier, and whenever a job is loaded or changes state.  Deadlines
+ * that move later are picked up when the timer runs.
  */
 
 void
-cupsdUnloadCompletedJobs(void)
+cupsdUpdateJobTimer(cupsd_job_t *job)	/* I - Job */
 {
-  cupsd_job_t	*job;			/* Current job */
-  time_t	expire;			/* Expiration time */
+  time_t	when = 0;		/* Next deadline */
 
 
-  expire = time(NULL) - 60;
+  if (job->kill_time)
+    when = job->kill_time;
 
-  for (job = (cupsd_job_t *)cupsArrayFirst(Jobs);
-       job;
-       job = (cupsd_job_t *)cupsArrayNext(Jobs))
-    if (job->attrs && job->state_value >= IPP_JOB_STOPPED && !job->printer &&
-        job->access_time < expire)
-    {
-      if (job->dirty)
-        cupsdSaveJob(job);
+  if (job->cancel_time && (!when || job->cancel_time < when))
+    when = job->cancel_time;
 
-      if (!job->dirty)
-        unload_job(job);
-    }
+  if (job->state_value == IPP_JOB_HELD && job->hold_until &&
+      (!when || job->hold_until < when))
+    when = job->hold_until + 1;
+
+  if (job->attrs && job->state_value >= IPP_JOB_STOPPED && !job->printer &&
+      (!when || (job->access_time + 60) < when))
+    when = job->access_time + 61;
+
+  if (job->timer)
+    cupsdSetTimer(job->timer, when);
+  else if (when)
+    job->timer = cupsdAddTimer(when, (cupsd_timerfunc_t)check_job_timer, job);
 }
 
 
@@ -2890,6 +3316,171 @@ cupsdUpdateJobs(void)
 }
 
 
+/*
+ * 'cupsdUpdateReadyJob()' - Add or remove a job from the ready queue for its
+ *                           destination.
+ *
+ * This must be called whenever a job becomes pending.  Jobs that are no longer
+ * pending are removed from the ready queues by cupsdCheckJobs().
+ */
+
+void
+cupsdUpdateReadyJob(cupsd_job_t *job)	/* I - Job */
+{
+  cupsd_readyq_t	*rq;		/* Ready queue */
+
+
+  if (!job->dest)
+    return;
+
+  if (job->state_value == IPP_JOB_PENDING)
+  {
+    if ((rq = find_ready_queue(job->dest, 1)) != NULL &&
+        !cupsArrayFind(rq->jobs, job))
+      cupsArrayAdd(rq->jobs, job);
+  }
+  else
+    remove_ready_job(job);
+}
+
+
+/*
+ * 'check_job_timer()' - Handle expired deadlines for a job.
+ */
+
+static void
+check_job_timer(cupsd_job_t *job)	/* I - Job */
+{
+  int			id;		/* Job ID */
+  time_t		curtime;	/* Current time */
+  ipp_attribute_t	*attr;		/* Job attribute */
+
+
+  id      = job->id;
+  curtime = time(NULL);
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG2,
+                  "check_job_timer: Job %d - state=%d, cancel_time=%ld, "
+		  "hold_until=%ld, kill_time=%ld, access_time=%ld", job->id,
+		  job->state_value, (long)job->cancel_time,
+		  (long)job->hold_until, (long)job->kill_time,
+		  (long)job->access_time);
+
+  if (job->kill_time && job->kill_time <= curtime)
+  {
+   /*
+    * Kill jobs if they are unresponsive...
+    */
+
+    if (!job->completed)
+      cupsdLogJob(job, CUPSD_LOG_ERROR, "Stopping unresponsive job.");
+
+    stop_job(job, CUPSD_JOB_FORCE);
+  }
+  else if (job->cancel_time && job->cancel_time <= curtime)
+  {
+   /*
+    * Cancel stuck jobs...
+    */
+
+    int cancel_after;			/* job-cancel-after value */
+
+    attr         = ippFindAttribute(job->attrs, "job-cancel-after", IPP_TAG_INTEGER);
+    cancel_after = attr ? ippGetInteger(attr, 0) : MaxJobTime;
+
+    job->cancel_time = 0;
+
+    if (job->completed)
+      cupsdSetJobState(job, IPP_JOB_CANCELED, CUPSD_JOB_FORCE, "Marking stuck job as completed after %d seconds.", cancel_after);
+    else
+      cupsdSetJobState(job, IPP_JOB_CANCELED, CUPSD_JOB_DEFAULT, "Canceling stuck job after %d seconds.", cancel_after);
+  }
+  else if (job->state_value == IPP_JOB_HELD && job->hold_until &&
+           job->hold_until < curtime)
+  {
+   /*
+    * Start held jobs if they are ready...
+    */
+
+    if (job->pending_timeout)
+    {
+     /*
+      * This job is pending; check that we don't have an active Send-Document
+      * operation in progress on any of the client connections, then timeout
+      * the job so we can start printing...
+      */
+
+      cupsd_client_t	*con;		/* Current client connection */
+
+      for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
+	   con;
+	   con = (cupsd_client_t *)cupsArrayNext(Clients))
+	if (con->request &&
+	    con->request->request.op.operation_id == IPP_SEND_DOCUMENT)
+	  break;
+
+      if (con || cupsdTimeoutJob(job))
+      {
+       /*
+        * Try again later...
+	*/
+
+        cupsdUpdateJobTimer(job);
+	return;
+      }
+    }
+
+    cupsdSetJobState(job, IPP_JOB_PENDING, CUPSD_JOB_DEFAULT,
+		     "Job submission timed out.");
+
+    cupsdCheckJobs();
+  }
+  else if (job->attrs && job->state_value >= IPP_JOB_STOPPED &&
+           !job->printer && job->access_time < (curtime - 60))
+  {
+   /*
+    * Unload completed jobs that have not been accessed recently...
+    */
+
+    if (job->dirty)
+      cupsdSaveJob(job);
+
+    if (!job->dirty)
+      unload_job(job);
+  }
+
+ /*
+  * Schedule the next deadline, if any, provided the job still exists...
+  */
+
+  if ((job = cupsdFindJob(id)) != NULL)
+    cupsdUpdateJobTimer(job);
+}
+
+
+/*
+ * 'close_job_index()' - Close the job.index file.
+ */
+
+static void
+close_job_index(void)
+{
+  if (job_index)
+  {
+    munmap(job_index, (size_t)((cupsd_jobhdr_t *)job_index)->num_records * CUPSD_JOBINDEX_RECORD);
+    job_index = NULL;
+  }
+
+  if (job_index_fd >= 0)
+  {
+    close(job_index_fd);
+    job_index_fd = -1;
+  }
+
+  job_index_hint = 1;
+}
+
+
 /*
  * 'compare_active_jobs()' - Compare the job IDs and priorities of two jobs.
  */
@@ -2949,6 +3540,22 @@ compare_jobs(void *first,		/* I - First job */
 }
 
 
+/*
+ * 'compare_ready_queues()' - Compare the destinations of two ready queues.
+ */
+
+static int				/* O - Result of comparison */
+compare_ready_queues(
+    cupsd_readyq_t *first,		/* I - First ready queue */
+    cupsd_readyq_t *second,		/* I - Second ready queue */
+    void           *data)		/* I - App data (not used) */
+{
+  (void)data;
+
+  return (_cups_strcasecmp(first->dest, second->dest));
+}
+
+
 /*
  * 'dump_job_history()' - Dump any debug messages for a job.
  */
@@ -3061,22 +3668,136 @@ dump_job_history(cupsd_job_t *job)	/* I - Job */
 
 
 /*
- * 'free_job_history()' - Free any log history.
+ * 'find_job_record()' - Assign an unused job.index record to a job.
  */
 
-static void
-free_job_history(cupsd_job_t *job)	/* I - Job */
+static int				/* O - 1 on success, 0 on failure */
+find_job_record(cupsd_job_t *job)	/* I - Job */
 {
-  char	*message;			/* Current message */
+  int			i;		/* Looping var */
+  cupsd_jobhdr_t	*hdr;		/* job.index header */
+  cupsd_jobrec_t	*rec;		/* Current record */
+  int			num_records;	/* New number of records */
+  size_t		size;		/* New size of job.index */
+  char			*temp;		/* New mapping */
 
 
-  if (!job->history)
-    return;
+  hdr = (cupsd_jobhdr_t *)job_index;
 
-  for (message = (char *)cupsArrayFirst(job->history);
-       message;
-       message = (char *)cupsArrayNext(job->history))
-    free(message);
+  for (i = job_index_hint; i < hdr->num_records; i ++)
+  {
+    rec = (cupsd_jobrec_t *)(job_index + i * CUPSD_JOBINDEX_RECORD);
+
+    if (!rec->id)
+      break;
+  }
+
+  if (i >= hdr->num_records)
+  {
+   /*
+    * Grow the job.index file...
+    */
+
+    num_records = 2 * hdr->num_records;
+    size        = (size_t)num_records * CUPSD_JOBINDEX_RECORD;
+
+    if (ftruncate(job_index_fd, (off_t)size))
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to grow job.index to %d records: %s", num_records, strerror(errno));
+      return (0);
+    }
+
+    munmap(job_index, (size_t)hdr->num_records * CUPSD_JOBINDEX_RECORD);
+
+    if ((temp = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, job_index_fd, 0)) == MAP_FAILED)
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to map job.index: %s", strerror(errno));
+      job_index = NULL;
+      close_job_index();
+      return (0);
+    }
+
+    job_index = temp;
+    hdr       = (cupsd_jobhdr_t *)job_index;
+    i         = hdr->num_records;
+
+    hdr->num_records = num_records;
+  }
+
+ /*
+  * Reserve the record for the job...
+  */
+
+  rec     = (cupsd_jobrec_t *)(job_index + i * CUPSD_JOBINDEX_RECORD);
+  rec->id = job->id;
+
+  job->index_slot = i;
+  job_index_hint  = i + 1;
+
+  return (1);
+}
+
+
+/*
+ * 'find_ready_queue()' - Find (or create) the ready queue for a destination.
+ */
+
+static cupsd_readyq_t *			/* O - Ready queue or NULL */
+find_ready_queue(const char *dest,	/* I - Destination name */
+                 int        create)	/* I - Create the queue as needed? */
+{
+  cupsd_readyq_t	key,		/* Search key */
+			*rq;		/* Ready queue */
+
+
+  if (!ready_queues)
+  {
+    if (!create)
+      return (NULL);
+
+    ready_queues = cupsArrayNew((cups_array_func_t)compare_ready_queues, NULL);
+  }
+
+  key.dest = (char *)dest;
+
+  if ((rq = (cupsd_readyq_t *)cupsArrayFind(ready_queues, &key)) != NULL ||
+      !create)
+    return (rq);
+
+  if ((rq = calloc(1, sizeof(cupsd_readyq_t))) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_EMERG,
+                    "Unable to allocate memory for ready queue \"%s\".",
+		    dest);
+    return (NULL);
+  }
+
+  rq->dest = strdup(dest);
+  rq->jobs = cupsArrayNew(compare_active_jobs, NULL);
+
+  cupsArrayAdd(ready_queues, rq);
+
+  return (rq);
+}
+
+
+/*
+ * 'free_job_history()' - Free any log history.
+ */
+
+static void
+free_job_history(cupsd_job_t *job)	/* I - Job */
+{
+  char	*message;			/* Current message */
+
+
+  if (!job->history)
+    return;
+
+  for (message = (char *)cupsArrayFirst(job->history);
+       message;
+       message = (char *)cupsArrayNext(job->history))
+    free(message);
 
   cupsArrayDelete(job->history);
   job->history = NULL;
@@ -3583,6 +4304,8 @@ finalize_job(cupsd_job_t *job,		/* I - Job */
 
   job->printer->job = NULL;
   job->printer      = NULL;
+
+  cupsdUpdateJobTimer(job);
 }
 
 
@@ -4169,6 +4892,32 @@ ipp_length(ipp_t *ipp)			/* I - IPP request */
 }
 
 
+/*
+ * 'job_record_checksum()' - Compute the checksum for a job.index record.
+ */
+
+static unsigned				/* O - Checksum */
+job_record_checksum(
+    const cupsd_jobrec_t *rec)		/* I - Record */
+{
+  const unsigned char	*ptr,		/* Pointer into record */
+			*end;		/* End of record */
+  unsigned		checksum = 2166136261U;
+					/* FNV-1a hash */
+
+
+  for (ptr = (const unsigned char *)rec, end = ptr + sizeof(cupsd_jobrec_t); ptr < end; ptr ++)
+  {
+    if (ptr >= (const unsigned char *)&rec->checksum && ptr < (const unsigned char *)(&rec->checksum + 1))
+      continue;				/* Skip checksum */
+
+    checksum = (checksum ^ *ptr) * 16777619U;
+  }
+
+  return (checksum);
+}
+
+
 /*
  * 'load_job_cache()' - Load jobs from the job.cache file.
  */
@@ -4272,6 +5021,8 @@ load_job_cache(const char *filename)	/* I - job.cache filename */
       job->status_pipes[0] = -1;
       job->status_pipes[1] = -1;
 
+      job->impressions_completed = -1;	/* Not in older job.cache files */
+
       cupsdLogJob(job, CUPSD_LOG_DEBUG, "Loading from cache...");
     }
     else if (!job)
@@ -4288,7 +5039,7 @@ load_job_cache(const char *filename)	/* I - job.cache filename */
 	cupsArrayAdd(ActiveJobs, job);
       else if (job->state_value > IPP_JOB_STOPPED)
       {
-        if (!job->completed_time || !job->creation_time || !job->name || !job->koctets)
+        if (!job->completed_time || !job->creation_time || !job->name || !job->koctets || job->impressions_completed < 0)
 	{
 	  cupsdLoadJob(job);
 	  unload_job(job);
@@ -4347,6 +5098,14 @@ load_job_cache(const char *filename)	/* I - job.cache filename */
     {
       job->koctets = atoi(value);
     }
+    else if (!_cups_strcasecmp(line, "Impressions"))
+    {
+      job->impressions_completed = atoi(value);
+    }
+    else if (!_cups_strcasecmp(line, "Sheets"))
+    {
+      job->sheets_completed = atoi(value);
+    }
     else if (!_cups_strcasecmp(line, "NumFiles"))
     {
       job->num_files = atoi(value);
@@ -4446,6 +5205,215 @@ load_job_cache(const char *filename)	/* I - job.cache filename */
 }
 
 
+/*
+ * 'load_job_index()' - Load jobs from the job.index file.
+ */
+
+static int				/* O - 1 on success, 0 if the file is bad */
+load_job_index(const char *filename)	/* I - job.index filename */
+{
+  int			i,		/* Looping var */
+			slot;		/* Current record */
+  cupsd_jobhdr_t	*hdr;		/* job.index header */
+  cupsd_jobrec_t	*rec;		/* Current record */
+  cupsd_job_t		*job;		/* New job */
+  const char		*strings[3],	/* Username, destination, and name */
+			*ptr,		/* Pointer into strings */
+			*end;		/* End of strings */
+  char			jobfile[1024],	/* Job filename */
+			super[MIME_MAX_SUPER],
+					/* MIME super type */
+			type[MIME_MAX_TYPE];
+					/* MIME type */
+  int			compression;	/* Compression value */
+
+
+  if (!open_job_index(filename, 0))
+    return (0);
+
+  cupsdLogMessage(CUPSD_LOG_INFO, "Loading job index file \"%s\"...", filename);
+
+  hdr = (cupsd_jobhdr_t *)job_index;
+
+  if (hdr->next_job_id > NextJobId)
+    NextJobId = hdr->next_job_id;
+
+ /*
+  * Validate all of the records before creating any jobs...
+  */
+
+  for (slot = 1; slot < hdr->num_records; slot ++)
+  {
+    rec = (cupsd_jobrec_t *)(job_index + slot * CUPSD_JOBINDEX_RECORD);
+
+    if (!rec->id)
+      continue;
+
+    end = rec->strings + sizeof(rec->strings);
+
+    for (i = 0, ptr = rec->strings; i < 3 && ptr < end; i ++, ptr += strlen(ptr) + 1)
+      if (!memchr(ptr, '\0', (size_t)(end - ptr)))
+        break;
+
+    if (rec->id < 1 || rec->checksum != job_record_checksum(rec) || i < 3 || rec->num_files < 0 || rec->num_files > 10000)
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Bad record %d in %s.", slot, filename);
+      break;
+    }
+
+    snprintf(jobfile, sizeof(jobfile), "%s/c%05d", RequestRoot, rec->id);
+    if (access(jobfile, 0))
+    {
+      snprintf(jobfile, sizeof(jobfile), "%s/c%05d.N", RequestRoot, rec->id);
+      if (access(jobfile, 0))
+      {
+	cupsdLogMessage(CUPSD_LOG_ERROR, "[Job %d] Files have gone away.", rec->id);
+	break;
+      }
+    }
+  }
+
+  if (slot < hdr->num_records)
+  {
+   /*
+    * job.index file is damaged or out-of-date compared to spool directory;
+    * load that instead...
+    */
+
+    close_job_index();
+    unlink(filename);
+    return (0);
+  }
+
+ /*
+  * Create the jobs...
+  */
+
+  for (slot = 1; slot < hdr->num_records; slot ++)
+  {
+    rec = (cupsd_jobrec_t *)(job_index + slot * CUPSD_JOBINDEX_RECORD);
+
+    if (!rec->id)
+    {
+      if (slot < job_index_hint)
+        job_index_hint = slot;
+
+      continue;
+    }
+
+    if ((job = calloc(1, sizeof(cupsd_job_t))) == NULL)
+    {
+      cupsdLogMessage(CUPSD_LOG_EMERG, "[Job %d] Unable to allocate memory for job.", rec->id);
+      break;
+    }
+
+    job->id              = rec->id;
+    job->index_slot      = slot;
+    job->back_pipes[0]   = -1;
+    job->back_pipes[1]   = -1;
+    job->print_pipes[0]  = -1;
+    job->print_pipes[1]  = -1;
+    job->side_pipes[0]   = -1;
+    job->side_pipes[1]   = -1;
+    job->status_pipes[0] = -1;
+    job->status_pipes[1] = -1;
+
+    cupsdLogJob(job, CUPSD_LOG_DEBUG, "Loading from index...");
+
+    job->state_value           = (ipp_jstate_t)rec->state;
+    job->priority              = rec->priority;
+    job->dtype                 = (cups_ptype_t)rec->dtype;
+    job->koctets               = rec->koctets;
+    job->impressions_completed = rec->impressions;
+    job->sheets_completed      = rec->sheets;
+    job->creation_time         = (time_t)rec->creation_time;
+    job->completed_time        = (time_t)rec->completed_time;
+    job->hold_until            = (time_t)rec->hold_until;
+
+    if (job->state_value < IPP_JOB_PENDING)
+      job->state_value = IPP_JOB_PENDING;
+    else if (job->state_value > IPP_JOB_COMPLETED)
+      job->state_value = IPP_JOB_COMPLETED;
+
+    for (i = 0, ptr = rec->strings; i < 3; i ++, ptr += strlen(ptr) + 1)
+      strings[i] = ptr;
+
+    if (strings[0][0])
+      cupsdSetString(&job->username, strings[0]);
+    if (strings[1][0])
+      cupsdSetString(&job->dest, strings[1]);
+    if (strings[2][0])
+      cupsdSetString(&job->name, strings[2]);
+
+    if (rec->num_files > 0 && !(rec->flags & CUPSD_JOBREC_PARTIAL))
+    {
+      snprintf(jobfile, sizeof(jobfile), "%s/d%05d-001", RequestRoot, job->id);
+      if (access(jobfile, 0))
+      {
+	cupsdLogJob(job, CUPSD_LOG_INFO, "Data files have gone away.");
+      }
+      else if ((job->filetypes = calloc((size_t)rec->num_files, sizeof(mime_type_t *))) == NULL || (job->compressions = calloc((size_t)rec->num_files, sizeof(int))) == NULL)
+      {
+	cupsdLogJob(job, CUPSD_LOG_EMERG, "Unable to allocate memory for %d files.", rec->num_files);
+	free(job->filetypes);
+	job->filetypes = NULL;
+      }
+      else
+      {
+        job->num_files = rec->num_files;
+
+	for (i = 0, end = rec->strings + sizeof(rec->strings); i < job->num_files; i ++)
+	{
+	  if (ptr < end && memchr(ptr, '\0', (size_t)(end - ptr)) && sscanf(ptr, "%d %15[^/]/%255s", &compression, super, type) == 3)
+	  {
+	    job->compressions[i] = compression;
+	    job->filetypes[i]    = mimeType(MimeDatabase, super, type);
+
+	    ptr += strlen(ptr) + 1;
+	  }
+	  else
+	    ptr = end;
+
+	  if (!job->filetypes[i])
+	  {
+	   /*
+	    * If the original MIME type is unknown, auto-type it!
+	    */
+
+	    cupsdLogJob(job, CUPSD_LOG_ERROR, "Unknown MIME type for file %d.", i + 1);
+
+	    snprintf(jobfile, sizeof(jobfile), "%s/d%05d-%03d", RequestRoot, job->id, i + 1);
+	    job->filetypes[i] = mimeFileType(MimeDatabase, jobfile, NULL, job->compressions + i);
+
+	   /*
+	    * If that didn't work, assume it is raw...
+	    */
+
+	    if (!job->filetypes[i])
+	      job->filetypes[i] = mimeType(MimeDatabase, "application", "vnd.cups-raw");
+	  }
+	}
+      }
+    }
+
+    cupsArrayAdd(Jobs, job);
+
+    if (job->state_value <= IPP_JOB_STOPPED && cupsdLoadJob(job))
+      cupsArrayAdd(ActiveJobs, job);
+    else if (job->state_value > IPP_JOB_STOPPED)
+    {
+      if (!job->completed_time || !job->creation_time || !job->name || !job->koctets || (rec->flags & CUPSD_JOBREC_PARTIAL))
+      {
+	cupsdLoadJob(job);
+	unload_job(job);
+      }
+    }
+  }
+
+  return (1);
+}
+
+
 /*
  * 'load_next_job_id()' - Load the NextJobId value from the job.cache file.
  */
@@ -4585,6 +5553,263 @@ load_request_root(void)
 }
 
 
+/*
+ * 'open_job_index()' - Open and map the job.index file.
+ */
+
+static int				/* O - 1 on success, 0 on failure */
+open_job_index(const char *filename,	/* I - job.index filename */
+               int        create)	/* I - Create the file as needed? */
+{
+  struct stat		fileinfo;	/* File information */
+  cupsd_jobhdr_t	*hdr;		/* job.index header */
+  size_t		size;		/* Size of file */
+
+
+  if (job_index)
+    return (1);
+
+  if ((job_index_fd = open(filename, O_RDWR | (create ? O_CREAT : 0), ConfigFilePerm)) < 0)
+  {
+    if (errno != ENOENT)
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to open \"%s\": %s", filename, strerror(errno));
+
+    return (0);
+  }
+
+  fcntl(job_index_fd, F_SETFD, fcntl(job_index_fd, F_GETFD) | FD_CLOEXEC);
+
+  if (fstat(job_index_fd, &fileinfo))
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to get file information for \"%s\" - %s", filename, strerror(errno));
+    close_job_index();
+    return (0);
+  }
+
+  if (fileinfo.st_size == 0 && create)
+  {
+   /*
+    * Initialize a new job.index file...
+    */
+
+    if (!getuid() && fchown(job_index_fd, getuid(), Group))
+      cupsdLogMessage(CUPSD_LOG_WARN, "Unable to change group for \"%s\": %s", filename, strerror(errno));
+
+    if (fchmod(job_index_fd, ConfigFilePerm))
+      cupsdLogMessage(CUPSD_LOG_WARN, "Unable to change permissions for \"%s\": %s", filename, strerror(errno));
+
+    size = 256 * CUPSD_JOBINDEX_RECORD;
+
+    if (ftruncate(job_index_fd, (off_t)size))
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to create \"%s\": %s", filename, strerror(errno));
+      close_job_index();
+      unlink(filename);
+      return (0);
+    }
+  }
+  else
+    size = (size_t)fileinfo.st_size;
+
+  if (size < CUPSD_JOBINDEX_RECORD || (size % CUPSD_JOBINDEX_RECORD) != 0 || size > (size_t)INT_MAX * CUPSD_JOBINDEX_RECORD)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Bad size for \"%s\".", filename);
+    close_job_index();
+    return (0);
+  }
+
+  if ((job_index = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, job_index_fd, 0)) == MAP_FAILED)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to map \"%s\": %s", filename, strerror(errno));
+    job_index = NULL;
+    close_job_index();
+    return (0);
+  }
+
+  hdr = (cupsd_jobhdr_t *)job_index;
+
+  if (fileinfo.st_size == 0)
+  {
+    memcpy(hdr->magic, CUPSD_JOBINDEX_MAGIC, sizeof(hdr->magic));
+    hdr->version     = CUPSD_JOBINDEX_VERSION;
+    hdr->record_size = CUPSD_JOBINDEX_RECORD;
+    hdr->byte_order  = CUPSD_JOBINDEX_ORDER;
+    hdr->num_records = (int)(size / CUPSD_JOBINDEX_RECORD);
+    hdr->next_job_id = NextJobId;
+  }
+  else if (memcmp(hdr->magic, CUPSD_JOBINDEX_MAGIC, sizeof(hdr->magic)) || hdr->version != CUPSD_JOBINDEX_VERSION || hdr->record_size != CUPSD_JOBINDEX_RECORD || hdr->byte_order != CUPSD_JOBINDEX_ORDER || (size_t)hdr->num_records * CUPSD_JOBINDEX_RECORD != size)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Bad header in \"%s\".", filename);
+    munmap(job_index, size);
+    job_index = NULL;
+    close_job_index();
+    return (0);
+  }
+
+  job_index_hint = 1;
+
+  return (1);
+}
+
+
+/*
+ * 'pack_job_record()' - Build the job.index record for a job.
+ */
+
+static void
+pack_job_record(cupsd_job_t    *job,	/* I - Job */
+                cupsd_jobrec_t *rec)	/* O - Record */
+{
+  int		i;			/* Looping var */
+  char		*ptr,			/* Pointer into strings */
+		*end;			/* End of strings */
+  size_t	len;			/* Length of string */
+
+
+  memset(rec, 0, sizeof(cupsd_jobrec_t));
+
+  if (job->attrs)
+  {
+    job->impressions_completed = ippGetInteger(job->impressions, 0);
+    job->sheets_completed      = ippGetInteger(job->sheets, 0);
+  }
+
+  rec->id             = job->id;
+  rec->state          = (int)job->state_value;
+  rec->priority       = job->priority;
+  rec->dtype          = (int)job->dtype;
+  rec->koctets        = job->koctets;
+  rec->impressions    = job->impressions_completed;
+  rec->sheets         = job->sheets_completed;
+  rec->num_files      = job->num_files;
+  rec->creation_time  = (long long)job->creation_time;
+  rec->completed_time = (long long)job->completed_time;
+  rec->hold_until     = (long long)job->hold_until;
+
+ /*
+  * Add the username, destination, name, and files as long as they fit;
+  * otherwise the job control file is loaded at startup to fill them in...
+  */
+
+  ptr = rec->strings;
+  end = rec->strings + sizeof(rec->strings);
+
+  if (job->username && (len = strlen(job->username) + 1) < (size_t)(end - ptr))
+  {
+    memcpy(ptr, job->username, len);
+    ptr += len;
+  }
+  else
+  {
+    rec->flags |= CUPSD_JOBREC_PARTIAL;
+    *ptr++ = '\0';
+  }
+
+  if (job->dest && (len = strlen(job->dest) + 1) < (size_t)(end - ptr))
+  {
+    memcpy(ptr, job->dest, len);
+    ptr += len;
+  }
+  else
+  {
+    rec->flags |= CUPSD_JOBREC_PARTIAL;
+    *ptr++ = '\0';
+  }
+
+  if (job->name && (len = strlen(job->name) + 1) < (size_t)(end - ptr))
+  {
+    memcpy(ptr, job->name, len);
+    ptr += len;
+  }
+  else
+    *ptr++ = '\0';
+
+  for (i = 0; i < job->num_files && !(rec->flags & CUPSD_JOBREC_PARTIAL); i ++)
+  {
+    len = (size_t)snprintf(ptr, (size_t)(end - ptr), "%d %s/%s", job->compressions[i], job->filetypes[i]->super, job->filetypes[i]->type) + 1;
+
+    if (len >= (size_t)(end - ptr))
+      rec->flags |= CUPSD_JOBREC_PARTIAL;
+    else
+      ptr += len;
+  }
+
+  if (rec->flags & CUPSD_JOBREC_PARTIAL)
+    memset(ptr, 0, (size_t)(end - ptr));
+
+  rec->checksum = job_record_checksum(rec);
+}
+
+
+/*
+ * 'read_job_attrs()' - Read a job control file from a worker thread.
+ *
+ * This function must not touch any scheduler state since it is run from the
+ * worker threads.
+ */
+
+static void
+read_job_attrs(cupsd_jobread_t *jr)	/* I - Control file read data */
+{
+  char		jobfile[1024];		/* Job filename */
+  cups_file_t	*fp;			/* Job file */
+
+
+  snprintf(jobfile, sizeof(jobfile), "%s/c%05d", RequestRoot, jr->id);
+
+  if ((fp = cupsFileOpen(jobfile, "r")) == NULL && errno == ENOENT)
+  {
+   /*
+    * Try opening the backup file...
+    */
+
+    strlcat(jobfile, ".O", sizeof(jobfile));
+    fp = cupsFileOpen(jobfile, "r");
+  }
+
+  if (!fp)
+  {
+    jr->error = errno;
+    return;
+  }
+
+  if ((jr->attrs = ippNew()) != NULL &&
+      ippReadIO(fp, (ipp_iocb_t)cupsFileRead, 1, NULL, jr->attrs) != IPP_DATA)
+  {
+    ippDelete(jr->attrs);
+    jr->attrs = NULL;
+  }
+
+  cupsFileClose(fp);
+}
+
+
+/*
+ * 'release_held_new_job()' - Clear the job-held-on-create reason for a job
+ *                            unless its destination is still holding new
+ *                            jobs.
+ */
+
+static int				/* O - 1 if the job can be started, 0 if held */
+release_held_new_job(cupsd_job_t *job)	/* I - Job */
+{
+  const char		*reasons;	/* job-state-reasons value */
+  cupsd_printer_t	*printer;	/* Job destination */
+
+
+  reasons = ippGetString(job->reasons, 0, NULL);
+  if (!reasons || strcmp(reasons, "job-held-on-create"))
+    return (1);
+
+  if ((printer = cupsdFindDest(job->dest)) != NULL && printer->holding_new_jobs)
+    return (0);
+
+  ippSetString(job->attrs, &job->reasons, 0, "none");
+
+  return (1);
+}
+
+
 /*
  * 'remove_job_files()' - Remove the document files for a job.
  */
@@ -4640,6 +5865,104 @@ remove_job_history(cupsd_job_t *job)	/* I - Job */
 }
 
 
+/*
+ * 'remove_ready_job()' - Remove a job from the ready queue for its destination.
+ */
+
+static void
+remove_ready_job(cupsd_job_t *job)	/* I - Job */
+{
+  cupsd_readyq_t	*rq;		/* Ready queue */
+
+
+  if (job->dest && (rq = find_ready_queue(job->dest, 0)) != NULL)
+    cupsArrayRemove(rq->jobs, job);
+}
+
+
+/*
+ * 'save_job_cache()' - Save a summary of all jobs to the text job.cache file.
+ */
+
+static void
+save_job_cache(void)
+{
+  int		i;			/* Looping var */
+  cups_file_t	*fp;			/* job.cache file */
+  char		filename[1024],		/* job.cache filename */
+		temp[1024];		/* Temporary string */
+  cupsd_job_t	*job;			/* Current job */
+  time_t	curtime;		/* Current time */
+  struct tm	*curdate;		/* Current date */
+
+
+  snprintf(filename, sizeof(filename), "%s/job.cache", CacheDir);
+  if ((fp = cupsdCreateConfFile(filename, ConfigFilePerm)) == NULL)
+    return;
+
+  cupsdLogMessage(CUPSD_LOG_INFO, "Saving job.cache...");
+
+ /*
+  * Write a small header to the file...
+  */
+
+  curtime = time(NULL);
+  curdate = localtime(&curtime);
+  strftime(temp, sizeof(temp) - 1, "%Y-%m-%d %H:%M", curdate);
+
+  cupsFilePuts(fp, "# Job cache file for " CUPS_SVERSION "\n");
+  cupsFilePrintf(fp, "# Written by cupsd on %s\n", temp);
+  cupsFilePrintf(fp, "NextJobId %d\n", NextJobId);
+
+ /*
+  * Write each job known to the system...
+  */
+
+  for (job = (cupsd_job_t *)cupsArrayFirst(Jobs);
+       job;
+       job = (cupsd_job_t *)cupsArrayNext(Jobs))
+  {
+    if (job->printer && job->printer->temporary)
+    {
+     /*
+      * Don't save jobs on temporary printers...
+      */
+
+      continue;
+    }
+
+    cupsFilePrintf(fp, "<Job %d>\n", job->id);
+    cupsFilePrintf(fp, "State %d\n", job->state_value);
+    cupsFilePrintf(fp, "Created %ld\n", (long)job->creation_time);
+    if (job->completed_time)
+      cupsFilePrintf(fp, "Completed %ld\n", (long)job->completed_time);
+    cupsFilePrintf(fp, "Priority %d\n", job->priority);
+    if (job->hold_until)
+      cupsFilePrintf(fp, "HoldUntil %ld\n", (long)job->hold_until);
+    cupsFilePrintf(fp, "Username %s\n", job->username);
+    if (job->name)
+      cupsFilePutConf(fp, "Name", job->name);
+    cupsFilePrintf(fp, "Destination %s\n", job->dest);
+    cupsFilePrintf(fp, "DestType %d\n", job->dtype);
+    cupsFilePrintf(fp, "KOctets %d\n", job->koctets);
+    if (job->attrs)
+    {
+      job->impressions_completed = ippGetInteger(job->impressions, 0);
+      job->sheets_completed      = ippGetInteger(job->sheets, 0);
+    }
+    cupsFilePrintf(fp, "Impressions %d\n", job->impressions_completed);
+    cupsFilePrintf(fp, "Sheets %d\n", job->sheets_completed);
+    cupsFilePrintf(fp, "NumFiles %d\n", job->num_files);
+    for (i = 0; i < job->num_files; i ++)
+      cupsFilePrintf(fp, "File %d %s/%s %d\n", i + 1, job->filetypes[i]->super,
+                     job->filetypes[i]->type, job->compressions[i]);
+    cupsFilePuts(fp, "</Job>\n");
+  }
+
+  cupsdCloseCreatedConfFile(fp, filename);
+}
+
+
 /*
  * 'set_time()' - Set one of the "time-at-xyz" attributes.
  */
@@ -4767,6 +6090,8 @@ start_job(cupsd_job_t     *job,		/* I - Job ID */
   else
     job->cancel_time = 0;
 
+  cupsdUpdateJobTimer(job);
+
  /*
   * Check for support files...
   */
@@ -4920,7 +6245,11 @@ stop_job(cupsd_job_t       *job,	/* I - Job */
   job->cost   = 0;
 
   if (action == CUPSD_JOB_DEFAULT && !job->kill_time && job->backend > 0)
+  {
     job->kill_time = time(NULL) + JobKillDelay;
+
+    cupsdUpdateJobTimer(job);
+  }
   else if (action >= CUPSD_JOB_FORCE)
     job->kill_time = 0;
 
@@ -4964,6 +6293,13 @@ unload_job(cupsd_job_t *job)		/* I - Job */
 
   cupsdLogJob(job, CUPSD_LOG_DEBUG, "Unloading...");
 
+ /*
+  * Keep the summary values that Get-Jobs can report for unloaded jobs...
+  */
+
+  job->impressions_completed = ippGetInteger(job->impressions, 0);
+  job->sheets_completed      = ippGetInteger(job->sheets, 0);
+
   ippDelete(job->attrs);
 
   job->attrs           = NULL;
@@ -5133,6 +6469,8 @@ update_job(cupsd_job_t *job)		/* I - Job to check */
 	      job->cancel_time = time(NULL) + ippGetInteger(cancel_after, 0);
 	    else
 	      job->cancel_time = time(NULL) + MaxJobTime;
+
+	    cupsdUpdateJobTimer(job);
 	  }
         }
       }
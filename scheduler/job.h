@@ -34,7 +34,11 @@ struct cupsd_job_s			/**** Job request ****/
   char			*username;	/* Printing user */
   char			*dest;		/* Destination printer or class */
   char			*name;		/* Job name/title */
-  int			koctets;	/* job-k-octets */
+  int			koctets,	/* job-k-octets */
+			impressions_completed,
+					/* job-impressions-completed */
+			sheets_completed;
+					/* job-media-sheets-completed */
   cups_ptype_t		dtype;		/* Destination type */
   cupsd_printer_t	*printer;	/* Printer this job is assigned to */
   int			num_files;	/* Number of files in job */
@@ -50,6 +54,8 @@ struct cupsd_job_s			/**** Job request ****/
 			history_time,	/* Job history retain time */
 			hold_until,	/* Hold expiration date/time */
 			kill_time;	/* When to send SIGKILL */
+  cupsd_timer_t		*timer;		/* Timer for next deadline */
+  int			index_slot;	/* Record in job.index or 0 */
   ipp_attribute_t	*state;		/* Job state */
   ipp_attribute_t	*reasons;	/* Job state reasons */
   ipp_attribute_t	*job_sheets;	/* Job sheets (NULL if none) */
@@ -150,9 +156,12 @@ extern void		cupsdFreeAllJobs(void);
 extern cups_array_t	*cupsdGetCompletedJobs(cupsd_printer_t *p);
 extern int		cupsdGetPrinterJobCount(const char *dest);
 extern int		cupsdGetUserJobCount(const char *username);
+extern int		cupsdHasPendingJobs(void);
 extern void		cupsdLoadAllJobs(void);
 extern int		cupsdLoadJob(cupsd_job_t *job);
+extern void		cupsdLoadJobs(cups_array_t *jobs);
 extern void		cupsdMoveJob(cupsd_job_t *job, cupsd_printer_t *p);
+extern void		cupsdReleaseHeldNewJobs(cupsd_printer_t *printer);
 extern void		cupsdReleaseJob(cupsd_job_t *job);
 extern void		cupsdRestartJob(cupsd_job_t *job);
 extern void		cupsdSaveAllJobs(void);
@@ -169,5 +178,6 @@ extern void		cupsdSetJobState(cupsd_job_t *job,
 extern void		cupsdStopAllJobs(cupsd_jobaction_t action,
 			                 int kill_delay);
 extern int		cupsdTimeoutJob(cupsd_job_t *job);
-extern void		cupsdUnloadCompletedJobs(void);
+extern void		cupsdUpdateJobTimer(cupsd_job_t *job);
 extern void		cupsdUpdateJobs(void);
+extern void		cupsdUpdateReadyJob(cupsd_job_t *job);
@@ -0,0 +1,873 @@
+/*
+ * State file journal functions for the CUPS scheduler.
+ *
+ * Licensed under Apache License v2.0.  See the file "LICENSE" for more information.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "cupsd.h"
+#include <cups/file-private.h>
+
+
+/*
+ * Design Notes for State File Journals in CUPSD
+ * ---------------------------------------------
+ *
+ * The printers.conf, classes.conf, and subscriptions.conf files consist of a
+ * header followed by one "<Name value>...</Name>" block per object.  Rather
+ * than rewriting the whole file every time one object changes, the save
+ * functions write each block as a separate record using
+ * cupsdAddJournalRecord().  cupsdEndJournal() then compares the records with
+ * the ones that were last saved and appends only the changed (or deleted)
+ * records to a "filename.journal" file.
+ *
+ * Each journal record starts with a "Record name length checksum" line
+ * followed by the record contents; a length of 0 means the record was
+ * deleted and the name "#" is used for the file header.  The header only
+ * changes with its "Written by" time, so it is never journaled and is
+ * rewritten when the state file is compacted.  Records are only
+ * applied when they are complete and their checksum matches, so a record
+ * that was partially written when the system crashed is ignored.
+ *
+ * The journal is compacted into the state file (using the normal atomic
+ * rename) when it grows larger than the state file, at shutdown, and at
+ * startup by cupsdReplayJournal() before the state file is loaded.  The
+ * state file therefore always uses the existing format, with an added
+ * "# Journal generation N" comment on the first line.
+ *
+ * Each compaction increments the generation number, and a journal starts
+ * with a "Journal N" line naming the generation of the state file it
+ * applies to.  If the system crashes after a compacted state file has been
+ * renamed into place but before the old journal is removed, the generation
+ * numbers no longer match and cupsdReplayJournal() removes the stale journal
+ * instead of applying its records to the newer state file.
+ *
+ * Journal records are appended by the I/O thread in file.c.  Compacting
+ * waits for the new state file to be in place before removing the journal,
+ * and any records appended afterwards are queued after the removal.
+ */
+
+
+/*
+ * Local types...
+ */
+
+typedef struct cupsd_jrecord_s		/**** Journal record ****/
+{
+  char		*name;			/* Record name ("#" for header) */
+  char		*data;			/* Record contents */
+  size_t	length;			/* Length of contents */
+} cupsd_jrecord_t;
+
+struct cupsd_journal_s			/**** State file journal ****/
+{
+  char		*filename;		/* State filename */
+  mode_t	perm;			/* Permissions for state file */
+  int		dirty;			/* Dirty flag for state file */
+  cups_array_t	*saved,			/* Records last saved */
+		*pending;		/* Records being saved, in order */
+  cups_file_t	*fp;			/* Buffer for current record */
+  char		*fpname;		/* Name of current record */
+  int		error;			/* Error while saving? */
+  unsigned	generation;		/* Generation of state file */
+  size_t	file_size,		/* Size of state file */
+		journal_size;		/* Size of journal file */
+};
+
+
+/*
+ * Local globals...
+ */
+
+static cups_array_t	*Journals = NULL;
+					/* Journals for state files */
+
+
+/*
+ * Local functions...
+ */
+
+static int		compact_journal(cupsd_journal_t *j, cups_array_t *records);
+static int		compare_journals(cupsd_journal_t *a, cupsd_journal_t *b);
+static int		compare_records(cupsd_jrecord_t *a, cupsd_jrecord_t *b);
+static cupsd_journal_t	*find_journal(const char *filename);
+static void		finish_record(cupsd_journal_t *j);
+static void		free_records(cups_array_t *records);
+static int		get_generation(const char *line, unsigned *generation);
+static unsigned		record_checksum(const char *data, size_t length);
+
+
+/*
+ * 'cupsdAddJournalRecord()' - Start a new record for a state file.
+ *
+ * The returned file is used to write the record contents and remains valid
+ * until the next call to cupsdAddJournalRecord() or cupsdEndJournal().  A
+ * NULL name is used for the file header.
+ */
+
+cups_file_t *				/* O - File for record contents */
+cupsdAddJournalRecord(
+    cupsd_journal_t *j,			/* I - Journal */
+    const char      *name)		/* I - Record name or NULL for header */
+{
+  finish_record(j);
+
+  if ((j->fp = _cupsFileOpenBuffer()) == NULL ||
+      (j->fpname = strdup(name ? name : "#")) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR,
+                    "Unable to allocate memory for journal record.");
+    j->error = 1;
+  }
+
+  return (j->fp);
+}
+
+
+/*
+ * 'cupsdBeginJournal()' - Start saving a state file.
+ */
+
+cupsd_journal_t *			/* O - Journal or NULL on error */
+cupsdBeginJournal(const char *filename,	/* I - State filename */
+                  mode_t     perm,	/* I - Permissions for state file */
+		  int        dirty)	/* I - Dirty flag for state file */
+{
+  cupsd_journal_t	*j;		/* Journal */
+
+
+  if ((j = find_journal(filename)) == NULL)
+    return (NULL);
+
+  j->perm    = perm;
+  j->dirty   = dirty;
+  j->error   = 0;
+  j->pending = cupsArrayNew(NULL, NULL);
+
+  return (j);
+}
+
+
+/*
+ * 'cupsdCompactJournals()' - Compact all journals into their state files.
+ *
+ * The state files are marked dirty so that the next cupsdCleanDirty() writes
+ * them in full.
+ */
+
+void
+cupsdCompactJournals(void)
+{
+  cupsd_journal_t	*j;		/* Current journal */
+
+
+  for (j = (cupsd_journal_t *)cupsArrayFirst(Journals);
+       j;
+       j = (cupsd_journal_t *)cupsArrayNext(Journals))
+  {
+    if (j->journal_size > 0)
+    {
+      free_records(j->saved);
+      j->saved = NULL;
+
+      cupsdMarkDirty(j->dirty);
+    }
+  }
+}
+
+
+/*
+ * 'cupsdEndJournal()' - Finish saving a state file.
+ *
+ * Only the records that have changed are written to the journal, unless the
+ * state file needs to be compacted.
+ */
+
+int					/* O - 1 on success, 0 on failure */
+cupsdEndJournal(cupsd_journal_t *j)	/* I - Journal */
+{
+  cupsd_jrecord_t	*rec,		/* Current record */
+			*old;		/* Previously saved record */
+  cups_array_t		*records;	/* Records being saved, by name */
+  cups_file_t		*fp;		/* Journal data */
+  const char		*data;		/* Journal data */
+  size_t		length;		/* Length of journal data */
+  int			count = 0,	/* Number of changed records */
+			status = 1;	/* Return status */
+  char			filename[1024];	/* Journal filename */
+
+
+  finish_record(j);
+
+  if (j->error)
+  {
+    free_records(j->pending);
+    j->pending = NULL;
+    return (0);
+  }
+
+  if ((records = cupsArrayNew((cups_array_func_t)compare_records, NULL)) == NULL)
+  {
+    free_records(j->pending);
+    j->pending = NULL;
+    return (0);
+  }
+
+  for (rec = (cupsd_jrecord_t *)cupsArrayFirst(j->pending);
+       rec;
+       rec = (cupsd_jrecord_t *)cupsArrayNext(j->pending))
+    cupsArrayAdd(records, rec);
+
+  if (!j->saved)
+  {
+   /*
+    * Write the whole file...
+    */
+
+    status = compact_journal(j, records);
+    cupsArrayDelete(j->pending);
+    j->pending = NULL;
+    return (status);
+  }
+
+ /*
+  * Collect the changed and deleted records...
+  */
+
+  if ((fp = _cupsFileOpenBuffer()) == NULL)
+  {
+    cupsArrayDelete(records);
+    free_records(j->pending);
+    j->pending = NULL;
+    return (0);
+  }
+
+  if (!j->journal_size)
+    cupsFilePrintf(fp, "Journal %u\n", j->generation);
+
+  for (rec = (cupsd_jrecord_t *)cupsArrayFirst(j->pending);
+       rec;
+       rec = (cupsd_jrecord_t *)cupsArrayNext(j->pending))
+  {
+   /*
+    * The header only holds comments and the "Written by" time, so it is only
+    * updated when the state file is compacted...
+    */
+
+    if (!strcmp(rec->name, "#"))
+      continue;
+
+    old = (cupsd_jrecord_t *)cupsArrayFind(j->saved, rec);
+
+    if (!old || old->length != rec->length ||
+        memcmp(old->data, rec->data, rec->length))
+    {
+      cupsFilePrintf(fp, "Record %s %u %08x\n", rec->name,
+                     (unsigned)rec->length,
+		     record_checksum(rec->data, rec->length));
+      cupsFileWrite(fp, rec->data, rec->length);
+      count ++;
+    }
+  }
+
+  for (old = (cupsd_jrecord_t *)cupsArrayFirst(j->saved);
+       old;
+       old = (cupsd_jrecord_t *)cupsArrayNext(j->saved))
+  {
+    if (!cupsArrayFind(records, old))
+    {
+      cupsFilePrintf(fp, "Record %s 0 %08x\n", old->name,
+                     record_checksum(NULL, 0));
+      count ++;
+    }
+  }
+
+  data = _cupsFileGetBuffer(fp, &length);
+
+  if (!count)
+  {
+   /*
+    * Nothing has changed...
+    */
+
+    free_records(j->saved);
+    j->saved = records;
+  }
+  else if (!data || j->journal_size + length > j->file_size)
+  {
+   /*
+    * The journal would be larger than the state file, so write the whole
+    * file instead...
+    */
+
+    status = compact_journal(j, records);
+  }
+  else
+  {
+   /*
+    * Append the changed records to the journal...
+    */
+
+    snprintf(filename, sizeof(filename), "%s.journal", j->filename);
+
+    if (cupsdAppendConfFile(filename, j->perm, data, length))
+    {
+      status = compact_journal(j, records);
+    }
+    else
+    {
+      cupsdLogMessage(CUPSD_LOG_DEBUG,
+		      "Journaled %d changed record(s) for \"%s\".", count,
+		      j->filename);
+
+      j->journal_size += length;
+
+      free_records(j->saved);
+      j->saved = records;
+    }
+  }
+
+  cupsFileClose(fp);
+
+  cupsArrayDelete(j->pending);
+  j->pending = NULL;
+
+  return (status);
+}
+
+
+/*
+ * 'cupsdReplayJournal()' - Apply the journal for a state file.
+ *
+ * The state file is rewritten with the records from the journal, if any, and
+ * the journal is removed.  Call this function before loading the state file.
+ */
+
+void
+cupsdReplayJournal(const char *filename,/* I - State filename */
+                   mode_t     perm)	/* I - Permissions for state file */
+{
+  cupsd_journal_t	*j;		/* Journal */
+  cups_file_t		*fp,		/* State file */
+			*jfp = NULL;	/* Journal file */
+  char			jfilename[1024],/* Journal filename */
+			*line = NULL,	/* Line from file */
+			*ptr,		/* Pointer into line */
+			name[256];	/* Record name */
+  size_t		linesize = 65536;
+					/* Size of line buffer */
+  cups_array_t		*records = NULL,/* Records by name */
+			*order = NULL;	/* Records in file order */
+  cupsd_jrecord_t	*rec,		/* Current record */
+			*header = NULL,	/* Header record */
+			*current = NULL,/* Current block */
+			rkey;		/* Search key */
+  unsigned		length,		/* Record length */
+			checksum,	/* Record checksum */
+			generation = 0,	/* Generation of state file */
+			jgeneration;	/* Generation of journal */
+  int			count = 0;	/* Number of records applied */
+  char			*data;		/* New record data */
+
+
+ /*
+  * The in-memory copy of the saved records is no longer valid...
+  */
+
+  if ((j = find_journal(filename)) == NULL)
+    return;
+
+  free_records(j->saved);
+  j->saved        = NULL;
+  j->journal_size = 0;
+
+  if ((line = malloc(linesize)) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to allocate memory for journal.");
+    return;
+  }
+
+ /*
+  * Get the generation of the state file...
+  */
+
+  if ((fp = cupsdOpenConfFile(filename)) != NULL)
+  {
+    if (cupsFileGets(fp, line, linesize))
+      get_generation(line, &generation);
+
+    cupsFileClose(fp);
+  }
+
+  j->generation = generation;
+
+ /*
+  * See if there is a journal to apply...
+  */
+
+  snprintf(jfilename, sizeof(jfilename), "%s.journal", filename);
+
+  if ((jfp = cupsFileOpen(jfilename, "r")) == NULL)
+    goto cleanup;
+
+  if (!cupsFileGets(jfp, line, linesize) ||
+      sscanf(line, "Journal %u", &jgeneration) != 1 ||
+      jgeneration != generation)
+  {
+   /*
+    * The journal was written for an older state file, which means the
+    * system stopped after the state file was compacted but before the
+    * journal was removed...
+    */
+
+    cupsdLogMessage(CUPSD_LOG_INFO, "Removing stale journal \"%s\".",
+                    jfilename);
+    unlink(jfilename);
+    goto cleanup;
+  }
+
+  cupsdLogMessage(CUPSD_LOG_INFO, "Applying journal \"%s\"...", jfilename);
+
+  if ((records = cupsArrayNew((cups_array_func_t)compare_records, NULL)) == NULL ||
+      (order = cupsArrayNew(NULL, NULL)) == NULL ||
+      (header = calloc(1, sizeof(cupsd_jrecord_t))) == NULL ||
+      (header->name = strdup("#")) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to allocate memory for journal.");
+    free(header);
+    goto cleanup;
+  }
+
+  cupsArrayAdd(records, header);
+  cupsArrayAdd(order, header);
+
+ /*
+  * Split the current state file into the header and blocks, skipping the
+  * generation line...
+  */
+
+  if ((fp = cupsdOpenConfFile(filename)) != NULL)
+  {
+    while (cupsFileGets(fp, line, linesize))
+    {
+      if (!header->length && !current && get_generation(line, NULL))
+        continue;
+
+      if (line[0] == '<' && line[1] != '/')
+      {
+       /*
+        * Start of a block, the record name is the value...
+	*/
+
+        if ((ptr = strchr(line, ' ')) != NULL)
+	  strlcpy(name, ptr + 1, sizeof(name));
+	else
+	  name[0] = '\0';
+
+        if ((ptr = strrchr(name, '>')) != NULL)
+	  *ptr = '\0';
+
+        if ((current = calloc(1, sizeof(cupsd_jrecord_t))) == NULL ||
+	    (current->name = strdup(name)) == NULL)
+	{
+	  free(current);
+	  cupsFileClose(fp);
+	  goto cleanup;
+	}
+
+        rkey.name = name;
+	if ((rec = (cupsd_jrecord_t *)cupsArrayFind(records, &rkey)) != NULL)
+	{
+	  cupsArrayRemove(records, rec);
+	  cupsArrayRemove(order, rec);
+	  free(rec->name);
+	  free(rec->data);
+	  free(rec);
+	}
+
+	cupsArrayAdd(records, current);
+	cupsArrayAdd(order, current);
+      }
+
+      rec    = current ? current : header;
+      length = (unsigned)strlen(line);
+
+      if ((data = realloc(rec->data, rec->length + length + 2)) == NULL)
+      {
+        cupsFileClose(fp);
+        goto cleanup;
+      }
+
+      rec->data = data;
+      memcpy(rec->data + rec->length, line, length);
+      rec->length += length;
+      rec->data[rec->length ++] = '\n';
+      rec->data[rec->length]    = '\0';
+
+      if (line[0] == '<' && line[1] == '/')
+        current = NULL;
+    }
+
+    cupsFileClose(fp);
+  }
+
+ /*
+  * Apply the complete records in the journal...
+  */
+
+  while (cupsFileGets(jfp, line, linesize))
+  {
+    if (sscanf(line, "Record %255s%u%x", name, &length, &checksum) != 3 ||
+        length > 16777216)
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Bad journal record \"%s\" in \"%s\".", line, jfilename);
+      break;
+    }
+
+    if (length > 0)
+    {
+      if ((data = malloc(length + 1)) == NULL)
+	break;
+
+      if (cupsFileRead(jfp, data, length) != (ssize_t)length ||
+	  record_checksum(data, length) != checksum)
+      {
+	cupsdLogMessage(CUPSD_LOG_WARN, "Ignoring incomplete journal record for \"%s\" in \"%s\".", name, jfilename);
+	free(data);
+	break;
+      }
+
+      data[length] = '\0';
+    }
+    else
+      data = NULL;
+
+    rkey.name = name;
+
+    if ((rec = (cupsd_jrecord_t *)cupsArrayFind(records, &rkey)) != NULL)
+    {
+      if (!data && rec != header)
+      {
+       /*
+	* Delete the record...
+	*/
+
+	cupsArrayRemove(records, rec);
+	cupsArrayRemove(order, rec);
+	free(rec->name);
+	free(rec->data);
+	free(rec);
+      }
+      else
+      {
+       /*
+	* Replace the record...
+	*/
+
+	free(rec->data);
+	rec->data   = data;
+	rec->length = length;
+      }
+    }
+    else if (data)
+    {
+     /*
+      * Add the record...
+      */
+
+      if ((rec = calloc(1, sizeof(cupsd_jrecord_t))) == NULL ||
+	  (rec->name = strdup(name)) == NULL)
+      {
+	free(rec);
+	free(data);
+	break;
+      }
+
+      rec->data   = data;
+      rec->length = length;
+
+      cupsArrayAdd(records, rec);
+      cupsArrayAdd(order, rec);
+    }
+
+    count ++;
+  }
+
+ /*
+  * Write the new state file with the next generation number and remove the
+  * journal...
+  */
+
+  if ((fp = cupsdCreateConfFile(filename, perm)) != NULL)
+  {
+    cupsFilePrintf(fp, "# Journal generation %u\n", generation + 1);
+
+    for (rec = (cupsd_jrecord_t *)cupsArrayFirst(order);
+         rec;
+	 rec = (cupsd_jrecord_t *)cupsArrayNext(order))
+      if (rec->length > 0)
+        cupsFileWrite(fp, rec->data, rec->length);
+
+    if (!cupsdCloseCreatedConfFile(fp, filename) &&
+        !cupsdSyncConfFile(filename))
+    {
+      cupsdLogMessage(CUPSD_LOG_INFO, "Applied %d journal record(s) to \"%s\".", count, filename);
+      j->generation = generation + 1;
+      unlink(jfilename);
+    }
+  }
+
+  cleanup:
+
+  if (jfp)
+    cupsFileClose(jfp);
+
+  free(line);
+  cupsArrayDelete(records);
+  free_records(order);
+}
+
+
+/*
+ * 'compact_journal()' - Write a complete state file and remove the journal.
+ */
+
+static int				/* O - 1 on success, 0 on failure */
+compact_journal(cupsd_journal_t *j,	/* I - Journal */
+                cups_array_t    *records)/* I - Records by name */
+{
+  cups_file_t		*fp;		/* State file */
+  cupsd_jrecord_t	*rec;		/* Current record */
+  size_t		size = 0;	/* Size of state file */
+  char			filename[1024];	/* Journal filename */
+
+
+ /*
+  * Write the state file with the next generation number so that the old
+  * journal is not applied to it if we stop before removing the journal...
+  */
+
+  if ((fp = cupsdCreateConfFile(j->filename, j->perm)) == NULL)
+    goto error;
+
+  cupsFilePrintf(fp, "# Journal generation %u\n", j->generation + 1);
+
+  for (rec = (cupsd_jrecord_t *)cupsArrayFirst(j->pending);
+       rec;
+       rec = (cupsd_jrecord_t *)cupsArrayNext(j->pending))
+  {
+    cupsFileWrite(fp, rec->data, rec->length);
+    size += rec->length;
+  }
+
+  if (cupsdCloseCreatedConfFile(fp, j->filename) ||
+      cupsdSyncConfFile(j->filename))
+    goto error;
+
+  j->generation ++;
+
+  snprintf(filename, sizeof(filename), "%s.journal", j->filename);
+  if (unlink(filename) && errno != ENOENT)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to remove \"%s\": %s", filename,
+                    strerror(errno));
+    goto error;
+  }
+
+  free_records(j->saved);
+
+  j->saved        = records;
+  j->file_size    = size;
+  j->journal_size = 0;
+
+  return (1);
+
+ /*
+  * If we get here the state file was not updated; forget the saved records
+  * so that the next save writes the whole file again...
+  */
+
+  error:
+
+  cupsArrayDelete(records);
+  free_records(j->pending);
+  free_records(j->saved);
+
+  j->pending = NULL;
+  j->saved   = NULL;
+
+  return (0);
+}
+
+
+/*
+ * 'compare_journals()' - Compare two journals.
+ */
+
+static int				/* O - Result of comparison */
+compare_journals(cupsd_journal_t *a,	/* I - First journal */
+                 cupsd_journal_t *b)	/* I - Second journal */
+{
+  return (strcmp(a->filename, b->filename));
+}
+
+
+/*
+ * 'compare_records()' - Compare two journal records.
+ */
+
+static int				/* O - Result of comparison */
+compare_records(cupsd_jrecord_t *a,	/* I - First record */
+                cupsd_jrecord_t *b)	/* I - Second record */
+{
+  return (strcmp(a->name, b->name));
+}
+
+
+/*
+ * 'find_journal()' - Find or create the journal for a state file.
+ */
+
+static cupsd_journal_t *		/* O - Journal or NULL on error */
+find_journal(const char *filename)	/* I - State filename */
+{
+  cupsd_journal_t	*j,		/* Journal */
+			key;		/* Search key */
+
+
+  if (!Journals)
+    Journals = cupsArrayNew((cups_array_func_t)compare_journals, NULL);
+
+  key.filename = (char *)filename;
+
+  if ((j = (cupsd_journal_t *)cupsArrayFind(Journals, &key)) == NULL)
+  {
+    if ((j = calloc(1, sizeof(cupsd_journal_t))) == NULL ||
+        (j->filename = strdup(filename)) == NULL)
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR,
+                      "Unable to allocate memory for journal.");
+      free(j);
+      return (NULL);
+    }
+
+    cupsArrayAdd(Journals, j);
+  }
+
+  return (j);
+}
+
+
+/*
+ * 'finish_record()' - Finish the current record.
+ */
+
+static void
+finish_record(cupsd_journal_t *j)	/* I - Journal */
+{
+  cupsd_jrecord_t	*rec;		/* New record */
+  const char		*data;		/* Record contents */
+  size_t		length;		/* Length of contents */
+
+
+  if (j->fp && j->fpname && !j->error)
+  {
+    if ((data = _cupsFileGetBuffer(j->fp, &length)) == NULL ||
+        (rec = calloc(1, sizeof(cupsd_jrecord_t))) == NULL)
+    {
+      j->error = 1;
+    }
+    else if ((rec->data = malloc(length + 1)) == NULL)
+    {
+      free(rec);
+      j->error = 1;
+    }
+    else
+    {
+      memcpy(rec->data, data, length + 1);
+
+      rec->name   = j->fpname;
+      rec->length = length;
+      j->fpname   = NULL;
+
+      cupsArrayAdd(j->pending, rec);
+    }
+  }
+
+  if (j->fp)
+  {
+    cupsFileClose(j->fp);
+    j->fp = NULL;
+  }
+
+  free(j->fpname);
+  j->fpname = NULL;
+}
+
+
+/*
+ * 'free_records()' - Free an array of records.
+ */
+
+static void
+free_records(cups_array_t *records)	/* I - Records */
+{
+  cupsd_jrecord_t	*rec;		/* Current record */
+
+
+  for (rec = (cupsd_jrecord_t *)cupsArrayFirst(records);
+       rec;
+       rec = (cupsd_jrecord_t *)cupsArrayNext(records))
+  {
+    free(rec->name);
+    free(rec->data);
+    free(rec);
+  }
+
+  cupsArrayDelete(records);
+}
+
+
+/*
+ * 'get_generation()' - Get the generation number from a state file line.
+ */
+
+static int				/* O - 1 if the line has a generation, 0 otherwise */
+get_generation(const char *line,	/* I - Line from state file */
+               unsigned   *generation)	/* O - Generation number or NULL */
+{
+  unsigned	value;			/* Generation number */
+
+
+  if (sscanf(line, "# Journal generation %u", &value) != 1)
+    return (0);
+
+  if (generation)
+    *generation = value;
+
+  return (1);
+}
+
+
+/*
+ * 'record_checksum()' - Compute the checksum for a journal record.
+ */
+
+static unsigned				/* O - Checksum */
+record_checksum(const char *data,	/* I - Record contents */
+                size_t     length)	/* I - Length of contents */
+{
+  unsigned	checksum = 2166136261U;	/* FNV-1a hash */
+
+
+  while (length > 0)
+  {
+    checksum = (checksum ^ (unsigned char)*data++) * 16777619U;
+    length --;
+  }
+
+  return (checksum);
+}
@@ -13,6 +13,7 @@
  */
 
 #include "cupsd.h"
+#include <cups/thread-private.h>
 #include <stdarg.h>
 #ifdef HAVE_ASL_H
 #  include <asl.h>
@@ -51,6 +52,59 @@
 #define PWG_JobAccountingUserURI	"JAUU"
 
 
+/*
+ * Design Notes for the Log Buffer in CUPSD
+ * ----------------------------------------
+ *
+ * While the server is running, lines for the access, error, and page logs
+ * are formatted by the main thread and added to a ring buffer (LogBufferSize
+ * bytes).  A log writer thread takes the lines out of the buffer in batches,
+ * writes them to the log files, and flushes each file once per batch.  The
+ * writer thread also does the size-based rotation of the log files, so the
+ * main thread never touches AccessFile, ErrorFile, or PageFile while the
+ * writer thread is running.
+ *
+ * Each record in the buffer starts with a cupsd_logrec_t header and is
+ * padded to a multiple of the header size.  Lines are only added by the main
+ * thread (serialized by log_mutex) and only removed by the writer thread, so
+ * the two sides just publish their positions (log_tail and log_head) with
+ * atomic stores.  A record that would not fit before the end of the buffer is
+ * preceded by a "wrap" record that tells the writer thread to continue at the
+ * start of the buffer.
+ *
+ * When the buffer is full, LogBufferOverflow controls what happens: "block"
+ * waits for the writer thread, "drop" discards the line, and "count" also
+ * discards the line but logs the number of discarded lines once there is
+ * room again.
+ *
+ * The writer thread is started by cupsdStartServer() and stopped, after
+ * writing all of the buffered lines, by cupsdStopServer().  Lines logged
+ * while the server is stopped (reading the configuration files, shutdown)
+ * are written directly as before.  The writer thread never logs messages of
+ * its own.
+ */
+
+
+/*
+ * Local types...
+ */
+
+#define CUPSD_LOGFILE_ACCESS	0	/* Access log */
+#define CUPSD_LOGFILE_ERROR	1	/* Error log */
+#define CUPSD_LOGFILE_PAGE	2	/* Page log */
+#define CUPSD_LOGFILE_WRAP	-1	/* Continue at start of buffer */
+
+#define CUPSD_LOGREC_SIZE(len)	((sizeof(cupsd_logrec_t) + (len) + sizeof(cupsd_logrec_t) - 1) / sizeof(cupsd_logrec_t) * sizeof(cupsd_logrec_t))
+					/* Size of a record in the log buffer */
+
+typedef struct cupsd_logrec_s		/**** Log buffer record ****/
+{
+  short			logfile,	/* Log file (CUPSD_LOGFILE_xxx) */
+			rotate;		/* Allow log rotation? */
+  int			length;		/* Length of line */
+} cupsd_logrec_t;
+
+
 /*
  * Local globals...
  */
@@ -60,6 +114,37 @@ static _cups_mutex_t log_mutex = _CUPS_MUTEX_INITIALIZER;
 static size_t	log_linesize = 0;	/* Size of line for output file */
 static char	*log_line = NULL;	/* Line for output file */
 
+static struct
+{
+  cups_file_t	**lf;			/* Log file */
+  char		**logname;		/* Log filename */
+}		log_files[] =		/* Log files by CUPSD_LOGFILE_xxx */
+{
+  { &AccessFile, &AccessLog },
+  { &ErrorFile, &ErrorLog },
+  { &PageFile, &PageLog }
+};
+
+static char	*log_buffer = NULL;	/* Log buffer */
+static size_t	log_bufsize = 0,	/* Size of log buffer */
+		log_head = 0,		/* Position of next record to write */
+		log_tail = 0;		/* Position of next record to add */
+static int	log_maxsize = 0,	/* MaxLogSize for writer thread */
+		log_sleeping = 0,	/* Writer thread waiting for records? */
+		log_waiting = 0,	/* Main thread waiting for room? */
+		log_stop = 0,		/* Stop the writer thread? */
+		log_dropped = 0,	/* Lines dropped since last report */
+		log_total_dropped = 0,	/* Total lines dropped */
+		log_batches = 0,	/* Number of batches written */
+		log_records = 0;	/* Number of lines written */
+static _cups_thread_t log_thread;	/* Writer thread */
+static _cups_mutex_t log_cond_mutex = _CUPS_MUTEX_INITIALIZER;
+					/* Mutex for log conditions */
+static _cups_cond_t log_cond = _CUPS_COND_INITIALIZER,
+					/* Condition for new records */
+		log_room_cond = _CUPS_COND_INITIALIZER;
+					/* Condition for room in buffer */
+
 #ifdef HAVE_ASL_H
 static const int log_levels[] =		/* ASL levels... */
 		{
@@ -95,7 +180,17 @@ static const int log_levels[] =		/* SYSLOG levels... */
  * Local functions...
  */
 
+static int	add_log_record(int logfile, const char *prefix,
+		               const char *message);
+static int	check_log_file(cups_file_t **lf, const char *logname,
+		               int maxsize, int writer);
 static int	format_log_line(const char *message, va_list ap);
+static void	*log_writer(void *arg);
+static int	write_log_line(int logfile, const char *prefix,
+		               const char *message);
+static int	write_log_linef(int logfile, const char *format, ...)
+		                _CUPS_FORMAT(2, 3);
+static int	write_log_records(void);
 
 
 /*
@@ -106,189 +201,7 @@ int					/* O  - 1 if log file open */
 cupsdCheckLogFile(cups_file_t **lf,	/* IO - Log file */
 	          const char  *logname)	/* I  - Log filename */
 {
-  char		backname[1024],		/* Backup log filename */
-		filename[1024],		/* Formatted log filename */
-		*ptr;			/* Pointer into filename */
-  const char	*logptr;		/* Pointer into log filename */
-
-
- /*
-  * See if we have a log file to check...
-  */
-
-  if (!lf || !logname || !logname[0])
-    return (1);
-
- /*
-  * Handle logging to stderr...
-  */
-
-  if (!strcmp(logname, "stderr"))
-  {
-    *lf = LogStderr;
-    return (1);
-  }
-
- /*
-  * Format the filename as needed...
-  */
-
-  if (!*lf ||
-      (strncmp(logname, "/dev/", 5) && cupsFileTell(*lf) > MaxLogSize &&
-       MaxLogSize > 0))
-  {
-   /*
-    * Handle format strings...
-    */
-
-    filename[sizeof(filename) - 1] = '\0';
-
-    if (logname[0] != '/')
-    {
-      strlcpy(filename, ServerRoot, sizeof(filename));
-      strlcat(filename, "/", sizeof(filename));
-    }
-    else
-      filename[0] = '\0';
-
-    for (logptr = logname, ptr = filename + strlen(filename);
-         *logptr && ptr < (filename + sizeof(filename) - 1);
-	 logptr ++)
-      if (*logptr == '%')
-      {
-       /*
-        * Format spec...
-	*/
-
-        logptr ++;
-	if (*logptr == 's')
-	{
-	 /*
-	  * Insert the server name...
-	  */
-
-	  strlcpy(ptr, ServerName, sizeof(filename) - (size_t)(ptr - filename));
-	  ptr += strlen(ptr);
-	}
-        else
-	{
-	 /*
-	  * Otherwise just insert the character...
-	  */
-
-	  *ptr++ = *logptr;
-	}
-      }
-      else
-	*ptr++ = *logptr;
-
-    *ptr = '\0';
-  }
-
- /*
-  * See if the log file is open...
-  */
-
-  if (!*lf)
-  {
-   /*
-    * Nope, open the log file...
-    */
-
-    if ((*lf = cupsFileOpen(filename, "a")) == NULL)
-    {
-     /*
-      * If the file is in CUPS_LOGDIR then try to create a missing directory...
-      */
-
-      if (!strncmp(filename, CUPS_LOGDIR, strlen(CUPS_LOGDIR)))
-      {
-       /*
-        * Try updating the permissions of the containing log directory, using
-	* the log file permissions as a basis...
-	*/
-
-        mode_t log_dir_perm = (mode_t)(0300 | LogFilePerm);
-					/* LogFilePerm + owner write/search */
-	if (log_dir_perm & 0040)
-	  log_dir_perm |= 0010;		/* Add group search */
-	if (log_dir_perm & 0004)
-	  log_dir_perm |= 0001;		/* Add other search */
-
-        cupsdCheckPermissions(CUPS_LOGDIR, NULL, log_dir_perm, RunUser, Group, 1, -1);
-
-        *lf = cupsFileOpen(filename, "a");
-      }
-
-      if (*lf == NULL)
-      {
-#ifdef HAVE_SYSTEMD_SD_JOURNAL_H
-        sd_journal_print(LOG_ERR, "Unable to open log file \"%s\" - %s", filename, strerror(errno));
-#else
-	syslog(LOG_ERR, "Unable to open log file \"%s\" - %s", filename, strerror(errno));
-#endif /* HAVE_SYSTEMD_SD_JOURNAL_H */
-
-        if (FatalErrors & CUPSD_FATAL_LOG)
-	  cupsdEndProcess(getpid(), 0);
-
-	return (0);
-      }
-    }
-
-    if (strncmp(filename, "/dev/", 5))
-    {
-     /*
-      * Change ownership and permissions of non-device logs...
-      */
-
-      fchown(cupsFileNumber(*lf), RunUser, Group);
-      fchmod(cupsFileNumber(*lf), LogFilePerm);
-    }
-  }
-
- /*
-  * Do we need to rotate the log?
-  */
-
-  if (strncmp(logname, "/dev/", 5) && cupsFileTell(*lf) > MaxLogSize &&
-      MaxLogSize > 0)
-  {
-   /*
-    * Rotate log file...
-    */
-
-    cupsFileClose(*lf);
-
-    strlcpy(backname, filename, sizeof(backname));
-    strlcat(backname, ".O", sizeof(backname));
-
-    unlink(backname);
-    rename(filename, backname);
-
-    if ((*lf = cupsFileOpen(filename, "a")) == NULL)
-    {
-#ifdef HAVE_SYSTEMD_SD_JOURNAL_H
-      sd_journal_print(LOG_ERR, "Unable to open log file \"%s\" - %s", filename, strerror(errno));
-
-#else
-      syslog(LOG_ERR, "Unable to open log file \"%s\" - %s", filename, strerror(errno));
-#endif /* HAVE_SYSTEMD_SD_JOURNAL_H */
-
-      if (FatalErrors & CUPSD_FATAL_LOG)
-	cupsdEndProcess(getpid(), 0);
-
-      return (0);
-    }
-
-   /*
-    * Change ownership and permissions of non-device logs...
-    */
-
-    fchown(cupsFileNumber(*lf), RunUser, Group);
-    fchmod(cupsFileNumber(*lf), LogFilePerm);
-  }
-
-  return (1);
+  return (check_log_file(lf, logname, MaxLogSize, 0));
 }
 
 
@@ -990,23 +903,10 @@ cupsdLogPage(cupsd_job_t *job,		/* I - Job being printed */
 #endif /* HAVE_SYSTEMD_SD_JOURNAL_H */
 
  /*
-  * Not using syslog; check the log file...
-  */
-
-  if (!cupsdCheckLogFile(&PageFile, PageLog))
-    return (0);
-
- /*
-  * Print a page log entry of the form:
-  *
-  *    printer user job-id [DD/MON/YYYY:HH:MM:SS +TTTT] page num-copies \
-  *        billing hostname
+  * Not using syslog; write to the log file...
   */
 
-  cupsFilePrintf(PageFile, "%s\n", buffer);
-  cupsFileFlush(PageFile);
-
-  return (1);
+  return (write_log_line(CUPSD_LOGFILE_PAGE, NULL, buffer));
 }
 
 
@@ -1178,34 +1078,120 @@ cupsdLogRequest(cupsd_client_t *con,	/* I - Request to log */
 #endif /* HAVE_SYSTEMD_SD_JOURNAL_H */
 
  /*
-  * Not using syslog; check the log file...
+  * Not using syslog; write a log of the request in "common log format"...
   */
 
-  if (!cupsdCheckLogFile(&AccessFile, AccessLog))
-    return (0);
+  return (write_log_linef(CUPSD_LOGFILE_ACCESS,
+			  "%s - %s %s \"%s %s HTTP/%d.%d\" %d " CUPS_LLFMT
+			  " %s %s",
+			  con->http->hostname,
+			  con->username[0] != '\0' ? con->username : "-",
+			  cupsdGetDateTime(&(con->start), LogTimeFormat),
+			  states[con->operation],
+			  _httpEncodeURI(temp, con->uri, sizeof(temp)),
+			  con->http->version / 100, con->http->version % 100,
+			  code, CUPS_LLCAST con->bytes,
+			  con->request ?
+			      ippOpString(con->request->request.op.operation_id) :
+			      "-",
+			  con->response ?
+			      ippErrorString(con->response->request.status.status_code) :
+			      "-"));
+}
+
+
+/*
+ * 'cupsdStartLogWriter()' - Start the log writer thread.
+ */
+
+void
+cupsdStartLogWriter(void)
+{
+  size_t	bufsize;		/* Size of log buffer */
+
+
+  if (log_buffer || LogBufferSize <= 0)
+    return;
 
  /*
-  * Write a log of the request in "common log format"...
+  * Round the buffer size to a multiple of the record header size, and make
+  * sure that the longest line from format_log_line() will fit...
   */
 
-  cupsFilePrintf(AccessFile,
-                 "%s - %s %s \"%s %s HTTP/%d.%d\" %d " CUPS_LLFMT " %s %s\n",
-        	 con->http->hostname,
-		 con->username[0] != '\0' ? con->username : "-",
-		 cupsdGetDateTime(&(con->start), LogTimeFormat),
-		 states[con->operation],
-		 _httpEncodeURI(temp, con->uri, sizeof(temp)),
-		 con->http->version / 100, con->http->version % 100,
-		 code, CUPS_LLCAST con->bytes,
-		 con->request ?
-		     ippOpString(con->request->request.op.operation_id) : "-",
-		 con->response ?
-		     ippErrorString(con->response->request.status.status_code) :
-		     "-");
-
-  cupsFileFlush(AccessFile);
+  if (LogBufferSize < 131072)
+    bufsize = 131072;
+  else
+    bufsize = (size_t)LogBufferSize;
+
+  bufsize -= bufsize % sizeof(cupsd_logrec_t);
 
-  return (1);
+  if ((log_buffer = malloc(bufsize)) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR,
+                    "Unable to allocate %d byte log buffer: %s",
+		    (int)bufsize, strerror(errno));
+    return;
+  }
+
+  log_bufsize       = bufsize;
+  log_head          = 0;
+  log_tail          = 0;
+  log_maxsize       = MaxLogSize;
+  log_stop          = 0;
+  log_dropped       = 0;
+  log_total_dropped = 0;
+  log_batches       = 0;
+  log_records       = 0;
+
+  if ((log_thread = _cupsThreadCreate((_cups_thread_func_t)log_writer, NULL)) == 0)
+  {
+    free(log_buffer);
+    log_buffer = NULL;
+
+    cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to start log writer thread.");
+    return;
+  }
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG,
+                  "cupsdStartLogWriter: Using %d byte log buffer.",
+		  (int)bufsize);
+}
+
+
+/*
+ * 'cupsdStopLogWriter()' - Write any buffered log lines and stop the log
+ *                          writer thread.
+ */
+
+void
+cupsdStopLogWriter(void)
+{
+  if (!log_buffer)
+    return;
+
+  _cupsMutexLock(&log_cond_mutex);
+  log_stop = 1;
+  _cupsCondBroadcast(&log_cond);
+  _cupsMutexUnlock(&log_cond_mutex);
+
+  _cupsThreadWait(log_thread);
+
+  free(log_buffer);
+  log_buffer  = NULL;
+  log_bufsize = 0;
+
+ /*
+  * The log files are ours again, so report what happened...
+  */
+
+  if (log_dropped > 0)
+    cupsdLogMessage(CUPSD_LOG_WARN,
+                    "Dropped %d log messages because the log buffer was full.",
+		    log_dropped);
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG,
+                  "cupsdStopLogWriter: Wrote %d log lines in %d batches, "
+		  "dropped %d.", log_records, log_batches, log_total_dropped);
 }
 
 
@@ -1217,7 +1203,7 @@ int					/* O - 1 on success, 0 on failure */
 cupsdWriteErrorLog(int        level,	/* I - Log level */
                    const char *message)	/* I - Message string */
 {
-  int		ret = 1;		/* Return value */
+  char		prefix[256];		/* Level and date/time prefix */
   static const char	levels[] =	/* Log levels... */
 		{
 		  ' ',
@@ -1253,36 +1239,294 @@ cupsdWriteErrorLog(int        level,	/* I - Log level */
 #endif /* HAVE_SYSTEMD_SD_JOURNAL_H */
 
  /*
-  * Not using syslog; check the log file...
+  * Not using syslog; write to the log file...
   */
 
-  _cupsMutexLock(&log_mutex);
-
-  if (!cupsdCheckLogFile(&ErrorFile, ErrorLog))
-  {
-    ret = 0;
-  }
-  else
-  {
-   /*
-    * Write the log message...
-    */
-
-    cupsFilePrintf(ErrorFile, "%c %s %s\n", levels[level],
-                   cupsdGetDateTime(NULL, LogTimeFormat), message);
-    cupsFileFlush(ErrorFile);
-  }
-
-  _cupsMutexUnlock(&log_mutex);
+  snprintf(prefix, sizeof(prefix), "%c %s ", levels[level],
+           cupsdGetDateTime(NULL, LogTimeFormat));
 
-  return (ret);
+  return (write_log_line(CUPSD_LOGFILE_ERROR, prefix, message));
 }
 
 
 /*
- * 'format_log_line()' - Format a line for a log file.
+ * 'add_log_record()' - Add a line to the log buffer.
  *
- * This function resizes a global string buffer as needed.  Each call returns
+ * The caller must hold log_mutex.
+ */
+
+static int				/* O - 1 if added, 0 if no room */
+add_log_record(int        logfile,	/* I - Log file */
+               const char *prefix,	/* I - Line prefix or @code NULL@ */
+	       const char *message)	/* I - Message */
+{
+  size_t		plen,		/* Length of prefix */
+			mlen,		/* Length of message */
+			recsize,	/* Size of record */
+			pos,		/* Position in buffer */
+			skip,		/* Bytes skipped at end of buffer */
+			head;		/* Position of writer thread */
+  cupsd_logrec_t	*rec;		/* Record */
+  char			*line;		/* Line in record */
+
+
+  plen    = prefix ? strlen(prefix) : 0;
+  mlen    = strlen(message);
+  recsize = CUPSD_LOGREC_SIZE(plen + mlen + 1);
+  pos     = log_tail % log_bufsize;
+  skip    = 0;
+
+  if (recsize > log_bufsize - pos)
+    skip = log_bufsize - pos;
+
+  head = __atomic_load_n(&log_head, __ATOMIC_ACQUIRE);
+
+  if (log_bufsize - (log_tail - head) < skip + recsize)
+    return (0);
+
+  if (skip)
+  {
+   /*
+    * Continue at the start of the buffer...
+    */
+
+    rec          = (cupsd_logrec_t *)(log_buffer + pos);
+    rec->logfile = CUPSD_LOGFILE_WRAP;
+    rec->rotate  = 0;
+    rec->length  = 0;
+    pos          = 0;
+  }
+
+  rec          = (cupsd_logrec_t *)(log_buffer + pos);
+  rec->logfile = (short)logfile;
+  rec->rotate  = MaxLogSize > 0;
+  rec->length  = (int)(plen + mlen + 1);
+
+  line = (char *)(rec + 1);
+
+  if (plen)
+    memcpy(line, prefix, plen);
+
+  memcpy(line + plen, message, mlen);
+  line[plen + mlen] = '\n';
+
+ /*
+  * Publish the record(s) to the writer thread...
+  */
+
+  __atomic_store_n(&log_tail, log_tail + skip + recsize, __ATOMIC_SEQ_CST);
+
+  return (1);
+}
+
+
+/*
+ * 'check_log_file()' - Open/rotate a log file if it needs it.
+ *
+ * The writer thread does not try to repair the log directory permissions,
+ * since that needs to log messages.
+ */
+
+static int				/* O  - 1 if log file open */
+check_log_file(cups_file_t **lf,	/* IO - Log file */
+	       const char  *logname,	/* I  - Log filename */
+	       int         maxsize,	/* I  - Maximum size of log file */
+	       int         writer)	/* I  - 1 if called by writer thread */
+{
+  char		backname[1024],		/* Backup log filename */
+		filename[1024],		/* Formatted log filename */
+		*ptr;			/* Pointer into filename */
+  const char	*logptr;		/* Pointer into log filename */
+
+
+ /*
+  * See if we have a log file to check...
+  */
+
+  if (!lf || !logname || !logname[0])
+    return (1);
+
+ /*
+  * Handle logging to stderr...
+  */
+
+  if (!strcmp(logname, "stderr"))
+  {
+    *lf = LogStderr;
+    return (1);
+  }
+
+ /*
+  * Format the filename as needed...
+  */
+
+  if (!*lf ||
+      (strncmp(logname, "/dev/", 5) && cupsFileTell(*lf) > maxsize &&
+       maxsize > 0))
+  {
+   /*
+    * Handle format strings...
+    */
+
+    filename[sizeof(filename) - 1] = '\0';
+
+    if (logname[0] != '/')
+    {
+      strlcpy(filename, ServerRoot, sizeof(filename));
+      strlcat(filename, "/", sizeof(filename));
+    }
+    else
+      filename[0] = '\0';
+
+    for (logptr = logname, ptr = filename + strlen(filename);
+         *logptr && ptr < (filename + sizeof(filename) - 1);
+	 logptr ++)
+      if (*logptr == '%')
+      {
+       /*
+        * Format spec...
+	*/
+
+        logptr ++;
+	if (*logptr == 's')
+	{
+	 /*
+	  * Insert the server name...
+	  */
+
+	  strlcpy(ptr, ServerName, sizeof(filename) - (size_t)(ptr - filename));
+	  ptr += strlen(ptr);
+	}
+        else
+	{
+	 /*
+	  * Otherwise just insert the character...
+	  */
+
+	  *ptr++ = *logptr;
+	}
+      }
+      else
+	*ptr++ = *logptr;
+
+    *ptr = '\0';
+  }
+
+ /*
+  * See if the log file is open...
+  */
+
+  if (!*lf)
+  {
+   /*
+    * Nope, open the log file...
+    */
+
+    if ((*lf = cupsFileOpen(filename, "a")) == NULL)
+    {
+     /*
+      * If the file is in CUPS_LOGDIR then try to create a missing directory...
+      */
+
+      if (!writer && !strncmp(filename, CUPS_LOGDIR, strlen(CUPS_LOGDIR)))
+      {
+       /*
+        * Try updating the permissions of the containing log directory, using
+	* the log file permissions as a basis...
+	*/
+
+        mode_t log_dir_perm = (mode_t)(0300 | LogFilePerm);
+					/* LogFilePerm + owner write/search */
+	if (log_dir_perm & 0040)
+	  log_dir_perm |= 0010;		/* Add group search */
+	if (log_dir_perm & 0004)
+	  log_dir_perm |= 0001;		/* Add other search */
+
+        cupsdCheckPermissions(CUPS_LOGDIR, NULL, log_dir_perm, RunUser, Group, 1, -1);
+
+        *lf = cupsFileOpen(filename, "a");
+      }
+
+      if (*lf == NULL)
+      {
+#ifdef HAVE_SYSTEMD_SD_JOURNAL_H
+        sd_journal_print(LOG_ERR, "Unable to open log file \"%s\" - %s", filename, strerror(errno));
+#else
+	syslog(LOG_ERR, "Unable to open log file \"%s\" - %s", filename, strerror(errno));
+#endif /* HAVE_SYSTEMD_SD_JOURNAL_H */
+
+        if ((FatalErrors & CUPSD_FATAL_LOG) && writer)
+	  kill(getpid(), SIGTERM);
+        else if (FatalErrors & CUPSD_FATAL_LOG)
+	  cupsdEndProcess(getpid(), 0);
+
+	return (0);
+      }
+    }
+
+    if (strncmp(filename, "/dev/", 5))
+    {
+     /*
+      * Change ownership and permissions of non-device logs...
+      */
+
+      fchown(cupsFileNumber(*lf), RunUser, Group);
+      fchmod(cupsFileNumber(*lf), LogFilePerm);
+    }
+  }
+
+ /*
+  * Do we need to rotate the log?
+  */
+
+  if (strncmp(logname, "/dev/", 5) && cupsFileTell(*lf) > maxsize &&
+      maxsize > 0)
+  {
+   /*
+    * Rotate log file...
+    */
+
+    cupsFileClose(*lf);
+
+    strlcpy(backname, filename, sizeof(backname));
+    strlcat(backname, ".O", sizeof(backname));
+
+    unlink(backname);
+    rename(filename, backname);
+
+    if ((*lf = cupsFileOpen(filename, "a")) == NULL)
+    {
+#ifdef HAVE_SYSTEMD_SD_JOURNAL_H
+      sd_journal_print(LOG_ERR, "Unable to open log file \"%s\" - %s", filename, strerror(errno));
+
+#else
+      syslog(LOG_ERR, "Unable to open log file \"%s\" - %s", filename, strerror(errno));
+#endif /* HAVE_SYSTEMD_SD_JOURNAL_H */
+
+      if ((FatalErrors & CUPSD_FATAL_LOG) && writer)
+	kill(getpid(), SIGTERM);
+      else if (FatalErrors & CUPSD_FATAL_LOG)
+	cupsdEndProcess(getpid(), 0);
+
+      return (0);
+    }
+
+   /*
+    * Change ownership and permissions of non-device logs...
+    */
+
+    fchown(cupsFileNumber(*lf), RunUser, Group);
+    fchmod(cupsFileNumber(*lf), LogFilePerm);
+  }
+
+  return (1);
+}
+
+
+/*
+ * 'format_log_line()' - Format a line for a log file.
+ *
+ * This function resizes a global string buffer as needed.  Each call returns
  * a pointer to this buffer, so the contents are only good until the next call
  * to format_log_line()...
  */
@@ -1341,3 +1585,270 @@ format_log_line(const char *message,	/* I - Printf-style format string */
 
   return (1);
 }
+
+
+/*
+ * 'log_writer()' - Write buffered log lines to the log files.
+ */
+
+static void *				/* O - Thread exit status */
+log_writer(void *arg)			/* I - Unused */
+{
+  int	stop = 0;			/* Stop the thread? */
+
+
+  (void)arg;
+
+  while (!stop)
+  {
+    if (write_log_records())
+      continue;
+
+   /*
+    * Wait for more lines...
+    */
+
+    _cupsMutexLock(&log_cond_mutex);
+
+    __atomic_store_n(&log_sleeping, 1, __ATOMIC_SEQ_CST);
+
+    if (!log_stop && __atomic_load_n(&log_tail, __ATOMIC_SEQ_CST) == log_head)
+      _cupsCondWait(&log_cond, &log_cond_mutex, 1.0);
+
+    __atomic_store_n(&log_sleeping, 0, __ATOMIC_SEQ_CST);
+
+    stop = log_stop && __atomic_load_n(&log_tail, __ATOMIC_SEQ_CST) == log_head;
+
+    _cupsMutexUnlock(&log_cond_mutex);
+  }
+
+  return (NULL);
+}
+
+
+/*
+ * 'write_log_line()' - Write a line to a log file.
+ *
+ * When the writer thread is running, the line is added to the log buffer.
+ * Otherwise it is written to the log file right away.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+write_log_line(int        logfile,	/* I - Log file */
+               const char *prefix,	/* I - Line prefix or @code NULL@ */
+	       const char *message)	/* I - Message */
+{
+  int		ret = 1;		/* Return value */
+  cups_file_t	**lf = log_files[logfile].lf;
+					/* Log file */
+
+
+  _cupsMutexLock(&log_mutex);
+
+  if (log_buffer)
+  {
+    if (log_dropped > 0 && LogBufferOverflow == CUPSD_LOGOVERFLOW_COUNT)
+    {
+     /*
+      * Report the lines that were dropped before this one...
+      */
+
+      char	dropped[256],		/* Dropped line message */
+		dprefix[256];		/* Prefix for message */
+
+      snprintf(dprefix, sizeof(dprefix), "W %s ",
+               cupsdGetDateTime(NULL, LogTimeFormat));
+      snprintf(dropped, sizeof(dropped),
+               "Dropped %d log messages because the log buffer was full.",
+	       log_dropped);
+
+      if (add_log_record(CUPSD_LOGFILE_ERROR, dprefix, dropped))
+        log_dropped = 0;
+    }
+
+    while (!add_log_record(logfile, prefix, message))
+    {
+      if (LogBufferOverflow != CUPSD_LOGOVERFLOW_BLOCK ||
+          CUPSD_LOGREC_SIZE(strlen(message) + (prefix ? strlen(prefix) : 0) + 1) > log_bufsize)
+      {
+       /*
+        * Drop the line...
+	*/
+
+        log_dropped ++;
+	log_total_dropped ++;
+	break;
+      }
+
+     /*
+      * Wait for the writer thread to make some room...
+      */
+
+      _cupsMutexLock(&log_cond_mutex);
+
+      __atomic_store_n(&log_waiting, 1, __ATOMIC_SEQ_CST);
+      _cupsCondBroadcast(&log_cond);
+      _cupsCondWait(&log_room_cond, &log_cond_mutex, 1.0);
+      __atomic_store_n(&log_waiting, 0, __ATOMIC_SEQ_CST);
+
+      _cupsMutexUnlock(&log_cond_mutex);
+    }
+
+    if (__atomic_load_n(&log_sleeping, __ATOMIC_SEQ_CST))
+    {
+     /*
+      * Wake up the writer thread...
+      */
+
+      _cupsMutexLock(&log_cond_mutex);
+      _cupsCondBroadcast(&log_cond);
+      _cupsMutexUnlock(&log_cond_mutex);
+    }
+  }
+  else if (!cupsdCheckLogFile(lf, *(log_files[logfile].logname)))
+  {
+    ret = 0;
+  }
+  else
+  {
+   /*
+    * Write the log line...
+    */
+
+    if (prefix)
+      cupsFilePuts(*lf, prefix);
+
+    cupsFilePuts(*lf, message);
+    cupsFilePutChar(*lf, '\n');
+    cupsFileFlush(*lf);
+  }
+
+  _cupsMutexUnlock(&log_mutex);
+
+  return (ret);
+}
+
+
+/*
+ * 'write_log_linef()' - Format and write a line to a log file.
+ *
+ * The line is formatted into a buffer that is sized to fit, so long lines are
+ * not truncated.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+write_log_linef(int        logfile,	/* I - Log file */
+                const char *format,	/* I - Printf-style format string */
+		...)			/* I - Additional args as needed */
+{
+  va_list	ap;			/* Argument pointer */
+  char		buffer[8192],		/* Line buffer */
+		*line = buffer;		/* Formatted line */
+  int		len,			/* Length of line */
+		ret;			/* Return value */
+
+
+  va_start(ap, format);
+  len = vsnprintf(buffer, sizeof(buffer), format, ap);
+  va_end(ap);
+
+  if (len < 0)
+    return (0);
+
+  if ((size_t)len >= sizeof(buffer))
+  {
+   /*
+    * Allocate a buffer for the whole line...
+    */
+
+    if ((line = malloc((size_t)len + 1)) == NULL)
+      return (0);
+
+    va_start(ap, format);
+    vsnprintf(line, (size_t)len + 1, format, ap);
+    va_end(ap);
+  }
+
+  ret = write_log_line(logfile, NULL, line);
+
+  if (line != buffer)
+    free(line);
+
+  return (ret);
+}
+
+
+/*
+ * 'write_log_records()' - Write a batch of lines from the log buffer.
+ *
+ * This function is only called by the writer thread.
+ */
+
+static int				/* O - Number of lines written */
+write_log_records(void)
+{
+  int			i,		/* Looping var */
+			count = 0,	/* Number of lines written */
+			written[3] = { 0, 0, 0 };
+					/* Log files written */
+  size_t		head = log_head,/* Position of next record */
+			tail,		/* Position after last record */
+			pos;		/* Position in buffer */
+  cupsd_logrec_t	*rec;		/* Current record */
+  cups_file_t		**lf;		/* Log file */
+
+
+  tail = __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE);
+
+  while (head != tail)
+  {
+    pos = head % log_bufsize;
+    rec = (cupsd_logrec_t *)(log_buffer + pos);
+
+    if (rec->logfile == CUPSD_LOGFILE_WRAP)
+    {
+      head += log_bufsize - pos;
+      continue;
+    }
+
+    lf = log_files[rec->logfile].lf;
+
+    if (check_log_file(lf, *(log_files[rec->logfile].logname), rec->rotate ? log_maxsize : 0, 1))
+    {
+      cupsFileWrite(*lf, (char *)(rec + 1), (size_t)rec->length);
+      written[rec->logfile] = 1;
+    }
+
+    head += CUPSD_LOGREC_SIZE((size_t)rec->length);
+    count ++;
+
+   /*
+    * The line has been copied to the file buffer, so make room for more...
+    */
+
+    __atomic_store_n(&log_head, head, __ATOMIC_SEQ_CST);
+  }
+
+  if (!count)
+    return (0);
+
+  for (i = 0; i < (int)(sizeof(written) / sizeof(written[0])); i ++)
+    if (written[i] && *(log_files[i].lf))
+      cupsFileFlush(*(log_files[i].lf));
+
+  log_batches ++;
+  log_records += count;
+
+  if (__atomic_load_n(&log_waiting, __ATOMIC_SEQ_CST))
+  {
+   /*
+    * Wake up the main thread...
+    */
+
+    _cupsMutexLock(&log_cond_mutex);
+    _cupsCondBroadcast(&log_room_cond);
+    _cupsMutexUnlock(&log_cond_mutex);
+  }
+
+  return (count);
+}
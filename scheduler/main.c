@@ -86,8 +86,6 @@ static int		dead_children = 0;
 					/* Dead children? */
 static int		stop_scheduler = 0;
 					/* Should the scheduler stop? */
-static time_t           local_timeout = 0;
-                                        /* Next local printer timeout */
 
 
 /*
@@ -112,9 +110,7 @@ main(int  argc,				/* I - Number of command-line args */
   cupsd_job_t		*job;		/* Current job */
   cupsd_listener_t	*lis;		/* Current listener */
   time_t		current_time,	/* Current time */
-			activity,	/* Client activity timer */
 			senddoc_time,	/* Send-Document time */
-			expire_time,	/* Subscription expire time */
 			report_time,	/* Malloc/client/job report time */
 			event_time;	/* Last event notification time */
   long			timeout;	/* Timeout for cupsdDoSelect() */
@@ -693,8 +689,6 @@ main(int  argc,				/* I - Number of command-line args */
 
   current_time  = time(NULL);
   event_time    = current_time;
-  expire_time   = current_time;
-  local_timeout = 0;
   fds           = 1;
   report_time   = 0;
   senddoc_time  = current_time;
@@ -949,28 +943,11 @@ main(int  argc,				/* I - Number of command-line args */
       cupsdResumeListening();
 
    /*
-    * Expire subscriptions and unload completed jobs as needed...
+    * Handle expired timers (job deadlines, unloading of completed jobs,
+    * subscription leases, stale local printers, and idle clients)...
     */
 
-    if (current_time > expire_time)
-    {
-      if (cupsArrayCount(Subscriptions) > 0)
-        cupsdExpireSubscriptions(NULL, NULL);
-
-      cupsdUnloadCompletedJobs();
-
-      expire_time = current_time;
-    }
-
-   /*
-    * Delete stale local printers...
-    */
-
-    if (current_time >= local_timeout)
-    {
-      cupsdDeleteTemporaryPrinters(0);
-      local_timeout = 0;
-    }
+    cupsdRunTimers(current_time);
 
 #ifndef HAVE_AUTHORIZATION_H
    /*
@@ -1003,23 +980,7 @@ main(int  argc,				/* I - Number of command-line args */
       */
 
       if (httpGetReady(con->http))
-      {
         cupsdReadClient(con);
-	continue;
-      }
-
-     /*
-      * Check the activity and close old clients...
-      */
-
-      activity = current_time - Timeout;
-      if (httpGetActivity(con->http) < activity && !con->pipe_pid)
-      {
-        cupsdLogMessage(CUPSD_LOG_DEBUG, "Closing client %d after %d seconds of inactivity.", con->number, Timeout);
-
-        cupsdCloseClient(con);
-        continue;
-      }
     }
 
    /*
@@ -1039,6 +1000,12 @@ main(int  argc,				/* I - Number of command-line args */
     if (JobHistoryUpdate && current_time >= JobHistoryUpdate)
       cupsdCleanJobs();
 
+   /*
+    * Log the results of any configuration and cache file writes...
+    */
+
+    cupsdCheckConfFiles();
+
    /*
     * Log statistics at most once a minute when in debug mode...
     */
@@ -1069,6 +1036,8 @@ main(int  argc,				/* I - Number of command-line args */
       cupsdLogMessage(CUPSD_LOG_DEBUG, "Report: printers=%d",
                       cupsArrayCount(Printers));
 
+      cupsdReportAuthCache();
+
       string_count = _cupsStrStatistics(&alloc_bytes, &total_bytes);
       cupsdLogMessage(CUPSD_LOG_DEBUG,
                       "Report: stringpool-string-count=" CUPS_LLFMT,
@@ -1179,6 +1148,8 @@ main(int  argc,				/* I - Number of command-line args */
     cupsdStopSystemMonitor();
 #endif /* __APPLE__ */
 
+  cupsdStopWorkers();
+  cupsdStopTimers();
   cupsdStopSelect();
 
   return (!stop_scheduler);
@@ -1610,10 +1581,9 @@ static long				/* O - Number of seconds */
 select_timeout(int fds)			/* I - Number of descriptors returned */
 {
   long			timeout;	/* Timeout for select */
-  time_t		now;		/* Current time */
+  time_t		now,		/* Current time */
+			next;		/* Next timer */
   cupsd_client_t	*con;		/* Client information */
-  cupsd_job_t		*job;		/* Job information */
-  cupsd_printer_t       *printer;       /* Printer information */
   const char		*why;		/* Debugging aid */
 
 
@@ -1675,19 +1645,6 @@ select_timeout(int fds)			/* I - Number of descriptors returned */
     why = "resume listening";
   }
 
- /*
-  * Check the activity and close old clients...
-  */
-
-  for (con = (cupsd_client_t *)cupsArrayFirst(Clients);
-       con;
-       con = (cupsd_client_t *)cupsArrayNext(Clients))
-    if ((httpGetActivity(con->http) + Timeout) < timeout)
-    {
-      timeout = httpGetActivity(con->http) + Timeout;
-      why     = "timeout a client connection";
-    }
-
  /*
   * Write out changes to configuration and state files...
   */
@@ -1708,50 +1665,25 @@ select_timeout(int fds)			/* I - Number of descriptors returned */
     why     = "update job history";
   }
 
-  for (job = (cupsd_job_t *)cupsArrayFirst(ActiveJobs);
-       job;
-       job = (cupsd_job_t *)cupsArrayNext(ActiveJobs))
+  if (timeout > (now + 10) && cupsdHasPendingJobs())
   {
-    if (job->cancel_time && job->cancel_time < timeout)
-    {
-      timeout = job->cancel_time;
-      why     = "cancel stuck jobs";
-    }
-
-    if (job->kill_time && job->kill_time < timeout)
-    {
-      timeout = job->kill_time;
-      why     = "kill unresponsive jobs";
-    }
-
-    if (job->state_value == IPP_JOB_HELD && job->hold_until < timeout)
-    {
-      timeout = job->hold_until;
-      why     = "release held jobs";
-    }
+   /*
+    * Check for pending jobs to start...
+    */
 
-    if (job->state_value == IPP_JOB_PENDING && timeout > (now + 10))
-    {
-      timeout = now + 10;
-      why     = "start pending jobs";
-      break;
-    }
+    timeout = now + 10;
+    why     = "start pending jobs";
   }
 
  /*
-  * Check for temporary printers that need to be deleted...
+  * Check for job deadlines, client timeouts, subscription leases, and
+  * temporary printers that need to be deleted...
   */
 
-  for (printer = (cupsd_printer_t *)cupsArrayFirst(Printers); printer; printer = (cupsd_printer_t *)cupsArrayNext(Printers))
-  {
-    if (printer->temporary && !printer->job && (!local_timeout || local_timeout > (printer->state_time + 60)))
-      local_timeout = printer->state_time + 60;
-  }
-
-  if (timeout > local_timeout && local_timeout)
+  if ((next = cupsdNextTimer()) != 0 && next < timeout)
   {
-    timeout = local_timeout;
-    why     = "delete stale local printers";
+    timeout = next;
+    why     = "run timers";
   }
 
  /*
@@ -15,14 +15,41 @@
 #include <pwd.h>
 
 
+/*
+ * Local constants...
+ */
+
+#define CUPSD_ACCESS_CACHE_MAX	256	/* Maximum cached users per policy */
+
+
+/*
+ * Local types...
+ */
+
+typedef struct cupsd_accesscache_s	/**** Cached private access check ****/
+{
+  const char	*username;		/* User name */
+  int		job_access,		/* Access to private job values? */
+		sub_access;		/* Access to private subscription values? */
+  time_t	expires;		/* When the entry expires */
+} cupsd_accesscache_t;
+
+
 /*
  * Local functions...
  */
 
+static int	check_access(cupsd_policy_t *p, cups_array_t *access_ptr,
+		             const char *username);
+static int	check_access_list(cups_array_t *access_ptr,
+		                  const char *username);
+static int	compare_access_cache(cupsd_accesscache_t *a,
+		                     cupsd_accesscache_t *b);
 static int	compare_ops(cupsd_location_t *a, cupsd_location_t *b);
 static int	compare_policies(cupsd_policy_t *a, cupsd_policy_t *b);
 static void	free_policy(cupsd_policy_t *p);
 static int	hash_op(cupsd_location_t *op);
+static int	table_index(ipp_op_t op);
 
 
 /*
@@ -207,6 +234,7 @@ cupsd_location_t *			/* O - Policy operation */
 cupsdFindPolicyOp(cupsd_policy_t *p,	/* I - Policy */
                   ipp_op_t       op)	/* I - IPP operation */
 {
+  int			i, j;		/* Table indices */
   cupsd_location_t	key,		/* Search key... */
 			*po;		/* Current policy operation */
 
@@ -221,6 +249,49 @@ cupsdFindPolicyOp(cupsd_policy_t *p,	/* I - Policy */
   if (!p)
     return (NULL);
 
+ /*
+  * Look up the operation in the table, building it as needed...
+  */
+
+  if ((i = table_index(op)) >= 0)
+  {
+    if (p->num_table != cupsArrayCount(p->ops))
+    {
+      for (j = 0; j < CUPSD_POLICY_OPS; j ++)
+        p->table[j] = NULL;
+
+      for (po = (cupsd_location_t *)cupsArrayFirst(p->ops);
+           po;
+	   po = (cupsd_location_t *)cupsArrayNext(p->ops))
+	if ((j = table_index(po->op)) >= 0 && !p->table[j])
+	  p->table[j] = po;		/* First limit for an operation wins */
+
+      if ((po = p->table[0]) != NULL)
+      {
+       /*
+        * Use the wildcard for operations without their own limit...
+	*/
+
+        for (j = 1; j < CUPSD_POLICY_OPS; j ++)
+	  if (!p->table[j])
+	    p->table[j] = po;
+      }
+
+      p->num_table = cupsArrayCount(p->ops);
+    }
+
+    if ((po = p->table[i]) == NULL)
+      cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdFindPolicyOp: No match found.");
+    else if (po->op == op)
+      cupsdLogMessage(CUPSD_LOG_DEBUG2,
+		      "cupsdFindPolicyOp: Found exact match...");
+    else
+      cupsdLogMessage(CUPSD_LOG_DEBUG2,
+		      "cupsdFindPolicyOp: Found wildcard match...");
+
+    return (po);
+  }
+
  /*
   * Check the operation against the available policies...
   */
@@ -264,7 +335,7 @@ cupsdGetPrivateAttrs(
 		*attrs_ptr;		/* Attributes array */
   const char	*username;		/* Username associated with request */
   ipp_attribute_t *attr;		/* Attribute from request */
-  struct passwd	*pw;			/* User info */
+  struct passwd	*pw = NULL;		/* User info */
 
 
 #ifdef DEBUG
@@ -330,14 +401,6 @@ cupsdGetPrivateAttrs(
   else
     username = "anonymous";
 
-  if (username[0])
-  {
-    pw = getpwnam(username);
-    endpwent();
-  }
-  else
-    pw = NULL;
-
 #ifdef DEBUG
   cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdGetPrivateAttrs: username=\"%s\"",
                   username);
@@ -359,6 +422,12 @@ cupsdGetPrivateAttrs(
     {
       char	*acl;			/* Current ACL user/group */
 
+      if (!pw && username[0])
+      {
+        pw = getpwnam(username);
+	endpwent();
+      }
+
       for (acl = (char *)cupsArrayFirst(printer->users);
 	   acl;
 	   acl = (char *)cupsArrayNext(printer->users))
@@ -395,41 +464,19 @@ cupsdGetPrivateAttrs(
 
       return (NULL);
     }
-    else if (!_cups_strcasecmp(name, "@SYSTEM"))
-    {
-      int i;				/* Looping var */
-
-      for (i = 0; i < NumSystemGroups; i ++)
-	if (cupsdCheckGroup(username, pw, SystemGroups[i]))
-	{
-#ifdef DEBUG
-	  cupsdLogMessage(CUPSD_LOG_DEBUG2,
-	                  "cupsdGetPrivateAttrs: Returning NULL.");
-#endif /* DEBUG */
+  }
 
-	  return (NULL);
-	}
-    }
-    else if (name[0] == '@')
-    {
-      if (cupsdCheckGroup(username, pw, name + 1))
-      {
-#ifdef DEBUG
-        cupsdLogMessage(CUPSD_LOG_DEBUG2,
-	                "cupsdGetPrivateAttrs: Returning NULL.");
-#endif /* DEBUG */
+ /*
+  * Then check the user and group names, which do not depend on the object...
+  */
 
-	return (NULL);
-      }
-    }
-    else if (!_cups_strcasecmp(username, name))
-    {
+  if (check_access(policy, access_ptr, username))
+  {
 #ifdef DEBUG
-      cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdGetPrivateAttrs: Returning NULL.");
+    cupsdLogMessage(CUPSD_LOG_DEBUG2, "cupsdGetPrivateAttrs: Returning NULL.");
 #endif /* DEBUG */
 
-      return (NULL);
-    }
+    return (NULL);
   }
 
  /*
@@ -444,6 +491,147 @@ cupsdGetPrivateAttrs(
 }
 
 
+/*
+ * 'check_access()' - Check the user and group names in an access list,
+ *                    caching the result for the policy.
+ */
+
+static int				/* O - 1 if user has access, 0 otherwise */
+check_access(cupsd_policy_t *p,		/* I - Policy */
+             cups_array_t   *access_ptr,/* I - Access list */
+             const char     *username)	/* I - User name */
+{
+  cupsd_accesscache_t	key,		/* Search key */
+			*entry,		/* Cache entry */
+			*oldest;	/* Oldest cache entry */
+  int			*result;	/* Cached result */
+  size_t		userlen;	/* Length of user name */
+  time_t		curtime;	/* Current time */
+
+
+  if (GroupCacheTimeout <= 0)
+    return (check_access_list(access_ptr, username));
+
+ /*
+  * See if we checked this user recently...
+  */
+
+  if (!p->access_cache)
+    p->access_cache = cupsArrayNew3((cups_array_func_t)compare_access_cache,
+                                    NULL, NULL, 0, NULL,
+				    (cups_afree_func_t)free);
+
+  key.username = username;
+  curtime      = time(NULL);
+
+  if ((entry = (cupsd_accesscache_t *)cupsArrayFind(p->access_cache, &key)) != NULL && entry->expires <= curtime)
+  {
+    cupsArrayRemove(p->access_cache, entry);
+    entry = NULL;
+  }
+
+  if (!entry)
+  {
+   /*
+    * Add a new entry, replacing the entry that expires first if the cache is
+    * full...
+    */
+
+    if (cupsArrayCount(p->access_cache) >= CUPSD_ACCESS_CACHE_MAX)
+    {
+      for (oldest = entry = (cupsd_accesscache_t *)cupsArrayFirst(p->access_cache);
+	   entry;
+	   entry = (cupsd_accesscache_t *)cupsArrayNext(p->access_cache))
+	if (entry->expires < oldest->expires)
+	  oldest = entry;
+
+      cupsArrayRemove(p->access_cache, oldest);
+    }
+
+    userlen = strlen(username) + 1;
+
+    if ((entry = malloc(sizeof(cupsd_accesscache_t) + userlen)) == NULL)
+      return (check_access_list(access_ptr, username));
+
+    memcpy((char *)(entry + 1), username, userlen);
+
+    entry->username   = (char *)(entry + 1);
+    entry->job_access = -1;
+    entry->sub_access = -1;
+    entry->expires    = curtime + GroupCacheTimeout;
+
+    cupsArrayAdd(p->access_cache, entry);
+  }
+
+  result = access_ptr == p->sub_access ? &entry->sub_access : &entry->job_access;
+
+  if (*result < 0)
+    *result = check_access_list(access_ptr, username);
+
+  return (*result);
+}
+
+
+/*
+ * 'check_access_list()' - Check the user and group names in an access list.
+ */
+
+static int				/* O - 1 if user has access, 0 otherwise */
+check_access_list(
+    cups_array_t *access_ptr,		/* I - Access list */
+    const char   *username)		/* I - User name */
+{
+  int		i;			/* Looping var */
+  char		*name;			/* Current name in access list */
+  struct passwd	*pw;			/* User info */
+
+
+  if (username[0])
+  {
+    pw = getpwnam(username);
+    endpwent();
+  }
+  else
+    pw = NULL;
+
+  for (name = (char *)cupsArrayFirst(access_ptr);
+       name;
+       name = (char *)cupsArrayNext(access_ptr))
+  {
+    if (!_cups_strcasecmp(name, "@ACL") || !_cups_strcasecmp(name, "@OWNER"))
+      continue;
+    else if (!_cups_strcasecmp(name, "@SYSTEM"))
+    {
+      for (i = 0; i < NumSystemGroups; i ++)
+	if (cupsdCheckGroup(username, pw, SystemGroups[i]))
+	  return (1);
+    }
+    else if (name[0] == '@')
+    {
+      if (cupsdCheckGroup(username, pw, name + 1))
+	return (1);
+    }
+    else if (!_cups_strcasecmp(username, name))
+      return (1);
+  }
+
+  return (0);
+}
+
+
+/*
+ * 'compare_access_cache()' - Compare two cached access checks.
+ */
+
+static int				/* O - Result of comparison */
+compare_access_cache(
+    cupsd_accesscache_t *a,		/* I - First entry */
+    cupsd_accesscache_t *b)		/* I - Second entry */
+{
+  return (strcmp(a->username, b->username));
+}
+
+
 /*
  * 'compare_ops()' - Compare two operations.
  */
@@ -480,6 +668,7 @@ free_policy(cupsd_policy_t *p)		/* I - Policy to free */
   cupsArrayDelete(p->sub_access);
   cupsArrayDelete(p->sub_attrs);
   cupsArrayDelete(p->ops);
+  cupsArrayDelete(p->access_cache);
   cupsdClearString(&p->name);
   free(p);
 }
@@ -494,3 +683,19 @@ hash_op(cupsd_location_t *op)		/* I - Operation */
 {
   return (((op->op >> 6) & 0x40) | (op->op & 0x3f));
 }
+
+
+/*
+ * 'table_index()' - Get the operation table index for an operation.
+ */
+
+static int				/* O - Index or -1 if not in table */
+table_index(ipp_op_t op)		/* I - Operation */
+{
+  if (op >= IPP_ANY_OPERATION && op < 0x0080)
+    return ((int)op);
+  else if (op >= IPP_OP_PRIVATE && op < (IPP_OP_PRIVATE + 0x40))
+    return (0x80 + (int)op - IPP_OP_PRIVATE);
+  else
+    return (-1);
+}
@@ -8,6 +8,14 @@
  */
 
 
+/*
+ * Size of the operation table, covering IPP operations 0x0000 to 0x007F and
+ * CUPS operations 0x4000 to 0x403F...
+ */
+
+#define CUPSD_POLICY_OPS	0xC0
+
+
 /*
  * Policy structure...
  */
@@ -19,7 +27,11 @@ typedef struct
 			*job_attrs,	/* Private attributes for jobs */
 			*sub_access,	/* Private users/groups for subscriptions */
 			*sub_attrs,	/* Private attributes for subscriptions */
-			*ops;		/* Operations */
+			*ops,		/* Operations */
+			*access_cache;	/* Cached private access checks */
+  int			num_table;	/* Number of operations in table */
+  cupsd_location_t	*table[CUPSD_POLICY_OPS];
+					/* Operations by operation code */
 } cupsd_policy_t;
 
 typedef struct cupsd_printer_s cupsd_printer_t;
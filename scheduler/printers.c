@@ -33,6 +33,36 @@
 #endif /* __APPLE__ */
 
 
+/*
+ * Local types...
+ */
+
+typedef struct cupsd_ppdread_s		/**** PPD read data ****/
+{
+  cupsd_printer_t	*p;		/* Printer */
+  char			cache_name[1024],
+					/* Cache filename */
+			ppd_name[1024];	/* PPD filename */
+  time_t		cache_mtime,	/* Cache modification time */
+			ppd_mtime;	/* PPD modification time */
+  _ppd_cache_t		*pc;		/* PPD cache */
+  ipp_t			*ppd_attrs;	/* Cached PPD attributes */
+  ppd_file_t		*ppd;		/* PPD file */
+  ppd_status_t		ppd_status;	/* PPD load status */
+  int			ppd_line,	/* PPD error line number */
+			ppd_errno;	/* PPD load errno */
+  char			message[256];	/* Cache creation error message */
+} cupsd_ppdread_t;
+
+
+/*
+ * Local globals...
+ */
+
+static cups_array_t	*PPDReads = NULL;
+					/* PPD files read by worker threads */
+
+
 /*
  * Local functions...
  */
@@ -43,10 +73,14 @@ static void	add_printer_filter(cupsd_printer_t *p, mime_type_t *type,
 static void	add_printer_formats(cupsd_printer_t *p);
 static int	compare_printers(void *first, void *second, void *data);
 static void	delete_printer_filters(cupsd_printer_t *p);
+static void	delete_temporary_printer(cupsd_printer_t *p);
 static void	dirty_printer(cupsd_printer_t *p);
+static int	compare_ppdreads(cupsd_ppdread_t *a, cupsd_ppdread_t *b);
 static void	load_ppd(cupsd_printer_t *p);
 static ipp_t	*new_media_col(pwg_size_t *size, const char *source,
 		               const char *type);
+static void	read_ppd(cupsd_ppdread_t *pr);
+static void	read_ppds(cups_array_t *printers);
 static void	write_xml_string(cups_file_t *fp, const char *s);
 
 
@@ -857,6 +891,8 @@ cupsdDeletePrinter(
 
   cupsFreeOptions(p->num_options, p->options);
 
+  cupsdDeleteTimer(p->timer);
+
   free(p);
 
  /*
@@ -941,6 +977,7 @@ cupsdLoadAllPrinters(void)
 			*value,		/* Pointer to value */
 			*valueptr;	/* Pointer into value */
   cupsd_printer_t	*p;		/* Current printer */
+  cups_array_t		*loaded;	/* Printers that were loaded */
 
 
  /*
@@ -948,6 +985,9 @@ cupsdLoadAllPrinters(void)
   */
 
   snprintf(line, sizeof(line), "%s/printers.conf", ServerRoot);
+
+  cupsdReplayJournal(line, ConfigFilePerm & 0600);
+
   if ((fp = cupsdOpenConfFile(line)) == NULL)
     return;
 
@@ -957,6 +997,7 @@ cupsdLoadAllPrinters(void)
 
   linenum = 0;
   p       = NULL;
+  loaded  = cupsArrayNew(NULL, NULL);
 
   while (cupsFileGetConf(fp, line, sizeof(line), &value, &linenum))
   {
@@ -1014,29 +1055,12 @@ cupsdLoadAllPrinters(void)
           cupsdMarkDirty(CUPSD_DIRTY_PRINTERS);
 	}
 
-        cupsdSetPrinterAttrs(p);
-
-        if (strncmp(p->device_uri, "file:", 5) && p->state != IPP_PRINTER_STOPPED)
-	{
-	 /*
-          * See if the backend exists...
-	  */
-
-	  snprintf(line, sizeof(line), "%s/backend/%s", ServerBin, p->device_uri);
-
-          if ((valueptr = strchr(line + strlen(ServerBin), ':')) != NULL)
-	    *valueptr = '\0';		/* Chop everything but URI scheme */
-
-          if (access(line, 0))
-	  {
-	   /*
-	    * Backend does not exist, stop printer...
-	    */
+       /*
+        * The printer attributes are set once all of the PPD files have been
+	* read...
+	*/
 
-	    p->state = IPP_PRINTER_STOPPED;
-	    snprintf(p->state_message, sizeof(p->state_message), "Backend %s does not exist!", line);
-	  }
-        }
+        cupsArrayAdd(loaded, p);
 
         p = NULL;
       }
@@ -1412,6 +1436,46 @@ cupsdLoadAllPrinters(void)
   }
 
   cupsFileClose(fp);
+
+ /*
+  * Read the PPD files for all of the printers using the worker threads and
+  * then set the printer attributes...
+  */
+
+  read_ppds(loaded);
+
+  for (p = (cupsd_printer_t *)cupsArrayFirst(loaded);
+       p;
+       p = (cupsd_printer_t *)cupsArrayNext(loaded))
+  {
+    cupsdSetPrinterAttrs(p);
+
+    if (strncmp(p->device_uri, "file:", 5) && p->state != IPP_PRINTER_STOPPED)
+    {
+     /*
+      * See if the backend exists...
+      */
+
+      snprintf(line, sizeof(line), "%s/backend/%s", ServerBin, p->device_uri);
+
+      if ((valueptr = strchr(line + strlen(ServerBin), ':')) != NULL)
+	*valueptr = '\0';		/* Chop everything but URI scheme */
+
+      if (access(line, 0))
+      {
+       /*
+	* Backend does not exist, stop printer...
+	*/
+
+	p->state = IPP_PRINTER_STOPPED;
+	snprintf(p->state_message, sizeof(p->state_message), "Backend %s does not exist!", line);
+      }
+    }
+  }
+
+  cupsArrayDelete(loaded);
+
+  read_ppds(NULL);
 }
 
 
@@ -1476,7 +1540,8 @@ void
 cupsdSaveAllPrinters(void)
 {
   int			i;		/* Looping var */
-  cups_file_t		*fp;		/* printers.conf file */
+  cupsd_journal_t	*j;		/* printers.conf journal */
+  cups_file_t		*fp;		/* printers.conf record */
   char			filename[1024],	/* printers.conf filename */
 			temp[1024],	/* Temporary string */
 			value[2048],	/* Value string */
@@ -1495,7 +1560,8 @@ cupsdSaveAllPrinters(void)
 
   snprintf(filename, sizeof(filename), "%s/printers.conf", ServerRoot);
 
-  if ((fp = cupsdCreateConfFile(filename, ConfigFilePerm & 0600)) == NULL)
+  if ((j = cupsdBeginJournal(filename, ConfigFilePerm & 0600,
+                             CUPSD_DIRTY_PRINTERS)) == NULL)
     return;
 
   cupsdLogMessage(CUPSD_LOG_INFO, "Saving printers.conf...");
@@ -1508,6 +1574,8 @@ cupsdSaveAllPrinters(void)
   curdate = localtime(&curtime);
   strftime(temp, sizeof(temp) - 1, "%Y-%m-%d %H:%M", curdate);
 
+  fp = cupsdAddJournalRecord(j, NULL);
+
   cupsFilePuts(fp, "# Printer configuration file for " CUPS_SVERSION "\n");
   cupsFilePrintf(fp, "# Written by cupsd on %s\n", temp);
   cupsFilePuts(fp, "# DO NOT EDIT THIS FILE WHEN CUPSD IS RUNNING\n");
@@ -1533,6 +1601,8 @@ cupsdSaveAllPrinters(void)
     * Write printers as needed...
     */
 
+    fp = cupsdAddJournalRecord(j, printer->name);
+
     if (printer == DefaultPrinter)
       cupsFilePrintf(fp, "<DefaultPrinter %s>\n", printer->name);
     else
@@ -1758,7 +1828,7 @@ cupsdSaveAllPrinters(void)
       cupsFilePuts(fp, "</Printer>\n");
   }
 
-  cupsdCloseCreatedConfFile(fp, filename);
+  cupsdEndJournal(j);
 }
 
 
@@ -2793,6 +2863,8 @@ cupsdSetPrinterState(
     */
 
     p->state_time = time(NULL);
+
+    cupsdUpdateTemporaryPrinter(p);
   }
 
  /*
@@ -3013,6 +3085,31 @@ cupsdUpdatePrinters(void)
 }
 
 
+/*
+ * 'cupsdUpdateTemporaryPrinter()' - Schedule the deletion of a temporary
+ *                                   printer.
+ *
+ * This must be called whenever a printer becomes temporary.  Temporary
+ * printers stick around for 60 seconds after the last state change.
+ */
+
+void
+cupsdUpdateTemporaryPrinter(
+    cupsd_printer_t *p)			/* I - Printer */
+{
+  time_t	when;			/* When to delete the printer */
+
+
+  when = p->temporary ? p->state_time + 61 : 0;
+
+  if (p->timer)
+    cupsdSetTimer(p->timer, when);
+  else if (when)
+    p->timer = cupsdAddTimer(when, (cupsd_timerfunc_t)delete_temporary_printer,
+                             p);
+}
+
+
 /*
  * 'cupsdValidateDest()' - Validate a printer/class destination.
  */
@@ -3782,6 +3879,23 @@ compare_printers(void *first,		/* I - First printer */
 }
 
 
+/*
+ * 'compare_ppdreads()' - Compare two PPD read records.
+ */
+
+static int				/* O - Result of comparison */
+compare_ppdreads(cupsd_ppdread_t *a,	/* I - First record */
+                 cupsd_ppdread_t *b)	/* I - Second record */
+{
+  if (a->p < b->p)
+    return (-1);
+  else if (a->p > b->p)
+    return (1);
+  else
+    return (0);
+}
+
+
 /*
  * 'delete_printer_filters()' - Delete all MIME filters for a printer.
  */
@@ -3832,6 +3946,48 @@ delete_printer_filters(
 }
 
 
+/*
+ * 'delete_temporary_printer()' - Delete a temporary printer that is no longer
+ *                                used.
+ */
+
+static void
+delete_temporary_printer(
+    cupsd_printer_t *p)			/* I - Printer */
+{
+  time_t	curtime;		/* Current time */
+
+
+  if (!p->temporary)
+    return;
+
+  curtime = time(NULL);
+
+  if (p->job)
+  {
+   /*
+    * Still printing, check again later...
+    */
+
+    cupsdSetTimer(p->timer, curtime + 60);
+  }
+  else if (p->state_time >= (curtime - 60))
+  {
+   /*
+    * State changed since the timer was scheduled...
+    */
+
+    cupsdSetTimer(p->timer, p->state_time + 61);
+  }
+  else
+  {
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Deleting unused temporary printer \"%s\".", p->name);
+
+    cupsdDeletePrinter(p, 0);
+  }
+}
+
+
 /*
  * 'dirty_printer()' - Mark config and state files dirty for the specified
  *                     printer.
@@ -3882,6 +4038,8 @@ load_ppd(cupsd_printer_t *p)		/* I - Printer */
 		*pwgtype;		/* Current PWG type */
   ipp_attribute_t *attr;		/* Attribute data */
   _ipp_value_t	*val;			/* Attribute value */
+  cupsd_ppdread_t *pr,			/* PPD read by worker thread, if any */
+		key;			/* Search key */
   int		num_finishings,		/* Number of finishings */
 		finishings[100];	/* finishings-supported values */
   int		num_qualities,		/* Number of print-quality values */
@@ -3910,17 +4068,35 @@ load_ppd(cupsd_printer_t *p)		/* I - Printer */
 		};
 
 
+ /*
+  * See if the PPD file was already read by a worker thread...
+  */
+
+  key.p = p;
+
+  if ((pr = (cupsd_ppdread_t *)cupsArrayFind(PPDReads, &key)) != NULL)
+    cupsArrayRemove(PPDReads, pr);
+
  /*
   * Check to see if the cache is up-to-date...
   */
 
   snprintf(cache_name, sizeof(cache_name), "%s/%s.data", CacheDir, p->name);
-  if (stat(cache_name, &cache_info))
-    cache_info.st_mtime = 0;
-
   snprintf(ppd_name, sizeof(ppd_name), "%s/ppd/%s.ppd", ServerRoot, p->name);
-  if (stat(ppd_name, &ppd_info))
-    ppd_info.st_mtime = 1;
+
+  if (pr)
+  {
+    cache_info.st_mtime = pr->cache_mtime;
+    ppd_info.st_mtime   = pr->ppd_mtime;
+  }
+  else
+  {
+    if (stat(cache_name, &cache_info))
+      cache_info.st_mtime = 0;
+
+    if (stat(ppd_name, &ppd_info))
+      ppd_info.st_mtime = 1;
+  }
 
   snprintf(strings_name, sizeof(strings_name), "%s/%s.strings", CacheDir, p->name);
 
@@ -3934,13 +4110,26 @@ load_ppd(cupsd_printer_t *p)		/* I - Printer */
   {
     cupsdLogMessage(CUPSD_LOG_DEBUG, "load_ppd: Loading %s...", cache_name);
 
-    if ((p->pc = _ppdCacheCreateWithFile(cache_name, &p->ppd_attrs)) != NULL &&
-        p->ppd_attrs)
+    if (pr)
+    {
+      if (pr->ppd_attrs)
+      {
+	p->pc         = pr->pc;
+	p->ppd_attrs  = pr->ppd_attrs;
+	pr->pc        = NULL;
+	pr->ppd_attrs = NULL;
+      }
+    }
+    else
+      p->pc = _ppdCacheCreateWithFile(cache_name, &p->ppd_attrs);
+
+    if (p->pc && p->ppd_attrs)
     {
      /*
       * Loaded successfully!
       */
 
+      free(pr);
       return;
     }
   }
@@ -3963,17 +4152,31 @@ load_ppd(cupsd_printer_t *p)		/* I - Printer */
 
   p->ppd_attrs = ippNew();
 
-  if ((ppd = _ppdOpenFile(ppd_name, _PPD_LOCALIZATION_NONE)) != NULL)
+  if (pr)
+  {
+    ppd     = pr->ppd;
+    pr->ppd = NULL;
+  }
+  else
+    ppd = _ppdOpenFile(ppd_name, _PPD_LOCALIZATION_NONE);
+
+  if (ppd)
   {
    /*
     * Add make/model and other various attributes...
     */
 
-    p->pc = _ppdCacheCreateWithPPD(ppd);
+    if (pr)
+    {
+      p->pc  = pr->pc;
+      pr->pc = NULL;
+    }
+    else
+      p->pc = _ppdCacheCreateWithPPD(ppd);
 
     if (!p->pc)
       cupsdLogMessage(CUPSD_LOG_WARN, "Unable to create cache of \"%s\": %s",
-                      ppd_name, cupsLastErrorString());
+                      ppd_name, pr ? pr->message : cupsLastErrorString());
 
     ppdMarkDefaults(ppd);
 
@@ -5049,7 +5252,14 @@ load_ppd(cupsd_printer_t *p)		/* I - Printer */
     ppd_status_t	pstatus;	/* PPD load status */
 
 
-    pstatus = ppdLastError(&pline);
+    if (pr)
+    {
+      pstatus = pr->ppd_status;
+      pline   = pr->ppd_line;
+      errno   = pr->ppd_errno;
+    }
+    else
+      pstatus = ppdLastError(&pline);
 
     cupsdLogMessage(CUPSD_LOG_ERROR, "PPD file for %s cannot be loaded.", p->name);
 
@@ -5130,6 +5340,13 @@ load_ppd(cupsd_printer_t *p)		/* I - Printer */
     if (cache_info.st_mtime)
       unlink(cache_name);
   }
+
+  if (pr)
+  {
+    _ppdCacheDestroy(pr->pc);
+    ippDelete(pr->ppd_attrs);
+    free(pr);
+  }
 }
 
 
@@ -5177,6 +5394,124 @@ new_media_col(pwg_size_t *size,	/* I - media-size/margin values */
 }
 
 
+/*
+ * 'read_ppd()' - Read a PPD file or its cache in a worker thread.
+ *
+ * This function only reads the files - the printer attributes are set using
+ * the results by load_ppd() on the main thread.
+ */
+
+static void
+read_ppd(cupsd_ppdread_t *pr)		/* I - PPD read data */
+{
+  struct stat	fileinfo;		/* File information */
+
+
+  if (stat(pr->cache_name, &fileinfo))
+    pr->cache_mtime = 0;
+  else
+    pr->cache_mtime = fileinfo.st_mtime;
+
+  if (stat(pr->ppd_name, &fileinfo))
+    pr->ppd_mtime = 1;
+  else
+    pr->ppd_mtime = fileinfo.st_mtime;
+
+  if (pr->cache_mtime >= pr->ppd_mtime)
+  {
+    if ((pr->pc = _ppdCacheCreateWithFile(pr->cache_name, &pr->ppd_attrs)) != NULL && pr->ppd_attrs)
+      return;
+
+    _ppdCacheDestroy(pr->pc);
+    ippDelete(pr->ppd_attrs);
+
+    pr->pc        = NULL;
+    pr->ppd_attrs = NULL;
+  }
+
+  if ((pr->ppd = _ppdOpenFile(pr->ppd_name, _PPD_LOCALIZATION_NONE)) != NULL)
+  {
+    if ((pr->pc = _ppdCacheCreateWithPPD(pr->ppd)) == NULL)
+      strlcpy(pr->message, cupsLastErrorString(), sizeof(pr->message));
+  }
+  else
+  {
+    pr->ppd_errno  = errno;
+    pr->ppd_status = ppdLastError(&pr->ppd_line);
+  }
+}
+
+
+/*
+ * 'read_ppds()' - Read the PPD files for printers using the worker threads.
+ *
+ * Passing NULL frees any PPD files that were not used.
+ */
+
+static void
+read_ppds(cups_array_t *printers)	/* I - Printers or NULL */
+{
+  int			i,		/* Looping var */
+			count;		/* Number of printers */
+  cupsd_printer_t	*p;		/* Current printer */
+  cupsd_ppdread_t	*pr,		/* Current PPD read data */
+			**prs;		/* PPD read data for workers */
+
+
+  if (!printers)
+  {
+    for (pr = (cupsd_ppdread_t *)cupsArrayFirst(PPDReads);
+         pr;
+	 pr = (cupsd_ppdread_t *)cupsArrayNext(PPDReads))
+    {
+      _ppdCacheDestroy(pr->pc);
+      ippDelete(pr->ppd_attrs);
+      ppdClose(pr->ppd);
+      free(pr);
+    }
+
+    cupsArrayDelete(PPDReads);
+    PPDReads = NULL;
+    return;
+  }
+
+  if ((count = cupsArrayCount(printers)) < 2 || WorkerThreads <= 0)
+    return;
+
+  if (!PPDReads)
+    PPDReads = cupsArrayNew((cups_array_func_t)compare_ppdreads, NULL);
+
+  if ((prs = calloc((size_t)count, sizeof(cupsd_ppdread_t *))) == NULL)
+    return;
+
+  for (i = 0, p = (cupsd_printer_t *)cupsArrayFirst(printers);
+       p;
+       p = (cupsd_printer_t *)cupsArrayNext(printers))
+  {
+    if (p->type & (CUPS_PRINTER_CLASS | CUPS_PRINTER_REMOTE))
+      continue;
+
+    if ((pr = calloc(1, sizeof(cupsd_ppdread_t))) == NULL)
+      break;
+
+    pr->p = p;
+    snprintf(pr->cache_name, sizeof(pr->cache_name), "%s/%s.data", CacheDir, p->name);
+    snprintf(pr->ppd_name, sizeof(pr->ppd_name), "%s/ppd/%s.ppd", ServerRoot, p->name);
+
+    prs[i ++] = pr;
+  }
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "Reading %d PPD files...", i);
+
+  cupsdRunWorkers((cupsd_workfunc_t)read_ppd, (void **)prs, i);
+
+  while (i > 0)
+    cupsArrayAdd(PPDReads, prs[-- i]);
+
+  free(prs);
+}
+
+
 /*
  * 'write_xml_string()' - Write a string with XML escaping.
  */
@@ -80,6 +80,7 @@ struct cupsd_printer_s
   char		*reasons[64];		/* printer-state-reasons strings */
   time_t	config_time,		/* Time at this configuration */
 		state_time;		/* Time at this state */
+  cupsd_timer_t	*timer;			/* Timer for temporary queue */
   char		*job_sheets[2];		/* Banners/job sheets */
   cups_ptype_t	type;			/* Printer type (color, small, etc.) */
   char		*device_uri;		/* Device URI */
@@ -163,9 +164,12 @@ extern cupsd_quota_t	*cupsdFindQuota(cupsd_printer_t *p,
 			                const char *username);
 extern void		cupsdFreeQuotas(cupsd_printer_t *p);
 extern void		cupsdLoadAllPrinters(void);
+extern void		cupsdLoadQuotas(void);
 extern void		cupsdRenamePrinter(cupsd_printer_t *p,
 			                   const char *name);
+extern void		cupsdResetQuotas(cupsd_printer_t *p);
 extern void		cupsdSaveAllPrinters(void);
+extern void		cupsdSaveQuotas(void);
 extern int		cupsdSetAuthInfoRequired(cupsd_printer_t *p,
 			                         const char *values,
 						 ipp_attribute_t *attr);
@@ -188,6 +192,7 @@ extern void		cupsdUpdatePrinters(void);
 extern cupsd_quota_t	*cupsdUpdateQuota(cupsd_printer_t *p,
 			                  const char *username, int pages,
 					  int k);
+extern void		cupsdUpdateTemporaryPrinter(cupsd_printer_t *p);
 extern const char	*cupsdValidateDest(const char *uri,
 			        	   cups_ptype_t *dtype,
 					   cupsd_printer_t **printer);
@@ -14,13 +14,93 @@
 #include "cupsd.h"
 
 
+/*
+ * Design Notes for Quotas in CUPSD
+ * --------------------------------
+ *
+ * Usage for each printer/class and user is kept in a ledger of time buckets,
+ * each holding the pages and kilobytes printed starting at a given time.  A
+ * quota period is covered by at most CUPSD_QUOTA_BUCKETS buckets, so usage
+ * that falls out of the quota period is dropped by discarding the oldest
+ * buckets rather than by loading every job in the history.  The ledger is
+ * updated as jobs are received and printed and is saved to the "quota.cache"
+ * file in the CacheDir so that usage is kept across restarts.
+ *
+ * Usage is only recorded for printers and classes that have a page or
+ * kilobyte limit.  The names and quota periods of these destinations are
+ * kept in the tracked list, which is also saved to "quota.cache".  The
+ * ledgers for a destination are (re)seeded from the job history the first
+ * time it is updated while not tracked or with a different quota period, for
+ * example when limits are added to an existing printer, when the quota period
+ * changes, or after upgrading from an older version of CUPS.  The ledgers
+ * and tracked list are kept when the configuration is reloaded.
+ *
+ * When AutoPurgeJobs is enabled, completed jobs whose usage has dropped out
+ * of the quota period are purged as the ledger for the job's destination and
+ * user expires.
+ */
+
+
+/*
+ * Local types...
+ */
+
+#define CUPSD_QUOTA_BUCKETS	32	/* Number of buckets per ledger */
+
+typedef struct cupsd_qbucket_s		/**** Quota usage bucket ****/
+{
+  time_t	start;			/* Start time for bucket */
+  int		pages,			/* Pages printed */
+		k;			/* Kilobytes printed */
+} cupsd_qbucket_t;
+
+typedef struct cupsd_ledger_s		/**** Quota usage ledger ****/
+{
+  char		dest[IPP_MAX_NAME],	/* Printer or class name */
+		username[33];		/* User data */
+  int		num_buckets;		/* Number of buckets */
+  cupsd_qbucket_t buckets[CUPSD_QUOTA_BUCKETS];
+					/* Usage buckets, oldest first */
+} cupsd_ledger_t;
+
+typedef struct cupsd_tracked_s		/**** Tracked printer or class ****/
+{
+  char		dest[IPP_MAX_NAME];	/* Printer or class name */
+  int		period;			/* Quota period for ledgers */
+} cupsd_tracked_t;
+
+
+/*
+ * Local globals...
+ */
+
+static cups_array_t	*Ledgers = NULL;/* Quota usage ledgers */
+static int		LedgersLoaded = 0;
+					/* Have the ledgers been loaded? */
+static cups_array_t	*Tracked = NULL;/* Destinations with current ledgers */
+
+
 /*
  * Local functions...
  */
 
+static void		add_ledger_usage(cupsd_ledger_t *l, int period,
+			                 time_t when, int pages, int k);
 static cupsd_quota_t	*add_quota(cupsd_printer_t *p, const char *username);
+static int		compare_ledgers(const cupsd_ledger_t *l1,
+			                const cupsd_ledger_t *l2);
 static int		compare_quotas(const cupsd_quota_t *q1,
 			               const cupsd_quota_t *q2);
+static int		compare_tracked(const cupsd_tracked_t *t1,
+			                const cupsd_tracked_t *t2);
+static int		expire_ledger(cupsd_ledger_t *l, int period,
+			              time_t curtime);
+static cupsd_ledger_t	*find_ledger(const char *dest, const char *username,
+			             int create);
+static void		purge_jobs(cupsd_printer_t *p, const char *username,
+			           time_t curtime);
+static void		seed_ledgers(cupsd_printer_t *p);
+static void		track_dest(const char *dest, int track, int period);
 
 
 /*
@@ -75,6 +155,210 @@ cupsdFreeQuotas(cupsd_printer_t *p)	/* I - Printer */
 }
 
 
+/*
+ * 'cupsdLoadQuotas()' - Load the quota usage ledgers from quota.cache.
+ */
+
+void
+cupsdLoadQuotas(void)
+{
+  cups_file_t		*fp;		/* quota.cache file */
+  char			filename[1024],	/* quota.cache filename */
+			line[256],	/* Line from file */
+			*value,		/* Value from line */
+			dest[IPP_MAX_NAME];
+					/* Printer or class name */
+  int			linenum = 0,	/* Line number in file */
+			period,		/* Quota period */
+			pages,		/* Pages printed */
+			k,		/* Kilobytes printed */
+			userpos;	/* Position of username in value */
+  long			start;		/* Start time for bucket */
+  cupsd_ledger_t	*l;		/* Current ledger */
+
+
+  if (LedgersLoaded)
+    return;
+
+  LedgersLoaded = 1;
+
+  if (!Ledgers)
+    Ledgers = cupsArrayNew((cups_array_func_t)compare_ledgers, NULL);
+
+  snprintf(filename, sizeof(filename), "%s/quota.cache", CacheDir);
+  if ((fp = cupsdOpenConfFile(filename)) == NULL)
+    return;
+
+  cupsdLogMessage(CUPSD_LOG_INFO, "Loading quota usage cache file \"%s\"...",
+                  filename);
+
+  while (cupsFileGetConf(fp, line, sizeof(line), &value, &linenum))
+  {
+    if (!_cups_strcasecmp(line, "Tracked") && value)
+    {
+     /*
+      * Tracked dest [period]
+      */
+
+      period = -1;			/* Reseed if the period is missing */
+
+      if (sscanf(value, "%127s%d", dest, &period) < 1)
+      {
+        cupsdLogMessage(CUPSD_LOG_ERROR,
+	                "Bad Tracked on line %d of quota.cache.", linenum);
+        continue;
+      }
+
+      track_dest(dest, 1, period);
+    }
+    else if (!_cups_strcasecmp(line, "Usage") && value)
+    {
+     /*
+      * Usage dest start pages k username
+      */
+
+      userpos = 0;
+
+      if (sscanf(value, "%127s%ld%d%d %n", dest, &start, &pages, &k,
+                 &userpos) < 4 || !userpos || !value[userpos])
+      {
+        cupsdLogMessage(CUPSD_LOG_ERROR,
+	                "Bad Usage on line %d of quota.cache.", linenum);
+        continue;
+      }
+
+      if ((l = find_ledger(dest, value + userpos, 1)) == NULL)
+        break;
+
+      if (l->num_buckets > 0 &&
+          (time_t)start <= l->buckets[l->num_buckets - 1].start)
+      {
+        cupsdLogMessage(CUPSD_LOG_ERROR,
+	                "Out-of-order Usage on line %d of quota.cache.",
+			linenum);
+        continue;
+      }
+
+      if (l->num_buckets < CUPSD_QUOTA_BUCKETS)
+      {
+        l->buckets[l->num_buckets].start = (time_t)start;
+	l->buckets[l->num_buckets].pages = pages;
+	l->buckets[l->num_buckets].k     = k;
+	l->num_buckets ++;
+      }
+      else
+      {
+        l->buckets[l->num_buckets - 1].pages += pages;
+        l->buckets[l->num_buckets - 1].k     += k;
+      }
+    }
+    else
+      cupsdLogMessage(CUPSD_LOG_ERROR,
+                      "Unknown %s directive on line %d of quota.cache.",
+		      line, linenum);
+  }
+
+  cupsFileClose(fp);
+}
+
+
+/*
+ * 'cupsdResetQuotas()' - Reseed the quota usage ledgers for a printer the
+ *                        next time they are used.
+ *
+ * This is called when the quota period or limits of a printer change and when
+ * the printer is deleted.
+ */
+
+void
+cupsdResetQuotas(cupsd_printer_t *p)	/* I - Printer */
+{
+  if (p)
+    track_dest(p->name, 0, 0);
+}
+
+
+/*
+ * 'cupsdSaveQuotas()' - Save the quota usage ledgers to quota.cache.
+ */
+
+void
+cupsdSaveQuotas(void)
+{
+  int			i;		/* Looping var */
+  cups_file_t		*fp;		/* quota.cache file */
+  char			filename[1024],	/* quota.cache filename */
+			temp[1024];	/* Temporary string */
+  cupsd_ledger_t	*l;		/* Current ledger */
+  cupsd_tracked_t	*t,		/* Current tracked destination */
+			key;		/* Search key */
+  cupsd_printer_t	*p;		/* Printer or class */
+  time_t		curtime;	/* Current time */
+  struct tm		*curdate;	/* Current date */
+
+
+  snprintf(filename, sizeof(filename), "%s/quota.cache", CacheDir);
+  if ((fp = cupsdCreateConfFile(filename, ConfigFilePerm)) == NULL)
+    return;
+
+  cupsdLogMessage(CUPSD_LOG_INFO, "Saving quota.cache...");
+
+ /*
+  * Write a small header to the file...
+  */
+
+  curtime = time(NULL);
+  curdate = localtime(&curtime);
+  strftime(temp, sizeof(temp) - 1, "%Y-%m-%d %H:%M", curdate);
+
+  cupsFilePuts(fp, "# Quota usage cache file for " CUPS_SVERSION "\n");
+  cupsFilePrintf(fp, "# Written by cupsd on %s\n", temp);
+
+ /*
+  * Write the printers and classes that still have limits...
+  */
+
+  for (t = (cupsd_tracked_t *)cupsArrayFirst(Tracked);
+       t;
+       t = (cupsd_tracked_t *)cupsArrayNext(Tracked))
+  {
+    if ((p = cupsdFindDest(t->dest)) == NULL || (!p->k_limit && !p->page_limit))
+    {
+      cupsArrayRemove(Tracked, t);
+      free(t);
+      continue;
+    }
+
+    cupsFilePrintf(fp, "Tracked %s %d\n", p->name, t->period);
+  }
+
+ /*
+  * Write the usage for each printer or class that is still tracked...
+  */
+
+  for (l = (cupsd_ledger_t *)cupsArrayFirst(Ledgers);
+       l;
+       l = (cupsd_ledger_t *)cupsArrayNext(Ledgers))
+  {
+    strlcpy(key.dest, l->dest, sizeof(key.dest));
+
+    if (!l->num_buckets || !cupsArrayFind(Tracked, &key))
+    {
+      cupsArrayRemove(Ledgers, l);
+      free(l);
+      continue;
+    }
+
+    for (i = 0; i < l->num_buckets; i ++)
+      cupsFilePrintf(fp, "Usage %s %ld %d %d %s\n", l->dest,
+                     (long)l->buckets[i].start, l->buckets[i].pages,
+		     l->buckets[i].k, l->username);
+  }
+
+  cupsdCloseCreatedConfFile(fp, filename);
+}
+
+
 /*
  * 'cupsdUpdateQuota()' - Update quota data for the specified printer and user.
  */
@@ -86,17 +370,27 @@ cupsdUpdateQuota(
     int             pages,		/* I - Number of pages */
     int             k)			/* I - Number of kilobytes */
 {
+  int			i;		/* Looping var */
   cupsd_quota_t		*q;		/* Quota data */
-  cupsd_job_t		*job;		/* Current job */
+  cupsd_ledger_t	*l;		/* Usage ledger */
+  cupsd_tracked_t	key,		/* Search key */
+			*t;		/* Tracked destination */
   time_t		curtime;	/* Current time */
-  ipp_attribute_t	*attr;		/* Job attribute */
 
 
   if (!p || !username)
     return (NULL);
 
   if (!p->k_limit && !p->page_limit)
+  {
+   /*
+    * Usage is not recorded without limits, so the ledgers need to be
+    * reseeded if limits are added later...
+    */
+
+    track_dest(p->name, 0, 0);
     return (NULL);
+  }
 
   if ((q = cupsdFindQuota(p, username)) == NULL)
     return (NULL);
@@ -105,77 +399,135 @@ cupsdUpdateQuota(
                   "cupsdUpdateQuota: p=%s username=%s pages=%d k=%d",
                   p->name, username, pages, k);
 
+  strlcpy(key.dest, p->name, sizeof(key.dest));
+
+  if ((t = (cupsd_tracked_t *)cupsArrayFind(Tracked, &key)) == NULL ||
+      t->period != p->quota_period)
+    seed_ledgers(p);
+
+  if ((l = find_ledger(p->name, q->username, 1)) == NULL)
+    return (q);
+
   curtime = time(NULL);
 
-  if (curtime < q->next_update)
+  if (pages || k)
+  {
+    add_ledger_usage(l, p->quota_period, curtime, pages, k);
+    cupsdMarkDirty(CUPSD_DIRTY_QUOTAS);
+  }
+  else if (curtime < q->next_update)
   {
-    q->page_count += pages;
-    q->k_count    += k;
+   /*
+    * Nothing has changed or expired since the last update...
+    */
 
     return (q);
   }
 
-  if (p->quota_period)
-    curtime -= p->quota_period;
+ /*
+  * Drop any usage that is now outside the quota period and total up the
+  * rest...
+  */
+
+  if (expire_ledger(l, p->quota_period, curtime))
+  {
+    cupsdMarkDirty(CUPSD_DIRTY_QUOTAS);
+
+    if (JobAutoPurge)
+      purge_jobs(p, q->username, curtime);
+  }
+
+  q->page_count = 0;
+  q->k_count    = 0;
+
+  for (i = 0; i < l->num_buckets; i ++)
+  {
+    q->page_count += l->buckets[i].pages;
+    q->k_count    += l->buckets[i].k;
+  }
+
+  if (l->num_buckets > 0 && p->quota_period > 0)
+    q->next_update = l->buckets[0].start + p->quota_period;
   else
-    curtime = 0;
+    q->next_update = 0;
+
+  return (q);
+}
 
-  q->next_update = 0;
-  q->page_count  = 0;
-  q->k_count     = 0;
 
-  for (job = (cupsd_job_t *)cupsArrayFirst(Jobs);
-       job;
-       job = (cupsd_job_t *)cupsArrayNext(Jobs))
+/*
+ * 'add_ledger_usage()' - Add usage to a ledger.
+ */
+
+static void
+add_ledger_usage(cupsd_ledger_t *l,	/* I - Ledger */
+                 int            period,	/* I - Quota period */
+		 time_t         when,	/* I - Time of usage */
+		 int            pages,	/* I - Number of pages */
+		 int            k)	/* I - Number of kilobytes */
+{
+  int			i;		/* Looping var */
+  int			width;		/* Width of buckets in seconds */
+  cupsd_qbucket_t	*b;		/* Current bucket */
+
+
+ /*
+  * Find the newest bucket that starts at or before the usage...
+  */
+
+  for (i = l->num_buckets - 1; i >= 0; i --)
+    if (l->buckets[i].start <= when)
+      break;
+
+  if (period > 0)
+  {
+    if ((width = period / CUPSD_QUOTA_BUCKETS) < 1)
+      width = 1;
+  }
+  else
+    width = 0;				/* No period, use a single bucket */
+
+  if (i >= 0 && (!width || (when - l->buckets[i].start) < width ||
+                 l->num_buckets >= CUPSD_QUOTA_BUCKETS))
   {
    /*
-    * We only care about the current printer/class and user...
+    * Add to an existing bucket...
     */
 
-    if (_cups_strcasecmp(job->dest, p->name) != 0 ||
-        _cups_strcasecmp(job->username, q->username) != 0)
-      continue;
-
+    b = l->buckets + i;
+  }
+  else if (i < 0 && l->num_buckets > 0 &&
+           (!width || l->num_buckets >= CUPSD_QUOTA_BUCKETS))
+  {
    /*
-    * Make sure attributes are loaded; we always call cupsdLoadJob() to ensure
-    * the access_time member is updated so the job isn't unloaded right away...
+    * Add to the oldest bucket, moving its start time back...
     */
 
-    if (!cupsdLoadJob(job))
-      continue;
-
-    if ((attr = ippFindAttribute(job->attrs, "time-at-completion",
-                                 IPP_TAG_INTEGER)) == NULL)
-      if ((attr = ippFindAttribute(job->attrs, "time-at-processing",
-                                   IPP_TAG_INTEGER)) == NULL)
-        attr = ippFindAttribute(job->attrs, "time-at-creation",
-                                IPP_TAG_INTEGER);
-
-    if (attr->values[0].integer < curtime)
-    {
-     /*
-      * This job is too old to count towards the quota, ignore it...
-      */
-
-      if (JobAutoPurge && !job->printer && job->state_value > IPP_JOB_STOPPED)
-        cupsdDeleteJob(job, CUPSD_JOB_PURGE);
+    b        = l->buckets;
+    b->start = when;
+  }
+  else
+  {
+   /*
+    * Insert a new bucket after the one we found...
+    */
 
-      continue;
-    }
+    i ++;
 
-    if (q->next_update == 0)
-      q->next_update = attr->values[0].integer + p->quota_period;
+    if (i < l->num_buckets)
+      memmove(l->buckets + i + 1, l->buckets + i,
+              (size_t)(l->num_buckets - i) * sizeof(cupsd_qbucket_t));
 
-    if ((attr = ippFindAttribute(job->attrs, "job-media-sheets-completed",
-                                 IPP_TAG_INTEGER)) != NULL)
-      q->page_count += attr->values[0].integer;
+    l->num_buckets ++;
 
-    if ((attr = ippFindAttribute(job->attrs, "job-k-octets",
-                                 IPP_TAG_INTEGER)) != NULL)
-      q->k_count += attr->values[0].integer;
+    b        = l->buckets + i;
+    b->start = when;
+    b->pages = 0;
+    b->k     = 0;
   }
 
-  return (q);
+  b->pages += pages;
+  b->k     += k;
 }
 
 
@@ -213,6 +565,24 @@ add_quota(cupsd_printer_t *p,		/* I - Printer */
 }
 
 
+/*
+ * 'compare_ledgers()' - Compare two quota usage ledgers...
+ */
+
+static int				/* O - Result of comparison */
+compare_ledgers(const cupsd_ledger_t *l1,/* I - First ledger */
+                const cupsd_ledger_t *l2)/* I - Second ledger */
+{
+  int	diff;				/* Difference */
+
+
+  if ((diff = _cups_strcasecmp(l1->dest, l2->dest)) != 0)
+    return (diff);
+  else
+    return (_cups_strcasecmp(l1->username, l2->username));
+}
+
+
 /*
  * 'compare_quotas()' - Compare two quota records...
  */
@@ -223,3 +593,275 @@ compare_quotas(const cupsd_quota_t *q1,	/* I - First quota record */
 {
   return (_cups_strcasecmp(q1->username, q2->username));
 }
+
+
+/*
+ * 'compare_tracked()' - Compare two tracked destinations.
+ */
+
+static int				/* O - Result of comparison */
+compare_tracked(
+    const cupsd_tracked_t *t1,		/* I - First destination */
+    const cupsd_tracked_t *t2)		/* I - Second destination */
+{
+  return (_cups_strcasecmp(t1->dest, t2->dest));
+}
+
+
+/*
+ * 'expire_ledger()' - Drop usage that is outside the quota period.
+ */
+
+static int				/* O - 1 if usage was dropped, 0 otherwise */
+expire_ledger(cupsd_ledger_t *l,	/* I - Ledger */
+              int            period,	/* I - Quota period */
+	      time_t         curtime)	/* I - Current time */
+{
+  int	count;				/* Number of expired buckets */
+
+
+  if (period <= 0)
+    return (0);
+
+  curtime -= period;
+
+  for (count = 0; count < l->num_buckets; count ++)
+    if (l->buckets[count].start >= curtime)
+      break;
+
+  if (!count)
+    return (0);
+
+  l->num_buckets -= count;
+
+  if (l->num_buckets > 0)
+    memmove(l->buckets, l->buckets + count,
+            (size_t)l->num_buckets * sizeof(cupsd_qbucket_t));
+
+  return (1);
+}
+
+
+/*
+ * 'find_ledger()' - Find or create the quota usage ledger for a printer and
+ *                   user.
+ */
+
+static cupsd_ledger_t *			/* O - Ledger or NULL */
+find_ledger(const char *dest,		/* I - Printer or class name */
+            const char *username,	/* I - User */
+	    int        create)		/* I - Create the ledger as needed? */
+{
+  cupsd_ledger_t	*l,		/* Ledger */
+			key;		/* Search key */
+  char			*ptr;		/* Pointer into username */
+
+
+  if (!Ledgers)
+    Ledgers = cupsArrayNew((cups_array_func_t)compare_ledgers, NULL);
+
+  strlcpy(key.dest, dest, sizeof(key.dest));
+  strlcpy(key.username, username, sizeof(key.username));
+  if ((ptr = strchr(key.username, '@')) != NULL)
+    *ptr = '\0';			/* Strip @domain/@KDC */
+
+  if ((l = (cupsd_ledger_t *)cupsArrayFind(Ledgers, &key)) != NULL || !create)
+    return (l);
+
+  if ((l = calloc(1, sizeof(cupsd_ledger_t))) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_ERROR,
+                    "Unable to allocate memory for quota usage of \"%s\" on "
+		    "\"%s\".", key.username, key.dest);
+    return (NULL);
+  }
+
+  strlcpy(l->dest, key.dest, sizeof(l->dest));
+  strlcpy(l->username, key.username, sizeof(l->username));
+
+  cupsArrayAdd(Ledgers, l);
+
+  return (l);
+}
+
+
+/*
+ * 'purge_jobs()' - Purge completed jobs that are outside the quota period.
+ */
+
+static void
+purge_jobs(cupsd_printer_t *p,		/* I - Printer or class */
+           const char      *username,	/* I - User */
+	   time_t          curtime)	/* I - Current time */
+{
+  cupsd_job_t	*job;			/* Current job */
+  time_t	jobtime;		/* Time of job */
+
+
+  if (p->quota_period <= 0)
+    return;
+
+  curtime -= p->quota_period;
+
+  for (job = (cupsd_job_t *)cupsArrayFirst(Jobs);
+       job;
+       job = (cupsd_job_t *)cupsArrayNext(Jobs))
+  {
+    if (job->printer || job->state_value <= IPP_JOB_STOPPED ||
+        !job->dest || _cups_strcasecmp(job->dest, p->name) ||
+        !job->username || _cups_strcasecmp(job->username, username))
+      continue;
+
+    jobtime = job->completed_time ? job->completed_time : job->creation_time;
+
+    if (jobtime < curtime)
+      cupsdDeleteJob(job, CUPSD_JOB_PURGE);
+  }
+}
+
+
+/*
+ * 'seed_ledgers()' - Seed the quota usage ledgers for a printer or class from
+ *                    the job history.
+ */
+
+static void
+seed_ledgers(cupsd_printer_t *p)	/* I - Printer or class */
+{
+  cupsd_job_t		*job;		/* Current job */
+  cupsd_ledger_t	*l;		/* Usage ledger */
+  ipp_attribute_t	*attr;		/* Job attribute */
+  time_t		curtime,	/* Current time */
+			jobtime;	/* Time of job */
+  int			pages,		/* Pages printed */
+			k;		/* Kilobytes printed */
+
+
+  cupsdLogMessage(CUPSD_LOG_INFO,
+                  "Seeding quota usage for \"%s\" from job history...",
+		  p->name);
+
+  track_dest(p->name, 1, p->quota_period);
+
+ /*
+  * Drop any old usage for this printer or class...
+  */
+
+  for (l = (cupsd_ledger_t *)cupsArrayFirst(Ledgers);
+       l;
+       l = (cupsd_ledger_t *)cupsArrayNext(Ledgers))
+  {
+    if (!_cups_strcasecmp(l->dest, p->name))
+    {
+      cupsArrayRemove(Ledgers, l);
+      free(l);
+    }
+  }
+
+ /*
+  * Then add the usage from the job history...
+  */
+
+  curtime = time(NULL);
+
+  for (job = (cupsd_job_t *)cupsArrayFirst(Jobs);
+       job;
+       job = (cupsd_job_t *)cupsArrayNext(Jobs))
+  {
+   /*
+    * We only care about the current printer or class...
+    */
+
+    if (!job->dest || _cups_strcasecmp(job->dest, p->name) || !job->username)
+      continue;
+
+   /*
+    * Make sure attributes are loaded; we always call cupsdLoadJob() to ensure
+    * the access_time member is updated so the job isn't unloaded right away...
+    */
+
+    if (!cupsdLoadJob(job))
+      continue;
+
+    if ((attr = ippFindAttribute(job->attrs, "time-at-completion",
+                                 IPP_TAG_INTEGER)) == NULL)
+      if ((attr = ippFindAttribute(job->attrs, "time-at-processing",
+                                   IPP_TAG_INTEGER)) == NULL)
+        attr = ippFindAttribute(job->attrs, "time-at-creation",
+                                IPP_TAG_INTEGER);
+
+    jobtime = attr ? (time_t)attr->values[0].integer : curtime;
+
+    if (p->quota_period && jobtime < (curtime - p->quota_period))
+    {
+     /*
+      * This job is too old to count towards the quota, ignore it...
+      */
+
+      if (JobAutoPurge && !job->printer && job->state_value > IPP_JOB_STOPPED)
+        cupsdDeleteJob(job, CUPSD_JOB_PURGE);
+
+      continue;
+    }
+
+    if ((attr = ippFindAttribute(job->attrs, "job-media-sheets-completed",
+                                 IPP_TAG_INTEGER)) != NULL)
+      pages = attr->values[0].integer;
+    else
+      pages = 0;
+
+    if ((attr = ippFindAttribute(job->attrs, "job-k-octets",
+                                 IPP_TAG_INTEGER)) != NULL)
+      k = attr->values[0].integer;
+    else
+      k = 0;
+
+    if ((pages || k) && (l = find_ledger(p->name, job->username, 1)) != NULL)
+      add_ledger_usage(l, p->quota_period, jobtime, pages, k);
+  }
+
+  cupsdMarkDirty(CUPSD_DIRTY_QUOTAS);
+}
+
+
+/*
+ * 'track_dest()' - Add or remove a destination from the tracked list.
+ */
+
+static void
+track_dest(const char *dest,		/* I - Printer or class name */
+           int        track,		/* I - 1 to track, 0 to stop tracking */
+	   int        period)		/* I - Quota period */
+{
+  cupsd_tracked_t	key,		/* Search key */
+			*t;		/* Tracked destination */
+
+
+  strlcpy(key.dest, dest, sizeof(key.dest));
+
+  if (!track)
+  {
+    if ((t = (cupsd_tracked_t *)cupsArrayFind(Tracked, &key)) != NULL)
+    {
+      cupsArrayRemove(Tracked, t);
+      free(t);
+      cupsdMarkDirty(CUPSD_DIRTY_QUOTAS);
+    }
+
+    return;
+  }
+
+  if (!Tracked)
+    Tracked = cupsArrayNew((cups_array_func_t)compare_tracked, NULL);
+
+  if ((t = (cupsd_tracked_t *)cupsArrayFind(Tracked, &key)) == NULL)
+  {
+    if ((t = calloc(1, sizeof(cupsd_tracked_t))) == NULL)
+      return;
+
+    strlcpy(t->dest, dest, sizeof(t->dest));
+    cupsArrayAdd(Tracked, t);
+  }
+
+  t->period = period;
+}
@@ -16,6 +16,11 @@
 #ifdef HAVE_EPOLL
 #  include <sys/epoll.h>
 #  include <poll.h>
+#  ifdef HAVE_IO_URING
+#    include <linux/io_uring.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#  endif /* HAVE_IO_URING */
 #elif defined(HAVE_KQUEUE)
 #  include <sys/event.h>
 #  include <sys/time.h>
@@ -32,18 +37,18 @@
  *
  * SUPPORTED APIS
  *
- *     OS              select  poll    epoll   kqueue  /dev/poll
- *     --------------  ------  ------  ------  ------  ---------
- *     AIX             YES     YES     NO      NO      NO
- *     FreeBSD         YES     YES     NO      YES     NO
- *     HP-UX           YES     YES     NO      NO      NO
- *     Linux           YES     YES     YES     NO      NO
- *     macOS           YES     YES     NO      YES     NO
- *     NetBSD          YES     YES     NO      YES     NO
- *     OpenBSD         YES     YES     NO      YES     NO
- *     Solaris         YES     YES     NO      NO      YES
- *     Tru64           YES     YES     NO      NO      NO
- *     Windows         YES     NO      NO      NO      NO
+ *     OS              select  poll    epoll   io_uring  kqueue  /dev/poll
+ *     --------------  ------  ------  ------  --------  ------  ---------
+ *     AIX             YES     YES     NO      NO        NO      NO
+ *     FreeBSD         YES     YES     NO      NO        YES     NO
+ *     HP-UX           YES     YES     NO      NO        NO      NO
+ *     Linux           YES     YES     YES     YES       NO      NO
+ *     macOS           YES     YES     NO      NO        YES     NO
+ *     NetBSD          YES     YES     NO      NO        YES     NO
+ *     OpenBSD         YES     YES     NO      NO        YES     NO
+ *     Solaris         YES     YES     NO      NO        NO      YES
+ *     Tru64           YES     YES     NO      NO        NO      NO
+ *     Windows         YES     NO      NO      NO        NO      NO
  *
  *
  * HIGH-LEVEL API
@@ -126,7 +131,38 @@
  *         e. cupsdStopSelect() closes the kqueue() file descriptor
  *            and frees all of the memory used by the event buffer.
  *
- *     5. /dev/poll - O(n log n) - NOT YET IMPLEMENTED
+ *     5. io_uring - O(n)
+ *         a. cupsdStartSelect() creates an io_uring instance using
+ *            io_uring_setup() and maps the submission and completion
+ *            rings.  If the kernel does not support io_uring (or the
+ *            extended io_uring_enter() arguments), epoll() is used
+ *            instead.
+ *         b. cupsdAddSelect() queues one-shot IORING_OP_POLL_ADD and
+ *            IORING_OP_POLL_REMOVE requests in the submission ring
+ *            without making a system call.  Each _cupsd_fd_t has at most
+ *            one poll request outstanding, which holds a reference to the
+ *            record until its completion is seen.  cupsdRemoveSelect()
+ *            queues an IORING_OP_POLL_REMOVE request; since the poll
+ *            request also holds a reference to the file, removals made
+ *            outside of cupsdDoSelect() (listening sockets on reload) are
+ *            submitted right away while removals made from a callback are
+ *            submitted with the next wait.
+ *         c. cupsdDoSelect() submits all queued requests and waits for
+ *            completions with a single io_uring_enter() call, then loops
+ *            through the completion ring, doing the callbacks and
+ *            re-arming the poll request for each file descriptor.  If
+ *            io_uring_enter() fails, the references held by outstanding
+ *            poll requests are released and the file descriptors are
+ *            added to a new epoll() file descriptor.
+ *         d. cupsdStopSelect() unmaps the rings and closes the io_uring
+ *            file descriptor.
+ *
+ *         Only the readiness wait uses io_uring, in place of epoll();
+ *         the callbacks still accept, read, and write (including spool
+ *         files) using the usual system calls since the HTTP, IPP, and
+ *         TLS code does its own non-blocking I/O on the file descriptors.
+ *
+ *     6. /dev/poll - O(n log n) - NOT YET IMPLEMENTED
  *         a. cupsdStartSelect() opens /dev/poll and allocates an
  *            array of pollfd structs; on failure to open /dev/poll,
  *            revert to poll() system call.
@@ -164,6 +200,11 @@
  *   change and eliminate the fd array lookups in the inner loop of
  *   cupsdDoSelect().
  *
+ *   The io_uring implementation exists to address the system call
+ *   overhead of epoll(): changes to the monitored file descriptors are
+ *   batched with the wait for new events, so each pass through the main
+ *   loop makes one system call regardless of the number of changes.
+ *
  *   Since /dev/poll will never be able to use a shadow array, it may
  *   not make sense to implement support for it.  ioctl() overhead will
  *   impact performance as well, so my guess would be that, for CUPS,
@@ -181,6 +222,10 @@ typedef struct _cupsd_fd_s
   cupsd_selfunc_t	read_cb,	/* Read callback */
 			write_cb;	/* Write callback */
   void			*data;		/* Data pointer for callbacks */
+#ifdef HAVE_IO_URING
+  unsigned		uring_events;	/* Events for outstanding poll request */
+  int			uring_canceled;	/* Has poll request been canceled? */
+#endif /* HAVE_IO_URING */
 } _cupsd_fd_t;
 
 
@@ -205,6 +250,25 @@ static struct pollfd	*cupsd_pollfds = NULL;
 #  ifdef HAVE_EPOLL
 static int		cupsd_epoll_fd = -1;
 static struct epoll_event *cupsd_epoll_events = NULL;
+#    ifdef HAVE_IO_URING
+static int		cupsd_uring_fd = -1;
+static unsigned		cupsd_uring_entries = 0,
+			*cupsd_uring_sq_head = NULL,
+			*cupsd_uring_sq_tail = NULL,
+			*cupsd_uring_sq_array = NULL,
+			cupsd_uring_sq_mask = 0,
+			*cupsd_uring_cq_head = NULL,
+			*cupsd_uring_cq_tail = NULL,
+			cupsd_uring_cq_mask = 0;
+static void		*cupsd_uring_sq_ptr = NULL,
+			*cupsd_uring_cq_ptr = NULL;
+static size_t		cupsd_uring_sq_size = 0,
+			cupsd_uring_cq_size = 0;
+static struct io_uring_sqe *cupsd_uring_sqes = NULL;
+static struct io_uring_cqe *cupsd_uring_cqes = NULL;
+static cups_array_t	*cupsd_uring_polls = NULL;
+					/* Records with outstanding poll requests */
+#    endif /* HAVE_IO_URING */
 #  endif /* HAVE_EPOLL */
 #else /* select() */
 static fd_set		cupsd_global_input,
@@ -225,6 +289,16 @@ static _cupsd_fd_t	*find_fd(int fd);
 			  if (!(f)->use) free((f));\
 			}
 #define			retain_fd(f) (f)->use++
+#ifdef HAVE_IO_URING
+static int		compare_polls(_cupsd_fd_t *a, _cupsd_fd_t *b);
+static void		uring_arm(_cupsd_fd_t *fdptr);
+static void		uring_cancel(_cupsd_fd_t *fdptr);
+static int		uring_enter(unsigned min_complete, long timeout);
+static void		uring_fallback(void);
+static struct io_uring_sqe *uring_get_sqe(void);
+static int		uring_start(void);
+static void		uring_stop(void);
+#endif /* HAVE_IO_URING */
 
 
 /*
@@ -327,6 +401,32 @@ cupsdAddSelect(int             fd,	/* I - File descriptor */
   }
 
 #elif defined(HAVE_POLL)
+#  ifdef HAVE_IO_URING
+  if (cupsd_uring_fd >= 0)
+  {
+   /*
+    * Save the new callbacks and then (re)arm the poll request.  If the
+    * events change while a poll request is outstanding, cancel it - the
+    * completion for the canceled request re-arms the poll request with the
+    * new events...
+    */
+
+    unsigned events = (read_cb ? POLLIN : 0) | (write_cb ? POLLOUT : 0);
+					/* New poll events */
+
+    fdptr->read_cb  = read_cb;
+    fdptr->write_cb = write_cb;
+    fdptr->data     = data;
+
+    if (!fdptr->uring_events)
+      uring_arm(fdptr);
+    else if (fdptr->uring_events != events)
+      uring_cancel(fdptr);
+
+    return (1);
+  }
+  else
+#  endif /* HAVE_IO_URING */
 #  ifdef HAVE_EPOLL
   if (cupsd_epoll_fd >= 0)
   {
@@ -448,6 +548,77 @@ cupsdDoSelect(long timeout)		/* I - Timeout in seconds */
 #  ifdef HAVE_EPOLL
   cupsd_in_select = 1;
 
+#    ifdef HAVE_IO_URING
+  if (cupsd_uring_fd >= 0)
+  {
+    unsigned		head,		/* Completion ring head */
+			tail;		/* Completion ring tail */
+    struct io_uring_cqe	*cqe;		/* Current completion */
+    int			res;		/* Poll result */
+
+
+    if (uring_enter(1, timeout) < 0 && errno != EINTR && errno != ETIME)
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR, "io_uring_enter() failed: %s",
+                      strerror(errno));
+
+      uring_fallback();
+      nfds = 0;
+
+      goto release_inactive;
+    }
+    else
+    {
+      head = *cupsd_uring_cq_head;
+      tail = __atomic_load_n(cupsd_uring_cq_tail, __ATOMIC_ACQUIRE);
+
+      for (nfds = 0; head != tail; head ++)
+      {
+	cqe   = cupsd_uring_cqes + (head & cupsd_uring_cq_mask);
+	fdptr = (_cupsd_fd_t *)(uintptr_t)cqe->user_data;
+	res   = cqe->res;
+
+	__atomic_store_n(cupsd_uring_cq_head, head + 1, __ATOMIC_RELEASE);
+
+	if (!fdptr)
+	  continue;			/* IORING_OP_POLL_REMOVE completion */
+
+       /*
+        * The outstanding poll request holds a reference to fdptr, so it is
+	* still valid even if the file descriptor has been removed...
+	*/
+
+	cupsArrayRemove(cupsd_uring_polls, fdptr);
+
+	fdptr->uring_events   = 0;
+	fdptr->uring_canceled = 0;
+
+	if (res > 0 && find_fd(fdptr->fd) == fdptr)
+	{
+	  nfds ++;
+
+	  if (fdptr->read_cb && (res & (POLLIN | POLLERR | POLLHUP)))
+	    (*(fdptr->read_cb))(fdptr->data);
+
+	  if (fdptr->write_cb && (res & (POLLOUT | POLLERR | POLLHUP)) &&
+	      find_fd(fdptr->fd) == fdptr)
+	    (*(fdptr->write_cb))(fdptr->data);
+	}
+
+	if (!fdptr->uring_events && find_fd(fdptr->fd) == fdptr)
+	  uring_arm(fdptr);
+
+	release_fd(fdptr);
+
+	if (cupsd_uring_fd < 0)
+	  break;
+      }
+
+      goto release_inactive;
+    }
+  }
+  else
+#    endif /* HAVE_IO_URING */
   if (cupsd_epoll_fd >= 0)
   {
     int			i;		/* Looping var */
@@ -713,6 +884,26 @@ cupsdRemoveSelect(int fd)		/* I - File descriptor */
     return;
 
 #ifdef HAVE_EPOLL
+#  ifdef HAVE_IO_URING
+  if (cupsd_uring_fd >= 0)
+  {
+   /*
+    * An outstanding poll request holds a reference to the file.  Removals
+    * from a callback are submitted with the next wait in cupsdDoSelect(),
+    * other removals are submitted now to make sure a following close()
+    * really closes the file (listening sockets are re-bound on reload)...
+    */
+
+    if (fdptr->uring_events)
+    {
+      uring_cancel(fdptr);
+
+      if (!cupsd_in_select)
+        uring_enter(0, -1);
+    }
+  }
+  else
+#  endif /* HAVE_IO_URING */
   if (epoll_ctl(cupsd_epoll_fd, EPOLL_CTL_DEL, fd, &event))
   {
     close(cupsd_epoll_fd);
@@ -799,9 +990,15 @@ cupsdStartSelect(void)
 #endif /* HAVE_EPOLL || HAVE_KQUEUE */
 
 #ifdef HAVE_EPOLL
+  cupsd_update_pollfds = 0;
+
+#  ifdef HAVE_IO_URING
+  if (uring_start())
+    return;
+#  endif /* HAVE_IO_URING */
+
   cupsd_epoll_fd       = epoll_create(MaxFDs);
   cupsd_epoll_events   = calloc((size_t)MaxFDs, sizeof(struct epoll_event));
-  cupsd_update_pollfds = 0;
 
 #elif defined(HAVE_KQUEUE)
   cupsd_kqueue_fd      = kqueue();
@@ -830,6 +1027,10 @@ cupsdStopSelect(void)
 
   cupsdLogMessage(CUPSD_LOG_DEBUG, "cupsdStopSelect()");
 
+#ifdef HAVE_IO_URING
+  uring_stop();
+#endif /* HAVE_IO_URING */
+
   for (fdptr = (_cupsd_fd_t *)cupsArrayFirst(cupsd_fds);
        fdptr;
        fdptr = (_cupsd_fd_t *)cupsArrayNext(cupsd_fds))
@@ -921,3 +1122,345 @@ find_fd(int fd)				/* I - File descriptor */
 
   return (fdptr);
 }
+
+
+#ifdef HAVE_IO_URING
+/*
+ * 'compare_polls()' - Compare file descriptor records by address.
+ */
+
+static int				/* O - Result of comparison */
+compare_polls(_cupsd_fd_t *a,		/* I - First record */
+              _cupsd_fd_t *b)		/* I - Second record */
+{
+  return (a < b ? -1 : a > b);
+}
+
+
+/*
+ * 'uring_arm()' - Queue a poll request for a file descriptor.
+ */
+
+static void
+uring_arm(_cupsd_fd_t *fdptr)		/* I - File descriptor record */
+{
+  unsigned		events;		/* Poll events */
+  struct io_uring_sqe	*sqe;		/* Submission queue entry */
+
+
+  events = (fdptr->read_cb ? POLLIN : 0) | (fdptr->write_cb ? POLLOUT : 0);
+
+  if (!events || (sqe = uring_get_sqe()) == NULL)
+    return;
+
+  sqe->opcode    = IORING_OP_POLL_ADD;
+  sqe->fd        = fdptr->fd;
+  sqe->user_data = (uintptr_t)fdptr;
+#  if __BYTE_ORDER == __BIG_ENDIAN
+  sqe->poll32_events = (events << 16) | (events >> 16);
+#  else
+  sqe->poll32_events = events;
+#  endif /* __BYTE_ORDER == __BIG_ENDIAN */
+
+  fdptr->uring_events   = events;
+  fdptr->uring_canceled = 0;
+
+  retain_fd(fdptr);
+  cupsArrayAdd(cupsd_uring_polls, fdptr);
+}
+
+
+/*
+ * 'uring_cancel()' - Queue the cancellation of a poll request.
+ */
+
+static void
+uring_cancel(_cupsd_fd_t *fdptr)	/* I - File descriptor record */
+{
+  struct io_uring_sqe	*sqe;		/* Submission queue entry */
+
+
+  if (fdptr->uring_canceled || (sqe = uring_get_sqe()) == NULL)
+    return;
+
+  sqe->opcode    = IORING_OP_POLL_REMOVE;
+  sqe->fd        = -1;
+  sqe->addr      = (uintptr_t)fdptr;
+  sqe->user_data = 0;
+
+  fdptr->uring_canceled = 1;
+}
+
+
+/*
+ * 'uring_enter()' - Submit queued requests and wait for completions.
+ */
+
+static int				/* O - Number of requests submitted or -1 on error */
+uring_enter(unsigned min_complete,	/* I - Minimum number of completions */
+            long     timeout)		/* I - Timeout in seconds */
+{
+  unsigned			to_submit;
+					/* Number of requests to submit */
+  struct io_uring_getevents_arg	arg;	/* Extended arguments */
+  struct __kernel_timespec	ts;	/* Timeout */
+
+
+  to_submit = *cupsd_uring_sq_tail -
+              __atomic_load_n(cupsd_uring_sq_head, __ATOMIC_ACQUIRE);
+
+  memset(&arg, 0, sizeof(arg));
+
+  if (min_complete && timeout >= 0 && timeout < 86400)
+  {
+    ts.tv_sec  = timeout;
+    ts.tv_nsec = 0;
+    arg.ts     = (uintptr_t)&ts;
+  }
+
+  return ((int)syscall(SYS_io_uring_enter, cupsd_uring_fd, to_submit,
+                       min_complete,
+		       (min_complete ? IORING_ENTER_GETEVENTS : 0) |
+		           IORING_ENTER_EXT_ARG,
+		       &arg, sizeof(arg)));
+}
+
+
+/*
+ * 'uring_fallback()' - Switch from io_uring to epoll() after an error.
+ */
+
+static void
+uring_fallback(void)
+{
+  _cupsd_fd_t		*fdptr;		/* Current file descriptor */
+  struct epoll_event	event;		/* Event data */
+
+
+  uring_stop();
+
+  if ((cupsd_epoll_fd = epoll_create(MaxFDs)) >= 0)
+  {
+    if (!cupsd_epoll_events)
+      cupsd_epoll_events = calloc((size_t)MaxFDs, sizeof(struct epoll_event));
+
+    for (fdptr = (_cupsd_fd_t *)cupsArrayFirst(cupsd_fds);
+	 fdptr && cupsd_epoll_events;
+	 fdptr = (_cupsd_fd_t *)cupsArrayNext(cupsd_fds))
+    {
+      memset(&event, 0, sizeof(event));
+
+      if (fdptr->read_cb)
+	event.events |= EPOLLIN;
+
+      if (fdptr->write_cb)
+	event.events |= EPOLLOUT;
+
+      event.data.ptr = fdptr;
+
+      if (epoll_ctl(cupsd_epoll_fd, EPOLL_CTL_ADD, fdptr->fd, &event))
+        break;
+    }
+
+    if (fdptr || !cupsd_epoll_events)
+    {
+      close(cupsd_epoll_fd);
+      cupsd_epoll_fd = -1;
+    }
+  }
+
+  if (cupsd_epoll_fd >= 0)
+  {
+    cupsdLogMessage(CUPSD_LOG_INFO, "Using epoll() instead of io_uring.");
+  }
+  else
+  {
+    cupsdLogMessage(CUPSD_LOG_INFO, "Using poll() instead of io_uring.");
+    cupsd_update_pollfds = 1;
+  }
+}
+
+
+/*
+ * 'uring_get_sqe()' - Get the next submission queue entry.
+ */
+
+static struct io_uring_sqe *		/* O - Submission queue entry or NULL */
+uring_get_sqe(void)
+{
+  unsigned		tail,		/* Submission ring tail */
+			index;		/* Index of entry */
+  struct io_uring_sqe	*sqe;		/* Submission queue entry */
+
+
+  tail = *cupsd_uring_sq_tail;
+
+  if (tail - __atomic_load_n(cupsd_uring_sq_head, __ATOMIC_ACQUIRE) >= cupsd_uring_entries)
+  {
+   /*
+    * Submission ring is full, submit what we have now...
+    */
+
+    if (uring_enter(0, -1) < 0 || tail - __atomic_load_n(cupsd_uring_sq_head, __ATOMIC_ACQUIRE) >= cupsd_uring_entries)
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to submit io_uring requests: %s", strerror(errno));
+      return (NULL);
+    }
+  }
+
+  index = tail & cupsd_uring_sq_mask;
+  sqe   = cupsd_uring_sqes + index;
+
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+
+  cupsd_uring_sq_array[index] = index;
+
+  __atomic_store_n(cupsd_uring_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  return (sqe);
+}
+
+
+/*
+ * 'uring_start()' - Create the io_uring instance.
+ */
+
+static int				/* O - 1 on success, 0 on failure */
+uring_start(void)
+{
+  struct io_uring_params params;	/* Setup parameters */
+  unsigned		entries;	/* Number of entries */
+
+
+  memset(&params, 0, sizeof(params));
+
+  if ((entries = (unsigned)MaxFDs) > 4096)
+    entries = 4096;
+
+  if ((cupsd_uring_fd = (int)syscall(SYS_io_uring_setup, entries, &params)) < 0)
+  {
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "io_uring_setup() failed: %s", strerror(errno));
+    return (0);
+  }
+
+  if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+  {
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "io_uring does not support extended arguments.");
+    close(cupsd_uring_fd);
+    cupsd_uring_fd = -1;
+    return (0);
+  }
+
+  fcntl(cupsd_uring_fd, F_SETFD, fcntl(cupsd_uring_fd, F_GETFD) | FD_CLOEXEC);
+
+ /*
+  * Map the submission and completion rings...
+  */
+
+  cupsd_uring_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cupsd_uring_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    if (cupsd_uring_cq_size > cupsd_uring_sq_size)
+      cupsd_uring_sq_size = cupsd_uring_cq_size;
+
+    cupsd_uring_cq_size = 0;
+  }
+
+  if ((cupsd_uring_sq_ptr = mmap(NULL, cupsd_uring_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, cupsd_uring_fd, IORING_OFF_SQ_RING)) == MAP_FAILED)
+  {
+    cupsd_uring_sq_ptr = NULL;
+    goto error;
+  }
+
+  if (cupsd_uring_cq_size == 0)
+    cupsd_uring_cq_ptr = cupsd_uring_sq_ptr;
+  else if ((cupsd_uring_cq_ptr = mmap(NULL, cupsd_uring_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, cupsd_uring_fd, IORING_OFF_CQ_RING)) == MAP_FAILED)
+  {
+    cupsd_uring_cq_ptr = NULL;
+    goto error;
+  }
+
+  if ((cupsd_uring_sqes = mmap(NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, cupsd_uring_fd, IORING_OFF_SQES)) == MAP_FAILED)
+  {
+    cupsd_uring_sqes = NULL;
+    goto error;
+  }
+
+  cupsd_uring_entries  = params.sq_entries;
+  cupsd_uring_sq_head  = (unsigned *)((char *)cupsd_uring_sq_ptr + params.sq_off.head);
+  cupsd_uring_sq_tail  = (unsigned *)((char *)cupsd_uring_sq_ptr + params.sq_off.tail);
+  cupsd_uring_sq_mask  = *(unsigned *)((char *)cupsd_uring_sq_ptr + params.sq_off.ring_mask);
+  cupsd_uring_sq_array = (unsigned *)((char *)cupsd_uring_sq_ptr + params.sq_off.array);
+  cupsd_uring_cq_head  = (unsigned *)((char *)cupsd_uring_cq_ptr + params.cq_off.head);
+  cupsd_uring_cq_tail  = (unsigned *)((char *)cupsd_uring_cq_ptr + params.cq_off.tail);
+  cupsd_uring_cq_mask  = *(unsigned *)((char *)cupsd_uring_cq_ptr + params.cq_off.ring_mask);
+  cupsd_uring_cqes     = (struct io_uring_cqe *)((char *)cupsd_uring_cq_ptr + params.cq_off.cqes);
+
+  cupsd_uring_polls = cupsArrayNew((cups_array_func_t)compare_polls, NULL);
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "Using io_uring with %u entries.", cupsd_uring_entries);
+
+  return (1);
+
+ /*
+  * If we get here, we were unable to map the rings...
+  */
+
+  error:
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "Unable to map io_uring rings: %s", strerror(errno));
+
+  uring_stop();
+
+  return (0);
+}
+
+
+/*
+ * 'uring_stop()' - Destroy the io_uring instance.
+ *
+ * The references held by outstanding poll requests are released.
+ */
+
+static void
+uring_stop(void)
+{
+  _cupsd_fd_t	*fdptr;			/* Current file descriptor */
+
+
+  for (fdptr = (_cupsd_fd_t *)cupsArrayFirst(cupsd_uring_polls);
+       fdptr;
+       fdptr = (_cupsd_fd_t *)cupsArrayNext(cupsd_uring_polls))
+  {
+    cupsArrayRemove(cupsd_uring_polls, fdptr);
+
+    fdptr->uring_events   = 0;
+    fdptr->uring_canceled = 0;
+
+    release_fd(fdptr);
+  }
+
+  cupsArrayDelete(cupsd_uring_polls);
+  cupsd_uring_polls = NULL;
+
+  if (cupsd_uring_sqes)
+    munmap(cupsd_uring_sqes, cupsd_uring_entries * sizeof(struct io_uring_sqe));
+
+  if (cupsd_uring_cq_ptr && cupsd_uring_cq_ptr != cupsd_uring_sq_ptr)
+    munmap(cupsd_uring_cq_ptr, cupsd_uring_cq_size);
+
+  if (cupsd_uring_sq_ptr)
+    munmap(cupsd_uring_sq_ptr, cupsd_uring_sq_size);
+
+  if (cupsd_uring_fd >= 0)
+    close(cupsd_uring_fd);
+
+  cupsd_uring_fd      = -1;
+  cupsd_uring_entries = 0;
+  cupsd_uring_sqes    = NULL;
+  cupsd_uring_sq_ptr  = NULL;
+  cupsd_uring_cq_ptr  = NULL;
+}
+#endif /* HAVE_IO_URING */
@@ -39,6 +39,12 @@ cupsdStartServer(void)
 
   DefaultProfile = cupsdCreateProfile(0, 1);
 
+ /*
+  * Start writing log files from a separate thread...
+  */
+
+  cupsdStartLogWriter();
+
 #ifdef HAVE_SANDBOX_H
   if (!DefaultProfile && UseSandboxing && Sandboxing != CUPSD_SANDBOXING_OFF)
   {
@@ -78,6 +84,21 @@ cupsdStartServer(void)
     cupsdAddSelect(CGIPipes[0], (cupsd_selfunc_t)cupsdUpdateCGI, NULL, NULL);
   }
 
+#ifdef HAVE_SPLICE
+ /*
+  * Create a pipe for splicing request data into the spool directory...
+  */
+
+  if (cupsdOpenPipe(SplicePipes))
+    cupsdLogMessage(CUPSD_LOG_WARN,
+                    "cupsdStartServer: Unable to create pipes for splice - %s",
+		    strerror(errno));
+#  ifdef F_SETPIPE_SZ
+  else
+    fcntl(SplicePipes[1], F_SETPIPE_SZ, CUPSD_SPLICE_SIZE);
+#  endif /* F_SETPIPE_SZ */
+#endif /* HAVE_SPLICE */
+
  /*
   * Mark that the server has started and printers and jobs may be changed...
   */
@@ -137,10 +158,27 @@ cupsdStopServer(void)
     CGIPipes[1] = -1;
   }
 
+#ifdef HAVE_SPLICE
  /*
-  * Close all log files...
+  * Close the pipe for splicing request data...
   */
 
+  if (SplicePipes[0] >= 0)
+  {
+    cupsdLogMessage(CUPSD_LOG_DEBUG,
+                    "cupsdStopServer: Received " CUPS_LLFMT
+		    " request bytes using splice().", CUPS_LLCAST SplicedBytes);
+
+    cupsdClosePipe(SplicePipes);
+  }
+#endif /* HAVE_SPLICE */
+
+ /*
+  * Write any buffered log lines and close all log files...
+  */
+
+  cupsdStopLogWriter();
+
   if (AccessFile != NULL)
   {
     if (AccessFile != LogStderr)
@@ -173,11 +211,16 @@ cupsdStopServer(void)
   DefaultProfile = NULL;
 
  /*
-  * Write out any dirty files...
+  * Write out any dirty files, folding the state file journals back into the
+  * state files...
   */
 
+  cupsdCompactJournals();
+
   if (DirtyFiles)
     cupsdCleanDirty();
 
+  cupsdSyncConfFiles();
+
   started = 0;
 }
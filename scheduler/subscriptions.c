@@ -12,6 +12,7 @@
  */
 
 #include "cupsd.h"
+#include <poll.h>
 #ifdef HAVE_DBUS
 #  include <dbus/dbus.h>
 #  ifdef HAVE_DBUS_MESSAGE_ITER_INIT_APPEND
@@ -22,22 +23,136 @@
 #endif /* HAVE_DBUS */
 
 
+/*
+ * Local constants...
+ */
+
+#define CUPSD_BATCH_WRITE	32768	/* Write batch at this many bytes */
+#define CUPSD_BATCH_MAX		1048576	/* Maximum unwritten batch bytes */
+#define CUPSD_BATCH_DRAIN	2	/* Seconds to wait for a notifier to
+					 * read its batch when stopping */
+#define CUPSD_EVENT_PREFIX	2	/* Attributes before the subscription
+					 * attributes (notify-charset and
+					 * notify-natural-language) */
+
+
+/*
+ * Local types...
+ */
+
+typedef struct cupsd_subindex_s		/**** Subscription index entry ****/
+{
+  const void	*key;			/* Printer or job */
+  unsigned	bit;			/* Event bit */
+  cups_array_t	*subs;			/* Subscriptions, sorted by ID */
+} cupsd_subindex_t;
+
+typedef struct cupsd_evbuf_s		/**** Event encoding buffer ****/
+{
+  ipp_uchar_t	*ptr,			/* Current position */
+		*end;			/* End of buffer */
+} cupsd_evbuf_t;
+
+
+/*
+ * Local globals...
+ *
+ * Subscriptions are indexed by event bit and printer (sub_dest_index) and
+ * by event bit and job (sub_job_index), so that cupsdAddEvent() only looks
+ * at the subscriptions that can match.  Subscriptions without a printer
+ * match all events and are found using the NULL printer key.  Subscriptions
+ * with a printer are also found using their job key - like before, this
+ * includes printer subscriptions (NULL job) for events without a job.
+ */
+
+static cups_array_t	*sub_dest_index = NULL,
+					/* Index by printer */
+			*sub_job_index = NULL;
+					/* Index by job */
+
+/*
+ * Each event is created once by cupsdAddEvent() and shared by all of the
+ * subscriptions that receive it.  The event attributes do not include the
+ * notify-subscription-id, notify-sequence-number, and notify-user-data
+ * attributes - these are inserted after the first CUPSD_EVENT_PREFIX
+ * attributes when the event is delivered, either by cupsd_copy_event() for
+ * Get-Notifications or by cupsd_queue_event() for the notifiers (which use a
+ * copy of the event encoded once by cupsd_encode_event()).
+ *
+ * Events are owned by a single cache of the last EventCacheSize events for
+ * all subscriptions.  Event "serial" is stored in event_cache[serial %
+ * event_size], and each event lists the subscriptions that received it and
+ * their notify-sequence-number values, so a subscription only needs the
+ * serial number of the last event it received to find its events.  An event
+ * is freed when it leaves the cache.
+ */
+
+static cupsd_event_t	**event_cache = NULL;
+					/* Cached events */
+static int		event_size = 0,	/* Size of event cache */
+			event_count = 0,/* Number of cached events */
+			event_serial = 0;
+					/* Serial number of last event */
+
+/*
+ * Messages for a notifier are collected in the subscription's batch buffer
+ * for up to NotifierBatchInterval seconds and then written to the notifier
+ * pipe with a single write.  A batch is just a series of IPP messages, which
+ * notifiers already read one after another, so the notifier is woken up once
+ * per batch instead of once per event.  If the pipe is full, the rest of the
+ * batch is written when the pipe becomes writable again.
+ *
+ * The end of each message in the batch is recorded so that the number of
+ * events that are lost can be logged when a notifier goes away before reading
+ * the whole batch.  When a subscription is deleted or the notifiers are
+ * stopped, the rest of the batch is written using blocking writes for up to
+ * CUPSD_BATCH_DRAIN seconds.
+ */
+
+
 /*
  * Local functions...
  */
 
+static void	cupsd_cache_event(cupsd_event_t *event);
+static int	cupsd_compare_subindex(cupsd_subindex_t *first,
+		                       cupsd_subindex_t *second,
+				       void *unused);
 static int	cupsd_compare_subscriptions(cupsd_subscription_t *first,
 		                            cupsd_subscription_t *second,
 		                            void *unused);
-static void	cupsd_delete_event(cupsd_event_t *event);
+static void	cupsd_copy_event(ipp_t *ipp, cupsd_subscription_t *sub,
+		                 cupsd_event_t *event, int sequence);
+static void	cupsd_drain_batch(cupsd_subscription_t *sub);
+static ipp_uchar_t *cupsd_encode_attr(ipp_uchar_t *bufptr, ipp_tag_t value_tag,
+		                      const char *name, const void *value,
+				      size_t length);
+static int	cupsd_encode_event(cupsd_event_t *event);
+static void	cupsd_expire_subscription(cupsd_subscription_t *sub);
+static cupsd_recipient_t *cupsd_find_recipient(cupsd_event_t *event, int id);
+static void	cupsd_find_subscriptions(cups_array_t *matches,
+		                         cups_array_t *index, const void *key,
+					 unsigned bit);
+static void	cupsd_flush_events(void);
+static void	cupsd_free_event(cupsd_event_t *event);
+static void	cupsd_index_subscription(cupsd_subscription_t *sub);
+static int	cupsd_queue_event(cupsd_subscription_t *sub,
+		                  cupsd_event_t *event, int sequence);
 #ifdef HAVE_DBUS
 static void	cupsd_send_dbus(cupsd_eventmask_t event, cupsd_printer_t *dest,
 		                cupsd_job_t *job);
 #endif /* HAVE_DBUS */
+static void	cupsd_reset_batch(cupsd_subscription_t *sub);
 static void	cupsd_send_notification(cupsd_subscription_t *sub,
 		                        cupsd_event_t *event);
 static void	cupsd_start_notifier(cupsd_subscription_t *sub);
+static void	cupsd_unindex_key(cups_array_t *index, const void *key,
+		                  unsigned mask, cupsd_subscription_t *sub);
+static void	cupsd_unindex_subscription(cupsd_subscription_t *sub);
 static void	cupsd_update_notifier(void);
+static void	cupsd_write_batch(cupsd_subscription_t *sub);
+static ssize_t	cupsd_write_buffer(cupsd_evbuf_t *buffer, ipp_uchar_t *data,
+		                   size_t bytes);
 
 
 /*
@@ -57,6 +172,9 @@ cupsdAddEvent(
   ipp_attribute_t	*attr;		/* Printer/job attribute */
   cupsd_event_t		*temp;		/* New event pointer */
   cupsd_subscription_t	*sub;		/* Current subscription */
+  cups_array_t		*matches;	/* Matching subscriptions */
+  unsigned		bit;		/* Current event bit */
+  cupsd_recipient_t	*recipient;	/* Current recipient */
 
 
   cupsdLogMessage(CUPSD_LOG_DEBUG2,
@@ -87,195 +205,217 @@ cupsdAddEvent(
   }
 
  /*
-  * Then loop through the subscriptions and add the event to the corresponding
-  * caches...
+  * Then find the subscriptions that want this event...
   */
 
-  for (temp = NULL, sub = (cupsd_subscription_t *)cupsArrayFirst(Subscriptions);
-       sub;
-       sub = (cupsd_subscription_t *)cupsArrayNext(Subscriptions))
+  if (!dest && job)
+    dest = cupsdFindPrinter(job->dest);
+
+  if ((matches = cupsArrayNew((cups_array_func_t)cupsd_compare_subscriptions,
+                               NULL)) == NULL)
   {
-   /*
-    * Check if this subscription requires this event...
-    */
+    cupsdLogMessage(CUPSD_LOG_CRIT,
+		    "Unable to allocate memory for event - %s",
+		    strerror(errno));
+    return;
+  }
 
-    if ((sub->mask & event) != 0 && (sub->dest == dest || !sub->dest || sub->job == job))
-    {
-     /*
-      * Need this event, so create a new event record...
-      */
+  for (bit = 1; bit & CUPSD_EVENT_ALL; bit <<= 1)
+  {
+    if (!(event & bit))
+      continue;
 
-      if ((temp = (cupsd_event_t *)calloc(1, sizeof(cupsd_event_t))) == NULL)
-      {
-	cupsdLogMessage(CUPSD_LOG_CRIT,
-	                "Unable to allocate memory for event - %s",
-        	        strerror(errno));
-	return;
-      }
+    cupsd_find_subscriptions(matches, sub_dest_index, NULL, bit);
+    if (dest)
+      cupsd_find_subscriptions(matches, sub_dest_index, dest, bit);
+    cupsd_find_subscriptions(matches, sub_job_index, job, bit);
+  }
 
-      temp->event = event;
-      temp->time  = time(NULL);
-      temp->attrs = ippNew();
-      temp->job   = job;
+  if (cupsArrayCount(matches) == 0)
+  {
+    cupsdLogMessage(CUPSD_LOG_DEBUG, "Discarding unused %s event...",
+                    cupsdEventName(event));
+    cupsArrayDelete(matches);
+    return;
+  }
 
-      if (dest)
-        temp->dest = dest;
-      else if (job)
-        temp->dest = dest = cupsdFindPrinter(job->dest);
+ /*
+  * Create a single event record that is shared by all of the subscriptions;
+  * the subscription-specific attributes are added when the event is
+  * delivered...
+  */
 
-     /*
-      * Add common event notification attributes...
-      */
+  if ((temp = (cupsd_event_t *)calloc(1, sizeof(cupsd_event_t))) == NULL ||
+      (temp->recipients = calloc((size_t)cupsArrayCount(matches), sizeof(cupsd_recipient_t))) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_CRIT,
+		    "Unable to allocate memory for event - %s",
+		    strerror(errno));
+    free(temp);
+    cupsArrayDelete(matches);
+    return;
+  }
 
-      ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_CHARSET,
-                   "notify-charset", NULL, "utf-8");
+  temp->serial   = ++ event_serial;
+  temp->event    = event;
+  temp->time     = time(NULL);
+  temp->attrs    = ippNew();
 
-      ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_LANGUAGE,
-                   "notify-natural-language", NULL, "en-US");
+ /*
+  * Add common event notification attributes...
+  */
 
-      ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
-	            "notify-subscription-id", sub->id);
+  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_CHARSET,
+	       "notify-charset", NULL, "utf-8");
 
-      ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
-	            "notify-sequence-number", sub->next_event_id);
+  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_LANGUAGE,
+	       "notify-natural-language", NULL, "en-US");
 
-      ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_KEYWORD,
-	           "notify-subscribed-event", NULL, cupsdEventName(event));
+  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_KEYWORD,
+	       "notify-subscribed-event", NULL, cupsdEventName(event));
 
-      if (sub->user_data_len > 0)
-        ippAddOctetString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-	                  "notify-user-data", sub->user_data,
-			  sub->user_data_len);
+  ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
+		"printer-up-time", time(NULL));
 
-      ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
-	            "printer-up-time", time(NULL));
+  va_start(ap, text);
+  vsnprintf(ftext, sizeof(ftext), text, ap);
+  va_end(ap);
 
-      va_start(ap, text);
-      vsnprintf(ftext, sizeof(ftext), text, ap);
-      va_end(ap);
+  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_TEXT,
+	       "notify-text", NULL, ftext);
 
-      ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_TEXT,
-	           "notify-text", NULL, ftext);
+  if (dest)
+  {
+   /*
+    * Add printer attributes...
+    */
 
-      if (dest)
-      {
-       /*
-	* Add printer attributes...
-	*/
+    ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_URI,
+		 "notify-printer-uri", NULL, dest->uri);
 
-	ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_URI,
-	             "notify-printer-uri", NULL, dest->uri);
+    ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_NAME,
+		 "printer-name", NULL, dest->name);
 
-	ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_NAME,
-	             "printer-name", NULL, dest->name);
+    ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_ENUM,
+		  "printer-state", dest->state);
 
-	ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_ENUM,
-	              "printer-state", dest->state);
+    if (dest->num_reasons == 0)
+      ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+		   IPP_TAG_KEYWORD, "printer-state-reasons", NULL,
+		   dest->state == IPP_PRINTER_STOPPED ? "paused" : "none");
+    else
+      ippAddStrings(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+		    IPP_TAG_KEYWORD, "printer-state-reasons",
+		    dest->num_reasons, NULL,
+		    (const char * const *)dest->reasons);
 
-	if (dest->num_reasons == 0)
-	  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-	               IPP_TAG_KEYWORD, "printer-state-reasons", NULL,
-		       dest->state == IPP_PRINTER_STOPPED ? "paused" : "none");
-	else
-	  ippAddStrings(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-	                IPP_TAG_KEYWORD, "printer-state-reasons",
-			dest->num_reasons, NULL,
-			(const char * const *)dest->reasons);
+    ippAddBoolean(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+		  "printer-is-accepting-jobs", (char)dest->accepting);
+  }
 
-	ippAddBoolean(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-	              "printer-is-accepting-jobs", (char)dest->accepting);
-      }
+  if (job)
+  {
+   /*
+    * Add job attributes...
+    */
 
-      if (job)
-      {
-       /*
-	* Add job attributes...
-	*/
+    ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
+		  "notify-job-id", job->id);
+    ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_ENUM,
+		  "job-state", job->state_value);
+
+    if ((attr = ippFindAttribute(job->attrs, "job-name",
+				 IPP_TAG_NAME)) != NULL)
+      ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_NAME,
+		   "job-name", NULL, attr->values[0].string.text);
+
+    switch (job->state_value)
+    {
+      case IPP_JOB_PENDING :
+	  if (dest && dest->state == IPP_PRINTER_STOPPED)
+	    ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+			 IPP_TAG_KEYWORD, "job-state-reasons", NULL,
+			 "printer-stopped");
+	  else
+	    ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+			 IPP_TAG_KEYWORD, "job-state-reasons", NULL,
+			 "none");
+	  break;
 
-	ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
-	              "notify-job-id", job->id);
-	ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_ENUM,
-	              "job-state", job->state_value);
+      case IPP_JOB_HELD :
+	  if (ippFindAttribute(job->attrs, "job-hold-until", IPP_TAG_KEYWORD) != NULL ||
+	      ippFindAttribute(job->attrs, "job-hold-until", IPP_TAG_NAME) != NULL)
+	    ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+			 IPP_TAG_KEYWORD, "job-state-reasons", NULL,
+			 "job-hold-until-specified");
+	  else
+	    ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+			 IPP_TAG_KEYWORD, "job-state-reasons", NULL,
+			 "job-incoming");
+	  break;
 
-        if ((attr = ippFindAttribute(job->attrs, "job-name",
-	                             IPP_TAG_NAME)) != NULL)
-	  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_NAME,
-	               "job-name", NULL, attr->values[0].string.text);
+      case IPP_JOB_PROCESSING :
+	  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+		       IPP_TAG_KEYWORD, "job-state-reasons", NULL,
+		       "job-printing");
+	  break;
 
-	switch (job->state_value)
-	{
-	  case IPP_JOB_PENDING :
-              if (dest && dest->state == IPP_PRINTER_STOPPED)
-        	ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-		             IPP_TAG_KEYWORD, "job-state-reasons", NULL,
-			     "printer-stopped");
-              else
-        	ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-		             IPP_TAG_KEYWORD, "job-state-reasons", NULL,
-			     "none");
-              break;
-
-	  case IPP_JOB_HELD :
-              if (ippFindAttribute(job->attrs, "job-hold-until", IPP_TAG_KEYWORD) != NULL ||
-		  ippFindAttribute(job->attrs, "job-hold-until", IPP_TAG_NAME) != NULL)
-        	ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-		             IPP_TAG_KEYWORD, "job-state-reasons", NULL,
-			     "job-hold-until-specified");
-              else
-        	ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-		             IPP_TAG_KEYWORD, "job-state-reasons", NULL,
-			     "job-incoming");
-              break;
-
-	  case IPP_JOB_PROCESSING :
-              ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-		           IPP_TAG_KEYWORD, "job-state-reasons", NULL,
-			   "job-printing");
-              break;
-
-	  case IPP_JOB_STOPPED :
-              ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-		           IPP_TAG_KEYWORD, "job-state-reasons", NULL,
-			   "job-stopped");
-              break;
-
-	  case IPP_JOB_CANCELED :
-              ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-		           IPP_TAG_KEYWORD, "job-state-reasons", NULL,
-			   "job-canceled-by-user");
-              break;
-
-	  case IPP_JOB_ABORTED :
-              ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-		           IPP_TAG_KEYWORD, "job-state-reasons", NULL,
-			   "aborted-by-system");
-              break;
-
-	  case IPP_JOB_COMPLETED :
-              ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
-		           IPP_TAG_KEYWORD, "job-state-reasons", NULL,
-			   "job-completed-successfully");
-              break;
-	}
+      case IPP_JOB_STOPPED :
+	  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+		       IPP_TAG_KEYWORD, "job-state-reasons", NULL,
+		       "job-stopped");
+	  break;
 
-	ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
-	              "job-impressions-completed",
-		      job->sheets ? job->sheets->values[0].integer : 0);
-      }
+      case IPP_JOB_CANCELED :
+	  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+		       IPP_TAG_KEYWORD, "job-state-reasons", NULL,
+		       "job-canceled-by-user");
+	  break;
 
-     /*
-      * Send the notification for this subscription...
-      */
+      case IPP_JOB_ABORTED :
+	  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+		       IPP_TAG_KEYWORD, "job-state-reasons", NULL,
+		       "aborted-by-system");
+	  break;
 
-      cupsd_send_notification(sub, temp);
+      case IPP_JOB_COMPLETED :
+	  ippAddString(temp->attrs, IPP_TAG_EVENT_NOTIFICATION,
+		       IPP_TAG_KEYWORD, "job-state-reasons", NULL,
+		       "job-completed-successfully");
+	  break;
     }
+
+    ippAddInteger(temp->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
+		  "job-impressions-completed",
+		  job->sheets ? job->sheets->values[0].integer : 0);
   }
 
-  if (temp)
-    cupsdMarkDirty(CUPSD_DIRTY_SUBSCRIPTIONS);
-  else
-    cupsdLogMessage(CUPSD_LOG_DEBUG, "Discarding unused %s event...",
-                    cupsdEventName(event));
+ /*
+  * Send the notification to each subscription...
+  */
+
+  for (sub = (cupsd_subscription_t *)cupsArrayFirst(matches),
+           recipient = temp->recipients;
+       sub;
+       sub = (cupsd_subscription_t *)cupsArrayNext(matches), recipient ++)
+  {
+    recipient->id       = sub->id;
+    recipient->sequence = sub->next_event_id;
+
+    temp->num_recipients ++;
+
+    cupsd_send_notification(sub, temp);
+  }
+
+  cupsArrayDelete(matches);
+
+ /*
+  * Then add the event to the cache for Get-Notifications...
+  */
+
+  cupsd_cache_event(temp);
+
+  cupsdMarkDirty(CUPSD_DIRTY_SUBSCRIPTIONS);
 }
 
 
@@ -401,7 +541,6 @@ cupsdAddSubscription(
   temp->dest           = dest;
   temp->job            = job;
   temp->pipe           = -1;
-  temp->first_event_id = 1;
   temp->next_event_id  = 1;
 
   cupsdSetString(&(temp->recipient), uri);
@@ -412,6 +551,8 @@ cupsdAddSubscription(
 
   cupsArrayAdd(Subscriptions, temp);
 
+  cupsd_index_subscription(temp);
+
  /*
   * For RSS subscriptions, run the notifier immediately...
   */
@@ -423,6 +564,70 @@ cupsdAddSubscription(
 }
 
 
+/*
+ * 'cupsdCopyEvents()' - Copy the cached events for a subscription.
+ *
+ * Events with a notify-sequence-number of min_seq or higher are copied, up to
+ * MaxEvents events.
+ */
+
+void
+cupsdCopyEvents(
+    ipp_t                *ipp,		/* I - Destination message */
+    cupsd_subscription_t *sub,		/* I - Subscription object */
+    int                  min_seq)	/* I - First notify-sequence-number */
+{
+  int			serial,		/* Current event serial number */
+			first;		/* First event to copy */
+  cupsd_event_t		*event;		/* Current event */
+  cupsd_recipient_t	*recipient;	/* Recipient entry */
+
+
+  if (min_seq < sub->next_event_id - MaxEvents)
+    min_seq = sub->next_event_id - MaxEvents;
+
+  if (!event_cache || min_seq >= sub->next_event_id ||
+      sub->last_serial <= event_serial - event_count)
+    return;
+
+ /*
+  * Look backwards from the last event for this subscription to find the
+  * first event to copy...
+  */
+
+  for (serial = first = sub->last_serial;
+       serial > event_serial - event_count;
+       serial --)
+  {
+    event = event_cache[serial % event_size];
+
+    if ((recipient = cupsd_find_recipient(event, sub->id)) == NULL)
+      continue;
+
+    if (recipient->sequence < min_seq)
+      break;
+
+    first = serial;
+  }
+
+ /*
+  * Then copy the events...
+  */
+
+  for (serial = first; serial <= sub->last_serial; serial ++)
+  {
+    event = event_cache[serial % event_size];
+
+    if ((recipient = cupsd_find_recipient(event, sub->id)) == NULL)
+      continue;
+
+    ippAddSeparator(ipp);
+
+    cupsd_copy_event(ipp, sub, event, recipient->sequence);
+  }
+}
+
+
 /*
  * 'cupsdDeleteAllSubscriptions()' - Delete all subscriptions.
  */
@@ -443,6 +648,14 @@ cupsdDeleteAllSubscriptions(void)
 
   cupsArrayDelete(Subscriptions);
   Subscriptions = NULL;
+
+  cupsArrayDelete(sub_dest_index);
+  sub_dest_index = NULL;
+
+  cupsArrayDelete(sub_job_index);
+  sub_job_index = NULL;
+
+  cupsd_flush_events();
 }
 
 
@@ -460,7 +673,12 @@ cupsdDeleteSubscription(
   */
 
   if (sub->pipe >= 0)
+  {
+    cupsd_drain_batch(sub);
+
+    cupsdRemoveSelect(sub->pipe);
     close(sub->pipe);
+  }
 
  /*
   * Remove subscription from array...
@@ -468,6 +686,8 @@ cupsdDeleteSubscription(
 
   cupsArrayRemove(Subscriptions, sub);
 
+  cupsd_unindex_subscription(sub);
+
  /*
   * Free memory...
   */
@@ -475,7 +695,13 @@ cupsdDeleteSubscription(
   cupsdClearString(&(sub->owner));
   cupsdClearString(&(sub->recipient));
 
-  cupsArrayDelete(sub->events);
+  cupsdDeleteTimer(sub->timer);
+
+  if (sub->batch)
+    free(sub->batch);
+
+  if (sub->batch_ends)
+    free(sub->batch_ends);
 
   free(sub);
 
@@ -712,6 +938,9 @@ cupsdLoadAllSubscriptions(void)
   */
 
   snprintf(line, sizeof(line), "%s/subscriptions.conf", ServerRoot);
+
+  cupsdReplayJournal(line, ConfigFilePerm);
+
   if ((fp = cupsdOpenConfFile(line)) == NULL)
     return;
 
@@ -1017,7 +1246,7 @@ cupsdLoadAllSubscriptions(void)
       */
 
       if (value && isdigit(*value & 255))
-        sub->next_event_id = sub->first_event_id = atoi(value);
+        sub->next_event_id = atoi(value);
       else
       {
 	cupsdLogMessage(CUPSD_LOG_ERROR,
@@ -1039,6 +1268,18 @@ cupsdLoadAllSubscriptions(void)
   }
 
   cupsFileClose(fp);
+
+ /*
+  * Index and schedule lease expiration for the loaded subscriptions...
+  */
+
+  for (sub = (cupsd_subscription_t *)cupsArrayFirst(Subscriptions);
+       sub;
+       sub = (cupsd_subscription_t *)cupsArrayNext(Subscriptions))
+  {
+    cupsd_index_subscription(sub);
+    cupsdUpdateSubscriptionTimer(sub);
+  }
 }
 
 
@@ -1050,7 +1291,8 @@ void
 cupsdSaveAllSubscriptions(void)
 {
   int			i;		/* Looping var */
-  cups_file_t		*fp;		/* subscriptions.conf file */
+  cupsd_journal_t	*j;		/* subscriptions.conf journal */
+  cups_file_t		*fp;		/* subscriptions.conf record */
   char			filename[1024],	/* subscriptions.conf filename */
 			temp[1024];	/* Temporary string */
   cupsd_subscription_t	*sub;		/* Current subscription */
@@ -1067,7 +1309,8 @@ cupsdSaveAllSubscriptions(void)
 
   snprintf(filename, sizeof(filename), "%s/subscriptions.conf", ServerRoot);
 
-  if ((fp = cupsdCreateConfFile(filename, ConfigFilePerm)) == NULL)
+  if ((j = cupsdBeginJournal(filename, ConfigFilePerm,
+                             CUPSD_DIRTY_SUBSCRIPTIONS)) == NULL)
     return;
 
   cupsdLogMessage(CUPSD_LOG_INFO, "Saving subscriptions.conf...");
@@ -1080,6 +1323,8 @@ cupsdSaveAllSubscriptions(void)
   curdate = localtime(&curtime);
   strftime(temp, sizeof(temp) - 1, "%Y-%m-%d %H:%M", curdate);
 
+  fp = cupsdAddJournalRecord(j, NULL);
+
   cupsFilePuts(fp, "# Subscription configuration file for " CUPS_SVERSION "\n");
   cupsFilePrintf(fp, "# Written by cupsd on %s\n", temp);
 
@@ -1093,6 +1338,9 @@ cupsdSaveAllSubscriptions(void)
        sub;
        sub = (cupsd_subscription_t *)cupsArrayNext(Subscriptions))
   {
+    snprintf(temp, sizeof(temp), "%d", sub->id);
+    fp = cupsdAddJournalRecord(j, temp);
+
     cupsFilePrintf(fp, "<Subscription %d>\n", sub->id);
 
     if ((name = cupsdEventName((cupsd_eventmask_t)sub->mask)) != NULL)
@@ -1171,7 +1419,7 @@ cupsdSaveAllSubscriptions(void)
     cupsFilePuts(fp, "</Subscription>\n");
   }
 
-  cupsdCloseCreatedConfFile(fp, filename);
+  cupsdEndJournal(j);
 }
 
 
@@ -1201,8 +1449,11 @@ cupsdStopAllNotifiers(void)
        sub = (cupsd_subscription_t *)cupsArrayNext(Subscriptions))
     if (sub->pid)
     {
+      cupsd_drain_batch(sub);
+
       cupsdEndProcess(sub->pid, 0);
 
+      cupsdRemoveSelect(sub->pipe);
       close(sub->pipe);
       sub->pipe = -1;
     }
@@ -1228,231 +1479,802 @@ cupsdStopAllNotifiers(void)
 
 
 /*
- * 'cupsd_compare_subscriptions()' - Compare two subscriptions.
+ * 'cupsdUpdateSubscriptionTimer()' - Schedule the lease expiration and batch
+ *                                    timer for a subscription.
+ *
+ * This must be called whenever the "expire" or "batch_time" time is changed.
  */
 
-static int				/* O - Result of comparison */
-cupsd_compare_subscriptions(
-    cupsd_subscription_t *first,	/* I - First subscription object */
-    cupsd_subscription_t *second,	/* I - Second subscription object */
-    void                 *unused)	/* I - Unused user data pointer */
+void
+cupsdUpdateSubscriptionTimer(
+    cupsd_subscription_t *sub)		/* I - Subscription object */
 {
-  (void)unused;
-
-  return (first->id - second->id);
-}
+  time_t	expire;			/* Lease expiration time */
 
 
-/*
- * 'cupsd_delete_event()' - Delete a single event...
- *
- * Oldest events must be deleted first, otherwise the subscription cache
- * flushing code will not work properly.
- */
+  expire = (!sub->job && sub->expire) ? sub->expire : 0;
 
-static void
-cupsd_delete_event(cupsd_event_t *event)/* I - Event to delete */
-{
- /*
-  * Free memory...
-  */
+  if (sub->batch_time && (!expire || sub->batch_time < expire))
+    expire = sub->batch_time;
 
-  ippDelete(event->attrs);
-  free(event);
+  if (sub->timer)
+    cupsdSetTimer(sub->timer, expire);
+  else if (expire)
+    sub->timer = cupsdAddTimer(expire,
+                               (cupsd_timerfunc_t)cupsd_expire_subscription,
+			       sub);
 }
 
 
-#ifdef HAVE_DBUS
 /*
- * 'cupsd_send_dbus()' - Send a DBUS notification...
+ * 'cupsd_cache_event()' - Add an event to the event cache.
+ *
+ * The event cache takes over the event, which is freed right away if events
+ * are not being cached.
  */
 
 static void
-cupsd_send_dbus(cupsd_eventmask_t event,/* I - Event to send */
-                cupsd_printer_t   *dest,/* I - Destination, if any */
-                cupsd_job_t       *job)	/* I - Job, if any */
+cupsd_cache_event(cupsd_event_t *event)	/* I - Event */
 {
-  DBusError		error;		/* Error, if any */
-  DBusMessage		*message;	/* Message to send */
-  DBusMessageIter	iter;		/* Iterator for message data */
-  const char		*what;		/* What to send */
-  static DBusConnection	*con = NULL;	/* Connection to DBUS server */
+  int		serial;			/* Current serial number */
+  cupsd_event_t	**cache;		/* New event cache */
 
 
- /*
-  * Figure out what to send, if anything...
-  */
+  if (EventCacheSize <= 0)
+  {
+   /*
+    * Not caching events...
+    */
 
-  if (event & CUPSD_EVENT_PRINTER_ADDED)
-    what = "PrinterAdded";
-  else if (event & CUPSD_EVENT_PRINTER_DELETED)
-    what = "PrinterRemoved";
-  else if (event & CUPSD_EVENT_PRINTER_CHANGED)
-    what = "QueueChanged";
-  else if (event & CUPSD_EVENT_JOB_CREATED)
-    what = "JobQueuedLocal";
-  else if ((event & CUPSD_EVENT_JOB_STATE) && job &&
-           job->state_value == IPP_JOB_PROCESSING)
-    what = "JobStartedLocal";
-  else
+    cupsd_flush_events();
+    cupsd_free_event(event);
     return;
-
- /*
-  * Verify connection to DBUS server...
-  */
-
-  if (con && !dbus_connection_get_is_connected(con))
-  {
-    dbus_connection_unref(con);
-    con = NULL;
   }
-
-  if (!con)
+  else if (EventCacheSize != event_size)
   {
-    dbus_error_init(&error);
+   /*
+    * Resize the cache, keeping the newest events...
+    */
 
-    con = dbus_bus_get(getuid() ? DBUS_BUS_SESSION : DBUS_BUS_SYSTEM, &error);
-    if (!con)
+    if ((cache = calloc((size_t)EventCacheSize, sizeof(cupsd_event_t *))) == NULL)
     {
-      dbus_error_free(&error);
+      cupsdLogMessage(CUPSD_LOG_CRIT,
+		      "Unable to allocate memory for event cache - %s",
+		      strerror(errno));
+      cupsd_flush_events();
+      cupsd_free_event(event);
       return;
     }
+
+    for (serial = event->serial - event_count; serial < event->serial; serial ++)
+    {
+      if (serial <= event->serial - EventCacheSize)
+        cupsd_free_event(event_cache[serial % event_size]);
+      else
+        cache[serial % EventCacheSize] = event_cache[serial % event_size];
+    }
+
+    if (event_count >= EventCacheSize)
+      event_count = EventCacheSize - 1;
+
+    free(event_cache);
+
+    event_cache = cache;
+    event_size  = EventCacheSize;
   }
 
  /*
-  * Create and send the new message...
+  * Replace the oldest event as needed...
   */
 
-  message = dbus_message_new_signal("/com/redhat/PrinterSpooler",
-				    "com.redhat.PrinterSpooler", what);
+  if (event_count == event_size)
+    cupsd_free_event(event_cache[event->serial % event_size]);
+  else
+    event_count ++;
 
-  dbus_message_append_iter_init(message, &iter);
-  if (dest)
-    dbus_message_iter_append_string(&iter, dest->name);
-  if (job)
-  {
-    dbus_message_iter_append_uint32(&iter, job->id);
-    dbus_message_iter_append_string(&iter, job->username);
-  }
+  event_cache[event->serial % event_size] = event;
+}
 
-  dbus_connection_send(con, message, NULL);
-  dbus_connection_flush(con);
-  dbus_message_unref(message);
+
+/*
+ * 'cupsd_compare_subindex()' - Compare two subscription index entries.
+ */
+
+static int				/* O - Result of comparison */
+cupsd_compare_subindex(
+    cupsd_subindex_t *first,		/* I - First index entry */
+    cupsd_subindex_t *second,		/* I - Second index entry */
+    void             *unused)		/* I - Unused user data pointer */
+{
+  (void)unused;
+
+  if (first->key < second->key)
+    return (-1);
+  else if (first->key > second->key)
+    return (1);
+  else if (first->bit < second->bit)
+    return (-1);
+  else
+    return (first->bit > second->bit);
 }
-#endif /* HAVE_DBUS */
 
 
 /*
- * 'cupsd_send_notification()' - Send a notification for the specified event.
+ * 'cupsd_compare_subscriptions()' - Compare two subscriptions.
+ */
+
+static int				/* O - Result of comparison */
+cupsd_compare_subscriptions(
+    cupsd_subscription_t *first,	/* I - First subscription object */
+    cupsd_subscription_t *second,	/* I - Second subscription object */
+    void                 *unused)	/* I - Unused user data pointer */
+{
+  (void)unused;
+
+  return (first->id - second->id);
+}
+
+
+/*
+ * 'cupsd_copy_event()' - Copy an event notification for a subscription.
+ *
+ * The notify-subscription-id, notify-sequence-number, and notify-user-data
+ * attributes are added after the first CUPSD_EVENT_PREFIX attributes, like
+ * cupsd_queue_event() does for the notifiers.
  */
 
 static void
-cupsd_send_notification(
+cupsd_copy_event(
+    ipp_t                *ipp,		/* I - Destination message */
     cupsd_subscription_t *sub,		/* I - Subscription object */
-    cupsd_event_t        *event)	/* I - Event to send */
+    cupsd_event_t        *event,	/* I - Event */
+    int                  sequence)	/* I - notify-sequence-number */
 {
-  ipp_state_t	state;			/* IPP event state */
+  ipp_attribute_t	*attr;		/* Current attribute */
+  int			count = 0;	/* Number of attributes copied */
 
 
-  cupsdLogMessage(CUPSD_LOG_DEBUG2,
-                  "cupsd_send_notification(sub=%p(%d), event=%p(%s))",
-                  sub, sub->id, event, cupsdEventName(event->event));
+  for (attr = event->attrs->attrs; attr; attr = attr->next)
+  {
+    if (!attr->name)
+      continue;
+
+    ippCopyAttribute(ipp, attr, 0);
+
+    if (++ count == CUPSD_EVENT_PREFIX)
+    {
+      ippAddInteger(ipp, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
+		    "notify-subscription-id", sub->id);
+      ippAddInteger(ipp, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER,
+		    "notify-sequence-number", sequence);
+
+      if (sub->user_data_len > 0)
+	ippAddOctetString(ipp, IPP_TAG_EVENT_NOTIFICATION, "notify-user-data",
+			  sub->user_data, sub->user_data_len);
+    }
+  }
+}
 
- /*
-  * Allocate the events array as needed...
-  */
 
-  if (!sub->events)
+/*
+ * 'cupsd_drain_batch()' - Write the rest of a notifier batch before closing
+ *                         the pipe.
+ *
+ * The pipe is non-blocking, so this waits up to CUPSD_BATCH_DRAIN seconds for
+ * the notifier to read the batch.  Any events that could not be written are
+ * logged.
+ */
+
+static void
+cupsd_drain_batch(
+    cupsd_subscription_t *sub)		/* I - Subscription object */
+{
+  struct pollfd	pfd;			/* Polled pipe */
+  time_t	deadline;		/* When to give up */
+  int		timeout,		/* Remaining time in seconds */
+		ret;			/* Return value from poll() */
+  ssize_t	bytes;			/* Bytes written */
+
+
+  deadline   = time(NULL) + CUPSD_BATCH_DRAIN;
+  pfd.fd     = sub->pipe;
+  pfd.events = POLLOUT;
+
+  while (sub->pipe >= 0 && sub->batch_sent < sub->batch_used &&
+         (timeout = (int)(deadline - time(NULL))) > 0)
   {
-    sub->events = cupsArrayNew3((cups_array_func_t)NULL, NULL,
-                                (cups_ahash_func_t)NULL, 0,
-				(cups_acopy_func_t)NULL,
-				(cups_afree_func_t)cupsd_delete_event);
+    if ((ret = poll(&pfd, 1, timeout * 1000)) < 0 && errno == EINTR)
+      continue;
+    else if (ret <= 0)
+      break;
 
-    if (!sub->events)
+    if ((bytes = write(sub->pipe, sub->batch + sub->batch_sent,
+                       sub->batch_used - sub->batch_sent)) < 0)
     {
-      cupsdLogMessage(CUPSD_LOG_CRIT,
-                      "Unable to allocate memory for subscription #%d!",
-                      sub->id);
-      return;
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+        continue;
+
+      break;
     }
+
+    sub->batch_sent += (size_t)bytes;
+  }
+
+  cupsd_reset_batch(sub);
+}
+
+
+/*
+ * 'cupsd_encode_attr()' - Encode a single-valued attribute.
+ */
+
+static ipp_uchar_t *			/* O - Next byte in buffer */
+cupsd_encode_attr(
+    ipp_uchar_t *bufptr,		/* I - Buffer */
+    ipp_tag_t   value_tag,		/* I - Value tag */
+    const char  *name,			/* I - Attribute name */
+    const void  *value,			/* I - Value */
+    size_t      length)			/* I - Length of value */
+{
+  size_t	namelen = strlen(name);	/* Length of name */
+
+
+  *bufptr++ = (ipp_uchar_t)value_tag;
+  *bufptr++ = (ipp_uchar_t)(namelen >> 8);
+  *bufptr++ = (ipp_uchar_t)namelen;
+  memcpy(bufptr, name, namelen);
+  bufptr += namelen;
+  *bufptr++ = (ipp_uchar_t)(length >> 8);
+  *bufptr++ = (ipp_uchar_t)length;
+  memcpy(bufptr, value, length);
+  bufptr += length;
+
+  return (bufptr);
+}
+
+
+/*
+ * 'cupsd_encode_event()' - Encode an event notification for the notifiers.
+ *
+ * The message is encoded once and shared by all of the notifiers; the
+ * subscription attributes are inserted after the first CUPSD_EVENT_PREFIX
+ * attributes by cupsd_queue_event().
+ */
+
+static int				/* O - 1 on success, 0 on error */
+cupsd_encode_event(
+    cupsd_event_t *event)		/* I - Event */
+{
+  int		i;			/* Looping var */
+  cupsd_evbuf_t	buffer;			/* Write buffer */
+  size_t	length;			/* Length of attribute */
+
+
+  event->datalen = ippLength(event->attrs);
+
+  if ((event->data = malloc(event->datalen)) == NULL)
+    return (0);
+
+  buffer.ptr = event->data;
+  buffer.end = event->data + event->datalen;
+
+  event->attrs->state = IPP_STATE_IDLE;
+
+  if (ippWriteIO(&buffer, (ipp_iocb_t)cupsd_write_buffer, 1, NULL,
+                 event->attrs) != IPP_STATE_DATA || buffer.ptr != buffer.end)
+  {
+    free(event->data);
+    event->data = NULL;
+    return (0);
   }
 
  /*
-  * Purge an old event as needed...
+  * Skip the message header, group tag, and the first CUPSD_EVENT_PREFIX
+  * attributes...
   */
 
-  if (cupsArrayCount(sub->events) >= MaxEvents)
+  event->prefixlen = 9;
+
+  for (i = 0; i < CUPSD_EVENT_PREFIX; i ++)
+  {
+    length           = (size_t)((event->data[event->prefixlen + 1] << 8) | event->data[event->prefixlen + 2]);
+    event->prefixlen += 3 + length;
+    length           = (size_t)((event->data[event->prefixlen] << 8) | event->data[event->prefixlen + 1]);
+    event->prefixlen += 2 + length;
+  }
+
+  return (1);
+}
+
+
+/*
+ * 'cupsd_expire_subscription()' - Write pending notifications and expire a
+ *                                 subscription when its lease runs out.
+ */
+
+static void
+cupsd_expire_subscription(
+    cupsd_subscription_t *sub)		/* I - Subscription object */
+{
+  time_t	curtime = time(NULL);	/* Current time */
+
+
+  if (sub->batch_time && sub->batch_time <= curtime)
+    cupsd_write_batch(sub);
+
+  if (sub->job || !sub->expire || sub->expire > curtime)
   {
    /*
-    * Purge the oldest event in the cache...
+    * No lease or lease was renewed...
     */
 
-    cupsArrayRemove(sub->events, cupsArrayFirst(sub->events));
+    cupsdUpdateSubscriptionTimer(sub);
+    return;
+  }
+
+  cupsdLogMessage(CUPSD_LOG_INFO, "Subscription %d has expired...", sub->id);
+
+  cupsdDeleteSubscription(sub, 0);
+
+  cupsdMarkDirty(CUPSD_DIRTY_SUBSCRIPTIONS);
+}
+
+
+/*
+ * 'cupsd_find_recipient()' - Find the recipient entry for a subscription.
+ */
+
+static cupsd_recipient_t *		/* O - Recipient or @code NULL@ */
+cupsd_find_recipient(
+    cupsd_event_t *event,		/* I - Event */
+    int           id)			/* I - Subscription ID */
+{
+  int	left,				/* Left side of search */
+	right,				/* Right side of search */
+	current;			/* Current element */
+
 
-    sub->first_event_id ++;
+  for (left = 0, right = event->num_recipients - 1; left <= right;)
+  {
+    current = (left + right) / 2;
+
+    if (event->recipients[current].id == id)
+      return (event->recipients + current);
+    else if (event->recipients[current].id < id)
+      left = current + 1;
+    else
+      right = current - 1;
   }
 
+  return (NULL);
+}
+
+
+/*
+ * 'cupsd_find_subscriptions()' - Add the subscriptions for an index key to
+ *                                an array of matches.
+ */
+
+static void
+cupsd_find_subscriptions(
+    cups_array_t *matches,		/* I - Matching subscriptions */
+    cups_array_t *index,		/* I - Index */
+    const void   *key,			/* I - Printer or job */
+    unsigned     bit)			/* I - Event bit */
+{
+  cupsd_subindex_t	ikey,		/* Search key */
+			*entry;		/* Index entry */
+  cupsd_subscription_t	*sub;		/* Current subscription */
+
+
+  ikey.key = key;
+  ikey.bit = bit;
+
+  if ((entry = (cupsd_subindex_t *)cupsArrayFind(index, &ikey)) == NULL)
+    return;
+
+  for (sub = (cupsd_subscription_t *)cupsArrayFirst(entry->subs);
+       sub;
+       sub = (cupsd_subscription_t *)cupsArrayNext(entry->subs))
+    if (!cupsArrayFind(matches, sub))
+      cupsArrayAdd(matches, sub);
+}
+
+
+/*
+ * 'cupsd_flush_events()' - Remove all events from the event cache.
+ */
+
+static void
+cupsd_flush_events(void)
+{
+  int	serial;				/* Current serial number */
+
+
+  for (serial = event_serial - event_count + 1; serial <= event_serial; serial ++)
+    cupsd_free_event(event_cache[serial % event_size]);
+
+  free(event_cache);
+
+  event_cache = NULL;
+  event_size  = 0;
+  event_count = 0;
+}
+
+
+/*
+ * 'cupsd_free_event()' - Free an event.
+ */
+
+static void
+cupsd_free_event(cupsd_event_t *event)	/* I - Event to free */
+{
+  ippDelete(event->attrs);
+  free(event->recipients);
+  free(event->data);
+  free(event);
+}
+
+
+/*
+ * 'cupsd_index_subscription()' - Add a subscription to the event indices.
+ *
+ * The indexed mask, printer, and job are saved so that the subscription can
+ * be found again when it is changed or deleted.
+ */
+
+static void
+cupsd_index_subscription(
+    cupsd_subscription_t *sub)		/* I - Subscription object */
+{
+  unsigned		bit;		/* Current event bit */
+  int			i;		/* Looping var */
+  cups_array_t		*index;		/* Current index */
+  cupsd_subindex_t	ikey,		/* Search key */
+			*entry;		/* Index entry */
+
+
+  cupsd_unindex_subscription(sub);
+
+  if (!sub_dest_index)
+    sub_dest_index = cupsArrayNew((cups_array_func_t)cupsd_compare_subindex,
+                                  NULL);
+  if (!sub_job_index)
+    sub_job_index = cupsArrayNew((cups_array_func_t)cupsd_compare_subindex,
+                                 NULL);
+
+  if (!sub_dest_index || !sub_job_index)
+  {
+    cupsdLogMessage(CUPSD_LOG_CRIT,
+                    "Unable to allocate memory for subscription index - %s",
+                    strerror(errno));
+    return;
+  }
+
+  for (bit = 1; bit & CUPSD_EVENT_ALL; bit <<= 1)
+  {
+    if (!(sub->mask & bit))
+      continue;
+
+    for (i = 0; i < 2; i ++)
+    {
+      if (i == 0)
+      {
+        index    = sub_dest_index;
+        ikey.key = sub->dest;
+      }
+      else if (sub->dest)
+      {
+        index    = sub_job_index;
+        ikey.key = sub->job;
+      }
+      else
+        break;
+
+      ikey.bit = bit;
+
+      if ((entry = (cupsd_subindex_t *)cupsArrayFind(index, &ikey)) == NULL)
+      {
+        if ((entry = calloc(1, sizeof(cupsd_subindex_t))) == NULL ||
+            (entry->subs = cupsArrayNew((cups_array_func_t)cupsd_compare_subscriptions, NULL)) == NULL)
+	{
+	  cupsdLogMessage(CUPSD_LOG_CRIT,
+			  "Unable to allocate memory for subscription index - "
+			  "%s", strerror(errno));
+          free(entry);
+	  return;
+	}
+
+        entry->key = ikey.key;
+	entry->bit = bit;
+
+	cupsArrayAdd(index, entry);
+      }
+
+      cupsArrayAdd(entry->subs, sub);
+    }
+
+    sub->index_mask |= bit;
+  }
+
+  sub->index_dest = sub->dest;
+  sub->index_job  = sub->job;
+}
+
+
+/*
+ * 'cupsd_queue_event()' - Add an event notification to a notifier batch.
+ */
+
+static int				/* O - 1 on success, 0 on error */
+cupsd_queue_event(
+    cupsd_subscription_t *sub,		/* I - Subscription object */
+    cupsd_event_t        *event,	/* I - Event */
+    int                  sequence)	/* I - notify-sequence-number */
+{
+  ipp_uchar_t	*bufptr,		/* Pointer into batch */
+		value[4];		/* Integer value */
+  size_t	length;			/* Maximum length of message */
+
+
+  if (!event->data && !cupsd_encode_event(event))
+    return (0);
+
  /*
-  * Add the event to the subscription.  Since the events array is
-  * always MaxEvents in length, and since we will have already
-  * removed an event from the subscription cache if we hit the
-  * event cache limit, we don't need to check for overflow here...
+  * Make room for the message, dropping it if the notifier has fallen too far
+  * behind...
   */
 
-  cupsArrayAdd(sub->events, event);
+  length = event->datalen + 2 * (5 + 22 + 4) + 5 + 16 + sizeof(sub->user_data);
+
+  if (sub->batch_sent > 0)
+  {
+    int	i, j;				/* Looping vars */
+
+    memmove(sub->batch, sub->batch + sub->batch_sent,
+            sub->batch_used - sub->batch_sent);
+
+    for (i = 0, j = 0; i < sub->batch_count; i ++)
+      if (sub->batch_ends[i] > sub->batch_sent)
+        sub->batch_ends[j ++] = sub->batch_ends[i] - sub->batch_sent;
+
+    sub->batch_count = j;
+    sub->batch_used -= sub->batch_sent;
+    sub->batch_sent  = 0;
+  }
+
+  if (sub->batch_used + length > CUPSD_BATCH_MAX)
+    return (0);
+
+  if (sub->batch_used + length > sub->batch_size)
+  {
+    ipp_uchar_t	*batch;			/* New batch buffer */
+    size_t	size;			/* New size of batch buffer */
+
+    for (size = sub->batch_size ? sub->batch_size : 8192;
+         size < sub->batch_used + length;
+	 size *= 2);
+
+    if ((batch = realloc(sub->batch, size)) == NULL)
+      return (0);
+
+    sub->batch      = batch;
+    sub->batch_size = size;
+  }
+
+  if (sub->batch_count >= sub->batch_alloc)
+  {
+    size_t	*ends;			/* New message ends */
+    int		alloc;			/* New number of message ends */
+
+    alloc = sub->batch_alloc ? 2 * sub->batch_alloc : 16;
+
+    if ((ends = realloc(sub->batch_ends, (size_t)alloc * sizeof(size_t))) == NULL)
+      return (0);
+
+    sub->batch_ends  = ends;
+    sub->batch_alloc = alloc;
+  }
 
  /*
-  * Deliver the event...
+  * Copy the shared message, inserting notify-subscription-id,
+  * notify-sequence-number, and notify-user-data...
   */
 
-  if (sub->recipient)
+  bufptr = sub->batch + sub->batch_used;
+
+  memcpy(bufptr, event->data, event->prefixlen);
+  bufptr += event->prefixlen;
+
+  value[0] = (ipp_uchar_t)(sub->id >> 24);
+  value[1] = (ipp_uchar_t)(sub->id >> 16);
+  value[2] = (ipp_uchar_t)(sub->id >> 8);
+  value[3] = (ipp_uchar_t)sub->id;
+
+  bufptr = cupsd_encode_attr(bufptr, IPP_TAG_INTEGER, "notify-subscription-id",
+                             value, 4);
+
+  value[0] = (ipp_uchar_t)(sequence >> 24);
+  value[1] = (ipp_uchar_t)(sequence >> 16);
+  value[2] = (ipp_uchar_t)(sequence >> 8);
+  value[3] = (ipp_uchar_t)sequence;
+
+  bufptr = cupsd_encode_attr(bufptr, IPP_TAG_INTEGER, "notify-sequence-number",
+                             value, 4);
+
+  if (sub->user_data_len > 0)
+    bufptr = cupsd_encode_attr(bufptr, IPP_TAG_STRING, "notify-user-data",
+                               sub->user_data, (size_t)sub->user_data_len);
+
+  memcpy(bufptr, event->data + event->prefixlen,
+         event->datalen - event->prefixlen);
+  bufptr += event->datalen - event->prefixlen;
+
+  sub->batch_used = (size_t)(bufptr - sub->batch);
+
+  sub->batch_ends[sub->batch_count ++] = sub->batch_used;
+
+  return (1);
+}
+
+
+/*
+ * 'cupsd_reset_batch()' - Reset a notifier batch, logging any events that
+ *                         were not written.
+ */
+
+static void
+cupsd_reset_batch(
+    cupsd_subscription_t *sub)		/* I - Subscription object */
+{
+  int	i,				/* Looping var */
+	dropped = 0;			/* Number of events dropped */
+
+
+  for (i = 0; i < sub->batch_count; i ++)
+    if (sub->batch_ends[i] > sub->batch_sent)
+      dropped ++;
+
+  if (dropped > 0)
+    cupsdLogMessage(CUPSD_LOG_WARN,
+                    "Dropped %d event(s) for subscription %d (%s).", dropped,
+		    sub->id, sub->recipient);
+
+  sub->batch_used  = sub->batch_sent = 0;
+  sub->batch_count = 0;
+  sub->batch_time  = 0;
+
+  if (sub->batch_size > CUPSD_BATCH_WRITE)
   {
-    for (;;)
+    free(sub->batch);
+
+    sub->batch      = NULL;
+    sub->batch_size = 0;
+  }
+}
+
+
+#ifdef HAVE_DBUS
+/*
+ * 'cupsd_send_dbus()' - Send a DBUS notification...
+ */
+
+static void
+cupsd_send_dbus(cupsd_eventmask_t event,/* I - Event to send */
+                cupsd_printer_t   *dest,/* I - Destination, if any */
+                cupsd_job_t       *job)	/* I - Job, if any */
+{
+  DBusError		error;		/* Error, if any */
+  DBusMessage		*message;	/* Message to send */
+  DBusMessageIter	iter;		/* Iterator for message data */
+  const char		*what;		/* What to send */
+  static DBusConnection	*con = NULL;	/* Connection to DBUS server */
+
+
+ /*
+  * Figure out what to send, if anything...
+  */
+
+  if (event & CUPSD_EVENT_PRINTER_ADDED)
+    what = "PrinterAdded";
+  else if (event & CUPSD_EVENT_PRINTER_DELETED)
+    what = "PrinterRemoved";
+  else if (event & CUPSD_EVENT_PRINTER_CHANGED)
+    what = "QueueChanged";
+  else if (event & CUPSD_EVENT_JOB_CREATED)
+    what = "JobQueuedLocal";
+  else if ((event & CUPSD_EVENT_JOB_STATE) && job &&
+           job->state_value == IPP_JOB_PROCESSING)
+    what = "JobStartedLocal";
+  else
+    return;
+
+ /*
+  * Verify connection to DBUS server...
+  */
+
+  if (con && !dbus_connection_get_is_connected(con))
+  {
+    dbus_connection_unref(con);
+    con = NULL;
+  }
+
+  if (!con)
+  {
+    dbus_error_init(&error);
+
+    con = dbus_bus_get(getuid() ? DBUS_BUS_SESSION : DBUS_BUS_SYSTEM, &error);
+    if (!con)
     {
-      if (sub->pipe < 0)
-	cupsd_start_notifier(sub);
+      dbus_error_free(&error);
+      return;
+    }
+  }
 
-      cupsdLogMessage(CUPSD_LOG_DEBUG2, "sub->pipe=%d", sub->pipe);
+ /*
+  * Create and send the new message...
+  */
 
-      if (sub->pipe < 0)
-	break;
+  message = dbus_message_new_signal("/com/redhat/PrinterSpooler",
+				    "com.redhat.PrinterSpooler", what);
 
-      event->attrs->state = IPP_IDLE;
+  dbus_message_append_iter_init(message, &iter);
+  if (dest)
+    dbus_message_iter_append_string(&iter, dest->name);
+  if (job)
+  {
+    dbus_message_iter_append_uint32(&iter, job->id);
+    dbus_message_iter_append_string(&iter, job->username);
+  }
 
-      while ((state = ippWriteFile(sub->pipe, event->attrs)) != IPP_DATA)
-        if (state == IPP_ERROR)
-	  break;
+  dbus_connection_send(con, message, NULL);
+  dbus_connection_flush(con);
+  dbus_message_unref(message);
+}
+#endif /* HAVE_DBUS */
 
-      if (state == IPP_ERROR)
-      {
-        if (errno == EPIPE)
-	{
-	 /*
-	  * Notifier died, try restarting it...
-	  */
-
-          cupsdLogMessage(CUPSD_LOG_WARN,
-	                  "Notifier for subscription %d (%s) went away, "
-			  "retrying!",
-			  sub->id, sub->recipient);
-	  cupsdEndProcess(sub->pid, 0);
-
-	  close(sub->pipe);
-	  sub->pipe = -1;
-          continue;
-	}
 
+/*
+ * 'cupsd_send_notification()' - Send a notification for the specified event.
+ */
+
+static void
+cupsd_send_notification(
+    cupsd_subscription_t *sub,		/* I - Subscription object */
+    cupsd_event_t        *event)	/* I - Event to send */
+{
+  cupsdLogMessage(CUPSD_LOG_DEBUG2,
+                  "cupsd_send_notification(sub=%p(%d), event=%p(%s))",
+                  sub, sub->id, event, cupsdEventName(event->event));
+
+  sub->last_serial = event->serial;
+
+ /*
+  * Add the event to the notifier's batch, writing it now if batching is
+  * disabled or enough messages are pending...
+  */
+
+  if (sub->recipient)
+  {
+    if (sub->pipe < 0)
+      cupsd_start_notifier(sub);
+
+    cupsdLogMessage(CUPSD_LOG_DEBUG2, "sub->pipe=%d", sub->pipe);
+
+    if (sub->pipe >= 0)
+    {
+      if (!cupsd_queue_event(sub, event, sub->next_event_id))
         cupsdLogMessage(CUPSD_LOG_ERROR,
 	                "Unable to send event for subscription %d (%s)!",
 			sub->id, sub->recipient);
+      else if (NotifierBatchInterval <= 0 ||
+               (sub->batch_used - sub->batch_sent) >= CUPSD_BATCH_WRITE)
+        cupsd_write_batch(sub);
+      else if (!sub->batch_time)
+      {
+        sub->batch_time = time(NULL) + NotifierBatchInterval;
+	cupsdUpdateSubscriptionTimer(sub);
       }
-
-     /*
-      * If we get this far, break out of the loop...
-      */
-
-      break;
     }
   }
 
@@ -1587,6 +2409,69 @@ cupsd_start_notifier(
 }
 
 
+/*
+ * 'cupsd_unindex_key()' - Remove a subscription from an index.
+ */
+
+static void
+cupsd_unindex_key(
+    cups_array_t         *index,	/* I - Index */
+    const void           *key,		/* I - Printer or job */
+    unsigned             mask,		/* I - Indexed event mask */
+    cupsd_subscription_t *sub)		/* I - Subscription object */
+{
+  unsigned		bit;		/* Current event bit */
+  cupsd_subindex_t	ikey,		/* Search key */
+			*entry;		/* Index entry */
+
+
+  ikey.key = key;
+
+  for (bit = 1; bit & CUPSD_EVENT_ALL; bit <<= 1)
+  {
+    if (!(mask & bit))
+      continue;
+
+    ikey.bit = bit;
+
+    if ((entry = (cupsd_subindex_t *)cupsArrayFind(index, &ikey)) == NULL)
+      continue;
+
+    cupsArrayRemove(entry->subs, sub);
+
+    if (cupsArrayCount(entry->subs) == 0)
+    {
+      cupsArrayRemove(index, entry);
+      cupsArrayDelete(entry->subs);
+      free(entry);
+    }
+  }
+}
+
+
+/*
+ * 'cupsd_unindex_subscription()' - Remove a subscription from the event
+ *                                  indices.
+ */
+
+static void
+cupsd_unindex_subscription(
+    cupsd_subscription_t *sub)		/* I - Subscription object */
+{
+  if (!sub->index_mask)
+    return;
+
+  cupsd_unindex_key(sub_dest_index, sub->index_dest, sub->index_mask, sub);
+
+  if (sub->index_dest)
+    cupsd_unindex_key(sub_job_index, sub->index_job, sub->index_mask, sub);
+
+  sub->index_mask = 0;
+  sub->index_dest = NULL;
+  sub->index_job  = NULL;
+}
+
+
 /*
  * 'cupsd_update_notifier()' - Read messages from notifiers.
  */
@@ -1608,3 +2493,100 @@ cupsd_update_notifier(void)
       break;
   }
 }
+
+
+/*
+ * 'cupsd_write_batch()' - Write pending notification messages to a notifier.
+ */
+
+static void
+cupsd_write_batch(
+    cupsd_subscription_t *sub)		/* I - Subscription object */
+{
+  ssize_t	bytes;			/* Bytes written */
+  int		restarted = 0;		/* Restarted notifier? */
+
+
+  sub->batch_time = 0;
+
+  while (sub->batch_sent < sub->batch_used)
+  {
+    if (sub->pipe < 0)
+      cupsd_start_notifier(sub);
+
+    if (sub->pipe < 0)
+      break;
+
+    if ((bytes = write(sub->pipe, sub->batch + sub->batch_sent,
+                       sub->batch_used - sub->batch_sent)) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+       /*
+        * Pipe is full, write the rest once the notifier catches up...
+	*/
+
+        cupsdAddSelect(sub->pipe, NULL, (cupsd_selfunc_t)cupsd_write_batch,
+	               sub);
+        return;
+      }
+
+      if (errno == EPIPE && !sub->batch_sent && !restarted)
+      {
+       /*
+	* Notifier died, try restarting it...
+	*/
+
+	cupsdLogMessage(CUPSD_LOG_WARN,
+			"Notifier for subscription %d (%s) went away, "
+			"retrying!",
+			sub->id, sub->recipient);
+	cupsdEndProcess(sub->pid, 0);
+
+        cupsdRemoveSelect(sub->pipe);
+	close(sub->pipe);
+	sub->pipe = -1;
+	restarted = 1;
+	continue;
+      }
+
+      cupsdLogMessage(CUPSD_LOG_ERROR,
+		      "Unable to send event for subscription %d (%s)!",
+		      sub->id, sub->recipient);
+      break;
+    }
+
+    sub->batch_sent += (size_t)bytes;
+  }
+
+ /*
+  * Batch written (or dropped), reset it...
+  */
+
+  cupsdRemoveSelect(sub->pipe);
+
+  cupsd_reset_batch(sub);
+}
+
+
+/*
+ * 'cupsd_write_buffer()' - Copy encoded IPP data to a buffer.
+ */
+
+static ssize_t				/* O - Number of bytes copied */
+cupsd_write_buffer(
+    cupsd_evbuf_t *buffer,		/* I - Buffer */
+    ipp_uchar_t   *data,		/* I - Data to copy */
+    size_t        bytes)		/* I - Number of bytes */
+{
+  if (bytes > (size_t)(buffer->end - buffer->ptr))
+    return (-1);
+
+  memcpy(buffer->ptr, data, bytes);
+  buffer->ptr += bytes;
+
+  return ((ssize_t)bytes);
+}
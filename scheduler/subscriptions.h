@@ -67,13 +67,25 @@ typedef enum
  * Notiification support structures...
  */
 
+typedef struct cupsd_recipient_s	/**** Event recipient ****/
+{
+  int			id,		/* notify-subscription-id */
+			sequence;	/* notify-sequence-number */
+} cupsd_recipient_t;
+
 typedef struct cupsd_event_s		/**** Event structure ****/
 {
+  int			serial;		/* Position in event cache */
   cupsd_eventmask_t	event;		/* Event */
   time_t		time;		/* Time of event */
-  ipp_t			*attrs;		/* Notification message */
-  cupsd_printer_t	*dest;		/* Associated printer, if any */
-  cupsd_job_t		*job;		/* Associated job, if any */
+  ipp_t			*attrs;		/* Notification message, without the
+					 * subscription attributes */
+  int			num_recipients;	/* Number of recipients */
+  cupsd_recipient_t	*recipients;	/* Recipients, sorted by ID */
+  ipp_uchar_t		*data;		/* Encoded notification message */
+  size_t		datalen,	/* Length of encoded message */
+			prefixlen;	/* Length of header, charset, and
+					 * language */
 } cupsd_event_t;
 
 typedef struct cupsd_subscription_s	/**** Subscription structure ****/
@@ -93,9 +105,20 @@ typedef struct cupsd_subscription_s	/**** Subscription structure ****/
   int			status;		/* Exit status of notifier */
   time_t		last;		/* Time of last notification */
   time_t		expire;		/* Lease expiration time */
-  int			first_event_id,	/* First event-id in cache */
-			next_event_id;	/* Next event-id to use */
-  cups_array_t		*events;	/* Cached events */
+  cupsd_timer_t		*timer;		/* Timer for lease expiration */
+  int			next_event_id,	/* Next event-id to use */
+			last_serial;	/* Serial number of last event */
+  unsigned		index_mask;	/* Indexed event mask */
+  cupsd_printer_t	*index_dest;	/* Indexed printer */
+  cupsd_job_t		*index_job;	/* Indexed job */
+  ipp_uchar_t		*batch;		/* Pending notification messages */
+  size_t		batch_size,	/* Size of batch buffer */
+			batch_used,	/* Bytes used in batch buffer */
+			batch_sent,	/* Bytes already written to notifier */
+			*batch_ends;	/* End of each message in batch */
+  int			batch_count,	/* Number of messages in batch */
+			batch_alloc;	/* Allocated message ends */
+  time_t		batch_time;	/* When to write pending messages */
 } cupsd_subscription_t;
 
 
@@ -121,6 +144,10 @@ VAR cups_array_t *Subscriptions VALUE(NULL);
 					/* Active subscriptions */
 
 VAR int		MaxEvents VALUE(100);	/* Maximum number of events */
+VAR int		EventCacheSize VALUE(1000);
+					/* Number of events to cache */
+VAR int		NotifierBatchInterval VALUE(0);
+					/* Seconds to collect notifier messages */
 
 VAR unsigned	LastEvent VALUE(0);	/* Last event(s) processed */
 VAR int		NotifierPipes[2] VALUE2(-1, -1);
@@ -139,6 +166,8 @@ extern cupsd_subscription_t *
 		cupsdAddSubscription(unsigned mask, cupsd_printer_t *dest,
 		                     cupsd_job_t *job, const char *uri,
 				     int sub_id);
+extern void	cupsdCopyEvents(ipp_t *ipp, cupsd_subscription_t *sub,
+		                int min_seq);
 extern void	cupsdDeleteAllSubscriptions(void);
 extern void	cupsdDeleteSubscription(cupsd_subscription_t *sub, int update);
 extern const char *
@@ -153,3 +182,4 @@ extern void	cupsdExpireSubscriptions(cupsd_printer_t *dest,
 extern void	cupsdLoadAllSubscriptions(void);
 extern void	cupsdSaveAllSubscriptions(void);
 extern void	cupsdStopAllNotifiers(void);
+extern void	cupsdUpdateSubscriptionTimer(cupsd_subscription_t *sub);
@@ -67,6 +67,9 @@ cupsdCleanDirty(void)
   if (DirtyFiles & CUPSD_DIRTY_SUBSCRIPTIONS)
     cupsdSaveAllSubscriptions();
 
+  if (DirtyFiles & CUPSD_DIRTY_QUOTAS)
+    cupsdSaveQuotas();
+
   DirtyFiles     = CUPSD_DIRTY_NONE;
   DirtyCleanTime = 0;
 
@@ -81,12 +84,13 @@ cupsdCleanDirty(void)
 void
 cupsdMarkDirty(int what)		/* I - What file(s) are dirty? */
 {
-  cupsdLogMessage(CUPSD_LOG_DEBUG, "cupsdMarkDirty(%c%c%c%c%c)",
+  cupsdLogMessage(CUPSD_LOG_DEBUG, "cupsdMarkDirty(%c%c%c%c%c%c)",
 		  (what & CUPSD_DIRTY_PRINTERS) ? 'P' : '-',
 		  (what & CUPSD_DIRTY_CLASSES) ? 'C' : '-',
 		  (what & CUPSD_DIRTY_PRINTCAP) ? 'p' : '-',
 		  (what & CUPSD_DIRTY_JOBS) ? 'J' : '-',
-		  (what & CUPSD_DIRTY_SUBSCRIPTIONS) ? 'S' : '-');
+		  (what & CUPSD_DIRTY_SUBSCRIPTIONS) ? 'S' : '-',
+		  (what & CUPSD_DIRTY_QUOTAS) ? 'Q' : '-');
 
   if (what == CUPSD_DIRTY_PRINTCAP && !Printcap)
     return;
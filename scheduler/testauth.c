@@ -0,0 +1,615 @@
+/*
+ * Authorization test program for the CUPS scheduler.
+ *
+ * Licensed under Apache License v2.0.  See the file "LICENSE" for more information.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#define _MAIN_C_
+#include "cupsd.h"
+#include <grp.h>
+
+
+/*
+ * Local globals...
+ */
+
+static const char	*report_name = NULL;
+					/* Report value to capture */
+static int		report_value = -1;
+					/* Captured report value */
+
+
+/*
+ * Local functions...
+ */
+
+static cupsd_location_t	*add_location(const char *location, int limit);
+static int		get_report(const char *name);
+static int		test_auth_cache(void);
+static int		test_check_auth(void);
+static int		test_group_cache(void);
+static int		test_find_best(void);
+
+
+/*
+ * 'main()' - Main entry.
+ */
+
+int					/* O - Exit status */
+main(void)
+{
+  int	status = 0;			/* Exit status */
+
+
+  status += test_find_best();
+  status += test_check_auth();
+  status += test_auth_cache();
+  status += test_group_cache();
+
+  if (status)
+    printf("%d authorization tests failed.\n", status);
+  else
+    puts("All authorization tests passed.");
+
+  return (status ? 1 : 0);
+}
+
+
+/*
+ * 'cupsdDefaultAuthType()' - Get the default AuthType (stub).
+ */
+
+int					/* O - Default AuthType value */
+cupsdDefaultAuthType(void)
+{
+  return (CUPSD_AUTH_BASIC);
+}
+
+
+/*
+ * 'cupsdFindCert()' - Find a certificate (stub).
+ */
+
+cupsd_cert_t *				/* O - Matching certificate or NULL */
+cupsdFindCert(const char *certificate)	/* I - Certificate */
+{
+  (void)certificate;
+
+  return (NULL);
+}
+
+
+/*
+ * 'cupsdLogClient()' - Log a client message (stub).
+ */
+
+int					/* O - 1 on success */
+cupsdLogClient(cupsd_client_t *con,	/* I - Client connection */
+               int            level,	/* I - Log level */
+               const char     *message,	/* I - printf-style message string */
+               ...)			/* I - Additional arguments as needed */
+{
+  (void)con;
+  (void)level;
+  (void)message;
+
+  return (1);
+}
+
+
+/*
+ * 'cupsdLogMessage()' - Log a message (stub).
+ */
+
+int					/* O - 1 on success */
+cupsdLogMessage(int        level,	/* I - Log level */
+                const char *message,	/* I - printf-style message string */
+		...)			/* I - Additional args as needed */
+{
+  va_list	ap;			/* Argument pointer */
+  char		buffer[1024];		/* Formatted message */
+  size_t	namelen;		/* Length of report name */
+
+
+  (void)level;
+
+ /*
+  * Capture the value of the requested "Report: name=value" message...
+  */
+
+  if (report_name && !strncmp(message, "Report: ", 8))
+  {
+    va_start(ap, message);
+    vsnprintf(buffer, sizeof(buffer), message, ap);
+    va_end(ap);
+
+    namelen = strlen(report_name);
+
+    if (!strncmp(buffer + 8, report_name, namelen) && buffer[8 + namelen] == '=')
+      report_value = atoi(buffer + 9 + namelen);
+  }
+
+  return (1);
+}
+
+
+/*
+ * 'cupsdNetIFUpdate()' - Update the network interface list (stub).
+ */
+
+void
+cupsdNetIFUpdate(void)
+{
+}
+
+
+/*
+ * 'add_location()' - Add a location with the given limit.
+ */
+
+static cupsd_location_t *		/* O - New location */
+add_location(const char *location,	/* I - Location path */
+             int        limit)		/* I - Limit for requests */
+{
+  cupsd_location_t	*loc;		/* New location */
+
+
+  if ((loc = cupsdNewLocation(location)) == NULL)
+  {
+    perror(location);
+    exit(1);
+  }
+
+  loc->limit = limit;
+
+  cupsdAddLocation(loc);
+
+  return (loc);
+}
+
+
+/*
+ * 'get_report()' - Get a value logged by cupsdReportAuthCache().
+ */
+
+static int				/* O - Value or -1 if not logged */
+get_report(const char *name)		/* I - Name of value */
+{
+  report_name  = name;
+  report_value = -1;
+
+  cupsdReportAuthCache();
+
+  report_name = NULL;
+
+  return (report_value);
+}
+
+
+/*
+ * 'test_auth_cache()' - Test the Basic authentication cache.
+ */
+
+static int				/* O - Number of failed tests */
+test_auth_cache(void)
+{
+  int		i,			/* Looping var */
+		result,			/* Result of check */
+		status = 0;		/* Number of failed tests */
+  char		username[256];		/* Username */
+  unsigned char	hash[32];		/* Cache key */
+
+
+  AuthCacheTimeout = 1;
+
+  fputs("cupsdCheckAuthCache(miss): ", stdout);
+
+  if ((result = cupsdCheckAuthCache("client.example.com", "user", "password", hash)) == 0)
+    puts("PASS");
+  else
+  {
+    printf("FAIL (got %d, expected 0)\n", result);
+    status ++;
+  }
+
+  cupsdAddAuthCache(hash);
+
+  fputs("cupsdCheckAuthCache(hit): ", stdout);
+
+  if ((result = cupsdCheckAuthCache("client.example.com", "user", "password", hash)) == 1)
+    puts("PASS");
+  else
+  {
+    printf("FAIL (got %d, expected 1)\n", result);
+    status ++;
+  }
+
+  fputs("cupsdCheckAuthCache(wrong password): ", stdout);
+
+  if ((result = cupsdCheckAuthCache("client.example.com", "user", "wrong", hash)) == 0)
+    puts("PASS");
+  else
+  {
+    printf("FAIL (got %d, expected 0)\n", result);
+    status ++;
+  }
+
+  fputs("cupsdCheckAuthCache(other host): ", stdout);
+
+  if ((result = cupsdCheckAuthCache("other.example.com", "user", "password", hash)) == 0)
+    puts("PASS");
+  else
+  {
+    printf("FAIL (got %d, expected 0)\n", result);
+    status ++;
+  }
+
+ /*
+  * Let the entry expire...
+  */
+
+  sleep(2);
+
+  fputs("cupsdCheckAuthCache(expired): ", stdout);
+
+  if ((result = cupsdCheckAuthCache("client.example.com", "user", "password", hash)) != 0)
+  {
+    printf("FAIL (got %d, expected 0)\n", result);
+    status ++;
+  }
+  else if ((result = get_report("auth-cache-entries")) != 0)
+  {
+    printf("FAIL (%d entries, expected 0)\n", result);
+    status ++;
+  }
+  else
+    puts("PASS");
+
+ /*
+  * Fill the cache past its limit of 256 entries...
+  */
+
+  fputs("cupsdAddAuthCache(evict): ", stdout);
+
+  for (i = 0; i < 300; i ++)
+  {
+    snprintf(username, sizeof(username), "user%d", i);
+
+    if (!cupsdCheckAuthCache("client.example.com", username, "password", hash))
+      cupsdAddAuthCache(hash);
+  }
+
+  if ((result = get_report("auth-cache-entries")) != 256)
+  {
+    printf("FAIL (%d entries, expected 256)\n", result);
+    status ++;
+  }
+  else if ((result = cupsdCheckAuthCache("client.example.com", username, "password", hash)) != 1)
+  {
+    printf("FAIL (got %d for newest entry, expected 1)\n", result);
+    status ++;
+  }
+  else
+    puts("PASS");
+
+  cupsdClearAuthCache();
+
+  AuthCacheTimeout = 0;
+
+  return (status);
+}
+
+
+/*
+ * 'test_check_auth()' - Test address and hostname masks with
+ *                       cupsdCheckAuth(), both with and without an index.
+ */
+
+static int				/* O - Number of failed tests */
+test_check_auth(void)
+{
+  int			i,		/* Looping var */
+			indexed,	/* Check with an index? */
+			result,		/* Result of check */
+			status = 0;	/* Number of failed tests */
+  unsigned		filler[4],	/* Non-matching filler address */
+			hostmask[4] = { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff };
+					/* Netmask for a single host */
+  cupsd_location_t	*loc;		/* Location holding the masks */
+  char			name[256];	/* Name mask */
+  static const struct
+  {
+    const char	*label;			/* Description of mask */
+    unsigned	address[4],		/* Mask address */
+		netmask[4];		/* Mask netmask */
+    const char	*name;			/* Name mask or NULL for IP mask */
+    unsigned	ip[4];			/* Client address */
+    const char	*host;			/* Client hostname */
+    int		expected;		/* Expected result */
+  }			tests[] =	/* Checks to test */
+  {
+    { "0/0", { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, NULL,
+      { 0, 0, 0, 0x0a010203 }, "host.example.com", 1 },
+    { "0/0", { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, NULL,
+      { 0x20010db8, 0, 0, 1 }, "host6.example.com", 1 },
+    { "10.0.0.1/255.0.0.255", { 0, 0, 0, 0x0a000001 }, { 0xffffffff, 0xffffffff, 0xffffffff, 0xff0000ff }, NULL,
+      { 0, 0, 0, 0x0a090901 }, "host.example.com", 1 },
+    { "10.0.0.1/255.0.0.255", { 0, 0, 0, 0x0a000001 }, { 0xffffffff, 0xffffffff, 0xffffffff, 0xff0000ff }, NULL,
+      { 0, 0, 0, 0x0a090902 }, "host.example.com", 0 },
+    { "10.0.0.1/255.0.0.255", { 0, 0, 0, 0x0a000001 }, { 0xffffffff, 0xffffffff, 0xffffffff, 0xff0000ff }, NULL,
+      { 0, 0, 0, 0x0b090901 }, "host.example.com", 0 },
+    { "192.168.1.0/24", { 0, 0, 0, 0xc0a80100 }, { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffff00 }, NULL,
+      { 0, 0, 0, 0xc0a8014d }, "host.example.com", 1 },
+    { "192.168.1.0/24", { 0, 0, 0, 0xc0a80100 }, { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffff00 }, NULL,
+      { 0, 0, 0, 0xc0a80201 }, "host.example.com", 0 },
+    { "*.example.com", { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, "*.example.com",
+      { 0, 0, 0, 0x0a010203 }, "host.example.com", 1 },
+    { "*.example.com", { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, "*.example.com",
+      { 0, 0, 0, 0x0a010203 }, "HOST.Example.COM", 1 },
+    { "*.example.com", { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, "*.example.com",
+      { 0, 0, 0, 0x0a010203 }, "a.b.example.com", 1 },
+    { "*.example.com", { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, "*.example.com",
+      { 0, 0, 0, 0x0a010203 }, "example.com", 0 },
+    { "*.example.com", { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, "*.example.com",
+      { 0, 0, 0, 0x0a010203 }, "badexample.com", 0 },
+    { "printer.local", { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, "printer.local",
+      { 0, 0, 0, 0x0a010203 }, "Printer.Local", 1 },
+    { "printer.local", { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, "printer.local",
+      { 0, 0, 0, 0x0a010203 }, "host.printer.local", 0 }
+  };
+
+
+  for (i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i ++)
+  {
+    if ((loc = cupsdNewLocation("/")) == NULL)
+    {
+      perror("/");
+      exit(1);
+    }
+
+    if (tests[i].name)
+    {
+      strlcpy(name, tests[i].name, sizeof(name));
+      cupsdAddNameMask(&loc->allow, name);
+    }
+    else
+      cupsdAddIPMask(&loc->allow, tests[i].address, tests[i].netmask);
+
+    for (indexed = 0; indexed < 2; indexed ++)
+    {
+      if (indexed)
+      {
+       /*
+        * Pad the masks with hosts on 192.0.2.0/24 (TEST-NET-1) so that
+	* cupsdCheckAuth() builds an index...
+	*/
+
+        filler[0] = filler[1] = filler[2] = 0;
+
+	for (filler[3] = 0xc0000201; cupsArrayCount(loc->allow) < 8; filler[3] ++)
+	  cupsdAddIPMask(&loc->allow, filler, hostmask);
+      }
+
+      printf("cupsdCheckAuth(%s, \"%s\", %s): ", tests[i].label, tests[i].host, indexed ? "indexed" : "linear");
+
+      result = cupsdCheckAuth((unsigned *)tests[i].ip, tests[i].host, strlen(tests[i].host), loc->allow);
+
+      if (result == tests[i].expected)
+        puts("PASS");
+      else
+      {
+        printf("FAIL (got %d, expected %d)\n", result, tests[i].expected);
+        status ++;
+      }
+    }
+
+    cupsdFreeLocation(loc);
+  }
+
+  return (status);
+}
+
+
+/*
+ * 'test_group_cache()' - Test the group membership cache.
+ */
+
+static int				/* O - Number of failed tests */
+test_group_cache(void)
+{
+  int		i,			/* Looping var */
+		result,			/* Result of check */
+		status = 0;		/* Number of failed tests */
+  struct passwd	*user;			/* Current user */
+  struct group	*group;			/* Primary group of current user */
+  char		username[256],		/* Username */
+		groupname[256];		/* Group name */
+
+
+  if ((user = getpwuid(getuid())) == NULL || (group = getgrgid(user->pw_gid)) == NULL)
+  {
+    puts("cupsdCheckGroup: SKIP (no user or group)");
+    return (0);
+  }
+
+  strlcpy(username, user->pw_name, sizeof(username));
+  strlcpy(groupname, group->gr_name, sizeof(groupname));
+
+  GroupCacheTimeout = 1;
+
+  fputs("cupsdCheckGroup(miss): ", stdout);
+
+  if ((result = cupsdCheckGroup(username, user, groupname)) != 1)
+  {
+    printf("FAIL (got %d, expected 1)\n", result);
+    status ++;
+  }
+  else if ((result = get_report("group-cache-misses")) != 1)
+  {
+    printf("FAIL (%d misses, expected 1)\n", result);
+    status ++;
+  }
+  else
+    puts("PASS");
+
+  fputs("cupsdCheckGroup(hit): ", stdout);
+
+  if ((result = cupsdCheckGroup(username, user, groupname)) != 1)
+  {
+    printf("FAIL (got %d, expected 1)\n", result);
+    status ++;
+  }
+  else if ((result = get_report("group-cache-hits")) != 1)
+  {
+    printf("FAIL (%d hits, expected 1)\n", result);
+    status ++;
+  }
+  else
+    puts("PASS");
+
+ /*
+  * Let the entry expire...
+  */
+
+  sleep(2);
+
+  fputs("cupsdCheckGroup(expired): ", stdout);
+
+  if ((result = cupsdCheckGroup(username, user, groupname)) != 1)
+  {
+    printf("FAIL (got %d, expected 1)\n", result);
+    status ++;
+  }
+  else if ((result = get_report("group-cache-misses")) != 2)
+  {
+    printf("FAIL (%d misses, expected 2)\n", result);
+    status ++;
+  }
+  else if ((result = get_report("group-cache-entries")) != 1)
+  {
+    printf("FAIL (%d entries, expected 1)\n", result);
+    status ++;
+  }
+  else
+    puts("PASS");
+
+ /*
+  * Fill the cache past its limit of 1024 entries...
+  */
+
+  fputs("cupsdCheckGroup(evict): ", stdout);
+
+  for (i = 0; i < 1100; i ++)
+  {
+    snprintf(username, sizeof(username), "testauth%d", i);
+    cupsdCheckGroup(username, NULL, groupname);
+  }
+
+  if ((result = get_report("group-cache-entries")) != 1024)
+  {
+    printf("FAIL (%d entries, expected 1024)\n", result);
+    status ++;
+  }
+  else
+    puts("PASS");
+
+  cupsdClearAuthCache();
+
+  GroupCacheTimeout = 0;
+
+  return (status);
+}
+
+
+/*
+ * 'test_find_best()' - Test location lookups with cupsdFindBest().
+ */
+
+static int				/* O - Number of failed tests */
+test_find_best(void)
+{
+  int			i,		/* Looping var */
+			status = 0;	/* Number of failed tests */
+  cupsd_location_t	*loc;		/* Matching location */
+  cupsd_location_t	*root,		/* / */
+			*admin,		/* /admin */
+			*adminconf,	/* /admin/conf */
+			*adminpost,	/* /admin/post (POST only) */
+			*printers,	/* /printers */
+			*printer,	/* /printers/Test */
+			*jobs,		/* First /jobs */
+			*adminfoo;	/* /adminfoo, added after the lookups */
+  struct
+  {
+    const char		*path;		/* Resource path */
+    http_state_t	state;		/* HTTP state */
+    cupsd_location_t	**expected;	/* Expected location */
+  }			tests[] =	/* Lookups to test */
+  {
+    { "/", HTTP_STATE_GET, &root },
+    { "/adminfoo", HTTP_STATE_GET, &admin },
+    { "/admin/", HTTP_STATE_GET, &admin },
+    { "/admin?path=/admin/conf", HTTP_STATE_GET, &admin },
+    { "/admin/conf/cupsd.conf", HTTP_STATE_GET, &adminconf },
+    { "/Admin", HTTP_STATE_GET, &root },
+    { "/admin/post", HTTP_STATE_POST_RECV, &adminpost },
+    { "/admin/post", HTTP_STATE_GET, &admin },
+    { "/printers/Test", HTTP_STATE_POST_RECV, &printer },
+    { "/printers/test", HTTP_STATE_GET, &printer },
+    { "/printers/TEST.ppd", HTTP_STATE_GET, &printer },
+    { "/printers/Other", HTTP_STATE_GET, &printers },
+    { "/PRINTERS/Test", HTTP_STATE_GET, &root },
+    { "/jobs/1", HTTP_STATE_GET, &jobs }
+  };
+
+
+  root      = add_location("/", CUPSD_AUTH_LIMIT_ALL);
+  admin     = add_location("/admin", CUPSD_AUTH_LIMIT_ALL);
+  adminconf = add_location("/admin/conf", CUPSD_AUTH_LIMIT_ALL);
+  adminpost = add_location("/admin/post", CUPSD_AUTH_LIMIT_POST);
+  printers  = add_location("/printers", CUPSD_AUTH_LIMIT_ALL);
+  printer   = add_location("/printers/Test", CUPSD_AUTH_LIMIT_ALL);
+  jobs      = add_location("/jobs", CUPSD_AUTH_LIMIT_ALL);
+  adminfoo  = NULL;
+
+  add_location("/jobs", CUPSD_AUTH_LIMIT_ALL);
+
+  for (i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i ++)
+  {
+    printf("cupsdFindBest(\"%s\", %s): ", tests[i].path, httpStateString(tests[i].state));
+
+    loc = cupsdFindBest(tests[i].path, tests[i].state);
+
+    if (loc == *(tests[i].expected))
+      puts("PASS");
+    else
+    {
+      printf("FAIL (got \"%s\", expected \"%s\")\n", loc ? loc->location : "(null)", *(tests[i].expected) ? (*(tests[i].expected))->location : "(null)");
+      status ++;
+    }
+  }
+
+ /*
+  * Adding a location must invalidate the lookup trees...
+  */
+
+  fputs("cupsdFindBest(\"/adminfoo\", HTTP_STATE_GET) after cupsdAddLocation: ", stdout);
+
+  adminfoo = add_location("/adminfoo", CUPSD_AUTH_LIMIT_ALL);
+
+  if ((loc = cupsdFindBest("/adminfoo", HTTP_STATE_GET)) == adminfoo)
+    puts("PASS");
+  else
+  {
+    printf("FAIL (got \"%s\", expected \"/adminfoo\")\n", loc ? loc->location : "(null)");
+    status ++;
+  }
+
+  cupsdDeleteAllLocations();
+
+  return (status);
+}
@@ -0,0 +1,426 @@
+/*
+ * State file journal test program for the CUPS scheduler.
+ *
+ * Licensed under Apache License v2.0.  See the file "LICENSE" for more information.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#define _MAIN_C_
+#include "cupsd.h"
+
+
+/*
+ * Local functions...
+ */
+
+static int	check_file(const char *filename, const char *expected);
+static int	save_state(const char *filename, const char *header, int num_records, const char * const *records);
+static int	write_file(const char *filename, const char *data);
+
+
+/*
+ * 'main()' - Main entry.
+ */
+
+int					/* O - Exit status */
+main(void)
+{
+  int		status = 0;		/* Exit status */
+  char		header[1024],		/* State file header */
+		expected[2048],		/* Expected state file */
+		tempdir[1024],		/* Temporary directory */
+		filename[1024],		/* State filename */
+		jfilename[1024];	/* Journal filename */
+  struct stat	jinfo;			/* Journal information */
+  off_t		jsize;			/* Journal size */
+  static const char * const records1[] =
+  {					/* Initial records */
+    "<Printer a>\nInfo A\n</Printer>\n",
+    "<Printer b>\nInfo B\n</Printer>\n"
+  };
+  static const char * const records2[] =
+  {					/* Changed records */
+    "<Printer a>\nInfo A\n</Printer>\n",
+    "<Printer b>\nInfo B2\n</Printer>\n",
+    "<Printer c>\nInfo C\n</Printer>\n"
+  };
+
+
+  snprintf(tempdir, sizeof(tempdir), "/tmp/testjournal.%d", (int)getpid());
+  if (mkdir(tempdir, 0700))
+  {
+    perror(tempdir);
+    return (1);
+  }
+
+  snprintf(filename, sizeof(filename), "%s/printers.conf", tempdir);
+  snprintf(jfilename, sizeof(jfilename), "%s/printers.conf.journal", tempdir);
+
+ /*
+  * Use a large header so that the changes fit in the journal...
+  */
+
+  memset(header, '#', 512);
+  header[512] = '\n';
+  header[513] = '\0';
+
+ /*
+  * Save the whole state file...
+  */
+
+  fputs("cupsdEndJournal(initial): ", stdout);
+
+  snprintf(expected, sizeof(expected), "# Journal generation 1\n%s<Printer a>\nInfo A\n</Printer>\n<Printer b>\nInfo B\n</Printer>\n", header);
+
+  if (!save_state(filename, header, 2, records1))
+  {
+    puts("FAIL (save failed)");
+    status ++;
+  }
+  else if (!access(jfilename, 0))
+  {
+    puts("FAIL (journal exists)");
+    status ++;
+  }
+  else if (check_file(filename, expected))
+    puts("PASS");
+  else
+    status ++;
+
+ /*
+  * Save changes to the journal...
+  */
+
+  fputs("cupsdEndJournal(changes): ", stdout);
+
+  if (!save_state(filename, header, 3, records2))
+  {
+    puts("FAIL (save failed)");
+    status ++;
+  }
+  else if (access(jfilename, 0))
+  {
+    puts("FAIL (no journal)");
+    status ++;
+  }
+  else
+    puts("PASS");
+
+ /*
+  * Save with only a changed header, which must not be journaled...
+  */
+
+  fputs("cupsdEndJournal(header): ", stdout);
+
+  jsize = stat(jfilename, &jinfo) ? -1 : jinfo.st_size;
+  header[0] = '%';
+
+  if (!save_state(filename, header, 3, records2))
+  {
+    puts("FAIL (save failed)");
+    status ++;
+  }
+  else if (stat(jfilename, &jinfo) || jinfo.st_size != jsize)
+  {
+    puts("FAIL (header journaled)");
+    status ++;
+  }
+  else
+    puts("PASS");
+
+  header[0] = '#';
+
+ /*
+  * Replay the journal...
+  */
+
+  fputs("cupsdReplayJournal(current): ", stdout);
+
+  snprintf(expected, sizeof(expected), "# Journal generation 2\n%s<Printer a>\nInfo A\n</Printer>\n<Printer b>\nInfo B2\n</Printer>\n<Printer c>\nInfo C\n</Printer>\n", header);
+
+  cupsdReplayJournal(filename, 0600);
+
+  if (!access(jfilename, 0))
+  {
+    puts("FAIL (journal not removed)");
+    status ++;
+  }
+  else if (check_file(filename, expected))
+    puts("PASS");
+  else
+    status ++;
+
+ /*
+  * Replay a journal for an older state file, as left behind when the
+  * system stops after a compacted state file is renamed into place but
+  * before the journal is removed...
+  */
+
+  fputs("cupsdReplayJournal(stale): ", stdout);
+
+  write_file(filename, "# Journal generation 5\n# Header\n<Printer a>\nInfo A5\n</Printer>\n");
+  write_file(jfilename, "Journal 4\nRecord a 0 00000000\n");
+
+  cupsdReplayJournal(filename, 0600);
+
+  if (!access(jfilename, 0))
+  {
+    puts("FAIL (journal not removed)");
+    status ++;
+  }
+  else if (check_file(filename, "# Journal generation 5\n# Header\n<Printer a>\nInfo A5\n</Printer>\n"))
+    puts("PASS");
+  else
+    status ++;
+
+ /*
+  * Replay a journal with an incomplete record...
+  */
+
+  fputs("cupsdReplayJournal(incomplete): ", stdout);
+
+  write_file(jfilename, "Journal 5\nRecord b 23 00000000\n<Printer b>\nInfo");
+
+  cupsdReplayJournal(filename, 0600);
+
+  if (!access(jfilename, 0))
+  {
+    puts("FAIL (journal not removed)");
+    status ++;
+  }
+  else if (check_file(filename, "# Journal generation 6\n# Header\n<Printer a>\nInfo A5\n</Printer>\n"))
+    puts("PASS");
+  else
+    status ++;
+
+ /*
+  * Clean up...
+  */
+
+  unlink(filename);
+  unlink(jfilename);
+  rmdir(tempdir);
+
+  if (status)
+    printf("%d journal tests failed.\n", status);
+  else
+    puts("All journal tests passed.");
+
+  return (status ? 1 : 0);
+}
+
+
+/*
+ * 'cupsdAppendConfFile()' - Append data to a file (stub).
+ */
+
+int					/* O - 0 on success, -1 on error */
+cupsdAppendConfFile(
+    const char *filename,		/* I - Filename */
+    mode_t     mode,			/* I - File permissions */
+    const char *data,			/* I - Data to append */
+    size_t     length)			/* I - Length of data */
+{
+  int	fd;				/* File descriptor */
+  int	status;				/* Return status */
+
+
+  if ((fd = open(filename, O_WRONLY | O_APPEND | O_CREAT, mode)) < 0)
+    return (-1);
+
+  status = write(fd, data, length) == (ssize_t)length ? 0 : -1;
+
+  close(fd);
+
+  return (status);
+}
+
+
+/*
+ * 'cupsdCloseCreatedConfFile()' - Close a created configuration file (stub).
+ */
+
+int					/* O - 0 on success, -1 on error */
+cupsdCloseCreatedConfFile(
+    cups_file_t *fp,			/* I - File to close */
+    const char  *filename)		/* I - Filename */
+{
+  char	newfile[1024];			/* New filename */
+
+
+  snprintf(newfile, sizeof(newfile), "%s.N", filename);
+
+  if (cupsFileClose(fp) || rename(newfile, filename))
+    return (-1);
+
+  return (0);
+}
+
+
+/*
+ * 'cupsdCreateConfFile()' - Create a configuration file (stub).
+ */
+
+cups_file_t *				/* O - File pointer */
+cupsdCreateConfFile(
+    const char *filename,		/* I - Filename */
+    mode_t     mode)			/* I - File permissions */
+{
+  char	newfile[1024];			/* New filename */
+
+
+  (void)mode;
+
+  snprintf(newfile, sizeof(newfile), "%s.N", filename);
+
+  return (cupsFileOpen(newfile, "w"));
+}
+
+
+/*
+ * 'cupsdLogMessage()' - Log a message (stub).
+ */
+
+int					/* O - 1 on success */
+cupsdLogMessage(int        level,	/* I - Log level */
+                const char *message,	/* I - printf-style message string */
+		...)			/* I - Additional args as needed */
+{
+  (void)level;
+  (void)message;
+
+  return (1);
+}
+
+
+/*
+ * 'cupsdMarkDirty()' - Mark config or state files as needing a write (stub).
+ */
+
+void
+cupsdMarkDirty(int what)		/* I - What file(s) are dirty? */
+{
+  (void)what;
+}
+
+
+/*
+ * 'cupsdOpenConfFile()' - Open a configuration file (stub).
+ */
+
+cups_file_t *				/* O - File pointer */
+cupsdOpenConfFile(const char *filename)	/* I - Filename */
+{
+  return (cupsFileOpen(filename, "r"));
+}
+
+
+/*
+ * 'cupsdSyncConfFile()' - Wait for writes to a configuration file (stub).
+ */
+
+int					/* O - 0 on success, -1 on error */
+cupsdSyncConfFile(const char *filename)	/* I - Filename */
+{
+  (void)filename;
+
+  return (0);
+}
+
+
+/*
+ * 'check_file()' - Check the contents of a file.
+ */
+
+static int				/* O - 1 if the contents match, 0 otherwise */
+check_file(const char *filename,	/* I - Filename */
+           const char *expected)	/* I - Expected contents */
+{
+  cups_file_t	*fp;			/* File */
+  char		buffer[8192];		/* File contents */
+  ssize_t	bytes;			/* Bytes read */
+
+
+  if ((fp = cupsFileOpen(filename, "r")) == NULL)
+  {
+    printf("FAIL (unable to open \"%s\": %s)\n", filename, strerror(errno));
+    return (0);
+  }
+
+  bytes = cupsFileRead(fp, buffer, sizeof(buffer) - 1);
+  cupsFileClose(fp);
+
+  if (bytes < 0)
+    bytes = 0;
+
+  buffer[bytes] = '\0';
+
+  if (strcmp(buffer, expected))
+  {
+    printf("FAIL (got \"%s\", expected \"%s\")\n", buffer, expected);
+    return (0);
+  }
+
+  return (1);
+}
+
+
+/*
+ * 'save_state()' - Save a state file using the journal functions.
+ */
+
+static int				/* O - 1 on success, 0 on failure */
+save_state(
+    const char         *filename,	/* I - State filename */
+    const char         *header,		/* I - File header */
+    int                num_records,	/* I - Number of records */
+    const char * const *records)	/* I - Records */
+{
+  int			i;		/* Looping var */
+  cupsd_journal_t	*j;		/* Journal */
+  cups_file_t		*fp;		/* Record file */
+  char			name[256],	/* Record name */
+			*ptr;		/* Pointer into name */
+
+
+  if ((j = cupsdBeginJournal(filename, 0600, CUPSD_DIRTY_PRINTERS)) == NULL)
+    return (0);
+
+  if ((fp = cupsdAddJournalRecord(j, NULL)) != NULL)
+    cupsFilePuts(fp, header);
+
+  for (i = 0; i < num_records; i ++)
+  {
+    strlcpy(name, strchr(records[i], ' ') + 1, sizeof(name));
+    if ((ptr = strchr(name, '>')) != NULL)
+      *ptr = '\0';
+
+    if ((fp = cupsdAddJournalRecord(j, name)) != NULL)
+      cupsFilePuts(fp, records[i]);
+  }
+
+  return (cupsdEndJournal(j));
+}
+
+
+/*
+ * 'write_file()' - Write a file.
+ */
+
+static int				/* O - 1 on success, 0 on failure */
+write_file(const char *filename,	/* I - Filename */
+           const char *data)		/* I - File contents */
+{
+  cups_file_t	*fp;			/* File */
+
+
+  if ((fp = cupsFileOpen(filename, "w")) == NULL)
+    return (0);
+
+  cupsFilePuts(fp, data);
+
+  return (!cupsFileClose(fp));
+}
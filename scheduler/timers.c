@@ -0,0 +1,344 @@
+/*
+ * Timer functions for the CUPS scheduler.
+ *
+ * Licensed under Apache License v2.0.  See the file "LICENSE" for more information.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "cupsd.h"
+
+
+/*
+ * Design Notes for Timers in CUPSD
+ * --------------------------------
+ *
+ * Jobs, printers, clients, and subscriptions all have deadlines (job
+ * cancellation, hold expiration, idle client timeouts, lease expiration,
+ * and so forth).  Rather than scanning every object on each pass through the
+ * main loop, each object owns a single timer that is scheduled for its next
+ * deadline.  The timers are kept in a binary min-heap ordered by time, so the
+ * next timeout is available in constant time and adding, moving, or removing
+ * a timer is O(log n).
+ *
+ * Timers are "lazy" - a timer callback always checks the object's current
+ * deadlines and may simply reschedule itself with cupsdSetTimer() when the
+ * deadline has moved.  This means that code that pushes a deadline further
+ * out (for example updating the last access time of a job) does not need to
+ * touch the timer at all; only code that makes a deadline earlier needs to
+ * reschedule the object's timer.
+ *
+ * A timer is removed from the heap before its callback is run, so callbacks
+ * are free to reschedule or delete their own timer and to delete the object
+ * that owns it.  Timers that are (re)scheduled for an expired time while the
+ * callbacks are running are deferred to the next pass through the main loop.
+ */
+
+
+/*
+ * Timer structure...
+ */
+
+struct cupsd_timer_s			/**** Timer ****/
+{
+  time_t		when;		/* When the timer expires */
+  int			index;		/* Index in heap or -1 if not queued */
+  cupsd_timerfunc_t	cb;		/* Callback function */
+  void			*data;		/* Callback data */
+};
+
+
+/*
+ * Local globals...
+ */
+
+static cupsd_timer_t	**timers = NULL;/* Heap of queued timers */
+static int		num_timers = 0,	/* Number of queued timers */
+			alloc_timers = 0;
+					/* Allocated timer slots */
+static time_t		run_time = 0;	/* Time used by cupsdRunTimers() */
+
+
+/*
+ * Local functions...
+ */
+
+static void		timer_down(int index);
+static void		timer_remove(cupsd_timer_t *timer);
+static void		timer_up(int index);
+
+
+/*
+ * 'cupsdAddTimer()' - Create a new timer.
+ *
+ * A "when" value of 0 creates the timer without scheduling it.
+ */
+
+cupsd_timer_t *				/* O - New timer or NULL on error */
+cupsdAddTimer(time_t            when,	/* I - When to run the callback */
+              cupsd_timerfunc_t cb,	/* I - Callback function */
+	      void              *data)	/* I - Callback data */
+{
+  cupsd_timer_t	*timer;			/* New timer */
+
+
+  if (!cb)
+    return (NULL);
+
+  if ((timer = calloc(1, sizeof(cupsd_timer_t))) == NULL)
+  {
+    cupsdLogMessage(CUPSD_LOG_EMERG, "Unable to allocate memory for timer.");
+    return (NULL);
+  }
+
+  timer->index = -1;
+  timer->cb    = cb;
+  timer->data  = data;
+
+  if (when)
+    cupsdSetTimer(timer, when);
+
+  return (timer);
+}
+
+
+/*
+ * 'cupsdDeleteTimer()' - Remove and free a timer.
+ */
+
+void
+cupsdDeleteTimer(cupsd_timer_t *timer)	/* I - Timer */
+{
+  if (!timer)
+    return;
+
+  timer_remove(timer);
+  free(timer);
+}
+
+
+/*
+ * 'cupsdNextTimer()' - Return the time of the next timer, if any.
+ */
+
+time_t					/* O - Time of next timer or 0 for none */
+cupsdNextTimer(void)
+{
+  return (num_timers > 0 ? timers[0]->when : 0);
+}
+
+
+/*
+ * 'cupsdRunTimers()' - Run the callbacks for all expired timers.
+ */
+
+void
+cupsdRunTimers(time_t curtime)		/* I - Current time */
+{
+  cupsd_timer_t	*timer;			/* Current timer */
+
+
+  run_time = curtime;
+
+  while (num_timers > 0 && timers[0]->when <= curtime)
+  {
+    timer = timers[0];
+
+    timer_remove(timer);
+
+    (*timer->cb)(timer->data);
+  }
+
+  run_time = 0;
+}
+
+
+/*
+ * 'cupsdSetTimer()' - Schedule a timer, replacing any previous time.
+ *
+ * A "when" value of 0 unschedules the timer.
+ */
+
+void
+cupsdSetTimer(cupsd_timer_t *timer,	/* I - Timer */
+              time_t        when)	/* I - When to run the callback */
+{
+  time_t	oldwhen;		/* Previous time */
+
+
+  if (!timer)
+    return;
+
+  if (!when)
+  {
+    timer_remove(timer);
+    return;
+  }
+
+  if (run_time && when <= run_time)
+  {
+   /*
+    * Don't run the same timer twice in one pass...
+    */
+
+    when = run_time + 1;
+  }
+
+  if (timer->index < 0)
+  {
+   /*
+    * Add the timer to the end of the heap...
+    */
+
+    if (num_timers >= alloc_timers)
+    {
+      cupsd_timer_t	**temp;		/* New heap array */
+      int		alloc;		/* New allocation */
+
+      alloc = alloc_timers ? 2 * alloc_timers : 64;
+
+      if ((temp = realloc(timers, (size_t)alloc * sizeof(cupsd_timer_t *))) == NULL)
+      {
+        cupsdLogMessage(CUPSD_LOG_EMERG,
+	                "Unable to allocate memory for %d timers.", alloc);
+        return;
+      }
+
+      timers       = temp;
+      alloc_timers = alloc;
+    }
+
+    timer->when  = when;
+    timer->index = num_timers;
+
+    timers[num_timers ++] = timer;
+
+    timer_up(timer->index);
+  }
+  else if (when != timer->when)
+  {
+   /*
+    * Move the timer within the heap...
+    */
+
+    oldwhen     = timer->when;
+    timer->when = when;
+
+    if (when < oldwhen)
+      timer_up(timer->index);
+    else
+      timer_down(timer->index);
+  }
+}
+
+
+/*
+ * 'cupsdStopTimers()' - Free the timer heap.
+ *
+ * The timers themselves are owned (and freed) by the objects that use them.
+ */
+
+void
+cupsdStopTimers(void)
+{
+  while (num_timers > 0)
+    timer_remove(timers[0]);
+
+  free(timers);
+
+  timers       = NULL;
+  alloc_timers = 0;
+}
+
+
+/*
+ * 'timer_down()' - Move a timer down the heap as needed.
+ */
+
+static void
+timer_down(int index)			/* I - Heap index */
+{
+  int		child;			/* Child index */
+  cupsd_timer_t	*timer;			/* Timer to move */
+
+
+  timer = timers[index];
+
+  while ((child = 2 * index + 1) < num_timers)
+  {
+    if (child + 1 < num_timers && timers[child + 1]->when < timers[child]->when)
+      child ++;
+
+    if (timers[child]->when >= timer->when)
+      break;
+
+    timers[index]        = timers[child];
+    timers[index]->index = index;
+    index                = child;
+  }
+
+  timers[index] = timer;
+  timer->index  = index;
+}
+
+
+/*
+ * 'timer_remove()' - Remove a timer from the heap.
+ */
+
+static void
+timer_remove(cupsd_timer_t *timer)	/* I - Timer */
+{
+  int		index;			/* Heap index */
+  cupsd_timer_t	*last;			/* Last timer in heap */
+
+
+  if ((index = timer->index) < 0)
+    return;
+
+  timer->index = -1;
+  last         = timers[-- num_timers];
+
+  if (last == timer)
+    return;
+
+  timers[index] = last;
+  last->index   = index;
+
+  if (index > 0 && last->when < timers[(index - 1) / 2]->when)
+    timer_up(index);
+  else
+    timer_down(index);
+}
+
+
+/*
+ * 'timer_up()' - Move a timer up the heap as needed.
+ */
+
+static void
+timer_up(int index)			/* I - Heap index */
+{
+  int		parent;			/* Parent index */
+  cupsd_timer_t	*timer;			/* Timer to move */
+
+
+  timer = timers[index];
+
+  while (index > 0)
+  {
+    parent = (index - 1) / 2;
+
+    if (timers[parent]->when <= timer->when)
+      break;
+
+    timers[index]        = timers[parent];
+    timers[index]->index = index;
+    index                = parent;
+  }
+
+  timers[index] = timer;
+  timer->index  = index;
+}
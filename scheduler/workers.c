@@ -0,0 +1,227 @@
+/*
+ * Worker thread functions for the CUPS scheduler.
+ *
+ * Licensed under Apache License v2.0.  See the file "LICENSE" for more information.
+ */
+
+/*
+ * Include necessary headers...
+ */
+
+#include "cupsd.h"
+#include <cups/thread-private.h>
+
+
+/*
+ * Design Notes for Worker Threads in CUPSD
+ * ----------------------------------------
+ *
+ * The scheduler state (jobs, printers, subscriptions, and the arrays that
+ * hold them) is owned by the main thread and is not protected by locks.
+ * Worker threads are therefore only used for self-contained work items that
+ * do not touch scheduler state, for example reading and parsing job control
+ * files into a new ipp_t.  The main thread prepares the work items, runs them
+ * with cupsdRunWorkers(), and then merges the results.
+ *
+ * cupsdRunWorkers() does not return until all of the work items have been
+ * processed, and the main thread processes work items alongside the worker
+ * threads.  When WorkerThreads is 0 all work items are processed by the main
+ * thread.
+ */
+
+
+/*
+ * Local globals...
+ */
+
+static _cups_mutex_t	worker_mutex = _CUPS_MUTEX_INITIALIZER;
+					/* Mutex for work queue */
+static _cups_cond_t	worker_cond = _CUPS_COND_INITIALIZER,
+					/* Condition for new work */
+			worker_done_cond = _CUPS_COND_INITIALIZER;
+					/* Condition for completed work */
+static int		worker_count = 0,
+					/* Number of worker threads */
+			worker_stop = 0;/* Stop worker threads? */
+static cupsd_workfunc_t	worker_func = NULL;
+					/* Current work function */
+static void		**worker_data = NULL;
+					/* Current work items */
+static int		worker_num_data = 0,
+					/* Number of work items */
+			worker_next = 0,/* Next work item */
+			worker_done = 0;/* Number of completed work items */
+
+
+/*
+ * Local functions...
+ */
+
+static void		*worker_thread(void *arg);
+
+
+/*
+ * 'cupsdRunWorkers()' - Process work items using the worker threads.
+ */
+
+void
+cupsdRunWorkers(cupsd_workfunc_t func,	/* I - Work function */
+                void             **data,/* I - Work items */
+		int              num_data)
+					/* I - Number of work items */
+{
+  int	i;				/* Looping var */
+  void	*item;				/* Current work item */
+
+
+  if (!func || !data || num_data <= 0)
+    return;
+
+  if (WorkerThreads <= 0 || num_data == 1 || worker_stop)
+  {
+   /*
+    * Process everything on the main thread...
+    */
+
+    for (i = 0; i < num_data; i ++)
+      (*func)(data[i]);
+
+    return;
+  }
+
+  _cupsMutexLock(&worker_mutex);
+
+ /*
+  * Start more threads as needed...
+  */
+
+  while (worker_count < WorkerThreads)
+  {
+    if (!_cupsThreadCreate((_cups_thread_func_t)worker_thread, NULL))
+    {
+      cupsdLogMessage(CUPSD_LOG_ERROR, "Unable to create worker thread: %s",
+                      strerror(errno));
+      break;
+    }
+
+    worker_count ++;
+  }
+
+  cupsdLogMessage(CUPSD_LOG_DEBUG2,
+                  "cupsdRunWorkers: Processing %d work items with %d threads.",
+		  num_data, worker_count);
+
+ /*
+  * Queue the work and wake up the worker threads...
+  */
+
+  worker_func     = func;
+  worker_data     = data;
+  worker_num_data = num_data;
+  worker_next     = 0;
+  worker_done     = 0;
+
+  _cupsCondBroadcast(&worker_cond);
+
+ /*
+  * Help out until all of the work items have been taken...
+  */
+
+  while (worker_next < worker_num_data)
+  {
+    item = worker_data[worker_next ++];
+
+    _cupsMutexUnlock(&worker_mutex);
+    (*func)(item);
+    _cupsMutexLock(&worker_mutex);
+
+    worker_done ++;
+  }
+
+ /*
+  * Then wait for the worker threads to finish...
+  */
+
+  while (worker_done < worker_num_data)
+    _cupsCondWait(&worker_done_cond, &worker_mutex, 0.0);
+
+  worker_func     = NULL;
+  worker_data     = NULL;
+  worker_num_data = 0;
+  worker_next     = 0;
+  worker_done     = 0;
+
+  _cupsMutexUnlock(&worker_mutex);
+}
+
+
+/*
+ * 'cupsdStopWorkers()' - Stop all worker threads.
+ */
+
+void
+cupsdStopWorkers(void)
+{
+  _cupsMutexLock(&worker_mutex);
+
+  worker_stop = 1;
+  _cupsCondBroadcast(&worker_cond);
+
+  while (worker_count > 0)
+    _cupsCondWait(&worker_done_cond, &worker_mutex, 1.0);
+
+  _cupsMutexUnlock(&worker_mutex);
+}
+
+
+/*
+ * 'worker_thread()' - Process work items as they are queued.
+ */
+
+static void *				/* O - Exit status */
+worker_thread(void *arg)		/* I - Not used */
+{
+  cupsd_workfunc_t func;		/* Current work function */
+  void		*item;			/* Current work item */
+  sigset_t	mask;			/* Signal mask */
+
+
+  (void)arg;
+
+ /*
+  * Signals are handled by the main thread...
+  */
+
+  sigfillset(&mask);
+  pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+  pthread_detach(pthread_self());
+
+  _cupsMutexLock(&worker_mutex);
+
+  while (!worker_stop)
+  {
+    if (worker_next >= worker_num_data)
+    {
+      _cupsCondWait(&worker_cond, &worker_mutex, 0.0);
+      continue;
+    }
+
+    func = worker_func;
+    item = worker_data[worker_next ++];
+
+    _cupsMutexUnlock(&worker_mutex);
+    (*func)(item);
+    _cupsMutexLock(&worker_mutex);
+
+    if (++ worker_done >= worker_num_data)
+      _cupsCondBroadcast(&worker_done_cond);
+  }
+
+  worker_count --;
+  _cupsCondBroadcast(&worker_done_cond);
+
+  _cupsMutexUnlock(&worker_mutex);
+
+  return (NULL);
+}
@@ -491,6 +491,7 @@ LogLevel $loglevel
 LogTimeFormat usecs
 PreserveJobHistory Yes
 PreserveJobFiles 5m
+WorkerThreads 2
 <Policy default>
 <Limit All>
 Order Allow,Deny
@@ -655,6 +655,7 @@ typedef unsigned long useconds_t;
 
 /* #undef HAVE_POLL */
 /* #undef HAVE_EPOLL */
+/* #undef HAVE_IO_URING */
 /* #undef HAVE_KQUEUE */
 
 
@@ -686,6 +687,20 @@ typedef unsigned long useconds_t;
 /* #undef HAVE_REMOVEFILE */
 
 
+/*
+ * Do we have splice()?
+ */
+
+/* #undef HAVE_SPLICE */
+
+
+/*
+ * Do we have the Linux sendfile()?
+ */
+
+/* #undef HAVE_SENDFILE */
+
+
 /*
  * Do we have <sandbox.h>?
  */
@@ -600,6 +600,7 @@
 
 #define HAVE_POLL 1
 /* #undef HAVE_EPOLL */
+/* #undef HAVE_IO_URING */
 #define HAVE_KQUEUE 1
 
 
@@ -631,6 +632,20 @@
 #define HAVE_REMOVEFILE 1
 
 
+/*
+ * Do we have splice()?
+ */
+
+/* #undef HAVE_SPLICE */
+
+
+/*
+ * Do we have the Linux sendfile()?
+ */
+
+/* #undef HAVE_SENDFILE */
+
+
 /*
  * Do we have <sandbox.h>?
  */